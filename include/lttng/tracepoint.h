@@ -804,6 +804,9 @@ lttng_ust__tracepoints__ptrs_destroy(void)
  *         * Array sequence of signed integer values *
  *         lttng_ust_field_array(long, field_f, arg4, FIXED_LEN4)
  *         lttng_ust_field_sequence(long, field_g, arg4, size_t, arg4_len)
+ *
+ *         * Reference to a copy of a large payload in the blob arena *
+ *         lttng_ust_field_blob(field_h, arg1, arg4_len)
  *     )
  * )
  *
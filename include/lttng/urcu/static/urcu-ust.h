@@ -78,6 +78,7 @@ struct lttng_ust_urcu_reader {
 	struct cds_list_head node __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
 	pthread_t tid;
 	int alloc;	/* registry entry allocated */
+	unsigned int shard;	/* registry shard */
 };
 
 /*
@@ -66,6 +66,23 @@ extern int lttng_ust_urcu_read_ongoing(void);
 
 extern void lttng_ust_urcu_synchronize_rcu(void);
 
+struct lttng_ust_urcu_head {
+	struct lttng_ust_urcu_head *next;
+	void (*func)(struct lttng_ust_urcu_head *head);
+};
+
+/*
+ * lttng_ust_urcu_call_rcu() queues func(head) to be invoked by a worker
+ * thread after a grace period, shared with the other callbacks queued
+ * in the meantime. It must not be called from a signal handler.
+ *
+ * lttng_ust_urcu_barrier() waits for the invocation of all the
+ * callbacks queued before it. It must not be called from a callback.
+ */
+extern void lttng_ust_urcu_call_rcu(struct lttng_ust_urcu_head *head,
+		void (*func)(struct lttng_ust_urcu_head *head));
+extern void lttng_ust_urcu_barrier(void);
+
 /*
  * lttng_ust_urcu_before_fork, lttng_ust_urcu_after_fork_parent and
  * lttng_ust_urcu_after_fork_child should be called around fork() system
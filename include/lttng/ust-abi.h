@@ -21,7 +21,7 @@
 /* Version for ABI between liblttng-ust, sessiond, consumerd */
 #define LTTNG_UST_ABI_MAJOR_VERSION			10
 #define LTTNG_UST_ABI_MAJOR_VERSION_OLDEST_COMPATIBLE	8
-#define LTTNG_UST_ABI_MINOR_VERSION		0
+#define LTTNG_UST_ABI_MINOR_VERSION		1
 
 #define LTTNG_UST_ABI_CMD_MAX_LEN			4096U
 
@@ -53,6 +53,40 @@ struct lttng_ust_abi_tracer_version {
 	uint32_t patchlevel;
 } __attribute__((packed));
 
+/*
+ * Notification protocol features which the session daemon supports.
+ * Enabled per application through LTTNG_UST_ABI_NOTIFY_FEATURES, which
+ * returns the subset supported by the application.
+ *
+ * LTTNG_UST_ABI_NOTIFY_FEATURE_EVENT_BATCH: register events with
+ * LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH messages.
+ *
+ * LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP: within batches, send each
+ * distinct field description once and refer to it by id afterwards.
+ * Requires LTTNG_UST_ABI_NOTIFY_FEATURE_EVENT_BATCH. Enabling it resets
+ * the descriptor ids of the application.
+ */
+#define LTTNG_UST_ABI_NOTIFY_FEATURE_EVENT_BATCH	(1ULL << 0)
+#define LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP	(1ULL << 1)
+
+#define LTTNG_UST_ABI_NOTIFY_FEATURES_PADDING	24
+struct lttng_ust_abi_notify_features {
+	uint64_t features;
+	char padding[LTTNG_UST_ABI_NOTIFY_FEATURES_PADDING];
+} __attribute__((packed));
+
+/*
+ * Shared-memory command ring, set up through LTTNG_UST_ABI_CMD_RING.
+ * The shared memory file descriptor of len bytes follows the command
+ * on the socket.
+ */
+#define LTTNG_UST_ABI_CMD_RING_PADDING	20
+struct lttng_ust_abi_cmd_ring {
+	uint64_t len;
+	uint32_t nr_slots;
+	char padding[LTTNG_UST_ABI_CMD_RING_PADDING];
+} __attribute__((packed));
+
 #define LTTNG_UST_ABI_CHANNEL_PADDING	(LTTNG_UST_ABI_SYM_NAME_LEN + 32)
 /*
  * Given that the consumerd is limited to 64k file descriptors, we
@@ -337,6 +371,18 @@ struct lttng_ust_abi_tracepoint_iter {
 	char padding[LTTNG_UST_ABI_TRACEPOINT_ITER_PADDING];
 } __attribute__((packed));
 
+/*
+ * Request of LTTNG_UST_ABI_TRACEPOINT_LIST_GET_BATCH and
+ * LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET_BATCH. The reply return value
+ * is the number of entries following it on the socket, at most
+ * max_entries, and 0 once the end of the list is reached.
+ */
+#define LTTNG_UST_ABI_LIST_BATCH_PADDING	28
+struct lttng_ust_abi_list_batch {
+	uint32_t max_entries;
+	char padding[LTTNG_UST_ABI_LIST_BATCH_PADDING];
+} __attribute__((packed));
+
 enum lttng_ust_abi_object_type {
 	LTTNG_UST_ABI_OBJECT_TYPE_UNKNOWN = -1,
 	LTTNG_UST_ABI_OBJECT_TYPE_CHANNEL = 0,
@@ -446,6 +492,10 @@ struct lttng_ust_abi_event_exclusion {
 #define LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST	LTTNG_UST_ABI_CMD(0x45)
 #define LTTNG_UST_ABI_EVENT_NOTIFIER_GROUP_CREATE \
 	LTTNG_UST_ABI_CMD(0x46)
+#define LTTNG_UST_ABI_NOTIFY_FEATURES		\
+	LTTNG_UST_ABI_CMDW(0x47, struct lttng_ust_abi_notify_features)
+#define LTTNG_UST_ABI_CMD_RING			\
+	LTTNG_UST_ABI_CMDW(0x48, struct lttng_ust_abi_cmd_ring)
 
 /* Session commands */
 #define LTTNG_UST_ABI_CHANNEL			\
@@ -472,6 +522,10 @@ struct lttng_ust_abi_event_exclusion {
 /* Tracepoint list commands */
 #define LTTNG_UST_ABI_TRACEPOINT_LIST_GET	LTTNG_UST_ABI_CMD(0x90)
 #define LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET	LTTNG_UST_ABI_CMD(0x91)
+#define LTTNG_UST_ABI_TRACEPOINT_LIST_GET_BATCH	\
+	LTTNG_UST_ABI_CMDW(0x92, struct lttng_ust_abi_list_batch)
+#define LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET_BATCH	\
+	LTTNG_UST_ABI_CMDW(0x93, struct lttng_ust_abi_list_batch)
 
 /* Event and event notifier commands */
 #define LTTNG_UST_ABI_FILTER			LTTNG_UST_ABI_CMD(0xA0)
@@ -140,9 +140,74 @@ int lttng_ust_ctl_tracepoint_field_list(int sock);
 int lttng_ust_ctl_tracepoint_field_list_get(int sock, int tp_field_list_handle,
 		struct lttng_ust_abi_field_iter *iter);
 
+/*
+ * lttng_ust_ctl_tracepoint_list_get_batch and
+ * lttng_ust_ctl_tracepoint_field_list_get_batch fill iters with up to
+ * max_entries entries of the list handle in a single round trip. They
+ * return the number of entries received, 0 once the end of the list is
+ * reached, or a negative error value. Batched and entry-by-entry gets
+ * iterate independently on a list handle.
+ */
+int lttng_ust_ctl_tracepoint_list_get_batch(int sock, int tp_list_handle,
+		struct lttng_ust_abi_tracepoint_iter *iters,
+		unsigned int max_entries);
+int lttng_ust_ctl_tracepoint_field_list_get_batch(int sock,
+		int tp_field_list_handle, struct lttng_ust_abi_field_iter *iters,
+		unsigned int max_entries);
+
 int lttng_ust_ctl_tracer_version(int sock, struct lttng_ust_abi_tracer_version *v);
 int lttng_ust_ctl_wait_quiescent(int sock);
 
+/*
+ * Enable notification protocol features (LTTNG_UST_ABI_NOTIFY_FEATURE_*)
+ * supported by the session daemon for the application. On success,
+ * *enabled holds the subset supported by the application. Applications
+ * which predate this command return an error, and keep using the
+ * original protocol.
+ */
+int lttng_ust_ctl_set_notify_features(int sock, uint64_t features,
+		uint64_t *enabled);
+
+/*
+ * Shared-memory command ring, to issue commands without payload nor
+ * file descriptor (LTTNG_UST_ABI_ENABLE, LTTNG_UST_ABI_DISABLE,
+ * LTTNG_UST_ABI_SESSION_START, ...) without a socket round trip each.
+ * The commands of the ring are executed in order. The application
+ * executes them in a thread distinct from the one executing the
+ * commands received on the socket, so nothing orders the two: a socket
+ * command can run before ring commands submitted earlier. Callers must
+ * wait for the replies of all the submitted ring commands with
+ * lttng_ust_ctl_cmd_ring_wait_reply() before using the socket.
+ *
+ * lttng_ust_ctl_create_cmd_ring() sizes and maps the shared memory
+ * shm_fd, provided by the caller, for nr_slots (power of two, at most
+ * 4096) commands, and passes it to the application. The ring can be
+ * used as long as the command socket is open. Applications which
+ * predate this command or lack futex support return an error: keep
+ * using the socket.
+ */
+struct lttng_ust_ctl_cmd_ring;
+
+int lttng_ust_ctl_create_cmd_ring(int sock, int shm_fd, uint32_t nr_slots,
+		struct lttng_ust_ctl_cmd_ring **ring);
+void lttng_ust_ctl_destroy_cmd_ring(struct lttng_ust_ctl_cmd_ring *ring);
+
+/*
+ * Queue command cmd on object handle. Returns -EAGAIN when nr_slots
+ * commands await lttng_ust_ctl_cmd_ring_wait_reply().
+ */
+int lttng_ust_ctl_cmd_ring_submit(struct lttng_ust_ctl_cmd_ring *ring,
+		int handle, uint32_t cmd);
+
+/*
+ * Wait for the oldest submitted command to complete, for at most
+ * timeout_ms (-1: no timeout), and return its return code, setting
+ * *ret_val if not NULL. Returns -ENOENT if no command is pending and
+ * -ETIMEDOUT on timeout.
+ */
+int lttng_ust_ctl_cmd_ring_wait_reply(struct lttng_ust_ctl_cmd_ring *ring,
+		int timeout_ms, uint32_t *ret_val);
+
 int lttng_ust_ctl_sock_flush_buffer(int sock, struct lttng_ust_abi_object_data *object);
 
 int lttng_ust_ctl_calibrate(int sock, struct lttng_ust_abi_calibrate *calibrate);
@@ -184,6 +249,40 @@ int lttng_ust_ctl_get_nr_stream_per_channel(void);
 struct lttng_ust_ctl_consumer_channel *
 	lttng_ust_ctl_create_channel(struct lttng_ust_ctl_consumer_channel_attr *attr,
 		const int *stream_fds, int nr_stream_fds);
+
+/*
+ * Consumer notification flags for lttng_ust_ctl_create_channel_wakeup().
+ *
+ * LTTNG_UST_CTL_WAKEUP_EVENTFD: the wait/wakeup fds of the channel and
+ * of its streams are non-blocking eventfds rather than pipes. A single
+ * 8-byte read clears all pending wakeups of a stream. The wait and
+ * wakeup fds are the same eventfd, so each stream uses one fd instead of
+ * two, and closing the wakeup fd with
+ * lttng_ust_ctl_stream_close_wakeup_fd() leaves it open until the wait
+ * fd is closed. As a consequence, the wait fd never reports POLLHUP
+ * when the application exits: consumers relying on that hang-up to
+ * detect the teardown of an application must use pipes.
+ *
+ * LTTNG_UST_CTL_WAKEUP_FUTEX: in addition to the per-stream wakeup fds,
+ * the tracer updates a channel-wide futex word on each wakeup, which
+ * can be waited on with lttng_ust_ctl_channel_wait_wakeup().
+ *
+ * These flags must only be used when every application writing into the
+ * channel reported LTTNG_UST_ABI_MINOR_VERSION 1 or later at
+ * registration: older tracers only know how to write into pipes.
+ *
+ * LTTNG_UST_CTL_SNAPSHOT_SPARE: allocate one spare sub-buffer per
+ * sub-buffer in each stream of an overwrite mode channel, doubling its
+ * memory usage, for lttng_ust_ctl_snapshot_swap().
+ */
+#define LTTNG_UST_CTL_WAKEUP_EVENTFD	(1U << 0)
+#define LTTNG_UST_CTL_WAKEUP_FUTEX	(1U << 1)
+#define LTTNG_UST_CTL_SNAPSHOT_SPARE	(1U << 2)
+
+struct lttng_ust_ctl_consumer_channel *
+	lttng_ust_ctl_create_channel_wakeup(struct lttng_ust_ctl_consumer_channel_attr *attr,
+		const int *stream_fds, int nr_stream_fds,
+		uint32_t wakeup_flags);
 /*
  * Each stream created needs to be destroyed before calling
  * lttng_ust_ctl_destroy_channel().
@@ -197,6 +296,19 @@ int lttng_ust_ctl_channel_close_wakeup_fd(struct lttng_ust_ctl_consumer_channel
 int lttng_ust_ctl_channel_get_wait_fd(struct lttng_ust_ctl_consumer_channel *consumer_chan);
 int lttng_ust_ctl_channel_get_wakeup_fd(struct lttng_ust_ctl_consumer_channel *consumer_chan);
 
+/*
+ * Channel-wide futex wakeup (LTTNG_UST_CTL_WAKEUP_FUTEX). Sample the
+ * wakeup sequence number, check the streams for data, then wait for
+ * the sequence number to change. lttng_ust_ctl_channel_wait_wakeup()
+ * returns 0 on wakeup, -ETIMEDOUT after timeout_ms (-1: wait forever),
+ * -EINTR if interrupted, and -ENOSYS if the channel was not created
+ * with LTTNG_UST_CTL_WAKEUP_FUTEX.
+ */
+int lttng_ust_ctl_channel_get_wakeup_seq(struct lttng_ust_ctl_consumer_channel *consumer_chan,
+		uint32_t *seq);
+int lttng_ust_ctl_channel_wait_wakeup(struct lttng_ust_ctl_consumer_channel *consumer_chan,
+		uint32_t seq, int timeout_ms);
+
 int lttng_ust_ctl_write_metadata_to_channel(
 		struct lttng_ust_ctl_consumer_channel *channel,
 		const char *metadata_str,	/* NOT null-terminated */
@@ -255,6 +367,26 @@ int lttng_ust_ctl_get_subbuf(struct lttng_ust_ctl_consumer_stream *stream,
 		unsigned long *pos);
 int lttng_ust_ctl_put_subbuf(struct lttng_ust_ctl_consumer_stream *stream);
 
+/*
+ * Take a snapshot of a stream of a channel created with
+ * LTTNG_UST_CTL_SNAPSHOT_SPARE by atomically exchanging its complete
+ * sub-buffers with spare ones: the application keeps tracing into the
+ * spare sub-buffers and cannot overwrite the snapshot while it is read
+ * with lttng_ust_ctl_get_subbuf() and lttng_ust_ctl_put_subbuf() between
+ * the positions returned by lttng_ust_ctl_snapshot_get_consumed() and
+ * lttng_ust_ctl_snapshot_get_produced().
+ *
+ * lttng_ust_ctl_snapshot_release() puts the snapshot sub-buffers back in
+ * the stream where the application did not write into the spare ones
+ * yet. Taking a new snapshot releases the previous one.
+ *
+ * Returns -EINVAL if the channel has no spare sub-buffers, -EBUSY if a
+ * sub-buffer is held, -EAGAIN if there is no complete sub-buffer, or
+ * -ENODATA if the stream is finalized.
+ */
+int lttng_ust_ctl_snapshot_swap(struct lttng_ust_ctl_consumer_stream *stream);
+int lttng_ust_ctl_snapshot_release(struct lttng_ust_ctl_consumer_stream *stream);
+
 int lttng_ust_ctl_flush_buffer(struct lttng_ust_ctl_consumer_stream *stream,
 		int producer_active);
 /*
@@ -291,6 +423,133 @@ int lttng_ust_ctl_get_packet_size(struct lttng_ust_ctl_consumer_stream *stream,
 int lttng_ust_ctl_get_sequence_number(struct lttng_ust_ctl_consumer_stream *stream,
 		uint64_t *seq);
 
+/*
+ * Hot IDs of the current packet of a channel using the
+ * LTTNG_UST_CTL_CHANNEL_HEADER_COMPACT_HOT_IDS header: compact header
+ * event ID n, below 31, stands for event ID ids[n]. The version changes
+ * when the table of the channel changes. Returns -ENODATA if the packet
+ * has no table, in which case all its events use the extended header.
+ */
+#define LTTNG_UST_CTL_NR_HOT_IDS	31
+
+int lttng_ust_ctl_get_hot_ids(struct lttng_ust_ctl_consumer_stream *stream,
+		uint32_t *version, uint32_t ids[LTTNG_UST_CTL_NR_HOT_IDS]);
+
+/*
+ * Check the content of the current packet against the CRC32C computed
+ * by the application when it delivered the packet. Returns 0 if the
+ * packet is intact, -EBADMSG if it was torn or overwritten, and -ENODATA
+ * if the application did not checksum it (see LTTNG_UST_PACKET_CHECKSUM).
+ */
+int lttng_ust_ctl_validate_packet(struct lttng_ust_ctl_consumer_stream *stream);
+
+/*
+ * Live statistics of a stream, updated by the application while it
+ * traces and readable at any time, without get/put. The application
+ * updates them without atomic operations, so they can miss a few
+ * updates when several threads write into the same stream concurrently.
+ */
+#define LTTNG_UST_CTL_STREAM_STATS_PADDING	60
+struct lttng_ust_ctl_stream_stats {
+	uint64_t records_written;	/* Records committed */
+	uint64_t bytes_written;		/* Bytes of the committed records */
+	uint64_t reserve_slow;		/* Reservations taking the slow path */
+	uint64_t switches;		/* Sub-buffers closed */
+	uint64_t blocking_retries;	/* Waits of blocking reservations */
+	uint64_t records_lost_full;	/* Discarded, buffer full */
+	uint64_t records_lost_wrap;	/* Discarded, nested wrap-around */
+	uint64_t records_lost_big;	/* Discarded, larger than a sub-buffer */
+	uint32_t max_nesting;		/* Deepest reservation nesting */
+	char padding[LTTNG_UST_CTL_STREAM_STATS_PADDING];
+};
+
+/*
+ * Returns 0 on success, -ENOSYS if the stream was created by a version
+ * of lttng-ust without live statistics.
+ */
+int lttng_ust_ctl_get_stream_stats(struct lttng_ust_ctl_consumer_stream *stream,
+		struct lttng_ust_ctl_stream_stats *stats);
+
+/*
+ * Reassembly of the records too large for a sub-buffer, which channels
+ * with the lttng_ust_fragment:chunk event enabled write as groups of
+ * chunk events instead of discarding them. The consumer adds the
+ * fields of each chunk event it decodes, from any stream of the
+ * channel, and gets back the payload of the original event once all
+ * its chunks are added. The payload is laid out from an offset aligned
+ * on the largest alignment of the event fields.
+ *
+ * Chunk group IDs are unique within an application: use one reassembly
+ * per application (vpid context) for per-user buffers.
+ */
+struct lttng_ust_ctl_fragment_reassembly;
+
+struct lttng_ust_ctl_fragment_record {
+	uint64_t id;			/* Chunk group ID */
+	uint32_t event_id;		/* Channel event ID of the record */
+	uint64_t len;			/* Length of the payload */
+	void *payload;			/* Payload, to release with free() */
+};
+
+/*
+ * Incomplete groups are dropped, oldest first, when adding a new one
+ * would exceed @max_pending_len bytes of pending payload, as their
+ * missing chunks were most likely discarded.
+ */
+struct lttng_ust_ctl_fragment_reassembly *
+	lttng_ust_ctl_fragment_reassembly_create(uint64_t max_pending_len);
+
+void lttng_ust_ctl_fragment_reassembly_destroy(
+		struct lttng_ust_ctl_fragment_reassembly *reassembly);
+
+/*
+ * Add the chunk holding @len bytes of @data at @offset of the payload of
+ * the group @id. Returns 1 and fills @record when the chunk completes
+ * its group, 0 while chunks are missing, -EINVAL if the chunk does not
+ * match its group, -EEXIST if it overlaps a chunk already added to its
+ * group, which is left unchanged, -E2BIG if the payload exceeds the
+ * pending limit.
+ */
+int lttng_ust_ctl_fragment_add_chunk(
+		struct lttng_ust_ctl_fragment_reassembly *reassembly,
+		uint64_t id, uint32_t event_id, uint64_t offset,
+		uint64_t total_len, const void *data, size_t len,
+		struct lttng_ust_ctl_fragment_record *record);
+
+/* Number of incomplete groups dropped so far. */
+int lttng_ust_ctl_fragment_get_dropped(
+		struct lttng_ust_ctl_fragment_reassembly *reassembly,
+		uint64_t *dropped);
+
+/*
+ * Blob arena of an application, holding the payloads of its
+ * lttng_ust_field_blob() fields, which are recorded as the unsigned
+ * 64-bit integer fields <field>_length, <field>_offset,
+ * <field>_generation and <field>_arena_id. The arena is named after the
+ * PID of the application and unlinked when the application exits: open
+ * it while the application runs, for instance when it registers, and
+ * keep it open until its records are consumed.
+ */
+struct lttng_ust_ctl_blob_arena;
+
+/* Returns 0, or -ENOENT if the application has no blob arena. */
+int lttng_ust_ctl_blob_arena_open(pid_t pid,
+		struct lttng_ust_ctl_blob_arena **arena);
+
+void lttng_ust_ctl_blob_arena_close(struct lttng_ust_ctl_blob_arena *arena);
+
+/*
+ * Copy the @length bytes of the payload referenced by @arena_id,
+ * @offset and @generation into @dst. Returns 0, -ENOENT if the payload
+ * was not copied into the arena, -EINVAL for an invalid reference, or
+ * -ESTALE if the payload was overwritten before being read, or if
+ * @arena_id is not the ID of @arena: the arena of another process which
+ * had the same PID.
+ */
+int lttng_ust_ctl_blob_read(struct lttng_ust_ctl_blob_arena *arena,
+		uint64_t arena_id, uint64_t offset, uint64_t length,
+		uint64_t generation, void *dst);
+
 /*
  * Getter returning state invariant for the stream, which can be used
  * without "get" operation.
@@ -321,6 +580,74 @@ void lttng_ust_ctl_packet_destroy(struct lttng_ust_ctl_consumer_packet *packet);
 int lttng_ust_ctl_packet_get_buffer(struct lttng_ust_ctl_consumer_packet *packet, void **buffer,
 		uint64_t *packet_length, uint64_t *packet_length_padded);
 
+/*
+ * Packet compression
+ */
+
+enum lttng_ust_ctl_compression {
+	LTTNG_UST_CTL_COMPRESSION_NONE = 0,
+	LTTNG_UST_CTL_COMPRESSION_LZ4 = 1,	/* level > 1 selects LZ4HC */
+	LTTNG_UST_CTL_COMPRESSION_ZSTD = 2,
+};
+
+#define LTTNG_UST_CTL_COMPRESSED_PACKET_MAGIC	0x75C0FAC7U
+
+/*
+ * Header preceding each compressed packet. Fields use the byte order of
+ * the traced host, which readers detect from the magic number, as with
+ * the CTF packet header magic.
+ */
+struct lttng_ust_ctl_compressed_packet_header {
+	uint32_t magic;			/* LTTNG_UST_CTL_COMPRESSED_PACKET_MAGIC */
+	uint32_t compression;		/* enum lttng_ust_ctl_compression */
+	uint64_t content_size;		/* Uncompressed packet content (bytes) */
+	uint64_t packet_size;		/* Uncompressed packet, with padding (bytes) */
+	uint64_t compressed_size;	/* Bytes following this header */
+} __attribute__((packed));
+
+/* Returns whether liblttng-ust-ctl was built with this compression. */
+int lttng_ust_ctl_compression_available(enum lttng_ust_ctl_compression compression);
+
+/*
+ * Returns the size of the output buffer needed to compress a packet of
+ * at most @packet_size bytes, header included, or 0 if the compression
+ * is not available.
+ */
+size_t lttng_ust_ctl_compress_bound(enum lttng_ust_ctl_compression compression,
+		size_t packet_size);
+
+/*
+ * Compress the content of the current sub-buffer (between get/put or
+ * get_next/put_next, mmap output only) into @dst, prefixed by a struct
+ * lttng_ust_ctl_compressed_packet_header. @level is passed to the
+ * compressor, 0 selecting its default. Returns 0 and the number of
+ * bytes written to @dst in @len, or a negative errno value: -ENOTSUP
+ * when the compression is not available, -ENOBUFS when @dst is too
+ * small.
+ */
+int lttng_ust_ctl_compress_packet(struct lttng_ust_ctl_consumer_stream *stream,
+		enum lttng_ust_ctl_compression compression, int level,
+		void *dst, size_t dst_len, size_t *len);
+
+/*
+ * Same as lttng_ust_ctl_compress_packet(), for a packet already copied
+ * out of the ring buffer, such as one from
+ * lttng_ust_ctl_packet_get_buffer(): @content_size bytes of @src are
+ * compressed, and decompression pads them up to @packet_size bytes.
+ */
+int lttng_ust_ctl_compress_buffer(enum lttng_ust_ctl_compression compression,
+		int level, const void *src, size_t content_size,
+		size_t packet_size, void *dst, size_t dst_len, size_t *len);
+
+/*
+ * Decompress a packet produced by lttng_ust_ctl_compress_packet() or
+ * lttng_ust_ctl_compress_buffer() into
+ * @dst, restoring its padding. Returns 0 and the packet size in @len,
+ * or a negative errno value.
+ */
+int lttng_ust_ctl_decompress_packet(const void *src, size_t src_len,
+		void *dst, size_t dst_len, size_t *len);
+
 /* returns whether UST has perf counters support. */
 int lttng_ust_ctl_has_perf_counters(void);
 
@@ -339,12 +666,15 @@ enum lttng_ust_ctl_notify_cmd {
 	LTTNG_UST_CTL_NOTIFY_CMD_CHANNEL = 1,
 	LTTNG_UST_CTL_NOTIFY_CMD_ENUM = 2,
 	LTTNG_UST_CTL_NOTIFY_CMD_KEY = 3,
+	LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH = 4,
 };
 
 enum lttng_ust_ctl_channel_header {
 	LTTNG_UST_CTL_CHANNEL_HEADER_UNKNOWN = 0,
 	LTTNG_UST_CTL_CHANNEL_HEADER_COMPACT = 1,
 	LTTNG_UST_CTL_CHANNEL_HEADER_LARGE = 2,
+	LTTNG_UST_CTL_CHANNEL_HEADER_VARINT = 3,
+	LTTNG_UST_CTL_CHANNEL_HEADER_COMPACT_HOT_IDS = 4,
 };
 
 /* event type structures */
@@ -573,6 +903,73 @@ int lttng_ust_ctl_reply_register_event(int sock,
 	uint32_t id,			/* id (input) */
 	int ret_code);			/* return code. 0 ok, negative error */
 
+/* Event of a LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH notification. */
+struct lttng_ust_ctl_event_registration {
+	int session_objd;		/* session descriptor */
+	int channel_objd;		/* channel descriptor */
+	char event_name[LTTNG_UST_ABI_SYM_NAME_LEN];
+	int loglevel;
+	char *signature;
+	size_t nr_fields;
+	struct lttng_ust_ctl_field *fields;
+	char *model_emf_uri;		/* NULL if absent */
+	uint64_t user_token;
+	/*
+	 * Field descriptor id, 0 if none. Events of an application
+	 * with the same nonzero descriptor id have identical fields.
+	 */
+	uint32_t fields_desc_id;
+};
+
+/*
+ * Field descriptors received from an application for which
+ * lttng_ust_ctl_set_notify_features() enabled
+ * LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP. One cache per notify
+ * socket, to be created again whenever the feature is enabled.
+ */
+struct lttng_ust_ctl_notify_fields_cache;
+
+struct lttng_ust_ctl_notify_fields_cache *lttng_ust_ctl_create_notify_fields_cache(void);
+void lttng_ust_ctl_destroy_notify_fields_cache(struct lttng_ust_ctl_notify_fields_cache *cache);
+
+/*
+ * Receive a LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH notification: the
+ * registration of *nr_events events. On success, the *events array, as
+ * well as the signature, fields and model_emf_uri of each of its
+ * entries, are dynamically allocated and must be free(3)'d by the
+ * caller. Fields sent by reference are resolved through fields_cache,
+ * which is NULL unless LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP is
+ * enabled. The field descriptors defined by the batch are only kept in
+ * fields_cache once lttng_ust_ctl_reply_register_event_batch() sent
+ * the reply to it.
+ *
+ * Batches are only sent by applications for which
+ * lttng_ust_ctl_set_notify_features() enabled
+ * LTTNG_UST_ABI_NOTIFY_FEATURE_EVENT_BATCH.
+ *
+ * Returns 0 on success, negative UST or system error value on error.
+ */
+int lttng_ust_ctl_recv_register_event_batch(int sock,
+	struct lttng_ust_ctl_notify_fields_cache *fields_cache,
+	struct lttng_ust_ctl_event_registration **events,
+	size_t *nr_events);
+
+/*
+ * Reply to a LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH notification with
+ * the id and return code (0 ok, negative error) of each event, in the
+ * order they were received. fields_cache is the one passed to
+ * lttng_ust_ctl_recv_register_event_batch(): the field descriptors
+ * defined by the batch are kept if the reply is sent, else forgotten,
+ * as the application does.
+ *
+ * Returns 0 on success, negative error value on error.
+ */
+int lttng_ust_ctl_reply_register_event_batch(int sock,
+	struct lttng_ust_ctl_notify_fields_cache *fields_cache,
+	const uint32_t *ids,
+	const int *ret_codes,
+	size_t nr_events);
+
 #ifdef CONFIG_LTTNG_UST_EXPERIMENTAL_COUNTER
 /*
  * Returns 0 on success, negative UST or system error value on error.
@@ -704,6 +704,32 @@ void lttng_ust_probe_unregister(struct lttng_ust_registered_probe *reg_probe);
  */
 void lttng_ust_context_procname_reset(void);
 
+/*
+ * Reference to a payload copied into the blob arena of the process,
+ * written in place of the payload by the lttng_ust_field_blob() fields.
+ * A zero @generation means the payload is not in the arena: it is
+ * disabled, or the payload is larger than it. @arena_id identifies the
+ * arena instance, distinct from that of a previous process with the
+ * same PID.
+ *
+ * IMPORTANT: this structure is part of the ABI between the probe and
+ * UST: it is written as is into the event records.
+ */
+struct lttng_ust_blob_ref {
+	uint64_t length;
+	uint64_t offset;
+	uint64_t generation;
+	uint64_t arena_id;
+};
+
+/*
+ * Copy @len bytes from @src into the blob arena of the process and fill
+ * @ref. Never blocks: the oldest payloads are overwritten once the arena
+ * wraps.
+ */
+void lttng_ust_blob_write(const void *src, size_t len,
+		struct lttng_ust_blob_ref *ref);
+
 static inline
 struct lttng_ust_channel_common *lttng_ust_get_chan_common_from_event_common(
 		struct lttng_ust_event_common *event)
@@ -43,6 +43,9 @@
 #undef lttng_ust__field_string
 #define lttng_ust__field_string(_item, _src, _nowrite)
 
+#undef lttng_ust__field_blob
+#define lttng_ust__field_blob(_item, _src, _len, _nowrite)
+
 #undef lttng_ust__field_unused
 #define lttng_ust__field_unused(_src)
 
@@ -98,6 +101,9 @@
 #undef lttng_ust_field_string
 #define lttng_ust_field_string(_item, _src)
 
+#undef lttng_ust_field_blob
+#define lttng_ust_field_blob(_item, _src, _len)
+
 #undef lttng_ust_field_unused
 #define lttng_ust_field_unused(_src)
 
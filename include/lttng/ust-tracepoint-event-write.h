@@ -76,6 +76,10 @@
 #define lttng_ust_field_string(_item, _src)					\
 	lttng_ust__field_string(_item, _src, 0)
 
+#undef lttng_ust_field_blob
+#define lttng_ust_field_blob(_item, _src, _len)				\
+	lttng_ust__field_blob(_item, _src, _len, 0)
+
 #undef lttng_ust_field_unused
 #define lttng_ust_field_unused(_src)					\
 	lttng_ust__field_unused(_src)
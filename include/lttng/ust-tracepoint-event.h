@@ -96,6 +96,12 @@
 /* Helpers */
 #define LTTNG_UST__TP_ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
 
+/*
+ * Largest payload image filled on the probe stack. Larger fixed-size
+ * payloads are written field by field rather than copied twice.
+ */
+#define LTTNG_UST__TP_IMAGE_MAX_LEN	256
+
 #define lttng_ust__tp_max_t(type, x, y)			\
 	({						\
 		type lttng_ust__max1 = (x);            	\
@@ -478,6 +484,37 @@ extern const struct lttng_ust_probe_desc LTTNG_UST__TP_COMBINE_TOKENS(lttng_ust_
 		.nofilter = 0,					\
 	}),
 
+#undef lttng_ust__field_blob
+#define lttng_ust__field_blob(_item, _src, _len, _nowrite)		\
+	LTTNG_UST_COMPOUND_LITERAL(const struct lttng_ust_event_field, { \
+		.struct_size = sizeof(struct lttng_ust_event_field), \
+		.name = #_item "_length",			\
+		.type = lttng_ust_type_integer_define(uint64_t, LTTNG_UST_BYTE_ORDER, 10), \
+		.nowrite = _nowrite,				\
+		.nofilter = 0,					\
+	}),							\
+	LTTNG_UST_COMPOUND_LITERAL(const struct lttng_ust_event_field, { \
+		.struct_size = sizeof(struct lttng_ust_event_field), \
+		.name = #_item "_offset",			\
+		.type = lttng_ust_type_integer_define(uint64_t, LTTNG_UST_BYTE_ORDER, 10), \
+		.nowrite = _nowrite,				\
+		.nofilter = 1,					\
+	}),							\
+	LTTNG_UST_COMPOUND_LITERAL(const struct lttng_ust_event_field, { \
+		.struct_size = sizeof(struct lttng_ust_event_field), \
+		.name = #_item "_generation",			\
+		.type = lttng_ust_type_integer_define(uint64_t, LTTNG_UST_BYTE_ORDER, 10), \
+		.nowrite = _nowrite,				\
+		.nofilter = 1,					\
+	}),							\
+	LTTNG_UST_COMPOUND_LITERAL(const struct lttng_ust_event_field, { \
+		.struct_size = sizeof(struct lttng_ust_event_field), \
+		.name = #_item "_arena_id",			\
+		.type = lttng_ust_type_integer_define(uint64_t, LTTNG_UST_BYTE_ORDER, 10), \
+		.nowrite = _nowrite,				\
+		.nofilter = 1,					\
+	}),
+
 #undef lttng_ust__field_unused
 #define lttng_ust__field_unused(_src)
 
@@ -577,6 +614,15 @@ extern const struct lttng_ust_probe_desc LTTNG_UST__TP_COMBINE_TOKENS(lttng_ust_
 	__event_len += __dynamic_len[__dynamic_len_idx++] =		       \
 		strlen((_src) ? (_src) : LTTNG_UST__NULL_STRING) + 1;
 
+#undef lttng_ust__field_blob
+#define lttng_ust__field_blob(_item, _src, _len, _nowrite)			       \
+	if (0)									 \
+		(void) (_src);	/* Unused */					 \
+	if (0)									 \
+		(void) (_len);	/* Unused */					 \
+	__event_len += lttng_ust_ring_buffer_align(__event_len, lttng_ust_rb_alignof(uint64_t)); \
+	__event_len += sizeof(struct lttng_ust_blob_ref);
+
 #undef lttng_ust__field_unused
 #define lttng_ust__field_unused(_src)							\
 	if (0)									\
@@ -746,6 +792,16 @@ size_t lttng_ust__event_get_size__##_provider##___##_name(			      \
 		__stack_data += sizeof(void *);				       \
 	}
 
+#undef lttng_ust__field_blob
+#define lttng_ust__field_blob(_item, _src, _len, _nowrite)			       \
+	if (0)								       \
+		(void) (_src);	/* Unused */				       \
+	{								       \
+		uint64_t __ctf_tmp_uint64 = (uint64_t) (_len);		       \
+		memcpy(__stack_data, &__ctf_tmp_uint64, sizeof(uint64_t));     \
+		__stack_data += sizeof(int64_t);			       \
+	}
+
 #undef lttng_ust__field_unused
 #define lttng_ust__field_unused(_src)							\
 	if (0)									\
@@ -821,6 +877,14 @@ void lttng_ust__event_prepare_interpreter_stack__##_provider##___##_name(char *_
 	if (0)									\
 		(void) (_src);	/* Unused */
 
+#undef lttng_ust__field_blob
+#define lttng_ust__field_blob(_item, _src, _len, _nowrite)			       \
+	if (0)								       \
+		(void) (_src);	/* Unused */				       \
+	if (0)								       \
+		(void) (_len);	/* Unused */				       \
+	__event_align = lttng_ust__tp_max_t(size_t, __event_align, lttng_ust_rb_alignof(uint64_t));
+
 #undef lttng_ust__field_unused
 #define lttng_ust__field_unused(_src)							\
 	if (0)									\
@@ -851,6 +915,304 @@ size_t lttng_ust__event_get_align__##_provider##___##_name(LTTNG_UST__TP_ARGS_PR
 
 #include LTTNG_UST_TRACEPOINT_INCLUDE
 
+/*
+ * Stage 4.1 of tracepoint event generation.
+ *
+ * Create the payload image of each event: a structure laid out exactly
+ * like the event payload in the ring buffer. Each field is a byte array
+ * aligned on the ring buffer alignment of its type, within a packed
+ * structure, so the offsets match the ones computed by
+ * lttng_ust__event_get_size__*() on every architecture and alignment
+ * configuration. Variable-size fields have no member: the image is only
+ * used for events without any.
+ */
+
+/* Reset all macros within LTTNG_UST_TRACEPOINT_EVENT */
+#include <lttng/ust-tracepoint-event-reset.h>
+#include <lttng/ust-tracepoint-event-write.h>
+
+#undef lttng_ust__field_integer_ext
+#define lttng_ust__field_integer_ext(_type, _item, _src, _byte_order, _base, _nowrite) \
+	char lttng_ust__image_##_item[sizeof(_type)]			       \
+		__attribute__((aligned(lttng_ust_rb_alignof(_type))));
+
+#undef lttng_ust__field_float
+#define lttng_ust__field_float(_type, _item, _src, _nowrite)			       \
+	char lttng_ust__image_##_item[sizeof(_type)]			       \
+		__attribute__((aligned(lttng_ust_rb_alignof(_type))));
+
+#undef lttng_ust__field_array_encoded
+#define lttng_ust__field_array_encoded(_type, _item, _src, _byte_order, _length,	       \
+			_encoding, _nowrite, _elem_type_base)		       \
+	char lttng_ust__image_##_item[sizeof(_type) * (_length)]		       \
+		__attribute__((aligned(lttng_ust_rb_alignof(_type))));
+
+#undef lttng_ust__field_enum
+#define lttng_ust__field_enum(_provider, _name, _type, _item, _src, _nowrite)		\
+	lttng_ust__field_integer_ext(_type, _item, _src, LTTNG_UST_BYTE_ORDER, 10, _nowrite)
+
+#undef LTTNG_UST_TP_FIELDS
+#define LTTNG_UST_TP_FIELDS(...) __VA_ARGS__
+
+#undef LTTNG_UST__TRACEPOINT_EVENT_CLASS
+#define LTTNG_UST__TRACEPOINT_EVENT_CLASS(_provider, _name, _args, _fields)	      \
+struct lttng_ust__event_image__##_provider##___##_name {			      \
+	_fields								      \
+	char lttng_ust__image_end;	/* C99 forbids empty structures. */	      \
+} __attribute__((packed));
+
+#include LTTNG_UST_TRACEPOINT_INCLUDE
+
+/*
+ * Stage 4.2 of tracepoint event generation.
+ *
+ * Create a compile-time constant telling whether every field written by
+ * the event has a static size, in which case the probe fills the payload
+ * image on the stack and writes it with a single event_write().
+ */
+
+/* Reset all macros within LTTNG_UST_TRACEPOINT_EVENT */
+#include <lttng/ust-tracepoint-event-reset.h>
+#include <lttng/ust-tracepoint-event-write.h>
+
+#undef lttng_ust__field_integer_ext
+#define lttng_ust__field_integer_ext(_type, _item, _src, _byte_order, _base, _nowrite) \
+	&& 1
+
+#undef lttng_ust__field_float
+#define lttng_ust__field_float(_type, _item, _src, _nowrite)			       \
+	&& 1
+
+#undef lttng_ust__field_array_encoded
+#define lttng_ust__field_array_encoded(_type, _item, _src, _byte_order, _length,	       \
+			_encoding, _nowrite, _elem_type_base)		       \
+	&& (lttng_ust_string_encoding_##_encoding == lttng_ust_string_encoding_none)
+
+#undef lttng_ust__field_sequence_encoded
+#define lttng_ust__field_sequence_encoded(_type, _item, _src, _byte_order, _length_type,   \
+			_src_length, _encoding, _nowrite, _elem_type_base)     \
+	&& 0
+
+#undef lttng_ust__field_string
+#define lttng_ust__field_string(_item, _src, _nowrite)				       \
+	&& 0
+
+#undef lttng_ust__field_blob
+#define lttng_ust__field_blob(_item, _src, _len, _nowrite)			       \
+	&& 0
+
+#undef lttng_ust__field_enum
+#define lttng_ust__field_enum(_provider, _name, _type, _item, _src, _nowrite)		\
+	&& 1
+
+#undef LTTNG_UST_TP_FIELDS
+#define LTTNG_UST_TP_FIELDS(...) __VA_ARGS__
+
+#undef LTTNG_UST__TRACEPOINT_EVENT_CLASS
+#define LTTNG_UST__TRACEPOINT_EVENT_CLASS(_provider, _name, _args, _fields)	      \
+enum {									      \
+	lttng_ust__event_fixed_size__##_provider##___##_name =		      \
+		(1 _fields)						      \
+		&& sizeof(struct lttng_ust__event_image__##_provider##___##_name) \
+			<= LTTNG_UST__TP_IMAGE_MAX_LEN				      \
+};
+
+#include LTTNG_UST_TRACEPOINT_INCLUDE
+
+/*
+ * Stage 4.3 of tracepoint event generation.
+ *
+ * Create static inline function that fills the payload image of events
+ * with only fixed-size fields.
+ */
+
+/* Reset all macros within LTTNG_UST_TRACEPOINT_EVENT */
+#include <lttng/ust-tracepoint-event-reset.h>
+#include <lttng/ust-tracepoint-event-write.h>
+
+#undef lttng_ust__field_integer_ext
+#define lttng_ust__field_integer_ext(_type, _item, _src, _byte_order, _base, _nowrite) \
+	{								       \
+		_type __tmp = (_src);					       \
+		memcpy(__image->lttng_ust__image_##_item, &__tmp, sizeof(__tmp)); \
+	}
+
+#undef lttng_ust__field_float
+#define lttng_ust__field_float(_type, _item, _src, _nowrite)			       \
+	{								       \
+		_type __tmp = (_src);					       \
+		memcpy(__image->lttng_ust__image_##_item, &__tmp, sizeof(__tmp)); \
+	}
+
+#undef lttng_ust__field_array_encoded
+#define lttng_ust__field_array_encoded(_type, _item, _src, _byte_order, _length,	       \
+			_encoding, _nowrite, _elem_type_base)		       \
+	if (lttng_ust_string_encoding_##_encoding == lttng_ust_string_encoding_none) \
+		memcpy(__image->lttng_ust__image_##_item, _src, sizeof(_type) * (_length));
+
+#undef lttng_ust__field_sequence_encoded
+#define lttng_ust__field_sequence_encoded(_type, _item, _src, _byte_order, _length_type,   \
+			_src_length, _encoding, _nowrite, _elem_type_base)     \
+	if (0)								       \
+		(void) (_src);	/* Unused */				       \
+	if (0)								       \
+		(void) (_src_length);	/* Unused */
+
+#undef lttng_ust__field_string
+#define lttng_ust__field_string(_item, _src, _nowrite)				       \
+	if (0)								       \
+		(void) (_src);	/* Unused */
+
+#undef lttng_ust__field_blob
+#define lttng_ust__field_blob(_item, _src, _len, _nowrite)			       \
+	if (0)								       \
+		(void) (_src);	/* Unused */				       \
+	if (0)								       \
+		(void) (_len);	/* Unused */
+
+#undef lttng_ust__field_unused
+#define lttng_ust__field_unused(_src)							\
+	if (0)									\
+		(void) (_src);	/* Unused */
+
+#undef lttng_ust__field_enum
+#define lttng_ust__field_enum(_provider, _name, _type, _item, _src, _nowrite)		\
+	lttng_ust__field_integer_ext(_type, _item, _src, LTTNG_UST_BYTE_ORDER, 10, _nowrite)
+
+#undef LTTNG_UST_TP_ARGS
+#define LTTNG_UST_TP_ARGS(...) __VA_ARGS__
+
+#undef LTTNG_UST_TP_FIELDS
+#define LTTNG_UST_TP_FIELDS(...) __VA_ARGS__
+
+#undef LTTNG_UST__TRACEPOINT_EVENT_CLASS
+#define LTTNG_UST__TRACEPOINT_EVENT_CLASS(_provider, _name, _args, _fields)	      \
+static inline								      \
+void lttng_ust__event_fill_image__##_provider##___##_name(			      \
+		struct lttng_ust__event_image__##_provider##___##_name *__image, \
+		LTTNG_UST__TP_ARGS_DATA_PROTO(_args))			      \
+	lttng_ust_notrace;						      \
+static inline								      \
+void lttng_ust__event_fill_image__##_provider##___##_name(			      \
+		struct lttng_ust__event_image__##_provider##___##_name *__image, \
+		LTTNG_UST__TP_ARGS_DATA_PROTO(_args))			      \
+{									      \
+	if (0)								      \
+		(void) __tp_data;	/* don't warn if unused */	      \
+	/* Don't leak stack contents through the alignment padding. */	      \
+	memset(__image, 0, sizeof(*__image));				      \
+	_fields								      \
+}
+
+#include LTTNG_UST_TRACEPOINT_INCLUDE
+
+/*
+ * Stage 4.4 of tracepoint event generation.
+ *
+ * Create a compile-time constant holding the number of blob fields of
+ * the event.
+ */
+
+/* Reset all macros within LTTNG_UST_TRACEPOINT_EVENT */
+#include <lttng/ust-tracepoint-event-reset.h>
+#include <lttng/ust-tracepoint-event-write.h>
+
+#undef lttng_ust__field_blob
+#define lttng_ust__field_blob(_item, _src, _len, _nowrite)			       \
+	+ 1
+
+#undef LTTNG_UST_TP_FIELDS
+#define LTTNG_UST_TP_FIELDS(...) __VA_ARGS__
+
+#undef LTTNG_UST__TRACEPOINT_EVENT_CLASS
+#define LTTNG_UST__TRACEPOINT_EVENT_CLASS(_provider, _name, _args, _fields)	      \
+enum {									      \
+	lttng_ust__event_nr_blobs__##_provider##___##_name = (0 _fields)	      \
+};
+
+#include LTTNG_UST_TRACEPOINT_INCLUDE
+
+/*
+ * Stage 4.5 of tracepoint event generation.
+ *
+ * Create static inline function that copies the payloads of the blob
+ * fields into the blob arena, before the record is reserved, so only
+ * their references are written within the reserve/commit window.
+ */
+
+/* Reset all macros within LTTNG_UST_TRACEPOINT_EVENT */
+#include <lttng/ust-tracepoint-event-reset.h>
+#include <lttng/ust-tracepoint-event-write.h>
+
+#undef lttng_ust__field_integer_ext
+#define lttng_ust__field_integer_ext(_type, _item, _src, _byte_order, _base, _nowrite) \
+	if (0)								       \
+		(void) (_src);	/* Unused */
+
+#undef lttng_ust__field_float
+#define lttng_ust__field_float(_type, _item, _src, _nowrite)			       \
+	if (0)								       \
+		(void) (_src);	/* Unused */
+
+#undef lttng_ust__field_array_encoded
+#define lttng_ust__field_array_encoded(_type, _item, _src, _byte_order, _length,	       \
+			_encoding, _nowrite, _elem_type_base)		       \
+	if (0)								       \
+		(void) (_src);	/* Unused */
+
+#undef lttng_ust__field_sequence_encoded
+#define lttng_ust__field_sequence_encoded(_type, _item, _src, _byte_order, _length_type,   \
+			_src_length, _encoding, _nowrite, _elem_type_base)     \
+	if (0)								       \
+		(void) (_src);	/* Unused */				       \
+	if (0)								       \
+		(void) (_src_length);	/* Unused */
+
+#undef lttng_ust__field_string
+#define lttng_ust__field_string(_item, _src, _nowrite)				       \
+	if (0)								       \
+		(void) (_src);	/* Unused */
+
+#undef lttng_ust__field_blob
+#define lttng_ust__field_blob(_item, _src, _len, _nowrite)			       \
+	lttng_ust_blob_write(_src, _len, __blob_refs++);
+
+#undef lttng_ust__field_unused
+#define lttng_ust__field_unused(_src)							\
+	if (0)									\
+		(void) (_src);	/* Unused */
+
+#undef lttng_ust__field_enum
+#define lttng_ust__field_enum(_provider, _name, _type, _item, _src, _nowrite)		\
+	lttng_ust__field_integer_ext(_type, _item, _src, LTTNG_UST_BYTE_ORDER, 10, _nowrite)
+
+#undef LTTNG_UST_TP_ARGS
+#define LTTNG_UST_TP_ARGS(...) __VA_ARGS__
+
+#undef LTTNG_UST_TP_FIELDS
+#define LTTNG_UST_TP_FIELDS(...) __VA_ARGS__
+
+#undef LTTNG_UST__TRACEPOINT_EVENT_CLASS
+#define LTTNG_UST__TRACEPOINT_EVENT_CLASS(_provider, _name, _args, _fields)	      \
+static inline								      \
+void lttng_ust__event_copy_blobs__##_provider##___##_name(			      \
+		struct lttng_ust_blob_ref *__blob_refs,			      \
+		LTTNG_UST__TP_ARGS_DATA_PROTO(_args))			      \
+	lttng_ust_notrace;						      \
+static inline								      \
+void lttng_ust__event_copy_blobs__##_provider##___##_name(			      \
+		struct lttng_ust_blob_ref *__blob_refs,			      \
+		LTTNG_UST__TP_ARGS_DATA_PROTO(_args))			      \
+{									      \
+	if (0) {							      \
+		(void) __tp_data;	/* don't warn if unused */	      \
+		(void) __blob_refs;					      \
+	}								      \
+	_fields								      \
+}
+
+#include LTTNG_UST_TRACEPOINT_INCLUDE
+
 
 /*
  * Stage 5 of tracepoint event generation.
@@ -907,6 +1269,11 @@ size_t lttng_ust__event_get_align__##_provider##___##_name(LTTNG_UST__TP_ARGS_PR
 			lttng_ust__get_dynamic_len(dest));			\
 	}
 
+#undef lttng_ust__field_blob
+#define lttng_ust__field_blob(_item, _src, _len, _nowrite)			\
+	__chan->ops->event_write(&__ctx, &__blob_refs[__blob_idx++],		\
+		sizeof(struct lttng_ust_blob_ref), lttng_ust_rb_alignof(uint64_t));
+
 #undef lttng_ust__field_unused
 #define lttng_ust__field_unused(_src)
 
@@ -1015,7 +1382,14 @@ void lttng_ust__event_probe__##_provider##___##_name(LTTNG_UST__TP_ARGS_DATA_PRO
 		struct lttng_ust_event_recorder *__event_recorder = (struct lttng_ust_event_recorder *) __event->child; \
 		struct lttng_ust_channel_buffer *__chan = __event_recorder->chan; \
 		struct lttng_ust_ring_buffer_ctx __ctx;			      \
+		struct lttng_ust_blob_ref __blob_refs[lttng_ust__event_nr_blobs__##_provider##___##_name + 1]; \
+		size_t __blob_idx = 0;					      \
 									      \
+		if (0)							      \
+			(void) __blob_idx;	/* don't warn if unused */    \
+		if (lttng_ust__event_nr_blobs__##_provider##___##_name)	      \
+			lttng_ust__event_copy_blobs__##_provider##___##_name(__blob_refs, \
+				LTTNG_UST__TP_ARGS_DATA_VAR(_args));	      \
 		__event_len = lttng_ust__event_get_size__##_provider##___##_name(__stackvar.__dynamic_len, \
 			 LTTNG_UST__TP_ARGS_DATA_VAR(_args));			      \
 		__event_align = lttng_ust__event_get_align__##_provider##___##_name(LTTNG_UST__TP_ARGS_VAR(_args)); \
@@ -1024,7 +1398,15 @@ void lttng_ust__event_probe__##_provider##___##_name(LTTNG_UST__TP_ARGS_DATA_PRO
 		__ret = __chan->ops->event_reserve(&__ctx);		      \
 		if (__ret < 0)						      \
 			return;						      \
-		_fields							      \
+		if (lttng_ust__event_fixed_size__##_provider##___##_name) {   \
+			struct lttng_ust__event_image__##_provider##___##_name __image; \
+									      \
+			lttng_ust__event_fill_image__##_provider##___##_name(&__image, \
+				LTTNG_UST__TP_ARGS_DATA_VAR(_args));	      \
+			__chan->ops->event_write(&__ctx, &__image, __event_len, __event_align); \
+		} else {						      \
+			_fields						      \
+		}							      \
 		__chan->ops->event_commit(&__ctx);			      \
 		break;							      \
 	}								      \
@@ -0,0 +1,96 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Process-shared futex compatibility layer.
+ *
+ * Wait and wake operations on 32-bit words located in memory mappings
+ * shared between the traced application and the consumer, e.g. ring
+ * buffer shared memory. Unlike the futex wrappers of liblttng-ust, there
+ * is no in-process fallback: callers must handle -ENOSYS.
+ */
+
+#ifndef _UST_COMMON_COMPAT_SHARED_FUTEX_H
+#define _UST_COMMON_COMPAT_SHARED_FUTEX_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__linux__)
+
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#ifdef __NR_futex
+#define LTTNG_UST_HAVE_SHARED_FUTEX
+#endif
+
+#elif defined(__FreeBSD__)
+
+#include <sys/types.h>
+#include <sys/umtx.h>
+
+#define LTTNG_UST_HAVE_SHARED_FUTEX
+
+#endif
+
+/*
+ * Wait until *uaddr differs from val, the relative timeout expires
+ * (NULL: wait forever) or a wakeup is received. Returns 0 on wakeup or
+ * if *uaddr already differs from val, else a negative errno value
+ * (-ETIMEDOUT, -EINTR, -ENOSYS).
+ */
+static inline int lttng_ust_shared_futex_wait(int32_t *uaddr, int32_t val,
+		const struct timespec *timeout)
+{
+#if defined(LTTNG_UST_HAVE_SHARED_FUTEX) && defined(__linux__)
+	/* FUTEX_WAIT, process-shared. */
+	if (syscall(__NR_futex, uaddr, 0, val, timeout, NULL, 0) < 0) {
+		if (errno == EAGAIN)
+			return 0;
+		return -errno;
+	}
+	return 0;
+#elif defined(LTTNG_UST_HAVE_SHARED_FUTEX)
+	if (_umtx_op(uaddr, UMTX_OP_WAIT_UINT, (uint32_t) val, NULL,
+			(void *) timeout) < 0)
+		return -errno;
+	return 0;
+#else
+	(void) uaddr;
+	(void) val;
+	(void) timeout;
+	return -ENOSYS;
+#endif
+}
+
+/*
+ * Wake up at most nr_wake waiters on uaddr. Returns the number of
+ * waiters woken up on Linux, 0 on FreeBSD, which does not report it, or
+ * a negative errno value.
+ */
+static inline int lttng_ust_shared_futex_wake(int32_t *uaddr, int32_t nr_wake)
+{
+#if defined(LTTNG_UST_HAVE_SHARED_FUTEX) && defined(__linux__)
+	long ret;
+
+	/* FUTEX_WAKE, process-shared. */
+	ret = syscall(__NR_futex, uaddr, 1, nr_wake, NULL, NULL, 0);
+	if (ret < 0)
+		return -errno;
+	return (int) ret;
+#elif defined(LTTNG_UST_HAVE_SHARED_FUTEX)
+	if (_umtx_op(uaddr, UMTX_OP_WAKE, (uint32_t) nr_wake, NULL, NULL) < 0)
+		return -errno;
+	/* The count of woken up waiters is not reported. */
+	return 0;
+#else
+	(void) uaddr;
+	(void) nr_wake;
+	return -ENOSYS;
+#endif
+}
+
+#endif /* _UST_COMMON_COMPAT_SHARED_FUTEX_H */
@@ -0,0 +1,176 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ */
+
+#define _LGPL_SOURCE
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <urcu/compiler.h>
+#include <urcu/system.h>
+
+#include <lttng/ust-endian.h>
+
+#include "common/crc32c.h"
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+/* Reflected CRC32C polynomial. */
+#define CRC32C_POLY	0x82F63B78U
+
+typedef uint32_t (*crc32c_fn)(uint32_t crc, const uint8_t *p, size_t len);
+
+/* Slice-by-8 tables, computed on first use of the software version. */
+static uint32_t crc32c_table[8][256];
+static int crc32c_table_init;
+
+static
+void crc32c_init_table(void)
+{
+	uint32_t crc;
+	unsigned int i, j;
+
+	for (i = 0; i < 256; i++) {
+		crc = i;
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (CRC32C_POLY & -(crc & 1));
+		crc32c_table[0][i] = crc;
+	}
+	for (i = 0; i < 256; i++) {
+		crc = crc32c_table[0][i];
+		for (j = 1; j < 8; j++) {
+			crc = crc32c_table[0][crc & 0xFF] ^ (crc >> 8);
+			crc32c_table[j][i] = crc;
+		}
+	}
+}
+
+static
+uint32_t crc32c_sw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	/*
+	 * Concurrent initializations store the same values, the flag
+	 * only saves recomputing them.
+	 */
+	if (caa_unlikely(!CMM_LOAD_SHARED(crc32c_table_init))) {
+		crc32c_init_table();
+		cmm_smp_wmb();
+		CMM_STORE_SHARED(crc32c_table_init, 1);
+	}
+	cmm_smp_rmb();
+
+	for (; len && ((uintptr_t) p & 7); len--)
+		crc = crc32c_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+	for (; len >= 8; len -= 8, p += 8) {
+		uint32_t lo, hi;
+
+		memcpy(&lo, p, sizeof(lo));
+		memcpy(&hi, p + 4, sizeof(hi));
+#if (LTTNG_UST_BYTE_ORDER == LTTNG_UST_BIG_ENDIAN)
+		lo = __builtin_bswap32(lo);
+		hi = __builtin_bswap32(hi);
+#endif
+		lo ^= crc;
+		crc = crc32c_table[7][lo & 0xFF] ^
+			crc32c_table[6][(lo >> 8) & 0xFF] ^
+			crc32c_table[5][(lo >> 16) & 0xFF] ^
+			crc32c_table[4][lo >> 24] ^
+			crc32c_table[3][hi & 0xFF] ^
+			crc32c_table[2][(hi >> 8) & 0xFF] ^
+			crc32c_table[1][(hi >> 16) & 0xFF] ^
+			crc32c_table[0][hi >> 24];
+	}
+	for (; len; len--)
+		crc = crc32c_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+#if defined(__x86_64__)
+static __attribute__((target("sse4.2")))
+uint32_t crc32c_hw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	uint64_t crc64 = crc;
+
+	for (; len && ((uintptr_t) p & 7); len--)
+		crc64 = __builtin_ia32_crc32qi((uint32_t) crc64, *p++);
+	for (; len >= 8; len -= 8, p += 8) {
+		uint64_t v;
+
+		memcpy(&v, p, sizeof(v));
+		crc64 = __builtin_ia32_crc32di(crc64, v);
+	}
+	for (; len; len--)
+		crc64 = __builtin_ia32_crc32qi((uint32_t) crc64, *p++);
+	return (uint32_t) crc64;
+}
+
+static
+crc32c_fn crc32c_select(void)
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.2"))
+		return crc32c_hw;
+	return crc32c_sw;
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+static
+uint32_t crc32c_hw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	for (; len && ((uintptr_t) p & 7); len--)
+		crc = __crc32cb(crc, *p++);
+	for (; len >= 8; len -= 8, p += 8) {
+		uint64_t v;
+
+		memcpy(&v, p, sizeof(v));
+		crc = __crc32cd(crc, v);
+	}
+	for (; len; len--)
+		crc = __crc32cb(crc, *p++);
+	return crc;
+}
+
+static
+crc32c_fn crc32c_select(void)
+{
+	return crc32c_hw;
+}
+#else
+static
+crc32c_fn crc32c_select(void)
+{
+	return crc32c_sw;
+}
+#endif
+
+static crc32c_fn crc32c_impl;
+
+uint32_t lttng_ust_crc32c(uint32_t crc, const void *buf, size_t len)
+{
+	crc32c_fn fn = CMM_LOAD_SHARED(crc32c_impl);
+
+	if (caa_unlikely(!fn)) {
+		fn = crc32c_select();
+		CMM_STORE_SHARED(crc32c_impl, fn);
+	}
+	return ~fn(~crc, buf, len);
+}
+
+uint32_t lttng_ust_crc32c_sw(uint32_t crc, const void *buf, size_t len)
+{
+	return ~crc32c_sw(~crc, buf, len);
+}
+
+int lttng_ust_crc32c_check_packet(const void *packet, uint64_t content_size,
+		uint64_t min_size, uint64_t max_size, uint32_t crc)
+{
+	if (content_size < min_size || content_size > max_size)
+		return -EBADMSG;
+	if (lttng_ust_crc32c(0, packet, content_size) != crc)
+		return -EBADMSG;
+	return 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ */
+
+#ifndef _UST_COMMON_CRC32C_H
+#define _UST_COMMON_CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Update the CRC32C (Castagnoli) @crc with @len bytes at @buf. Start
+ * with a @crc of 0.
+ *
+ * Uses the SSE 4.2 CRC32 instruction on x86-64 when the processor
+ * supports it, the ARMv8 CRC32 instructions when the library is built
+ * for them, and a table-driven implementation otherwise.
+ */
+uint32_t lttng_ust_crc32c(uint32_t crc, const void *buf, size_t len)
+	__attribute__((visibility("hidden")));
+
+/* Table-driven implementation of lttng_ust_crc32c(), for reference. */
+uint32_t lttng_ust_crc32c_sw(uint32_t crc, const void *buf, size_t len)
+	__attribute__((visibility("hidden")));
+
+/*
+ * Check a packet against the @crc of its content, computed when it was
+ * delivered. @content_size, read from the packet header, is only
+ * trusted within [@min_size, @max_size]: a torn header can hold any
+ * size. Returns 0 if the packet is intact, -EBADMSG otherwise.
+ */
+int lttng_ust_crc32c_check_packet(const void *packet, uint64_t content_size,
+		uint64_t min_size, uint64_t max_size, uint32_t crc)
+	__attribute__((visibility("hidden")));
+
+#endif /* _UST_COMMON_CRC32C_H */
@@ -9,6 +9,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -28,42 +29,66 @@
 #endif
 
 /*
- * Retrieve the nth (where n is the `index` argument) phdr (program
- * header) from the given elf instance.
+ * Copy `len` bytes located at `offset` in the ELF file into `buf`.
+ *
+ * When the file is mapped, the data is copied from the mapping after
+ * checking that the range lies within the file, without any system
+ * call. Otherwise, it is read from the file descriptor.
  *
- * A pointer to the phdr is returned on success, NULL on failure.
+ * Returns 0 on success, -1 on failure.
  */
 static
-struct lttng_ust_elf_phdr *lttng_ust_elf_get_phdr(struct lttng_ust_elf *elf,
-						uint16_t index)
+int lttng_ust_elf_read_at(struct lttng_ust_elf *elf, uint64_t offset,
+		void *buf, size_t len)
 {
-	struct lttng_ust_elf_phdr *phdr = NULL;
-	off_t offset;
-
-	if (!elf) {
-		goto error;
+	if (elf->map) {
+		if (offset > elf->map_len || len > elf->map_len - offset) {
+			return -1;
+		}
+		memcpy(buf, elf->map + offset, len);
+		return 0;
 	}
 
-	if (index >= elf->ehdr->e_phnum) {
-		goto error;
+	if (offset > INT64_MAX) {
+		return -1;
+	}
+	if (lseek(elf->fd, (off_t) offset, SEEK_SET) < 0) {
+		return -1;
 	}
+	if (lttng_ust_read(elf->fd, buf, len) < len) {
+		return -1;
+	}
+	return 0;
+}
 
-	phdr = zmalloc(sizeof(struct lttng_ust_elf_phdr));
-	if (!phdr) {
+/*
+ * Retrieve the nth (where n is the `index` argument) phdr (program
+ * header) from the given elf instance into `phdr`.
+ *
+ * Returns 0 on success, -1 on failure.
+ */
+static
+int lttng_ust_elf_get_phdr(struct lttng_ust_elf *elf, uint16_t index,
+		struct lttng_ust_elf_phdr *phdr)
+{
+	uint64_t offset;
+
+	if (!elf) {
 		goto error;
 	}
 
-	offset = (off_t) elf->ehdr->e_phoff
-			+ (off_t) index * elf->ehdr->e_phentsize;
-	if (lseek(elf->fd, offset, SEEK_SET) < 0) {
+	if (index >= elf->ehdr.e_phnum) {
 		goto error;
 	}
 
+	offset = elf->ehdr.e_phoff
+			+ (uint64_t) index * elf->ehdr.e_phentsize;
+
 	if (is_elf_32_bit(elf)) {
 		Elf32_Phdr elf_phdr;
 
-		if (lttng_ust_read(elf->fd, &elf_phdr, sizeof(elf_phdr))
-				< sizeof(elf_phdr)) {
+		if (lttng_ust_elf_read_at(elf, offset, &elf_phdr,
+				sizeof(elf_phdr))) {
 			goto error;
 		}
 		if (!is_elf_native_endian(elf)) {
@@ -73,8 +98,8 @@ struct lttng_ust_elf_phdr *lttng_ust_elf_get_phdr(struct lttng_ust_elf *elf,
 	} else {
 		Elf64_Phdr elf_phdr;
 
-		if (lttng_ust_read(elf->fd, &elf_phdr, sizeof(elf_phdr))
-				< sizeof(elf_phdr)) {
+		if (lttng_ust_elf_read_at(elf, offset, &elf_phdr,
+				sizeof(elf_phdr))) {
 			goto error;
 		}
 		if (!is_elf_native_endian(elf)) {
@@ -83,50 +108,40 @@ struct lttng_ust_elf_phdr *lttng_ust_elf_get_phdr(struct lttng_ust_elf *elf,
 		copy_phdr(elf_phdr, *phdr);
 	}
 
-	return phdr;
+	return 0;
 
 error:
-	free(phdr);
-	return NULL;
+	return -1;
 }
 
 /*
  * Retrieve the nth (where n is the `index` argument) shdr (section
- * header) from the given elf instance.
+ * header) from the given elf instance into `shdr`.
  *
- * A pointer to the shdr is returned on success, NULL on failure.
+ * Returns 0 on success, -1 on failure.
  */
 static
-struct lttng_ust_elf_shdr *lttng_ust_elf_get_shdr(struct lttng_ust_elf *elf,
-						uint16_t index)
+int lttng_ust_elf_get_shdr(struct lttng_ust_elf *elf, uint16_t index,
+		struct lttng_ust_elf_shdr *shdr)
 {
-	struct lttng_ust_elf_shdr *shdr = NULL;
-	off_t offset;
+	uint64_t offset;
 
 	if (!elf) {
 		goto error;
 	}
 
-	if (index >= elf->ehdr->e_shnum) {
+	if (index >= elf->ehdr.e_shnum) {
 		goto error;
 	}
 
-	shdr = zmalloc(sizeof(struct lttng_ust_elf_shdr));
-	if (!shdr) {
-		goto error;
-	}
-
-	offset = (off_t) elf->ehdr->e_shoff
-			+ (off_t) index * elf->ehdr->e_shentsize;
-	if (lseek(elf->fd, offset, SEEK_SET) < 0) {
-		goto error;
-	}
+	offset = elf->ehdr.e_shoff
+			+ (uint64_t) index * elf->ehdr.e_shentsize;
 
 	if (is_elf_32_bit(elf)) {
 		Elf32_Shdr elf_shdr;
 
-		if (lttng_ust_read(elf->fd, &elf_shdr, sizeof(elf_shdr))
-				< sizeof(elf_shdr)) {
+		if (lttng_ust_elf_read_at(elf, offset, &elf_shdr,
+				sizeof(elf_shdr))) {
 			goto error;
 		}
 		if (!is_elf_native_endian(elf)) {
@@ -136,8 +151,8 @@ struct lttng_ust_elf_shdr *lttng_ust_elf_get_shdr(struct lttng_ust_elf *elf,
 	} else {
 		Elf64_Shdr elf_shdr;
 
-		if (lttng_ust_read(elf->fd, &elf_shdr, sizeof(elf_shdr))
-				< sizeof(elf_shdr)) {
+		if (lttng_ust_elf_read_at(elf, offset, &elf_shdr,
+				sizeof(elf_shdr))) {
 			goto error;
 		}
 		if (!is_elf_native_endian(elf)) {
@@ -146,11 +161,10 @@ struct lttng_ust_elf_shdr *lttng_ust_elf_get_shdr(struct lttng_ust_elf *elf,
 		copy_shdr(elf_shdr, *shdr);
 	}
 
-	return shdr;
+	return 0;
 
 error:
-	free(shdr);
-	return NULL;
+	return -1;
 }
 
 /*
@@ -223,16 +237,112 @@ error:
 	return NULL;
 }
 
+/*
+ * Test whether the name of a section, located at `offset` in the
+ * section names string table, is `name`. When the file is mapped, the
+ * comparison is done in place.
+ *
+ * Returns 1 if the names match, 0 otherwise.
+ */
+static
+int lttng_ust_elf_section_name_is(struct lttng_ust_elf *elf, off_t offset,
+		const char *name)
+{
+	size_t name_len = strlen(name);
+
+	if (offset < 0 || offset >= elf->section_names_size) {
+		return 0;
+	}
+
+	if (elf->map) {
+		uint64_t start, avail;
+
+		start = (uint64_t) elf->section_names_offset + offset;
+		avail = elf->section_names_size - offset;
+		if (start > elf->map_len || avail > elf->map_len - start) {
+			return 0;
+		}
+		/* Include the terminating \0 in the comparison. */
+		if (avail < name_len + 1) {
+			return 0;
+		}
+		return !memcmp(elf->map + start, name, name_len + 1);
+	} else {
+		char *section_name;
+		int ret;
+
+		section_name = lttng_ust_elf_get_section_name(elf, offset);
+		if (!section_name) {
+			return 0;
+		}
+		ret = !strcmp(section_name, name);
+		free(section_name);
+		return ret;
+	}
+}
+
+/*
+ * Close the file descriptor of the given elf instance, if open.
+ */
+static
+void lttng_ust_elf_close_fd(struct lttng_ust_elf *elf)
+{
+	int ret;
+
+	if (elf->fd < 0) {
+		return;
+	}
+
+	lttng_ust_lock_fd_tracker();
+	ret = close(elf->fd);
+	if (!ret) {
+		lttng_ust_delete_fd_from_tracker(elf->fd);
+	} else {
+		PERROR("close");
+		abort();
+	}
+	lttng_ust_unlock_fd_tracker();
+	elf->fd = -1;
+}
+
+/*
+ * Map the whole ELF file read-only, and close its file descriptor
+ * which is not needed anymore. The file is left unmapped if it cannot
+ * be mapped, in which case it is read through its file descriptor.
+ */
+static
+void lttng_ust_elf_map(struct lttng_ust_elf *elf)
+{
+	struct stat sb;
+	void *map;
+
+	if (fstat(elf->fd, &sb) < 0) {
+		return;
+	}
+	if (sb.st_size <= 0 || (uint64_t) sb.st_size > SIZE_MAX) {
+		return;
+	}
+	map = mmap(NULL, (size_t) sb.st_size, PROT_READ, MAP_PRIVATE,
+			elf->fd, 0);
+	if (map == MAP_FAILED) {
+		return;
+	}
+	elf->map = map;
+	elf->map_len = (size_t) sb.st_size;
+	lttng_ust_elf_close_fd(elf);
+}
+
 /*
  * Create an instance of lttng_ust_elf for the ELF file located at
- * `path`.
+ * `path`, with `flags` being a combination of LTTNG_UST_ELF_* flags.
  *
  * Return a pointer to the instance on success, NULL on failure.
  */
-struct lttng_ust_elf *lttng_ust_elf_create(const char *path)
+struct lttng_ust_elf *lttng_ust_elf_create_flags(const char *path,
+		unsigned int flags)
 {
 	uint8_t e_ident[EI_NIDENT];
-	struct lttng_ust_elf_shdr *section_names_shdr;
+	struct lttng_ust_elf_shdr section_names_shdr;
 	struct lttng_ust_elf *elf = NULL;
 	int ret, fd;
 
@@ -269,54 +379,46 @@ struct lttng_ust_elf *lttng_ust_elf_create(const char *path)
 	elf->fd = ret;
 	lttng_ust_unlock_fd_tracker();
 
-	if (lttng_ust_read(elf->fd, e_ident, EI_NIDENT) < EI_NIDENT) {
-		goto error;
-	}
-	elf->bitness = e_ident[EI_CLASS];
-	elf->endianness = e_ident[EI_DATA];
-
-	if (lseek(elf->fd, 0, SEEK_SET) < 0) {
-		goto error;
+	if (!(flags & LTTNG_UST_ELF_NO_MMAP)) {
+		lttng_ust_elf_map(elf);
 	}
 
-	elf->ehdr = zmalloc(sizeof(struct lttng_ust_elf_ehdr));
-	if (!elf->ehdr) {
+	if (lttng_ust_elf_read_at(elf, 0, e_ident, EI_NIDENT)) {
 		goto error;
 	}
+	elf->bitness = e_ident[EI_CLASS];
+	elf->endianness = e_ident[EI_DATA];
 
 	if (is_elf_32_bit(elf)) {
 		Elf32_Ehdr elf_ehdr;
 
-		if (lttng_ust_read(elf->fd, &elf_ehdr, sizeof(elf_ehdr))
-				< sizeof(elf_ehdr)) {
+		if (lttng_ust_elf_read_at(elf, 0, &elf_ehdr, sizeof(elf_ehdr))) {
 			goto error;
 		}
 		if (!is_elf_native_endian(elf)) {
 			bswap_ehdr(elf_ehdr);
 		}
-		copy_ehdr(elf_ehdr, *(elf->ehdr));
+		copy_ehdr(elf_ehdr, elf->ehdr);
 	} else {
 		Elf64_Ehdr elf_ehdr;
 
-		if (lttng_ust_read(elf->fd, &elf_ehdr, sizeof(elf_ehdr))
-				< sizeof(elf_ehdr)) {
+		if (lttng_ust_elf_read_at(elf, 0, &elf_ehdr, sizeof(elf_ehdr))) {
 			goto error;
 		}
 		if (!is_elf_native_endian(elf)) {
 			bswap_ehdr(elf_ehdr);
 		}
-		copy_ehdr(elf_ehdr, *(elf->ehdr));
+		copy_ehdr(elf_ehdr, elf->ehdr);
 	}
 
-	section_names_shdr = lttng_ust_elf_get_shdr(elf, elf->ehdr->e_shstrndx);
-	if (!section_names_shdr) {
+	if (lttng_ust_elf_get_shdr(elf, elf->ehdr.e_shstrndx,
+			&section_names_shdr)) {
 		goto error;
 	}
 
-	elf->section_names_offset = section_names_shdr->sh_offset;
-	elf->section_names_size = section_names_shdr->sh_size;
+	elf->section_names_offset = section_names_shdr.sh_offset;
+	elf->section_names_size = section_names_shdr.sh_size;
 
-	free(section_names_shdr);
 	return elf;
 
 error:
@@ -324,6 +426,17 @@ error:
 	return NULL;
 }
 
+/*
+ * Create an instance of lttng_ust_elf for the ELF file located at
+ * `path`.
+ *
+ * Return a pointer to the instance on success, NULL on failure.
+ */
+struct lttng_ust_elf *lttng_ust_elf_create(const char *path)
+{
+	return lttng_ust_elf_create_flags(path, 0);
+}
+
 /*
  * Test whether the ELF file is position independent code (PIC)
  */
@@ -333,7 +446,7 @@ uint8_t lttng_ust_elf_is_pic(struct lttng_ust_elf *elf)
 	 * PIC has and e_type value of ET_DYN, see ELF specification
 	 * version 1.1 p. 1-3.
 	 */
-	return elf->ehdr->e_type == ET_DYN;
+	return elf->ehdr.e_type == ET_DYN;
 }
 
 /*
@@ -341,25 +454,17 @@ uint8_t lttng_ust_elf_is_pic(struct lttng_ust_elf *elf)
  */
 void lttng_ust_elf_destroy(struct lttng_ust_elf *elf)
 {
-	int ret;
-
 	if (!elf) {
 		return;
 	}
 
-	if (elf->fd >= 0) {
-		lttng_ust_lock_fd_tracker();
-		ret = close(elf->fd);
-		if (!ret) {
-			lttng_ust_delete_fd_from_tracker(elf->fd);
-		} else {
-			PERROR("close");
-			abort();
+	if (elf->map) {
+		if (munmap((void *) elf->map, elf->map_len)) {
+			PERROR("munmap");
 		}
-		lttng_ust_unlock_fd_tracker();
 	}
+	lttng_ust_elf_close_fd(elf);
 
-	free(elf->ehdr);
 	free(elf->path);
 	free(elf);
 }
@@ -379,11 +484,10 @@ int lttng_ust_elf_get_memsz(struct lttng_ust_elf *elf, uint64_t *memsz)
 		goto error;
 	}
 
-	for (i = 0; i < elf->ehdr->e_phnum; ++i) {
-		struct lttng_ust_elf_phdr *phdr;
+	for (i = 0; i < elf->ehdr.e_phnum; ++i) {
+		struct lttng_ust_elf_phdr phdr;
 
-		phdr = lttng_ust_elf_get_phdr(elf, i);
-		if (!phdr) {
+		if (lttng_ust_elf_get_phdr(elf, i, &phdr)) {
 			goto error;
 		}
 
@@ -391,15 +495,13 @@ int lttng_ust_elf_get_memsz(struct lttng_ust_elf *elf, uint64_t *memsz)
 		 * Only PT_LOAD segments contribute to memsz. Skip
 		 * other segments.
 		 */
-		if (phdr->p_type != PT_LOAD) {
-			goto next_loop;
+		if (phdr.p_type != PT_LOAD) {
+			continue;
 		}
 
-		low_addr = min_t(uint64_t, low_addr, phdr->p_vaddr);
+		low_addr = min_t(uint64_t, low_addr, phdr.p_vaddr);
 		high_addr = max_t(uint64_t, high_addr,
-				phdr->p_vaddr + phdr->p_memsz);
-	next_loop:
-		free(phdr);
+				phdr.p_vaddr + phdr.p_memsz);
 	}
 
 	if (high_addr < low_addr) {
@@ -428,30 +530,20 @@ error:
 static
 int lttng_ust_elf_get_build_id_from_segment(
 	struct lttng_ust_elf *elf, uint8_t **build_id, size_t *length,
-	off_t offset, off_t segment_end)
+	uint64_t offset, uint64_t segment_end)
 {
 	uint8_t *_build_id = NULL;	/* Silence old gcc warning. */
 	size_t _length = 0;		/* Silence old gcc warning. */
 
 	while (offset < segment_end) {
 		struct lttng_ust_elf_nhdr nhdr;
-		size_t read_len;
 
 		/* Align start of note entry */
 		offset += lttng_ust_offset_align(offset, ELF_NOTE_ENTRY_ALIGN);
 		if (offset >= segment_end) {
 			break;
 		}
-		/*
-		 * We seek manually because if the note isn't the
-		 * build id the data following the header will not
-		 * have been read.
-		 */
-		if (lseek(elf->fd, offset, SEEK_SET) < 0) {
-			goto error;
-		}
-		if (lttng_ust_read(elf->fd, &nhdr, sizeof(nhdr))
-				< sizeof(nhdr)) {
+		if (lttng_ust_elf_read_at(elf, offset, &nhdr, sizeof(nhdr))) {
 			goto error;
 		}
 
@@ -480,11 +572,8 @@ int lttng_ust_elf_get_build_id_from_segment(
 			goto error;
 		}
 
-		if (lseek(elf->fd, offset, SEEK_SET) < 0) {
-			goto error;
-		}
-		read_len = sizeof(*_build_id) * _length;
-		if (lttng_ust_read(elf->fd, _build_id, read_len) < read_len) {
+		if (lttng_ust_elf_read_at(elf, offset, _build_id,
+				sizeof(*_build_id) * _length)) {
 			goto error;
 		}
 
@@ -526,28 +615,23 @@ int lttng_ust_elf_get_build_id(struct lttng_ust_elf *elf, uint8_t **build_id,
 		goto error;
 	}
 
-	for (i = 0; i < elf->ehdr->e_phnum; ++i) {
-		off_t offset, segment_end;
-		struct lttng_ust_elf_phdr *phdr;
-		int ret = 0;
+	for (i = 0; i < elf->ehdr.e_phnum; ++i) {
+		uint64_t offset, segment_end;
+		struct lttng_ust_elf_phdr phdr;
 
-		phdr = lttng_ust_elf_get_phdr(elf, i);
-		if (!phdr) {
+		if (lttng_ust_elf_get_phdr(elf, i, &phdr)) {
 			goto error;
 		}
 
 		/* Build ID will be contained in a PT_NOTE segment. */
-		if (phdr->p_type != PT_NOTE) {
-			goto next_loop;
+		if (phdr.p_type != PT_NOTE) {
+			continue;
 		}
 
-		offset = phdr->p_offset;
-		segment_end = offset + phdr->p_filesz;
-		ret = lttng_ust_elf_get_build_id_from_segment(
-			elf, &_build_id, &_length, offset, segment_end);
-	next_loop:
-		free(phdr);
-		if (ret) {
+		offset = phdr.p_offset;
+		segment_end = offset + phdr.p_filesz;
+		if (lttng_ust_elf_get_build_id_from_segment(
+				elf, &_build_id, &_length, offset, segment_end)) {
 			goto error;
 		}
 		if (_build_id) {
@@ -586,7 +670,6 @@ int lttng_ust_elf_get_debug_link_from_section(struct lttng_ust_elf *elf,
 {
 	char *_filename = NULL;		/* Silence old gcc warning. */
 	size_t filename_len;
-	char *section_name = NULL;
 	uint32_t _crc = 0;		/* Silence old gcc warning. */
 
 	if (!elf || !filename || !crc || !shdr) {
@@ -601,12 +684,12 @@ int lttng_ust_elf_get_debug_link_from_section(struct lttng_ust_elf *elf,
 		goto end;
 	}
 
-	section_name = lttng_ust_elf_get_section_name(elf,
-						shdr->sh_name);
-	if (!section_name) {
+	if (!lttng_ust_elf_section_name_is(elf, shdr->sh_name,
+			".gnu_debuglink")) {
 		goto end;
 	}
-	if (strcmp(section_name, ".gnu_debuglink")) {
+
+	if (shdr->sh_size <= ELF_CRC_SIZE) {
 		goto end;
 	}
 
@@ -614,18 +697,17 @@ int lttng_ust_elf_get_debug_link_from_section(struct lttng_ust_elf *elf,
 	 * The length of the filename is the sh_size excluding the CRC
 	 * which comes after it in the section.
 	 */
-	_filename = zmalloc(sizeof(char) * (shdr->sh_size - ELF_CRC_SIZE));
+	filename_len = sizeof(*_filename) * (shdr->sh_size - ELF_CRC_SIZE);
+	_filename = zmalloc(filename_len);
 	if (!_filename) {
 		goto error;
 	}
-	if (lseek(elf->fd, shdr->sh_offset, SEEK_SET) < 0) {
+	if (lttng_ust_elf_read_at(elf, shdr->sh_offset, _filename,
+			filename_len)) {
 		goto error;
 	}
-	filename_len = sizeof(*_filename) * (shdr->sh_size - ELF_CRC_SIZE);
-	if (lttng_ust_read(elf->fd, _filename, filename_len) < filename_len) {
-		goto error;
-	}
-	if (lttng_ust_read(elf->fd, &_crc, sizeof(_crc)) < sizeof(_crc)) {
+	if (lttng_ust_elf_read_at(elf, shdr->sh_offset + filename_len,
+			&_crc, sizeof(_crc))) {
 		goto error;
 	}
 	if (!is_elf_native_endian(elf)) {
@@ -633,7 +715,6 @@ int lttng_ust_elf_get_debug_link_from_section(struct lttng_ust_elf *elf,
 	}
 
 end:
-	free(section_name);
 	if (_filename) {
 		*filename = _filename;
 		*crc = _crc;
@@ -643,7 +724,6 @@ end:
 
 error:
 	free(_filename);
-	free(section_name);
 	return -1;
 }
 
@@ -669,18 +749,15 @@ int lttng_ust_elf_get_debug_link(struct lttng_ust_elf *elf, char **filename,
 		goto error;
 	}
 
-	for (i = 0; i < elf->ehdr->e_shnum; ++i) {
-		struct lttng_ust_elf_shdr *shdr = NULL;
+	for (i = 0; i < elf->ehdr.e_shnum; ++i) {
+		struct lttng_ust_elf_shdr shdr;
 
-		shdr = lttng_ust_elf_get_shdr(elf, i);
-		if (!shdr) {
+		if (lttng_ust_elf_get_shdr(elf, i, &shdr)) {
 			goto error;
 		}
 
 		ret = lttng_ust_elf_get_debug_link_from_section(
-			elf, &_filename, &_crc, shdr);
-		free(shdr);
-
+			elf, &_filename, &_crc, &shdr);
 		if (ret) {
 			goto error;
 		}
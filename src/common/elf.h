@@ -64,12 +64,24 @@ struct lttng_ust_elf {
 	/* Size in bytes of section names string table. */
 	size_t section_names_size;
 	char *path;
+	/* File descriptor, only kept open when the file is not mapped. */
 	int fd;
-	struct lttng_ust_elf_ehdr *ehdr;
+	/* Read-only mapping of the whole file, NULL if not mapped. */
+	const uint8_t *map;
+	size_t map_len;
+	struct lttng_ust_elf_ehdr ehdr;
 	uint8_t bitness;
 	uint8_t endianness;
 };
 
+/*
+ * Flags for lttng_ust_elf_create_flags().
+ *
+ * LTTNG_UST_ELF_NO_MMAP: read the file with lseek/read rather than
+ * through a memory mapping.
+ */
+#define LTTNG_UST_ELF_NO_MMAP	(1U << 0)
+
 /*
  * Determine native endianness in order to convert when reading an ELF
  * file if there is a mismatch.
@@ -212,6 +224,10 @@ int is_elf_native_endian(struct lttng_ust_elf *elf)
 struct lttng_ust_elf *lttng_ust_elf_create(const char *path)
 	__attribute__((visibility("hidden")));
 
+struct lttng_ust_elf *lttng_ust_elf_create_flags(const char *path,
+		unsigned int flags)
+	__attribute__((visibility("hidden")));
+
 void lttng_ust_elf_destroy(struct lttng_ust_elf *elf)
 	__attribute__((visibility("hidden")));
 
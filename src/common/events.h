@@ -8,6 +8,7 @@
 #define _UST_COMMON_UST_EVENTS_H
 
 #include <limits.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <urcu/list.h>
@@ -40,6 +41,10 @@ union lttng_ust_abi_args {
 	struct {
 		struct lttng_ust_abi_field_iter entry;
 	} field_list;
+	struct {
+		void *entries;		/* Sent after the reply, freed by the caller */
+		size_t len;
+	} list_batch;
 	struct {
 		char *ctxname;
 	} app_context;
@@ -231,9 +236,18 @@ struct tp_list_entry {
 	struct cds_list_head head;
 };
 
+/* Position of a batched listing within the registered probes. */
+struct lttng_ust_probe_list_cursor {
+	unsigned int probe;		/* Index in the probe list */
+	unsigned int event;		/* Index in the probe events */
+	unsigned int field;		/* Index in the event fields */
+};
+
 struct lttng_ust_tracepoint_list {
 	struct tp_list_entry *iter;
 	struct cds_list_head head;
+	bool populated;			/* List built by the first LIST_GET */
+	struct lttng_ust_probe_list_cursor cursor;	/* LIST_GET_BATCH */
 };
 
 struct tp_field_list_entry {
@@ -244,6 +258,8 @@ struct tp_field_list_entry {
 struct lttng_ust_field_list {
 	struct tp_field_list_entry *iter;
 	struct cds_list_head head;
+	bool populated;			/* List built by the first FIELD_LIST_GET */
+	struct lttng_ust_probe_list_cursor cursor;	/* FIELD_LIST_GET_BATCH */
 };
 
 /*
@@ -336,6 +352,7 @@ struct lttng_ust_event_recorder_private {
 	struct lttng_ust_event_session_common_private parent;
 
 	struct lttng_ust_event_recorder *pub;	/* Public event interface */
+	unsigned int hot_id;			/* Last hot ID slot of the event */
 };
 
 struct lttng_ust_event_counter_private {
@@ -421,7 +438,8 @@ struct lttng_ust_channel_buffer_ops_private {
 			unsigned char *uuid,
 			uint32_t chan_id,
 			const int *stream_fds, int nr_stream_fds,
-			int64_t blocking_timeout);
+			int64_t blocking_timeout,
+			uint32_t wakeup_flags);
 	void (*channel_destroy)(struct lttng_ust_channel_buffer *chan);
 	/*
 	 * packet_avail_size returns the available size in the current
@@ -442,17 +460,52 @@ struct lttng_ust_channel_common_private {
 	bool coalesce_hits;
 };
 
+/*
+ * Sampled event counts of a channel with hot IDs, updated without
+ * synchronization (space-saving top-k). The LTTNG_UST_NR_HOT_IDS
+ * most frequent events get the short IDs of the compact header.
+ */
+#define LTTNG_UST_NR_HOT_IDS	31
+
+struct lttng_ust_hot_ids {
+	uint32_t version;			/* Incremented on slot change */
+	uint32_t nr_samples;
+	struct {
+		uint32_t id;			/* Event ID */
+		uint32_t count;			/* Decayed sample count */
+	} slots[LTTNG_UST_NR_HOT_IDS];
+};
+
+/*
+ * Probe of the lttng_ust_fragment:chunk event, called by the ring
+ * buffer clients for each chunk of a record too large for a
+ * sub-buffer.
+ */
+typedef void (*lttng_ust_fragment_probe_t)(void *tp_data, uint64_t id,
+		uint32_t event_id, uint32_t index, uint64_t offset,
+		uint64_t total_len, const uint8_t *data, uint32_t len,
+		void *ip);
+
 struct lttng_ust_channel_buffer_private {
 	struct lttng_ust_channel_common_private parent;
 
 	struct lttng_ust_channel_buffer *pub;	/* Public channel buffer interface */
 	struct cds_list_head node;		/* Channel list in session */
-	int header_type;			/* 0: unset, 1: compact, 2: large */
+	int header_type;			/*
+						 * 0: unset, 1: compact, 2: large,
+						 * 3: varint, 4: compact hot IDs
+						 */
 	unsigned int id;			/* Channel ID */
 	enum lttng_ust_abi_chan_type type;
 	struct lttng_ust_ctx *ctx;
 	struct lttng_ust_ring_buffer_channel *rb_chan;	/* Ring buffer channel */
 	unsigned char uuid[LTTNG_UST_UUID_LEN];	/* Trace session unique ID */
+	struct lttng_ust_hot_ids hot_ids;	/* Sampled hottest events */
+	/*
+	 * lttng_ust_fragment:chunk event of the channel, NULL if records
+	 * too large for a sub-buffer are discarded (RCU).
+	 */
+	struct lttng_ust_event_common *fragment_event;
 };
 
 struct lttng_ust_channel_counter_ops_private {
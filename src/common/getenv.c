@@ -42,7 +42,14 @@ static struct lttng_env lttng_env[] = {
 	/* Env. var. which can be used in setuid/setgid executables. */
 	{ "LTTNG_UST_WITHOUT_BADDR_STATEDUMP", LTTNG_ENV_NOT_SECURE, NULL, },
 	{ "LTTNG_UST_REGISTER_TIMEOUT", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_MAP_MLOCK", LTTNG_ENV_NOT_SECURE, NULL, },
 	{ "LTTNG_UST_MAP_POPULATE_POLICY", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_READ_TIMER_MIN_INTERVAL", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_READ_TIMER_MAX_INTERVAL", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_REGISTER_ASYNC", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_EARLY_BUFFER_SIZE", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_BLOB_ARENA_SIZE", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_PACKET_CHECKSUM", LTTNG_ENV_NOT_SECURE, NULL, },
 
 	/* Env. var. which are not fetched in setuid/setgid executables. */
 	{ "LTTNG_UST_CLOCK_PLUGIN", LTTNG_ENV_SECURE, NULL, },
@@ -20,6 +20,9 @@ enum populate_policy {
 
 static enum populate_policy map_populate_policy = POPULATE_UNSET;
 
+/* -1: unset, 0: disabled, 1: enabled. */
+static int map_mlock = -1;
+
 static void init_map_populate_policy(void)
 {
 	const char *populate_env_str;
@@ -84,3 +87,19 @@ bool lttng_ust_map_populate_cpu_is_enabled(int cpu)
 
 	return lttng_ust_map_populate_is_enabled();
 }
+
+/*
+ * Return whether the ring buffer mappings should be locked in memory
+ * with mlock(2), which also faults in their pages.
+ */
+bool lttng_ust_map_mlock_is_enabled(void)
+{
+	const char *mlock_env_str;
+
+	if (map_mlock >= 0)
+		return map_mlock;
+
+	mlock_env_str = lttng_ust_getenv("LTTNG_UST_MAP_MLOCK");
+	map_mlock = mlock_env_str && strcmp(mlock_env_str, "0") != 0;
+	return map_mlock;
+}
@@ -15,4 +15,7 @@ bool lttng_ust_map_populate_cpu_is_enabled(int cpu)
 bool lttng_ust_map_populate_is_enabled(void)
 	__attribute__((visibility("hidden")));
 
+bool lttng_ust_map_mlock_is_enabled(void)
+	__attribute__((visibility("hidden")));
+
 #endif /* _UST_COMMON_POPULATE_H */
@@ -4,10 +4,16 @@
  * Copyright (C) 2011 Mathieu Desnoyers <mathieu.desnoyers@efficios.com>
  */
 
+#include "common/getenv.h"
 #include "common/ringbuffer-clients/clients.h"
 
+bool lttng_ust_ring_buffer_packet_checksum;
+unsigned long lttng_ust_ring_buffer_fragment_id;
+
 void lttng_ust_ring_buffer_clients_init(void)
 {
+	if (lttng_ust_getenv("LTTNG_UST_PACKET_CHECKSUM"))
+		lttng_ust_ring_buffer_packet_checksum = true;
 	lttng_ring_buffer_metadata_client_init();
 	lttng_ring_buffer_client_overwrite_init();
 	lttng_ring_buffer_client_overwrite_rt_init();
@@ -7,6 +7,7 @@
 #ifndef _UST_COMMON_RINGBUFFER_CLIENTS_CLIENTS_H
 #define _UST_COMMON_RINGBUFFER_CLIENTS_CLIENTS_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <lttng/ust-events.h>
 
@@ -43,6 +44,11 @@ struct lttng_ust_client_lib_ring_buffer_client_cb {
 		struct lttng_ust_ring_buffer_channel *chan, uint64_t *seq);
 	int (*instance_id) (struct lttng_ust_ring_buffer *buf,
 			struct lttng_ust_ring_buffer_channel *chan, uint64_t *id);
+	int (*hot_ids) (struct lttng_ust_ring_buffer *buf,
+			struct lttng_ust_ring_buffer_channel *chan,
+			uint32_t *version, uint32_t *ids);
+	int (*validate_packet) (struct lttng_ust_ring_buffer *buf,
+			struct lttng_ust_ring_buffer_channel *chan);
 	int (*packet_create) (void **packet, uint64_t *packet_length);
 	int (*packet_initialize) (struct lttng_ust_ring_buffer *buf,
 			struct lttng_ust_ring_buffer_channel *chan,
@@ -52,6 +58,20 @@ struct lttng_ust_client_lib_ring_buffer_client_cb {
 			uint64_t *packet_length, uint64_t *packet_length_padded);
 };
 
+/*
+ * Whether the packets delivered by this process carry a CRC32C of their
+ * content (LTTNG_UST_PACKET_CHECKSUM).
+ */
+extern bool lttng_ust_ring_buffer_packet_checksum
+	__attribute__((visibility("hidden")));
+
+/*
+ * Last ID given to a group of chunks of a record too large for a
+ * sub-buffer, shared by all the clients of this process.
+ */
+extern unsigned long lttng_ust_ring_buffer_fragment_id
+	__attribute__((visibility("hidden")));
+
 void lttng_ust_ring_buffer_clients_init(void)
 	__attribute__((visibility("hidden")));
 
@@ -9,19 +9,39 @@
 #include <limits.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
 
 #include <lttng/urcu/pointer.h>
 #include <urcu/tls-compat.h>
+#include <urcu/uatomic.h>
 
 #include "common/events.h"
 #include "common/bitfield.h"
 #include "common/align.h"
 #include "common/clock.h"
+#include "common/crc32c.h"
 #include "common/ringbuffer/frontend_types.h"
+#include "common/varint.h"
 
 #define LTTNG_COMPACT_EVENT_BITS	5
 #define LTTNG_COMPACT_TIMESTAMP_BITS	27
 
+/* Upper bound of an event header, including its alignment. */
+#define LTTNG_EVENT_HEADER_MAX_LEN	32
+/* Upper bound of the fields of a chunk event preceding its data. */
+#define LTTNG_FRAGMENT_CHUNK_FIELDS_LEN	48
+
+/* Sample one event out of LTTNG_HOT_ID_SAMPLE_PERIOD per thread. */
+#define LTTNG_HOT_ID_SAMPLE_PERIOD	64
+/* Halve the sampled counts every LTTNG_HOT_ID_DECAY_PERIOD samples. */
+#define LTTNG_HOT_ID_DECAY_PERIOD	4096
+
+lttng_ust_static_assert(LTTNG_UST_NR_HOT_IDS == (1U << LTTNG_COMPACT_EVENT_BITS) - 1
+		&& RB_NR_HOT_IDS == LTTNG_UST_NR_HOT_IDS,
+		"Hot IDs must cover the compact event IDs but the extended one",
+		Hot_ids_must_cover_the_compact_event_ids);
+
 /*
  * Keep the natural field alignment for _each field_ within this structure if
  * you ever add/remove a field from this header. Packed attribute is not used
@@ -62,6 +82,11 @@ struct lttng_client_ctx {
 	size_t packet_context_len;
 	size_t event_context_len;
 	struct lttng_ust_ctx *chan_ctx;
+	size_t event_id_len;		/* Varint header event id length */
+	size_t timestamp_len;		/* Varint header timestamp length */
+	uint32_t event_id;		/* Event ID */
+	unsigned int hot_id;		/* Hot ID slot of the event */
+	uint32_t compact_id;		/* Compact header event ID */
 };
 
 /*
@@ -70,12 +95,18 @@ struct lttng_client_ctx {
 typedef struct lttng_ust_ring_buffer_ctx_private private_ctx_stack_t[LIB_RING_BUFFER_MAX_NESTING];
 static DEFINE_URCU_TLS(private_ctx_stack_t, private_ctx_stack);
 
+/*
+ * Events emitted by this thread in channels with hot IDs, for sampling.
+ */
+static DEFINE_URCU_TLS(unsigned int, hot_id_sample);
+
 /*
  * Force a read (imply TLS allocation for dlopen) of TLS variables.
  */
 void RING_BUFFER_MODE_TEMPLATE_ALLOC_TLS(void)
 {
 	__asm__ __volatile__ ("" : : "m" (URCU_TLS(private_ctx_stack)));
+	__asm__ __volatile__ ("" : : "m" (URCU_TLS(hot_id_sample)));
 }
 
 static inline uint64_t lib_ring_buffer_clock_read(
@@ -127,6 +158,41 @@ void ctx_record(struct lttng_ust_ring_buffer_ctx *bufctx,
 		ctx->fields[i].record(ctx->fields[i].priv, bufctx->probe_ctx, bufctx, chan);
 }
 
+/*
+ * varint_timestamp_len - Length of the timestamp of a varint header.
+ *
+ * The varint header only holds the low-order 7-bit groups of the
+ * timestamp covering its delta from the last timestamp saved in the
+ * buffer. The last timestamp is never more recent than the one of the
+ * previous record, so the reader can update the low-order bits of its
+ * clock and infer a carry when the new value is smaller, as for the
+ * compact header. The full timestamp is written when the delta needs more
+ * than timestamp_bits.
+ */
+static inline
+size_t varint_timestamp_len(const struct lttng_ust_ring_buffer_config *config,
+		struct lttng_ust_ring_buffer_ctx *ctx)
+{
+	struct lttng_ust_ring_buffer_ctx_private *ctx_private = ctx->priv;
+	uint64_t delta;
+
+	if (ctx_private->rflags & RING_BUFFER_RFLAG_FULL_TIMESTAMP)
+		return LTTNG_VARINT_FULL_TIMESTAMP_LEN;
+#if (CAA_BITS_PER_LONG == 64)
+	delta = ctx_private->timestamp
+		- v_read(config, &ctx_private->buf->last_timestamp);
+#else
+	/* Only the high-order bits of the last timestamp are saved. */
+	delta = (1ULL << config->timestamp_bits) - 1;
+#endif
+	return lttng_ust_varint_timestamp_len(delta, config->timestamp_bits);
+}
+
+static
+int lttng_hot_id_lookup(const struct lttng_ust_ring_buffer_config *config,
+		struct lttng_ust_ring_buffer_ctx *ctx, size_t offset,
+		uint32_t event_id, unsigned int hot_id);
+
 /*
  * record_header_size - Calculate the header size and padding necessary.
  * @config: ring buffer instance configuration
@@ -142,7 +208,7 @@ void ctx_record(struct lttng_ust_ring_buffer_ctx *bufctx,
  */
 static __inline__
 size_t record_header_size(
-		const struct lttng_ust_ring_buffer_config *config __attribute__((unused)),
+		const struct lttng_ust_ring_buffer_config *config,
 		struct lttng_ust_ring_buffer_channel *chan,
 		size_t offset,
 		size_t *pre_header_padding,
@@ -154,6 +220,21 @@ size_t record_header_size(
 	size_t padding;
 
 	switch (lttng_chan->priv->header_type) {
+	case 4:	/* compact, hot IDs */
+	{
+		int hot_id;
+
+		/* The short ID depends on the packet of the record. */
+		hot_id = lttng_hot_id_lookup(config, ctx, offset,
+				client_ctx->event_id, client_ctx->hot_id);
+		if (hot_id < 0) {
+			ctx->priv->rflags |= LTTNG_RFLAG_EXTENDED;
+		} else {
+			ctx->priv->rflags &= ~LTTNG_RFLAG_EXTENDED;
+			client_ctx->compact_id = hot_id;
+		}
+	}
+		/* Fall-through */
 	case 1:	/* compact */
 		padding = lttng_ust_ring_buffer_align(offset, lttng_ust_rb_alignof(uint32_t));
 		offset += padding;
@@ -184,6 +265,12 @@ size_t record_header_size(
 			offset += sizeof(uint64_t);	/* timestamp */
 		}
 		break;
+	case 3:	/* varint */
+		padding = 0;
+		client_ctx->timestamp_len = varint_timestamp_len(config, ctx);
+		offset += client_ctx->event_id_len;
+		offset += client_ctx->timestamp_len;
+		break;
 	default:
 		padding = 0;
 		WARN_ON_ONCE(1);
@@ -197,12 +284,76 @@ size_t record_header_size(
 #include "common/ringbuffer/api.h"
 #include "common/ringbuffer-clients/clients.h"
 
+/*
+ * lttng_hot_id_lookup - Find the short ID of an event in a packet.
+ * @config: ring buffer instance configuration
+ * @ctx: reservation context
+ * @offset: offset of the record in the buffer
+ * @event_id: event ID
+ * @hot_id: hot ID slot of the event in the channel
+ *
+ * Returns the short ID of the event in the hot IDs of the packet
+ * containing @offset, or -1 if it has none. The table is only used if
+ * it is tagged with this very packet: a packet being opened or opened
+ * by the consumer uses extended headers.
+ */
+static
+int lttng_hot_id_lookup(const struct lttng_ust_ring_buffer_config *config,
+		struct lttng_ust_ring_buffer_ctx *ctx, size_t offset,
+		uint32_t event_id, unsigned int hot_id)
+{
+	struct lttng_ust_ring_buffer_ctx_private *ctx_private = ctx->priv;
+	struct lttng_ust_ring_buffer_channel *chan = ctx_private->chan;
+	struct lttng_ust_ring_buffer *buf = ctx_private->buf;
+	struct lttng_ust_shm_handle *handle = chan->handle;
+	unsigned long idx = subbuf_index(offset, chan);
+	struct lttng_ust_ring_buffer_backend_subbuffer *wsb;
+	struct lttng_ust_ring_buffer_backend_counts *counts;
+	struct lttng_ust_ring_buffer_hot_ids *hot_ids;
+	uint64_t seq;
+
+	wsb = shmp_index(handle, buf->backend.buf_wsb, idx);
+	counts = shmp_index(handle, buf->backend.buf_cnt, idx);
+	if (caa_unlikely(!wsb || !counts))
+		return -1;
+	hot_ids = shmp_index(handle, buf->hot_ids,
+			subbuffer_id_get_index(config, CMM_LOAD_SHARED(wsb->id)));
+	if (caa_unlikely(!hot_ids))
+		return -1;
+	seq = chan->backend.num_subbuf * CMM_LOAD_SHARED(counts->seq_cnt) + idx;
+	if (CMM_LOAD_SHARED(hot_ids->tag) != seq + 1)
+		return -1;
+	/* Read the tag before the IDs, paired with client_hot_ids_begin(). */
+	cmm_smp_rmb();
+	if (CMM_LOAD_SHARED(hot_ids->ids[hot_id]) != event_id)
+		return -1;
+	return hot_id;
+}
+
 static
 void lttng_write_event_header_slow(const struct lttng_ust_ring_buffer_config *config,
 				 struct lttng_ust_ring_buffer_ctx *ctx,
 				 struct lttng_client_ctx *client_ctx,
 				 uint32_t event_id);
 
+/*
+ * Writes the varint event header: LEB128 event ID followed by the
+ * LEB128 low-order bits of the timestamp, sized by record_header_size().
+ */
+static __inline__
+void lttng_write_varint_event_header(const struct lttng_ust_ring_buffer_config *config,
+			    struct lttng_ust_ring_buffer_ctx *ctx,
+			    struct lttng_client_ctx *client_ctx,
+			    uint32_t event_id)
+{
+	uint8_t header[LTTNG_VARINT_HEADER_MAX_LEN];
+	uint8_t *p = header;
+
+	p = lttng_ust_varint_encode(p, event_id, client_ctx->event_id_len);
+	p = lttng_ust_varint_encode(p, ctx->priv->timestamp, client_ctx->timestamp_len);
+	lib_ring_buffer_write(config, ctx, header, p - header);
+}
+
 /*
  * lttng_write_event_header
  *
@@ -225,13 +376,14 @@ void lttng_write_event_header(const struct lttng_ust_ring_buffer_config *config,
 
 	switch (lttng_chan->priv->header_type) {
 	case 1:	/* compact */
+	case 4:	/* compact, hot IDs */
 	{
 		uint32_t id_time = 0;
 
 		bt_bitfield_write(&id_time, uint32_t,
 				0,
 				LTTNG_COMPACT_EVENT_BITS,
-				event_id);
+				client_ctx->compact_id);
 		bt_bitfield_write(&id_time, uint32_t,
 				LTTNG_COMPACT_EVENT_BITS,
 				LTTNG_COMPACT_TIMESTAMP_BITS,
@@ -249,6 +401,9 @@ void lttng_write_event_header(const struct lttng_ust_ring_buffer_config *config,
 		lib_ring_buffer_write(config, ctx, &timestamp, sizeof(timestamp));
 		break;
 	}
+	case 3:	/* varint */
+		lttng_write_varint_event_header(config, ctx, client_ctx, event_id);
+		break;
 	default:
 		WARN_ON_ONCE(1);
 	}
@@ -273,13 +428,14 @@ void lttng_write_event_header_slow(const struct lttng_ust_ring_buffer_config *co
 
 	switch (lttng_chan->priv->header_type) {
 	case 1:	/* compact */
+	case 4:	/* compact, hot IDs */
 		if (!(ctx_private->rflags & (RING_BUFFER_RFLAG_FULL_TIMESTAMP | LTTNG_RFLAG_EXTENDED))) {
 			uint32_t id_time = 0;
 
 			bt_bitfield_write(&id_time, uint32_t,
 					0,
 					LTTNG_COMPACT_EVENT_BITS,
-					event_id);
+					client_ctx->compact_id);
 			bt_bitfield_write(&id_time, uint32_t,
 					LTTNG_COMPACT_EVENT_BITS,
 					LTTNG_COMPACT_TIMESTAMP_BITS,
@@ -323,6 +479,9 @@ void lttng_write_event_header_slow(const struct lttng_ust_ring_buffer_config *co
 		}
 		break;
 	}
+	case 3:	/* varint */
+		lttng_write_varint_event_header(config, ctx, client_ctx, event_id);
+		break;
 	default:
 		WARN_ON_ONCE(1);
 	}
@@ -361,6 +520,35 @@ static size_t client_packet_header_size(void)
 	return offsetof(struct packet_header, ctx.header_end);
 }
 
+/*
+ * Copy the hot IDs of the channel into the table of the packet being
+ * opened, then tag the table so writers start using the short IDs.
+ */
+static void client_hot_ids_begin(struct lttng_ust_ring_buffer *buf,
+		struct lttng_ust_channel_buffer *lttng_chan,
+		unsigned int subbuf_idx, uint64_t seq,
+		struct lttng_ust_shm_handle *handle)
+{
+	struct lttng_ust_hot_ids *chan_hot_ids = &lttng_chan->priv->hot_ids;
+	struct lttng_ust_ring_buffer_backend_subbuffer *wsb;
+	struct lttng_ust_ring_buffer_hot_ids *hot_ids;
+	unsigned int i;
+
+	wsb = shmp_index(handle, buf->backend.buf_wsb, subbuf_idx);
+	if (!wsb)
+		return;
+	hot_ids = shmp_index(handle, buf->hot_ids,
+			subbuffer_id_get_index(&client_config, wsb->id));
+	if (!hot_ids)
+		return;
+	hot_ids->version = CMM_LOAD_SHARED(chan_hot_ids->version);
+	for (i = 0; i < RB_NR_HOT_IDS; i++)
+		hot_ids->ids[i] = CMM_LOAD_SHARED(chan_hot_ids->slots[i].id);
+	/* Write the IDs before the tag, paired with lttng_hot_id_lookup(). */
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(hot_ids->tag, seq + 1);
+}
+
 static void client_buffer_begin(struct lttng_ust_ring_buffer *buf, uint64_t timestamp,
 				unsigned int subbuf_idx,
 				struct lttng_ust_shm_handle *handle)
@@ -394,6 +582,45 @@ static void client_buffer_begin(struct lttng_ust_ring_buffer *buf, uint64_t time
 #ifdef RING_BUFFER_CLIENT_HAS_CPU_ID
 	header->ctx.cpu_id = buf->backend.cpu;
 #endif
+	if (lttng_chan->priv->header_type == 4)
+		client_hot_ids_begin(buf, lttng_chan, subbuf_idx,
+				header->ctx.packet_seq_num, handle);
+}
+
+static struct lttng_ust_ring_buffer_backend_pages *client_backend_pages(
+		struct lttng_ust_ring_buffer *buf, unsigned long id,
+		struct lttng_ust_shm_handle *handle)
+{
+	struct lttng_ust_ring_buffer_backend_pages_shmp *rpages;
+
+	rpages = shmp_index(handle, buf->backend.array,
+			subbuffer_id_get_index(&client_config, id));
+	if (!rpages)
+		return NULL;
+	return shmp(handle, rpages->shmp);
+}
+
+/*
+ * Checksum the content of the packet being delivered, header included,
+ * once its header is complete. The checksum is tagged with the packet
+ * sequence number so the reader never checks a packet against the
+ * checksum of an older one.
+ */
+static void client_checksum_end(struct lttng_ust_ring_buffer *buf,
+		struct packet_header *header, unsigned int subbuf_idx,
+		unsigned long data_size, struct lttng_ust_shm_handle *handle)
+{
+	struct lttng_ust_ring_buffer_backend_subbuffer *wsb;
+	struct lttng_ust_ring_buffer_backend_pages *backend_pages;
+
+	wsb = shmp_index(handle, buf->backend.buf_wsb, subbuf_idx);
+	if (!wsb)
+		return;
+	backend_pages = client_backend_pages(buf, wsb->id, handle);
+	if (!backend_pages)
+		return;
+	backend_pages->content_crc = lttng_ust_crc32c(0, header, data_size);
+	backend_pages->content_crc_tag = header->ctx.packet_seq_num + 1;
 }
 
 /*
@@ -429,6 +656,8 @@ static void client_buffer_end(struct lttng_ust_ring_buffer *buf, uint64_t timest
 	header->ctx.packet_size =
 		(uint64_t) LTTNG_UST_ALIGN(data_size, page_size) * CHAR_BIT;	/* in bits */
 	header->ctx.events_discarded = cc_cold->end_events_discarded;
+	if (lttng_ust_ring_buffer_packet_checksum)
+		client_checksum_end(buf, header, subbuf_idx, data_size, handle);
 }
 
 static int client_buffer_create(
@@ -597,6 +826,50 @@ static int client_sequence_number(struct lttng_ust_ring_buffer *buf,
 	return 0;
 }
 
+static int client_hot_ids(struct lttng_ust_ring_buffer *buf,
+		struct lttng_ust_ring_buffer_channel *chan,
+		uint32_t *version, uint32_t *ids)
+{
+	struct lttng_ust_shm_handle *handle = chan->handle;
+	struct lttng_ust_ring_buffer_hot_ids *hot_ids;
+	struct packet_header *header;
+
+	header = client_packet_header(buf, handle);
+	if (!header)
+		return -1;
+	hot_ids = shmp_index(handle, buf->hot_ids,
+			subbuffer_id_get_index(&client_config, buf->backend.buf_rsb.id));
+	if (!hot_ids)
+		return -1;
+	if (hot_ids->tag != header->ctx.packet_seq_num + 1)
+		return -ENODATA;
+	*version = hot_ids->version;
+	memcpy(ids, hot_ids->ids, sizeof(hot_ids->ids));
+	return 0;
+}
+
+static int client_validate_packet(struct lttng_ust_ring_buffer *buf,
+		struct lttng_ust_ring_buffer_channel *chan)
+{
+	struct lttng_ust_shm_handle *handle = chan->handle;
+	struct lttng_ust_ring_buffer_backend_pages *backend_pages;
+	struct packet_header *header;
+	uint64_t content_size;
+
+	header = client_packet_header(buf, handle);
+	if (!header)
+		return -1;
+	backend_pages = client_backend_pages(buf, buf->backend.buf_rsb.id, handle);
+	if (!backend_pages)
+		return -1;
+	if (backend_pages->content_crc_tag != header->ctx.packet_seq_num + 1)
+		return -ENODATA;
+	content_size = header->ctx.content_size / CHAR_BIT;
+	return lttng_ust_crc32c_check_packet(header, content_size,
+			client_packet_header_size(), chan->backend.subbuf_size,
+			backend_pages->content_crc);
+}
+
 static int client_instance_id(struct lttng_ust_ring_buffer *buf,
 		struct lttng_ust_ring_buffer_channel *chan __attribute__((unused)),
 		uint64_t *id)
@@ -704,6 +977,8 @@ struct lttng_ust_client_lib_ring_buffer_client_cb client_cb = {
 	.current_timestamp = client_current_timestamp,
 	.sequence_number = client_sequence_number,
 	.instance_id = client_instance_id,
+	.hot_ids = client_hot_ids,
+	.validate_packet = client_validate_packet,
 	.packet_create = client_packet_create,
 	.packet_initialize = client_packet_initialize,
 };
@@ -741,7 +1016,8 @@ struct lttng_ust_channel_buffer *_channel_create(const char *name,
 				unsigned char *uuid,
 				uint32_t chan_id,
 				const int *stream_fds, int nr_stream_fds,
-				int64_t blocking_timeout)
+				int64_t blocking_timeout,
+				uint32_t wakeup_flags)
 {
 	struct lttng_ust_abi_channel_config chan_priv_init;
 	struct lttng_ust_shm_handle *handle;
@@ -763,7 +1039,8 @@ struct lttng_ust_channel_buffer *_channel_create(const char *name,
 			&chan_priv_init,
 			lttng_chan_buf, buf_addr, subbuf_size, num_subbuf,
 			switch_timer_interval, read_timer_interval,
-			stream_fds, nr_stream_fds, blocking_timeout);
+			stream_fds, nr_stream_fds, blocking_timeout,
+			wakeup_flags);
 	if (!handle)
 		goto error;
 	lttng_chan_buf->priv->rb_chan = shmp(handle, handle->chan);
@@ -781,6 +1058,115 @@ void lttng_channel_destroy(struct lttng_ust_channel_buffer *lttng_chan_buf)
 	lttng_ust_free_channel_common(lttng_chan_buf->parent);
 }
 
+/*
+ * Count a sampled occurrence of an event in the hot IDs of its channel.
+ * The event keeps its slot while it owns it, otherwise it takes the
+ * slot of the least counted event (space-saving). Concurrent updates
+ * are not synchronized and only make the counts approximate.
+ */
+static
+void lttng_hot_ids_sample(struct lttng_ust_channel_buffer_private *chan_priv,
+		struct lttng_ust_event_recorder_private *event_priv,
+		uint32_t event_id)
+{
+	struct lttng_ust_hot_ids *hot_ids = &chan_priv->hot_ids;
+	unsigned int i, slot = event_priv->hot_id;
+
+	if (CMM_LOAD_SHARED(hot_ids->slots[slot].id) != event_id) {
+		slot = 0;
+		for (i = 1; i < LTTNG_UST_NR_HOT_IDS; i++) {
+			if (hot_ids->slots[i].count < hot_ids->slots[slot].count)
+				slot = i;
+		}
+		CMM_STORE_SHARED(hot_ids->slots[slot].id, event_id);
+		CMM_STORE_SHARED(hot_ids->version, hot_ids->version + 1);
+		event_priv->hot_id = slot;
+	}
+	hot_ids->slots[slot].count++;
+	if (!(++hot_ids->nr_samples % LTTNG_HOT_ID_DECAY_PERIOD)) {
+		for (i = 0; i < LTTNG_UST_NR_HOT_IDS; i++)
+			hot_ids->slots[i].count >>= 1;
+	}
+}
+
+/*
+ * Stage a record which cannot fit in a sub-buffer, rather than having
+ * the ring buffer discard it, if the channel has its
+ * lttng_ust_fragment:chunk event enabled. The record is then written on
+ * commit as chunks of at most half a sub-buffer. Returns 1 if the
+ * record is staged, 0 if it must be reserved in the ring buffer.
+ */
+static
+int lttng_fragment_stage(struct lttng_ust_ring_buffer_ctx *ctx,
+		struct lttng_ust_channel_buffer *lttng_chan,
+		size_t packet_context_len)
+{
+	struct lttng_ust_ring_buffer_ctx_private *private_ctx = ctx->priv;
+	struct lttng_ust_event_common *fragment_event;
+	size_t subbuf_size, overhead, chunk_len;
+	void *stage;
+
+	fragment_event = lttng_ust_rcu_dereference(lttng_chan->priv->fragment_event);
+	if (caa_likely(!fragment_event))
+		return 0;
+	subbuf_size = private_ctx->chan->backend.subbuf_size;
+	overhead = client_packet_header_size() + LTTNG_EVENT_HEADER_MAX_LEN
+			+ packet_context_len;
+	if (caa_likely(overhead + ctx->data_size <= subbuf_size))
+		return 0;
+	if (!CMM_ACCESS_ONCE(fragment_event->enabled))
+		return 0;
+	if (overhead + LTTNG_FRAGMENT_CHUNK_FIELDS_LEN >= subbuf_size)
+		return 0;
+	chunk_len = subbuf_size - overhead - LTTNG_FRAGMENT_CHUNK_FIELDS_LEN;
+	if (chunk_len > subbuf_size / 2)
+		chunk_len = subbuf_size / 2;
+	/* mmap() rather than malloc() is async-signal-safe. */
+	stage = mmap(NULL, ctx->data_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (stage == MAP_FAILED)
+		return 0;
+	private_ctx->stage = stage;
+	private_ctx->stage_chunk_len = chunk_len;
+	return 1;
+}
+
+/*
+ * Write a staged record as lttng_ust_fragment:chunk events sharing a
+ * new ID, reserved within the nesting level of the record.
+ */
+static
+void lttng_fragment_commit(struct lttng_ust_ring_buffer_ctx *ctx)
+{
+	struct lttng_ust_ring_buffer_ctx_private *private_ctx = ctx->priv;
+	struct lttng_ust_event_recorder *event_recorder = ctx->client_priv;
+	struct lttng_ust_event_common *fragment_event;
+	size_t chunk_len = private_ctx->stage_chunk_len;
+	size_t len = ctx->data_size;
+	char *stage = private_ctx->stage;
+
+	fragment_event = lttng_ust_rcu_dereference(event_recorder->chan->priv->fragment_event);
+	if (fragment_event) {
+		lttng_ust_fragment_probe_t probe;
+		uint32_t event_id, index;
+		uint64_t id;
+		size_t offset;
+
+		probe = (lttng_ust_fragment_probe_t)
+			fragment_event->priv->desc->tp_class->probe_callback;
+		event_id = (uint32_t) event_recorder->priv->parent.id;
+		id = uatomic_add_return(&lttng_ust_ring_buffer_fragment_id, 1);
+		for (offset = 0, index = 0; offset < len; offset += chunk_len, index++) {
+			probe(fragment_event, id, event_id, index, offset, len,
+				(const uint8_t *) stage + offset,
+				(uint32_t) min_t(size_t, chunk_len, len - offset),
+				ctx->probe_ctx->ip);
+		}
+	}
+	(void) munmap(stage, len);
+	lib_ring_buffer_nesting_dec(&client_config);
+}
+
 static
 int lttng_event_reserve(struct lttng_ust_ring_buffer_ctx *ctx)
 {
@@ -807,15 +1193,30 @@ int lttng_event_reserve(struct lttng_ust_ring_buffer_ctx *ctx)
 
 	ctx->priv = private_ctx;
 
+	if (caa_unlikely(lttng_fragment_stage(ctx, lttng_chan,
+			client_ctx.packet_context_len)))
+		return 0;
+
 	switch (lttng_chan->priv->header_type) {
 	case 1:	/* compact */
 		if (event_id > 30)
 			private_ctx->rflags |= LTTNG_RFLAG_EXTENDED;
+		client_ctx.compact_id = event_id;
 		break;
 	case 2:	/* large */
 		if (event_id > 65534)
 			private_ctx->rflags |= LTTNG_RFLAG_EXTENDED;
 		break;
+	case 3:	/* varint */
+		client_ctx.event_id_len = lttng_ust_varint_len(event_id);
+		break;
+	case 4:	/* compact, hot IDs */
+		if (caa_unlikely(!(++URCU_TLS(hot_id_sample) % LTTNG_HOT_ID_SAMPLE_PERIOD)))
+			lttng_hot_ids_sample(lttng_chan->priv, event_recorder->priv,
+					event_id);
+		client_ctx.event_id = event_id;
+		client_ctx.hot_id = event_recorder->priv->hot_id;
+		break;
 	default:
 		WARN_ON_ONCE(1);
 	}
@@ -838,6 +1239,10 @@ put:
 static
 void lttng_event_commit(struct lttng_ust_ring_buffer_ctx *ctx)
 {
+	if (caa_unlikely(ctx->priv->stage)) {
+		lttng_fragment_commit(ctx);
+		return;
+	}
 	lib_ring_buffer_commit(&client_config, ctx);
 	lib_ring_buffer_nesting_dec(&client_config);
 }
@@ -846,14 +1251,54 @@ static
 void lttng_event_write(struct lttng_ust_ring_buffer_ctx *ctx,
 		const void *src, size_t len, size_t alignment)
 {
+	struct lttng_ust_ring_buffer_ctx_private *private_ctx = ctx->priv;
+
 	lttng_ust_ring_buffer_align_ctx(ctx, alignment);
+	if (caa_unlikely(private_ctx->stage)) {
+		memcpy(private_ctx->stage + private_ctx->buf_offset, src, len);
+		private_ctx->buf_offset += len;
+		return;
+	}
 	lib_ring_buffer_write(&client_config, ctx, src, len);
 }
 
+/* Same output as lib_ring_buffer_strcpy(), into the staged record. */
+static
+void lttng_stage_strcpy(struct lttng_ust_ring_buffer_ctx_private *private_ctx,
+		const char *src, size_t len, char pad)
+{
+	char *p = private_ctx->stage + private_ctx->buf_offset;
+	size_t count;
+
+	if (caa_unlikely(!len))
+		return;
+	count = lib_ring_buffer_do_strcpy(&client_config, p, src, len - 1);
+	lib_ring_buffer_do_memset(p + count, pad, len - 1 - count);
+	p[len - 1] = '\0';
+	private_ctx->buf_offset += len;
+}
+
+/* Same output as lib_ring_buffer_pstrcpy(), into the staged record. */
+static
+void lttng_stage_pstrcpy(struct lttng_ust_ring_buffer_ctx_private *private_ctx,
+		const char *src, size_t len, char pad)
+{
+	char *p = private_ctx->stage + private_ctx->buf_offset;
+	size_t count;
+
+	count = lib_ring_buffer_do_strcpy(&client_config, p, src, len);
+	lib_ring_buffer_do_memset(p + count, pad, len - count);
+	private_ctx->buf_offset += len;
+}
+
 static
 void lttng_event_strcpy(struct lttng_ust_ring_buffer_ctx *ctx,
 		const char *src, size_t len)
 {
+	if (caa_unlikely(ctx->priv->stage)) {
+		lttng_stage_strcpy(ctx->priv, src, len, '#');
+		return;
+	}
 	lib_ring_buffer_strcpy(&client_config, ctx, src, len, '#');
 }
 
@@ -861,6 +1306,10 @@ static
 void lttng_event_pstrcpy_pad(struct lttng_ust_ring_buffer_ctx *ctx,
 		const char *src, size_t len)
 {
+	if (caa_unlikely(ctx->priv->stage)) {
+		lttng_stage_pstrcpy(ctx->priv, src, len, '\0');
+		return;
+	}
 	lib_ring_buffer_pstrcpy(&client_config, ctx, src, len, '\0');
 }
 
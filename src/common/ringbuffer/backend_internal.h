@@ -41,7 +41,8 @@ int channel_backend_init(struct channel_backend *chanb,
 			 const char *name,
 			 const struct lttng_ust_ring_buffer_config *config,
 			 size_t subbuf_size,
-			 size_t num_subbuf, struct lttng_ust_shm_handle *handle,
+			 size_t num_subbuf, int snapshot_sb,
+			 struct lttng_ust_shm_handle *handle,
 			 const int *stream_fds)
 	__attribute__((visibility("hidden")));
 
@@ -203,6 +204,23 @@ int subbuffer_id_check_index(const struct lttng_ust_ring_buffer_config *config,
 		return 0;
 }
 
+/*
+ * Number of backend pages allocated per buffer: the writer subbuffers,
+ * the reader subbuffer in overwrite mode, and the spare snapshot
+ * subbuffers, in this index order.
+ */
+static inline
+unsigned long channel_backend_num_subbuf_alloc(const struct channel_backend *chanb)
+{
+	unsigned long num_subbuf_alloc = chanb->num_subbuf;
+
+	if (chanb->extra_reader_sb)
+		num_subbuf_alloc++;
+	if (chanb->snapshot_sb)
+		num_subbuf_alloc += chanb->num_subbuf;
+	return num_subbuf_alloc;
+}
+
 static inline
 int lib_ring_buffer_backend_get_pages(const struct lttng_ust_ring_buffer_config *config,
 			const struct lttng_ust_ring_buffer_ctx *ctx,
@@ -538,15 +556,18 @@ void lib_ring_buffer_set_noref_offset(const struct lttng_ust_ring_buffer_config
 }
 
 /**
- * update_read_sb_index - Read-side subbuffer index update.
+ * exchange_read_sb - Exchange a reader-owned subbuffer with a writer one.
+ *
+ * @rsb is either the reader subbuffer or one of the subbuffers holding a
+ * swapped snapshot.
  */
 static inline
-int update_read_sb_index(const struct lttng_ust_ring_buffer_config *config,
-			 struct lttng_ust_ring_buffer_backend *bufb,
-			 struct channel_backend *chanb __attribute__((unused)),
-			 unsigned long consumed_idx,
-			 unsigned long consumed_count,
-			 struct lttng_ust_shm_handle *handle)
+int exchange_read_sb(const struct lttng_ust_ring_buffer_config *config,
+		     struct lttng_ust_ring_buffer_backend *bufb,
+		     struct lttng_ust_ring_buffer_backend_subbuffer *rsb,
+		     unsigned long consumed_idx,
+		     unsigned long consumed_count,
+		     struct lttng_ust_shm_handle *handle)
 {
 	struct lttng_ust_ring_buffer_backend_subbuffer *wsb;
 	unsigned long old_id, new_id;
@@ -577,20 +598,35 @@ int update_read_sb_index(const struct lttng_ust_ring_buffer_config *config,
 		chan = shmp(handle, bufb->chan);
 		if (caa_unlikely(!chan))
 			return -EPERM;
-		CHAN_WARN_ON(chan, !subbuffer_id_is_noref(config, bufb->buf_rsb.id));
-		subbuffer_id_set_noref_offset(config, &bufb->buf_rsb.id,
+		CHAN_WARN_ON(chan, !subbuffer_id_is_noref(config, rsb->id));
+		subbuffer_id_set_noref_offset(config, &rsb->id,
 					      consumed_count);
-		new_id = uatomic_cmpxchg(&wsb->id, old_id, bufb->buf_rsb.id);
+		new_id = uatomic_cmpxchg(&wsb->id, old_id, rsb->id);
 		if (caa_unlikely(old_id != new_id))
 			return -EAGAIN;
-		bufb->buf_rsb.id = new_id;
+		rsb->id = new_id;
 	} else {
 		/* No page exchange, use the writer page directly */
-		bufb->buf_rsb.id = wsb->id;
+		rsb->id = wsb->id;
 	}
 	return 0;
 }
 
+/**
+ * update_read_sb_index - Read-side subbuffer index update.
+ */
+static inline
+int update_read_sb_index(const struct lttng_ust_ring_buffer_config *config,
+			 struct lttng_ust_ring_buffer_backend *bufb,
+			 struct channel_backend *chanb __attribute__((unused)),
+			 unsigned long consumed_idx,
+			 unsigned long consumed_count,
+			 struct lttng_ust_shm_handle *handle)
+{
+	return exchange_read_sb(config, bufb, &bufb->buf_rsb, consumed_idx,
+				consumed_count, handle);
+}
+
 #ifndef inline_memcpy
 #define inline_memcpy(dest, src, n)	memcpy(dest, src, n)
 #endif
@@ -14,13 +14,15 @@
 #include "shm_internal.h"
 #include "vatomic.h"
 
-#define RB_BACKEND_PAGES_PADDING	16
+#define RB_BACKEND_PAGES_PADDING	4
 struct lttng_ust_ring_buffer_backend_pages {
 	unsigned long mmap_offset;	/* offset of the subbuffer in mmap */
 	union v_atomic records_commit;	/* current records committed count */
 	union v_atomic records_unread;	/* records to read */
 	unsigned long data_size;	/* Amount of data to read from subbuf */
 	DECLARE_SHMP(char, p);		/* Backing memory map */
+	uint64_t content_crc_tag;	/* Packet sequence number + 1, 0: none */
+	uint32_t content_crc;		/* CRC32C of the packet content */
 	char padding[RB_BACKEND_PAGES_PADDING];
 };
 
@@ -44,6 +46,7 @@ struct lttng_ust_ring_buffer_backend_counts {
  */
 struct lttng_ust_ring_buffer_channel;
 struct lttng_ust_ring_buffer;
+struct lttng_ust_ring_buffer_stats;
 
 struct lttng_ust_ring_buffer_backend_pages_shmp {
 	DECLARE_SHMP(struct lttng_ust_ring_buffer_backend_pages, shmp);
@@ -68,7 +71,18 @@ struct lttng_ust_ring_buffer_backend {
 	int cpu;			/* This buffer's cpu. -1 if per-channel. */
 	union v_atomic records_read;	/* Number of records read */
 	unsigned int allocated:1;	/* is buffer allocated ? */
-	char padding[RB_BACKEND_RING_BUFFER_PADDING];
+	/*
+	 * Array of ring_buffer_backend_subbuffer holding the sub-buffers
+	 * of a swapped snapshot, for reader. Only allocated with spare
+	 * snapshot sub-buffers.
+	 */
+	DECLARE_SHMP(struct lttng_ust_ring_buffer_backend_subbuffer, buf_ssb);
+	/*
+	 * Live statistics of the frontend buffer, kept here for lack of
+	 * room in struct lttng_ust_ring_buffer.
+	 */
+	DECLARE_SHMP(struct lttng_ust_ring_buffer_stats, stats);
+	char padding[RB_BACKEND_RING_BUFFER_PADDING - 2 * sizeof(struct shm_ref)];
 };
 
 struct lttng_ust_ring_buffer_shmp {
@@ -86,6 +100,7 @@ struct channel_backend {
 					 */
 	unsigned int buf_size_order;	/* Order of buffer size */
 	unsigned int extra_reader_sb:1;	/* has extra reader subbuffer ? */
+	unsigned int snapshot_sb:1;	/* has spare snapshot subbuffers ? */
 	unsigned long num_subbuf;	/* Number of sub-buffers for writer */
 	uint64_t start_timestamp;	/* Channel creation timestamp value */
 	DECLARE_SHMP(void *, priv_data);/* Client-specific information */
@@ -0,0 +1,261 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Blob arena.
+ *
+ * The payloads of the lttng_ust_field_blob() fields are copied once
+ * into a shared memory arena of the traced process, and the ring buffer
+ * records only hold a reference to them: (offset, length, generation).
+ * Small events stay small in the sub-buffers, and large payloads are
+ * not copied again by the consumer until it resolves the reference.
+ *
+ * Space is handed out by a lock-free bump allocator on a monotonic
+ * logical position. The data area is used as a circular buffer: a
+ * payload never straddles its end, and the generation of a payload is
+ * the number of times the position wrapped before it, plus one. Writers
+ * never wait for readers; a payload is reclaimed implicitly once the
+ * position moves more than one data area past it, which readers detect
+ * by checking the position after copying the payload out.
+ *
+ * The arena is found by a name derived from the PID of its process, so
+ * a random instance ID, recorded in each reference, tells it apart from
+ * the arena of a previous process which had the same PID.
+ */
+
+#define _LGPL_SOURCE
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_RANDOM_H
+#include <sys/random.h>
+#endif
+
+#include <urcu/arch.h>
+#include <urcu/compiler.h>
+#include <urcu/uatomic.h>
+
+#include "common/align.h"
+#include "common/logging.h"
+#include "common/macros.h"
+#include "blob_arena.h"
+#include "shm.h"
+
+#define BLOB_ARENA_MAGIC	0x424c4f42U	/* "BLOB" */
+#define BLOB_ALIGN		8
+
+/* Shared header of the arena, followed by the data area. */
+struct blob_arena_header {
+	uint32_t magic;			/* Set once initialized. */
+	uint32_t bits_per_long;		/* Of the traced process. */
+	uint64_t data_size;		/* Power of two. */
+	uint64_t instance_id;		/* Random, never 0. */
+	/* Logical position of the next payload, alone in its cache line. */
+	unsigned long head __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
+} __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
+
+struct lttng_ust_blob_arena {
+	struct shm_object_table *table;
+	struct blob_arena_header *header;
+	char *data;
+	size_t data_size;
+	uint64_t instance_id;
+};
+
+/*
+ * Random ID of a new arena. Without getrandom(2), mix the time and the
+ * PID, which still differ from those of a previous process with the
+ * same PID.
+ */
+static
+uint64_t blob_arena_new_instance_id(void)
+{
+	struct timespec ts = { 0, 0 };
+	uint64_t id = 0;
+
+#if defined(HAVE_GETRANDOM) && defined(HAVE_SYS_RANDOM_H)
+	if (getrandom(&id, sizeof(id), GRND_NONBLOCK) == sizeof(id) && id)
+		return id;
+#endif
+	(void) clock_gettime(CLOCK_REALTIME, &ts);
+	id = ((uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec)
+		^ ((uint64_t) getpid() << 32);
+	return id ? id : 1;
+}
+
+static
+bool blob_arena_size_is_valid(uint64_t data_size)
+{
+	return data_size >= LTTNG_UST_BLOB_ARENA_MIN_SIZE
+		&& data_size <= LTTNG_UST_BLOB_ARENA_MAX_SIZE
+		&& !(data_size & (data_size - 1));
+}
+
+struct lttng_ust_blob_arena *lttng_ust_blob_arena_create(int shm_fd,
+		size_t data_size, bool populate)
+{
+	struct lttng_ust_blob_arena *arena;
+	struct shm_object *obj;
+	struct shm_ref header_ref, data_ref;
+
+	if (!blob_arena_size_is_valid(data_size))
+		return NULL;
+	arena = zmalloc(sizeof(*arena));
+	if (!arena)
+		return NULL;
+	arena->table = shm_object_table_create(1, populate);
+	if (!arena->table)
+		goto error_table;
+	obj = shm_object_table_map_shm(arena->table, shm_fd,
+			sizeof(struct blob_arena_header) + data_size,
+			true, populate);
+	if (!obj)
+		goto error_map;
+	header_ref = zalloc_shm(obj, sizeof(struct blob_arena_header));
+	data_ref = zalloc_shm(obj, data_size);
+	arena->header = (struct blob_arena_header *)
+		_shmp_offset(arena->table, &header_ref, 0,
+			sizeof(struct blob_arena_header));
+	arena->data = _shmp_offset(arena->table, &data_ref, 0, data_size);
+	assert(arena->header && arena->data);
+	arena->data_size = data_size;
+	arena->instance_id = blob_arena_new_instance_id();
+
+	arena->header->bits_per_long = CAA_BITS_PER_LONG;
+	arena->header->data_size = data_size;
+	arena->header->instance_id = arena->instance_id;
+	/* Publish the header before the magic number. */
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(arena->header->magic, BLOB_ARENA_MAGIC);
+	return arena;
+
+error_map:
+	shm_object_table_destroy(arena->table, 0);
+error_table:
+	free(arena);
+	return NULL;
+}
+
+struct lttng_ust_blob_arena *lttng_ust_blob_arena_map(int shm_fd)
+{
+	struct lttng_ust_blob_arena *arena;
+	struct blob_arena_header *header;
+	struct shm_object *obj;
+	struct shm_ref header_ref = { 0, 0 };
+	struct stat statbuf;
+	uint64_t data_size;
+
+	if (fstat(shm_fd, &statbuf))
+		return NULL;
+	if (statbuf.st_size < (off_t) sizeof(struct blob_arena_header))
+		return NULL;
+	arena = zmalloc(sizeof(*arena));
+	if (!arena)
+		return NULL;
+	arena->table = shm_object_table_create(1, false);
+	if (!arena->table)
+		goto error_table;
+	obj = shm_object_table_map_shm(arena->table, shm_fd,
+			statbuf.st_size, false, false);
+	if (!obj)
+		goto error_map;
+	header = (struct blob_arena_header *)
+		_shmp_offset(arena->table, &header_ref, 0,
+			sizeof(struct blob_arena_header));
+	if (CMM_LOAD_SHARED(header->magic) != BLOB_ARENA_MAGIC)
+		goto error_header;
+	cmm_smp_rmb();
+	data_size = header->data_size;
+	if (header->bits_per_long != CAA_BITS_PER_LONG
+			|| !header->instance_id
+			|| !blob_arena_size_is_valid(data_size)
+			|| obj->memory_map_size
+				!= sizeof(struct blob_arena_header) + data_size)
+		goto error_header;
+	arena->header = header;
+	arena->data = obj->memory_map + sizeof(struct blob_arena_header);
+	arena->data_size = data_size;
+	arena->instance_id = header->instance_id;
+	return arena;
+
+error_header:
+	/* Leave @shm_fd to the caller. */
+	obj->shm_fd_ownership = 0;
+error_map:
+	shm_object_table_destroy(arena->table, 1);
+error_table:
+	free(arena);
+	return NULL;
+}
+
+void lttng_ust_blob_arena_destroy(struct lttng_ust_blob_arena *arena,
+		int consumer)
+{
+	shm_object_table_destroy(arena->table, consumer);
+	free(arena);
+}
+
+int lttng_ust_blob_arena_write(struct lttng_ust_blob_arena *arena,
+		const void *src, size_t len, struct lttng_ust_blob_ref *ref)
+{
+	unsigned long mask = arena->data_size - 1;
+	unsigned long old_head, head, begin;
+	size_t alloc_len;
+
+	if (caa_unlikely(len > arena->data_size))
+		return -E2BIG;
+	alloc_len = LTTNG_UST_ALIGN(len, BLOB_ALIGN);
+	old_head = uatomic_read(&arena->header->head);
+	for (;;) {
+		begin = old_head;
+		/* Skip to the next generation rather than straddle the end. */
+		if ((begin & mask) + len > arena->data_size)
+			begin = (begin | mask) + 1;
+		head = uatomic_cmpxchg(&arena->header->head, old_head,
+				begin + alloc_len);
+		if (caa_likely(head == old_head))
+			break;
+		old_head = head;
+	}
+	/*
+	 * The payload is ordered before the record referencing it by the
+	 * barrier of the ring buffer commit.
+	 */
+	memcpy(arena->data + (begin & mask), src, len);
+	ref->length = len;
+	ref->offset = begin & mask;
+	ref->generation = (uint64_t) (begin / arena->data_size) + 1;
+	ref->arena_id = arena->instance_id;
+	return 0;
+}
+
+int lttng_ust_blob_arena_read(struct lttng_ust_blob_arena *arena,
+		const struct lttng_ust_blob_ref *ref, void *dst)
+{
+	uint64_t offset = ref->offset, length = ref->length;
+	unsigned long begin, head;
+
+	if (!ref->generation)
+		return -ENOENT;
+	if (ref->arena_id != arena->instance_id)
+		return -ESTALE;
+	if (length > arena->data_size
+			|| offset > arena->data_size - length)
+		return -EINVAL;
+	begin = (unsigned long) ((ref->generation - 1) * arena->data_size + offset);
+	head = uatomic_read(&arena->header->head);
+	if (head - begin > arena->data_size)
+		return -ESTALE;
+	memcpy(dst, arena->data + offset, length);
+	/* Check the payload was not overwritten while copying it out. */
+	cmm_smp_rmb();
+	head = uatomic_read(&arena->header->head);
+	if (head - begin > arena->data_size)
+		return -ESTALE;
+	return 0;
+}
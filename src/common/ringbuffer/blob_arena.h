@@ -0,0 +1,67 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Blob arena: per-process shared memory area holding the payloads of the
+ * lttng_ust_field_blob() fields, referenced from the ring buffer records.
+ */
+
+#ifndef _LTTNG_RING_BUFFER_BLOB_ARENA_H
+#define _LTTNG_RING_BUFFER_BLOB_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <lttng/ust-events.h>
+
+/* Name of the POSIX shm object of the blob arena of a process, by PID. */
+#define LTTNG_UST_BLOB_ARENA_NAME_FMT	"/lttng-ust-blob-%d"
+#define LTTNG_UST_BLOB_ARENA_NAME_LEN	32
+
+#define LTTNG_UST_BLOB_ARENA_MIN_SIZE	4096UL
+#define LTTNG_UST_BLOB_ARENA_MAX_SIZE	(1UL << 30)
+
+struct lttng_ust_blob_arena;
+
+/*
+ * Create an arena with a data area of @data_size bytes, a power of two,
+ * in the POSIX shm object @shm_fd. On success, the arena takes ownership
+ * of @shm_fd.
+ */
+struct lttng_ust_blob_arena *lttng_ust_blob_arena_create(int shm_fd,
+		size_t data_size, bool populate)
+	__attribute__((visibility("hidden")));
+
+/*
+ * Map read-only the arena created by another process in the POSIX shm
+ * object @shm_fd. On success, the arena takes ownership of @shm_fd.
+ */
+struct lttng_ust_blob_arena *lttng_ust_blob_arena_map(int shm_fd)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_blob_arena_destroy(struct lttng_ust_blob_arena *arena,
+		int consumer)
+	__attribute__((visibility("hidden")));
+
+/*
+ * Copy @len bytes from @src into the arena and fill @ref. Never blocks:
+ * the oldest payloads are overwritten when the arena wraps. Returns 0,
+ * or -E2BIG if the payload is larger than the data area.
+ */
+int lttng_ust_blob_arena_write(struct lttng_ust_blob_arena *arena,
+		const void *src, size_t len, struct lttng_ust_blob_ref *ref)
+	__attribute__((visibility("hidden")));
+
+/*
+ * Copy the payload referenced by @ref into @dst. Returns 0, -ENOENT if
+ * the payload was not copied into the arena, -EINVAL if the reference
+ * does not fit the arena, or -ESTALE if the payload was overwritten or
+ * belongs to another instance of the arena.
+ */
+int lttng_ust_blob_arena_read(struct lttng_ust_blob_arena *arena,
+		const struct lttng_ust_blob_ref *ref, void *dst)
+	__attribute__((visibility("hidden")));
+
+#endif /* _LTTNG_RING_BUFFER_BLOB_ARENA_H */
@@ -51,7 +51,8 @@ struct lttng_ust_shm_handle *channel_create(const struct lttng_ust_ring_buffer_c
 				unsigned int switch_timer_interval,
 				unsigned int read_timer_interval,
 				const int *stream_fds, int nr_stream_fds,
-				int64_t blocking_timeout)
+				int64_t blocking_timeout,
+				uint32_t wakeup_flags)
 	__attribute__((visibility("hidden")));
 
 /*
@@ -142,6 +143,21 @@ extern int lib_ring_buffer_snapshot_sample_positions(
 				    struct lttng_ust_shm_handle *handle)
 	__attribute__((visibility("hidden")));
 
+/*
+ * Swapped snapshot read sequence: snapshot_swap, many get_subbuf/put_subbuf
+ * within the returned positions, snapshot_release. Requires a channel
+ * created with spare snapshot sub-buffers.
+ */
+extern int lib_ring_buffer_snapshot_swap(struct lttng_ust_ring_buffer *buf,
+					 unsigned long *consumed,
+					 unsigned long *produced,
+					 struct lttng_ust_shm_handle *handle)
+	__attribute__((visibility("hidden")));
+
+extern void lib_ring_buffer_snapshot_release(struct lttng_ust_ring_buffer *buf,
+					     struct lttng_ust_shm_handle *handle)
+	__attribute__((visibility("hidden")));
+
 extern void lib_ring_buffer_move_consumer(struct lttng_ust_ring_buffer *buf,
 					  unsigned long consumed_new,
 					  struct lttng_ust_shm_handle *handle)
@@ -251,10 +251,21 @@ void lib_ring_buffer_commit(const struct lttng_ust_ring_buffer_config *config,
 	unsigned long commit_count;
 	struct commit_counters_hot *cc_hot = shmp_index(handle,
 						buf->commit_hot, endidx);
+	struct lttng_ust_ring_buffer_stats *stats;
+	unsigned int nesting;
 
 	if (caa_unlikely(!cc_hot))
 		return;
 
+	stats = lib_ring_buffer_stats(buf, handle);
+	if (caa_likely(stats)) {
+		stats->records_written++;
+		stats->bytes_written += ctx_private->slot_size;
+		nesting = lib_ring_buffer_nesting_count(config);
+		if (caa_unlikely(nesting > stats->max_nesting))
+			stats->max_nesting = nesting;
+	}
+
 	/*
 	 * Must count record before incrementing the commit count.
 	 */
@@ -17,7 +17,9 @@
 #include <stdint.h>
 #include <pthread.h>
 
+#include <lttng/ust-endian.h>
 #include <lttng/ust-ringbuffer-context.h>
+#include "common/compat/shared-futex.h"
 #include "ringbuffer-config.h"
 #include "backend_types.h"
 #include "backend_internal.h"
@@ -198,6 +200,36 @@ void lib_ring_buffer_reserve_push_reader(struct lttng_ust_ring_buffer *buf,
 					      consumed_new) != consumed_old));
 }
 
+/*
+ * Futex word the producers of a blocking channel wait on when the
+ * buffer is full: the 32 low-order bits of the consumed position.
+ */
+static inline
+int32_t *lib_ring_buffer_consumed_futex(struct lttng_ust_ring_buffer *buf)
+{
+	int32_t *word = (int32_t *) &buf->consumed;
+
+#if (LTTNG_UST_BYTE_ORDER == LTTNG_UST_BIG_ENDIAN)
+	word += sizeof(buf->consumed) / sizeof(int32_t) - 1;
+#endif
+	return word;
+}
+
+/*
+ * Wake up the producers waiting for space after the consumed position
+ * moved forward. The caller must order the consumed position update
+ * before this call with a full memory barrier (a successful
+ * uatomic_cmpxchg()), which pairs with the barrier between the waiters
+ * increment and the futex wait of the producers.
+ */
+static inline
+void lib_ring_buffer_wake_blocked_writers(struct lttng_ust_ring_buffer *buf)
+{
+	if (caa_unlikely(uatomic_read(&buf->consumed_waiters)))
+		(void) lttng_ust_shared_futex_wake(
+				lib_ring_buffer_consumed_futex(buf), INT32_MAX);
+}
+
 /*
  * Move consumed position to the beginning of subbuffer in which the
  * write offset is. Should only be used on ring buffers that are not
@@ -229,6 +261,7 @@ void lib_ring_buffer_clear_reader(struct lttng_ust_ring_buffer *buf,
 		consumed_new = subbuf_trunc(offset, chan);
 	} while (caa_unlikely(uatomic_cmpxchg(&buf->consumed, consumed_old,
 					      consumed_new) != consumed_old));
+	lib_ring_buffer_wake_blocked_writers(buf);
 }
 
 static inline
@@ -350,6 +383,24 @@ void lib_ring_buffer_write_commit_counter(
 		v_set(config, &cc_hot->seq, commit_count);
 }
 
+/*
+ * Live statistics of @buf, NULL if the buffer has none. See struct
+ * lttng_ust_ring_buffer_stats for the update rules.
+ *
+ * A buffer created by a version without statistics leaves the reference
+ * zeroed in the backend padding, and offset 0 holds the buffer itself:
+ * never resolve such a reference.
+ */
+static inline
+struct lttng_ust_ring_buffer_stats *lib_ring_buffer_stats(
+		struct lttng_ust_ring_buffer *buf,
+		struct lttng_ust_shm_handle *handle)
+{
+	if (caa_unlikely(!buf->backend.stats._ref.offset))
+		return NULL;
+	return shmp(handle, buf->backend.stats);
+}
+
 extern int lib_ring_buffer_create(struct lttng_ust_ring_buffer *buf,
 				  struct channel_backend *chanb, int cpu,
 				  struct lttng_ust_shm_handle *handle,
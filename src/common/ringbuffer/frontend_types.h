@@ -62,6 +62,12 @@ struct lttng_ust_ring_buffer_channel {
 		struct {
 			int32_t blocking_timeout_ms;
 			void *priv;		/* Private data pointer. */
+			uint32_t wakeup_flags;	/* RING_BUFFER_WAKEUP_* */
+			uint32_t read_timer_cur_interval; /*
+							   * Adaptive reader wakeup
+							   * period (us), 0 when the
+							   * read timer is stopped.
+							   */
 		} s;
 		char padding[RB_CHANNEL_PADDING];
 	} u;
@@ -96,6 +102,38 @@ struct commit_counters_cold {
 	};
 } __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
 
+/*
+ * Short event IDs of a packet, one table per sub-buffer backend pages
+ * so it follows the pages exchanged with the reader. Written by the
+ * client when it opens the packet and tagged with the packet sequence
+ * number plus one, so a stale table is never used for a later packet.
+ */
+#define RB_NR_HOT_IDS			31
+
+struct lttng_ust_ring_buffer_hot_ids {
+	uint64_t tag;			/* Packet sequence number + 1, 0: none */
+	uint32_t version;		/* Version of the client table */
+	uint32_t ids[RB_NR_HOT_IDS];	/* Event ID of each short ID */
+};
+
+/*
+ * Live statistics of a buffer, read by the consumer while tracing.
+ *
+ * The producers update the counters with plain, non-atomic operations
+ * to keep them off the atomic operations of the fast path: they are
+ * exact for a per-CPU buffer written by a single thread at a time, and
+ * may miss updates racing between threads writing the same buffer
+ * (preemption, migration or per-channel buffers).
+ */
+struct lttng_ust_ring_buffer_stats {
+	uint64_t records_written;	/* Records committed */
+	uint64_t bytes_written;		/* Bytes of the committed records */
+	uint64_t reserve_slow;		/* Reservations taking the slow path */
+	uint64_t switches;		/* Sub-buffers closed */
+	uint64_t blocking_retries;	/* Waits of blocking reservations */
+	uint32_t max_nesting;		/* Deepest reservation nesting */
+} __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
+
 /* ring buffer state */
 #define RB_CRASH_DUMP_ABI_LEN		256
 #define RB_RING_BUFFER_PADDING		60
@@ -229,9 +267,34 @@ struct lttng_ust_ring_buffer {
 	unsigned long prod_snapshot;	/* Producer count snapshot */
 	unsigned long cons_snapshot;	/* Consumer count snapshot */
 	unsigned int get_subbuf:1;	/* Sub-buffer being held by reader */
+	unsigned int get_subbuf_swapped:1;	/* Held sub-buffer is from swapped snapshot */
+	unsigned int snapshot_swapped:1;	/* Reader holds a swapped snapshot */
 	/* shmp pointer to self */
 	DECLARE_SHMP(struct lttng_ust_ring_buffer, self);
-	char padding[RB_RING_BUFFER_PADDING];
+	/* Read timer state, only accessed by the timer handler. */
+	unsigned long read_timer_offset;	/* Write offset at last tick */
+	unsigned long read_timer_consumed;	/* Consumed at last wakeup */
+	/*
+	 * Channel-wide futex wakeup (RING_BUFFER_WAKEUP_FUTEX), only
+	 * used in the buffer of stream 0.
+	 */
+	int32_t wakeup_seq;		/* Incremented on each wakeup */
+	int32_t wakeup_waiters;		/* Number of consumers waiting */
+	/* Short event IDs per sub-buffer backend pages. */
+	DECLARE_SHMP(struct lttng_ust_ring_buffer_hot_ids, hot_ids);
+	/*
+	 * Positions of the swapped snapshot held by the reader in the
+	 * backend buf_ssb, only accessed by the reader.
+	 */
+	unsigned long swap_consumed;
+	unsigned long swap_produced;
+	/*
+	 * Number of producers of a blocking channel waiting on the
+	 * consumed position futex.
+	 */
+	int32_t consumed_waiters;
+	char padding[RB_RING_BUFFER_PADDING - 4 * sizeof(unsigned long)
+		- 3 * sizeof(int32_t) - sizeof(struct shm_ref)];
 } __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
 
 /*
@@ -275,6 +338,13 @@ struct lttng_ust_ring_buffer_ctx_private {
 	unsigned long records_lost_full;
 	unsigned long records_lost_wrap;
 	unsigned long records_lost_big;
+
+	/*
+	 * Record too large for a sub-buffer, staged from buf_offset 0 and
+	 * written in chunks of stage_chunk_len bytes on commit.
+	 */
+	char *stage;
+	size_t stage_chunk_len;
 };
 
 static inline
@@ -13,4 +13,8 @@ void lttng_ringbuffer_alloc_tls(void)
 void lttng_ust_ringbuffer_set_allow_blocking(void)
 	__attribute__((visibility("hidden")));
 
+void lttng_ust_ringbuffer_set_read_timer_bounds(unsigned long min_interval,
+		unsigned long max_interval)
+	__attribute__((visibility("hidden")));
+
 #endif /* _LTTNG_UST_RINGBUFFER_RB_INIT_H */
@@ -54,6 +54,8 @@ int lib_ring_buffer_backend_allocate(const struct lttng_ust_ring_buffer_config *
 
 	if (extra_reader_sb)
 		num_subbuf_alloc++;
+	if (chanb->snapshot_sb)
+		num_subbuf_alloc += num_subbuf;
 
 	page_size = LTTNG_UST_PAGE_SIZE;
 	if (page_size <= 0) {
@@ -105,8 +107,7 @@ int lib_ring_buffer_backend_allocate(const struct lttng_ust_ring_buffer_config *
 
 	/* Assign read-side subbuffer table */
 	if (extra_reader_sb)
-		bufb->buf_rsb.id = subbuffer_id(config, 0, 1,
-						num_subbuf_alloc - 1);
+		bufb->buf_rsb.id = subbuffer_id(config, 0, 1, num_subbuf);
 	else
 		bufb->buf_rsb.id = subbuffer_id(config, 0, 1, 0);
 
@@ -118,6 +119,25 @@ int lib_ring_buffer_backend_allocate(const struct lttng_ust_ring_buffer_config *
 	if (caa_unlikely(!shmp(handle, bufb->buf_cnt)))
 		goto free_wsb;
 
+	/* Allocate snapshot subbuffer table, assigned the spare subbuffers */
+	if (chanb->snapshot_sb) {
+		align_shm(shmobj, __alignof__(struct lttng_ust_ring_buffer_backend_subbuffer));
+		set_shmp(bufb->buf_ssb, zalloc_shm(shmobj,
+					sizeof(struct lttng_ust_ring_buffer_backend_subbuffer)
+					* num_subbuf));
+		if (caa_unlikely(!shmp(handle, bufb->buf_ssb)))
+			goto free_wsb;
+
+		for (i = 0; i < num_subbuf; i++) {
+			struct lttng_ust_ring_buffer_backend_subbuffer *sb;
+
+			sb = shmp_index(handle, bufb->buf_ssb, i);
+			if (!sb)
+				goto free_wsb;
+			sb->id = subbuffer_id(config, 0, 1, num_subbuf + 1 + i);
+		}
+	}
+
 	/* Assign pages to page index */
 	for (i = 0; i < num_subbuf_alloc; i++) {
 		struct lttng_ust_ring_buffer_backend_pages_shmp *sbp;
@@ -182,9 +202,7 @@ void lib_ring_buffer_backend_reset(struct lttng_ust_ring_buffer_backend *bufb,
 		return;
 	config = &chanb->config;
 
-	num_subbuf_alloc = chanb->num_subbuf;
-	if (chanb->extra_reader_sb)
-		num_subbuf_alloc++;
+	num_subbuf_alloc = channel_backend_num_subbuf_alloc(chanb);
 
 	for (i = 0; i < chanb->num_subbuf; i++) {
 		struct lttng_ust_ring_buffer_backend_subbuffer *sb;
@@ -196,9 +214,20 @@ void lib_ring_buffer_backend_reset(struct lttng_ust_ring_buffer_backend *bufb,
 	}
 	if (chanb->extra_reader_sb)
 		bufb->buf_rsb.id = subbuffer_id(config, 0, 1,
-						num_subbuf_alloc - 1);
+						chanb->num_subbuf);
 	else
 		bufb->buf_rsb.id = subbuffer_id(config, 0, 1, 0);
+	if (chanb->snapshot_sb) {
+		for (i = 0; i < chanb->num_subbuf; i++) {
+			struct lttng_ust_ring_buffer_backend_subbuffer *sb;
+
+			sb = shmp_index(handle, bufb->buf_ssb, i);
+			if (!sb)
+				return;
+			sb->id = subbuffer_id(config, 0, 1,
+					      chanb->num_subbuf + 1 + i);
+		}
+	}
 
 	for (i = 0; i < num_subbuf_alloc; i++) {
 		struct lttng_ust_ring_buffer_backend_pages_shmp *sbp;
@@ -232,7 +261,8 @@ void channel_backend_reset(struct channel_backend *chanb)
 
 	/*
 	 * Don't reset buf_size, subbuf_size, subbuf_size_order,
-	 * num_subbuf_order, buf_size_order, extra_reader_sb, num_subbuf,
+	 * num_subbuf_order, buf_size_order, extra_reader_sb, snapshot_sb,
+	 * num_subbuf,
 	 * priv, notifiers, config, cpumask and name.
 	 */
 	chanb->start_timestamp = config->cb.ring_buffer_clock_read(chan);
@@ -246,6 +276,7 @@ void channel_backend_reset(struct channel_backend *chanb)
  * @parent: dentry of parent directory, %NULL for root directory
  * @subbuf_size: size of sub-buffers (> page size, power of 2)
  * @num_subbuf: number of sub-buffers (power of 2)
+ * @snapshot_sb: allocate spare sub-buffers for swapped snapshots
  * @lttng_ust_shm_handle: shared memory handle
  * @stream_fds: stream file descriptors.
  *
@@ -261,6 +292,7 @@ int channel_backend_init(struct channel_backend *chanb,
 			 const char *name,
 			 const struct lttng_ust_ring_buffer_config *config,
 			 size_t subbuf_size, size_t num_subbuf,
+			 int snapshot_sb,
 			 struct lttng_ust_shm_handle *handle,
 			 const int *stream_fds)
 {
@@ -296,8 +328,15 @@ int channel_backend_init(struct channel_backend *chanb,
 	 */
 	if (config->mode == RING_BUFFER_OVERWRITE && num_subbuf < 2)
 		return -EINVAL;
+	/*
+	 * Snapshots are only swapped out of overwrite mode buffers: the
+	 * consumer owns the unread sub-buffers in discard mode.
+	 */
+	if (snapshot_sb && config->mode != RING_BUFFER_OVERWRITE)
+		return -EINVAL;
 
-	ret = subbuffer_id_check_index(config, num_subbuf);
+	ret = subbuffer_id_check_index(config,
+			snapshot_sb ? 2 * num_subbuf : num_subbuf);
 	if (ret)
 		return ret;
 
@@ -308,6 +347,7 @@ int channel_backend_init(struct channel_backend *chanb,
 	chanb->num_subbuf_order = get_count_order(num_subbuf);
 	chanb->extra_reader_sb =
 			(config->mode == RING_BUFFER_OVERWRITE) ? 1 : 0;
+	chanb->snapshot_sb = snapshot_sb ? 1 : 0;
 	chanb->num_subbuf = num_subbuf;
 	strncpy(chanb->name, name, NAME_MAX);
 	chanb->name[NAME_MAX - 1] = '\0';
@@ -325,8 +365,16 @@ int channel_backend_init(struct channel_backend *chanb,
 	shmsize += sizeof(uint64_t) * num_subbuf;
 
 	/* Per-cpu buffer size: backend */
-	/* num_subbuf + 1 is the worse case */
+	/* num_subbuf + 1 is the worse case, doubled by the snapshot spares */
 	num_subbuf_alloc = num_subbuf + 1;
+	if (snapshot_sb)
+		num_subbuf_alloc += num_subbuf;
+	/* Short event IDs */
+	shmsize += lttng_ust_offset_align(shmsize, __alignof__(struct lttng_ust_ring_buffer_hot_ids));
+	shmsize += sizeof(struct lttng_ust_ring_buffer_hot_ids) * num_subbuf_alloc;
+	/* Live statistics */
+	shmsize += lttng_ust_offset_align(shmsize, __alignof__(struct lttng_ust_ring_buffer_stats));
+	shmsize += sizeof(struct lttng_ust_ring_buffer_stats);
 	shmsize += lttng_ust_offset_align(shmsize, __alignof__(struct lttng_ust_ring_buffer_backend_pages_shmp));
 	shmsize += sizeof(struct lttng_ust_ring_buffer_backend_pages_shmp) * num_subbuf_alloc;
 	shmsize += lttng_ust_offset_align(shmsize, page_size);
@@ -337,6 +385,10 @@ int channel_backend_init(struct channel_backend *chanb,
 	shmsize += sizeof(struct lttng_ust_ring_buffer_backend_subbuffer) * num_subbuf;
 	shmsize += lttng_ust_offset_align(shmsize, __alignof__(struct lttng_ust_ring_buffer_backend_counts));
 	shmsize += sizeof(struct lttng_ust_ring_buffer_backend_counts) * num_subbuf;
+	if (snapshot_sb) {
+		shmsize += lttng_ust_offset_align(shmsize, __alignof__(struct lttng_ust_ring_buffer_backend_subbuffer));
+		shmsize += sizeof(struct lttng_ust_ring_buffer_backend_subbuffer) * num_subbuf;
+	}
 
 	if (config->alloc == RING_BUFFER_ALLOC_PER_CPU) {
 		struct lttng_ust_ring_buffer *buf;
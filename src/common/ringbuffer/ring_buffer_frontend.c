@@ -63,6 +63,7 @@
 #include "shm.h"
 #include "rb-init.h"
 #include "common/compat/errno.h"	/* For ENODATA */
+#include "common/compat/shared-futex.h"
 #include "common/populate.h"
 
 /* Print DBG() messages about events lost only every 1048576 hits */
@@ -144,11 +145,26 @@ static struct timer_signal_data timer_signal = {
 
 static bool lttng_ust_allow_blocking;
 
+/*
+ * Bounds of the adaptive read timer period, in us. A bound set to 0 is
+ * replaced by the read timer period requested at channel creation.
+ */
+static bool read_timer_adaptive;
+static unsigned long read_timer_min_interval, read_timer_max_interval;
+
 void lttng_ust_ringbuffer_set_allow_blocking(void)
 {
 	lttng_ust_allow_blocking = true;
 }
 
+void lttng_ust_ringbuffer_set_read_timer_bounds(unsigned long min_interval,
+		unsigned long max_interval)
+{
+	read_timer_min_interval = min_interval;
+	read_timer_max_interval = max_interval;
+	read_timer_adaptive = true;
+}
+
 /* Get blocking timeout, in ms */
 static int lttng_ust_ringbuffer_get_timeout(struct lttng_ust_ring_buffer_channel *chan)
 {
@@ -171,6 +187,7 @@ void lib_ring_buffer_reset(struct lttng_ust_ring_buffer *buf,
 {
 	struct lttng_ust_ring_buffer_channel *chan;
 	const struct lttng_ust_ring_buffer_config *config;
+	struct lttng_ust_ring_buffer_stats *stats;
 	unsigned int i;
 
 	chan = shmp(handle, buf->backend.chan);
@@ -202,9 +219,18 @@ void lib_ring_buffer_reset(struct lttng_ust_ring_buffer *buf,
 		cc_cold->end_events_discarded = 0;
 		*ts_end = 0;
 	}
+	for (i = 0; i < channel_backend_num_subbuf_alloc(&chan->backend); i++) {
+		struct lttng_ust_ring_buffer_hot_ids *hot_ids;
+
+		hot_ids = shmp_index(handle, buf->hot_ids, i);
+		if (!hot_ids)
+			return;
+		hot_ids->tag = 0;
+	}
 	uatomic_set(&buf->consumed, 0);
 	uatomic_set(&buf->record_disabled, 0);
 	v_set(config, &buf->last_timestamp, 0);
+	buf->snapshot_swapped = 0;
 	lib_ring_buffer_backend_reset(&buf->backend, handle);
 	/* Don't reset number of active readers */
 	v_set(config, &buf->records_lost_full, 0);
@@ -212,6 +238,11 @@ void lib_ring_buffer_reset(struct lttng_ust_ring_buffer *buf,
 	v_set(config, &buf->records_lost_big, 0);
 	v_set(config, &buf->records_count, 0);
 	v_set(config, &buf->records_overrun, 0);
+	stats = lib_ring_buffer_stats(buf, handle);
+	if (stats)
+		memset(stats, 0, sizeof(*stats));
+	buf->read_timer_offset = 0;
+	buf->read_timer_consumed = 0;
 	buf->finalized = 0;
 }
 
@@ -375,6 +406,23 @@ int lib_ring_buffer_create(struct lttng_ust_ring_buffer *buf,
 		goto free_commit_cold;
 	}
 
+	align_shm(shmobj, __alignof__(struct lttng_ust_ring_buffer_hot_ids));
+	set_shmp(buf->hot_ids,
+		 zalloc_shm(shmobj,
+			sizeof(struct lttng_ust_ring_buffer_hot_ids)
+			* channel_backend_num_subbuf_alloc(&chan->backend)));
+	if (!shmp(handle, buf->hot_ids)) {
+		ret = -ENOMEM;
+		goto free_ts_end;
+	}
+
+	align_shm(shmobj, __alignof__(struct lttng_ust_ring_buffer_stats));
+	set_shmp(buf->backend.stats,
+		 zalloc_shm(shmobj, sizeof(struct lttng_ust_ring_buffer_stats)));
+	if (!shmp(handle, buf->backend.stats)) {
+		ret = -ENOMEM;
+		goto free_hot_ids;
+	}
 
 	ret = lib_ring_buffer_backend_create(&buf->backend, &chan->backend,
 			cpu, handle, shmobj);
@@ -422,6 +470,10 @@ int lib_ring_buffer_create(struct lttng_ust_ring_buffer *buf,
 
 	/* Error handling */
 free_init:
+	/* stats will be freed by shm teardown */
+free_hot_ids:
+	/* hot_ids will be freed by shm teardown */
+free_ts_end:
 	/* ts_end will be freed by shm teardown */
 free_commit_cold:
 	/* commit_cold will be freed by shm teardown */
@@ -524,33 +576,36 @@ int lib_ring_buffer_poll_deliver(const struct lttng_ust_ring_buffer_config *conf
 	return 1;
 }
 
+/*
+ * Wake-up the other end by writing a null byte in the pipe
+ * (non-blocking).  Important note: Because writing into the pipe is
+ * non-blocking (and therefore we allow dropping wakeup data, as long as
+ * there is wakeup data present in the pipe buffer to wake up the
+ * consumer), the consumer should perform the following sequence for
+ * waiting:
+ * 1) empty the pipe (reads).
+ * 2) check if there is data in the buffer.
+ * 3) wait on the pipe (poll).
+ *
+ * Writes are performed between sigpipe_block() and sigpipe_unblock() to
+ * discard the SIGPIPE from write(), not disturbing any SIGPIPE that
+ * might be already pending. If a bogus SIGPIPE is sent to the entire
+ * process concurrently by a malicious user, it may be simply discarded.
+ * Several wakeups can be batched within a single block/unblock pair.
+ */
+struct sigpipe_state {
+	sigset_t sigpipe_set, old_set;
+	int was_pending;
+	int got_epipe;
+};
+
 static
-void lib_ring_buffer_wakeup(struct lttng_ust_ring_buffer *buf,
-		struct lttng_ust_shm_handle *handle)
+void sigpipe_block(struct sigpipe_state *state)
 {
-	int wakeup_fd = shm_get_wakeup_fd(handle, &buf->self._ref);
-	sigset_t sigpipe_set, pending_set, old_set;
-	int ret, sigpipe_was_pending = 0;
-
-	if (wakeup_fd < 0)
-		return;
+	sigset_t pending_set;
+	int ret;
 
-	/*
-	 * Wake-up the other end by writing a null byte in the pipe
-	 * (non-blocking).  Important note: Because writing into the
-	 * pipe is non-blocking (and therefore we allow dropping wakeup
-	 * data, as long as there is wakeup data present in the pipe
-	 * buffer to wake up the consumer), the consumer should perform
-	 * the following sequence for waiting:
-	 * 1) empty the pipe (reads).
-	 * 2) check if there is data in the buffer.
-	 * 3) wait on the pipe (poll).
-	 *
-	 * Discard the SIGPIPE from write(), not disturbing any SIGPIPE
-	 * that might be already pending. If a bogus SIGPIPE is sent to
-	 * the entire process concurrently by a malicious user, it may
-	 * be simply discarded.
-	 */
+	state->got_epipe = 0;
 	ret = sigemptyset(&pending_set);
 	assert(!ret);
 	/*
@@ -560,33 +615,215 @@ void lib_ring_buffer_wakeup(struct lttng_ust_ring_buffer *buf,
 	 */
 	ret = sigpending(&pending_set);
 	assert(!ret);
-	sigpipe_was_pending = sigismember(&pending_set, SIGPIPE);
+	state->was_pending = sigismember(&pending_set, SIGPIPE);
 	/*
 	 * If sigpipe was pending, it means it was already blocked, so
 	 * no need to block it.
 	 */
-	if (!sigpipe_was_pending) {
-		ret = sigemptyset(&sigpipe_set);
+	if (!state->was_pending) {
+		ret = sigemptyset(&state->sigpipe_set);
 		assert(!ret);
-		ret = sigaddset(&sigpipe_set, SIGPIPE);
+		ret = sigaddset(&state->sigpipe_set, SIGPIPE);
 		assert(!ret);
-		ret = pthread_sigmask(SIG_BLOCK, &sigpipe_set, &old_set);
+		ret = pthread_sigmask(SIG_BLOCK, &state->sigpipe_set,
+				&state->old_set);
 		assert(!ret);
 	}
-	do {
-		ret = write(wakeup_fd, "", 1);
-	} while (ret == -1L && errno == EINTR);
-	if (ret == -1L && errno == EPIPE && !sigpipe_was_pending) {
+}
+
+static
+void sigpipe_unblock(struct sigpipe_state *state)
+{
+	int ret;
+
+	if (state->was_pending)
+		return;
+	if (state->got_epipe) {
 		struct timespec timeout = { 0, 0 };
 		do {
-			ret = sigtimedwait(&sigpipe_set, NULL,
+			ret = sigtimedwait(&state->sigpipe_set, NULL,
 				&timeout);
 		} while (ret == -1L && errno == EINTR);
 	}
-	if (!sigpipe_was_pending) {
-		ret = pthread_sigmask(SIG_SETMASK, &old_set, NULL);
-		assert(!ret);
+	ret = pthread_sigmask(SIG_SETMASK, &state->old_set, NULL);
+	assert(!ret);
+}
+
+/*
+ * A wakeup eventfd (RING_BUFFER_WAKEUP_EVENTFD) is written an 8-byte
+ * counter increment rather than a null byte. Concurrent wakeups
+ * accumulate in the counter, which the consumer clears with a single
+ * read.
+ */
+static
+void lib_ring_buffer_wakeup_fd(struct lttng_ust_ring_buffer_channel *chan,
+		int wakeup_fd, struct sigpipe_state *state)
+{
+	const uint64_t one = 1;
+	int ret;
+
+	do {
+		if (chan->u.s.wakeup_flags & RING_BUFFER_WAKEUP_EVENTFD)
+			ret = write(wakeup_fd, &one, sizeof(one));
+		else
+			ret = write(wakeup_fd, "", 1);
+	} while (ret == -1L && errno == EINTR);
+	if (ret == -1L && errno == EPIPE)
+		state->got_epipe = 1;
+}
+
+/*
+ * Notify consumers waiting on the channel-wide futex word
+ * (RING_BUFFER_WAKEUP_FUTEX), located in the buffer of stream 0. The
+ * sequence number is always incremented, the futex wake system call is
+ * only issued when a consumer is waiting.
+ */
+static
+void lib_ring_buffer_wakeup_futex(struct lttng_ust_ring_buffer_channel *chan,
+		struct lttng_ust_shm_handle *handle)
+{
+	struct lttng_ust_ring_buffer *buf0;
+
+	if (!(chan->u.s.wakeup_flags & RING_BUFFER_WAKEUP_FUTEX))
+		return;
+	buf0 = shmp(handle, chan->backend.buf[0].shmp);
+	if (!buf0)
+		return;
+	uatomic_inc(&buf0->wakeup_seq);
+	/* Order seq update before waiters read, matches consumer wait. */
+	cmm_smp_mb();
+	if (uatomic_read(&buf0->wakeup_waiters))
+		(void) lttng_ust_shared_futex_wake(&buf0->wakeup_seq, INT32_MAX);
+}
+
+static
+void lib_ring_buffer_wakeup(struct lttng_ust_ring_buffer_channel *chan,
+		struct lttng_ust_ring_buffer *buf,
+		struct lttng_ust_shm_handle *handle)
+{
+	int wakeup_fd = shm_get_wakeup_fd(handle, &buf->self._ref);
+	struct sigpipe_state state;
+
+	lib_ring_buffer_wakeup_futex(chan, handle);
+	if (wakeup_fd < 0)
+		return;
+	sigpipe_block(&state);
+	lib_ring_buffer_wakeup_fd(chan, wakeup_fd, &state);
+	sigpipe_unblock(&state);
+}
+
+/*
+ * Scale the read timer period so that the fastest-filling stream is
+ * checked about twice per sub-buffer, within the configured bounds.
+ * Back off exponentially while no data is produced. Called with
+ * wakeup_fd_mutex held, which excludes concurrent timer deletion.
+ */
+static
+void lib_ring_buffer_channel_adapt_read_timer(struct lttng_ust_ring_buffer_channel *chan,
+		unsigned long max_fill)
+{
+	uint64_t interval, target, min_interval, max_interval;
+	struct itimerspec its;
+	int ret;
+
+	if (!read_timer_adaptive)
+		return;
+	interval = CMM_LOAD_SHARED(chan->u.s.read_timer_cur_interval);
+	if (!interval)
+		return;
+	min_interval = read_timer_min_interval ?
+		read_timer_min_interval : chan->read_timer_interval;
+	max_interval = read_timer_max_interval ?
+		read_timer_max_interval : chan->read_timer_interval;
+	if (max_fill)
+		target = interval * (chan->backend.subbuf_size >> 1) / max_fill;
+	else
+		target = interval << 1;
+	/* Grow at most twofold per tick, shrink as fast as needed. */
+	target = min_t(uint64_t, target, interval << 1);
+	target = max_t(uint64_t, target, min_interval);
+	target = min_t(uint64_t, target, max_interval);
+	/* Avoid re-arming the timer for changes below 1/8th. */
+	if ((target > interval ? target - interval : interval - target) < (interval >> 3))
+		return;
+
+	its.it_value.tv_sec = target / 1000000;
+	its.it_value.tv_nsec = (target % 1000000) * 1000;
+	its.it_interval = its.it_value;
+	ret = timer_settime(chan->read_timer, 0, &its, NULL);
+	if (ret == -1) {
+		PERROR("timer_settime");
+		return;
 	}
+	CMM_STORE_SHARED(chan->u.s.read_timer_cur_interval, target);
+}
+
+/*
+ * Check whether the reader of @buf needs to be woken up, and sample the
+ * amount of data written since the previous read timer tick in
+ * @fill. With the adaptive read timer, a reader which was woken up on
+ * the previous tick and has not consumed anything since is skipped for
+ * one tick. It is not skipped longer: it may have drained its wakeup
+ * pipe and deferred the read, and it must be woken up again.
+ */
+static
+bool lib_ring_buffer_read_timer_check(const struct lttng_ust_ring_buffer_config *config,
+		struct lttng_ust_ring_buffer *buf,
+		struct lttng_ust_ring_buffer_channel *chan,
+		struct lttng_ust_shm_handle *handle,
+		unsigned long *fill)
+{
+	unsigned long offset, consumed;
+
+	offset = v_read(config, &buf->offset);
+	*fill = offset - buf->read_timer_offset;
+	buf->read_timer_offset = offset;
+
+	if (!uatomic_read(&buf->active_readers)
+	    || !lib_ring_buffer_poll_deliver(config, buf, chan, handle))
+		return false;
+	/*
+	 * Consumed positions are sub-buffer aligned: the low bit tells
+	 * a previous wakeup apart from the initial state.
+	 */
+	consumed = uatomic_read(&buf->consumed) | 1UL;
+	if (read_timer_adaptive && consumed == buf->read_timer_consumed) {
+		buf->read_timer_consumed = 0;
+		return false;
+	}
+	buf->read_timer_consumed = consumed;
+	return true;
+}
+
+/*
+ * Wake up the reader of @buf if needed, blocking SIGPIPE on the first
+ * wakeup of the batch.
+ */
+static
+void lib_ring_buffer_read_timer_wakeup(const struct lttng_ust_ring_buffer_config *config,
+		struct lttng_ust_ring_buffer *buf,
+		struct lttng_ust_ring_buffer_channel *chan,
+		struct lttng_ust_shm_handle *handle,
+		struct sigpipe_state *state, bool *blocked,
+		unsigned long *max_fill)
+{
+	unsigned long fill;
+	bool wakeup;
+	int wakeup_fd;
+
+	wakeup = lib_ring_buffer_read_timer_check(config, buf, chan, handle,
+			&fill);
+	*max_fill = max_t(unsigned long, *max_fill, fill);
+	if (!wakeup)
+		return;
+	wakeup_fd = shm_get_wakeup_fd(handle, &buf->self._ref);
+	if (wakeup_fd < 0)
+		return;
+	if (!*blocked) {
+		sigpipe_block(state);
+		*blocked = true;
+	}
+	lib_ring_buffer_wakeup_fd(chan, wakeup_fd, state);
 }
 
 static
@@ -594,6 +831,9 @@ void lib_ring_buffer_channel_do_read(struct lttng_ust_ring_buffer_channel *chan)
 {
 	const struct lttng_ust_ring_buffer_config *config;
 	struct lttng_ust_shm_handle *handle;
+	struct sigpipe_state state;
+	unsigned long max_fill = 0;
+	bool blocked = false;
 	int cpu;
 
 	handle = chan->handle;
@@ -610,11 +850,8 @@ void lib_ring_buffer_channel_do_read(struct lttng_ust_ring_buffer_channel *chan)
 
 			if (!buf)
 				goto end;
-			if (uatomic_read(&buf->active_readers)
-			    && lib_ring_buffer_poll_deliver(config, buf,
-					chan, handle)) {
-				lib_ring_buffer_wakeup(buf, handle);
-			}
+			lib_ring_buffer_read_timer_wakeup(config, buf, chan,
+					handle, &state, &blocked, &max_fill);
 		}
 	} else {
 		struct lttng_ust_ring_buffer *buf =
@@ -622,13 +859,16 @@ void lib_ring_buffer_channel_do_read(struct lttng_ust_ring_buffer_channel *chan)
 
 		if (!buf)
 			goto end;
-		if (uatomic_read(&buf->active_readers)
-		    && lib_ring_buffer_poll_deliver(config, buf,
-				chan, handle)) {
-			lib_ring_buffer_wakeup(buf, handle);
-		}
+		lib_ring_buffer_read_timer_wakeup(config, buf, chan,
+				handle, &state, &blocked, &max_fill);
 	}
+	lib_ring_buffer_channel_adapt_read_timer(chan, max_fill);
 end:
+	if (blocked) {
+		sigpipe_unblock(&state);
+		/* A single futex notification for all the streams. */
+		lib_ring_buffer_wakeup_futex(chan, handle);
+	}
 	pthread_mutex_unlock(&wakeup_fd_mutex);
 }
 
@@ -867,6 +1107,8 @@ void lib_ring_buffer_channel_read_timer_start(struct lttng_ust_ring_buffer_chann
 	its.it_interval.tv_sec = its.it_value.tv_sec;
 	its.it_interval.tv_nsec = its.it_value.tv_nsec;
 
+	CMM_STORE_SHARED(chan->u.s.read_timer_cur_interval,
+			chan->read_timer_interval);
 	ret = timer_settime(chan->read_timer, 0, &its, NULL);
 	if (ret == -1) {
 		PERROR("timer_settime");
@@ -883,10 +1125,14 @@ void lib_ring_buffer_channel_read_timer_stop(struct lttng_ust_ring_buffer_channe
 			|| !chan->read_timer_interval || !chan->read_timer_enabled)
 		return;
 
+	/* Prevent the timer handler from re-arming the deleted timer. */
+	pthread_mutex_lock(&wakeup_fd_mutex);
+	CMM_STORE_SHARED(chan->u.s.read_timer_cur_interval, 0);
 	ret = timer_delete(chan->read_timer);
 	if (ret == -1) {
 		PERROR("timer_delete");
 	}
+	pthread_mutex_unlock(&wakeup_fd_mutex);
 
 	/*
 	 * do one more check to catch data that has been written in the last
@@ -959,6 +1205,11 @@ static void channel_free(struct lttng_ust_ring_buffer_channel *chan,
  * @read_timer_interval: Time interval (in us) to wake up pending readers.
  * @stream_fds: array of stream file descriptors.
  * @nr_stream_fds: number of file descriptors in array.
+ * @blocking_timeout: Timeout (in us) of blocking reservations, -1 to
+ *                    block forever.
+ * @wakeup_flags: RING_BUFFER_WAKEUP_* consumer notification flags, and
+ *                RING_BUFFER_SNAPSHOT_SPARE to allocate spare sub-buffers
+ *                for lib_ring_buffer_snapshot_swap().
  *
  * Holds cpu hotplug.
  * Returns NULL on failure.
@@ -973,7 +1224,8 @@ struct lttng_ust_shm_handle *channel_create(const struct lttng_ust_ring_buffer_c
 		   size_t num_subbuf, unsigned int switch_timer_interval,
 		   unsigned int read_timer_interval,
 		   const int *stream_fds, int nr_stream_fds,
-		   int64_t blocking_timeout)
+		   int64_t blocking_timeout,
+		   uint32_t wakeup_flags)
 {
 	int ret;
 	size_t shmsize, chansize;
@@ -1017,6 +1269,7 @@ struct lttng_ust_shm_handle *channel_create(const struct lttng_ust_ring_buffer_c
 	handle->table = shm_object_table_create(1 + get_possible_cpus_array_len(), populate);
 	if (!handle->table)
 		goto error_table_alloc;
+	handle->table->wakeup_flags = wakeup_flags;
 
 	/* Calculate the shm allocation layout */
 	shmsize = sizeof(struct lttng_ust_ring_buffer_channel);
@@ -1059,12 +1312,14 @@ struct lttng_ust_shm_handle *channel_create(const struct lttng_ust_ring_buffer_c
 	}
 
 	chan->u.s.blocking_timeout_ms = (int32_t) blocking_timeout_ms;
+	chan->u.s.wakeup_flags = wakeup_flags;
 
 	channel_set_private(chan, priv);
 
 	ret = channel_backend_init(&chan->backend, name, config,
-				   subbuf_size, num_subbuf, handle,
-				   stream_fds);
+				   subbuf_size, num_subbuf,
+				   !!(wakeup_flags & RING_BUFFER_SNAPSHOT_SPARE),
+				   handle, stream_fds);
 	if (ret)
 		goto error_backend_init;
 
@@ -1388,6 +1643,156 @@ int lib_ring_buffer_snapshot_sample_positions(
 	return 0;
 }
 
+/*
+ * Swap the sub-buffer at position @pos, if it is fully committed, with
+ * the one held at its index in the snapshot subbuffer table. Never
+ * waits for the writers.
+ */
+static
+int lib_ring_buffer_swap_subbuf(struct lttng_ust_ring_buffer *buf,
+				struct lttng_ust_ring_buffer_channel *chan,
+				unsigned long pos,
+				struct lttng_ust_shm_handle *handle)
+{
+	const struct lttng_ust_ring_buffer_config *config = &chan->backend.config;
+	struct lttng_ust_ring_buffer_backend_subbuffer *ssb;
+	struct commit_counters_cold *cc_cold;
+	unsigned long idx, commit_count;
+
+	idx = subbuf_index(pos, chan);
+	cc_cold = shmp_index(handle, buf->commit_cold, idx);
+	ssb = shmp_index(handle, buf->backend.buf_ssb, idx);
+	if (!cc_cold || !ssb)
+		return -EPERM;
+	commit_count = v_read(config, &cc_cold->cc_sb);
+	/*
+	 * Read the commit count before the sub-buffer ID, see
+	 * lib_ring_buffer_get_subbuf().
+	 */
+	cmm_smp_rmb();
+	if (((commit_count - chan->backend.subbuf_size)
+	     & chan->commit_count_mask)
+	    - (buf_trunc(pos, chan) >> chan->backend.num_subbuf_order)
+	    != 0)
+		return -EAGAIN;
+	return exchange_read_sb(config, &buf->backend, ssb, idx,
+				buf_trunc_val(pos, chan), handle);
+}
+
+/**
+ * lib_ring_buffer_snapshot_swap - take a consistent snapshot of the buffer
+ * @buf: ring buffer
+ * @consumed: consumed count indicating the position where to read
+ * @produced: produced count, indicates position when to stop reading
+ *
+ * Exchanges every complete sub-buffer between the consumed and produced
+ * positions with a spare sub-buffer, the same way lib_ring_buffer_get_subbuf()
+ * exchanges one with the reader sub-buffer. The writers keep going in the
+ * spare sub-buffers while the snapshot is read with get_subbuf/put_subbuf,
+ * and cannot overwrite it until lib_ring_buffer_snapshot_release().
+ *
+ * Sub-buffers which cannot be swapped without waiting (overwritten since
+ * the positions were sampled, or not fully committed) are left out: the
+ * snapshot starts after the leading ones and stops before the first
+ * other one, so it is always contiguous.
+ *
+ * Returns -EINVAL if the channel has no spare sub-buffers, -EBUSY if the
+ * reader holds a sub-buffer, -ENODATA if buffer is finalized, -EAGAIN if
+ * no sub-buffer could be swapped, or 0 on success.
+ */
+int lib_ring_buffer_snapshot_swap(struct lttng_ust_ring_buffer *buf,
+				  unsigned long *consumed, unsigned long *produced,
+				  struct lttng_ust_shm_handle *handle)
+{
+	struct lttng_ust_ring_buffer_channel *chan;
+	unsigned long consumed_cur, produced_cur, begin, end, pos;
+	int ret;
+
+	chan = shmp(handle, buf->backend.chan);
+	if (!chan)
+		return -EPERM;
+	if (!chan->backend.snapshot_sb)
+		return -EINVAL;
+	if (buf->get_subbuf)
+		return -EBUSY;
+	lib_ring_buffer_snapshot_release(buf, handle);
+
+	ret = lib_ring_buffer_snapshot(buf, &consumed_cur, &produced_cur, handle);
+	if (ret)
+		return ret;
+
+	/*
+	 * The writers may have pushed the consumed position since it was
+	 * sampled: never swap more than one buffer worth of sub-buffers.
+	 */
+	begin = subbuf_trunc(consumed_cur, chan);
+	if ((long) (produced_cur - begin) > (long) chan->backend.buf_size)
+		begin = produced_cur - chan->backend.buf_size;
+	end = begin;
+	for (pos = begin; (long) (produced_cur - pos) > 0;
+			pos += chan->backend.subbuf_size) {
+		ret = lib_ring_buffer_swap_subbuf(buf, chan, pos, handle);
+		if (ret == -EPERM)
+			return ret;
+		if (!ret) {
+			end = pos + chan->backend.subbuf_size;
+			continue;
+		}
+		if (begin != end)
+			break;
+		begin = end = pos + chan->backend.subbuf_size;
+	}
+	if (begin == end)
+		return -EAGAIN;
+
+	buf->swap_consumed = begin;
+	buf->swap_produced = end;
+	buf->snapshot_swapped = 1;
+	*consumed = begin;
+	*produced = end;
+	return 0;
+}
+
+/**
+ * lib_ring_buffer_snapshot_release - release a swapped snapshot
+ * @buf: ring buffer
+ *
+ * Puts the sub-buffers of the snapshot back in place of the spare ones
+ * the writers have not reached yet, so the data they hold stays readable.
+ * The others become the new spare sub-buffers.
+ */
+void lib_ring_buffer_snapshot_release(struct lttng_ust_ring_buffer *buf,
+				      struct lttng_ust_shm_handle *handle)
+{
+	struct lttng_ust_ring_buffer_channel *chan;
+	const struct lttng_ust_ring_buffer_config *config;
+	unsigned long pos;
+
+	chan = shmp(handle, buf->backend.chan);
+	if (!chan)
+		return;
+	config = &chan->backend.config;
+	if (!buf->snapshot_swapped)
+		return;
+	CHAN_WARN_ON(chan, buf->get_subbuf);
+	for (pos = buf->swap_consumed; pos != buf->swap_produced;
+			pos += chan->backend.subbuf_size) {
+		struct lttng_ust_ring_buffer_backend_subbuffer *ssb;
+		unsigned long idx = subbuf_index(pos, chan);
+
+		ssb = shmp_index(handle, buf->backend.buf_ssb, idx);
+		if (!ssb)
+			return;
+		/*
+		 * Fails if a writer entered the spare sub-buffer: keep the
+		 * snapshot one, which is now stale.
+		 */
+		(void) exchange_read_sb(config, &buf->backend, ssb, idx,
+					buf_trunc_val(pos, chan), handle);
+	}
+	buf->snapshot_swapped = 0;
+}
+
 /**
  * lib_ring_buffer_move_consumer - move consumed counter forward
  * @buf: ring buffer
@@ -1412,9 +1817,15 @@ void lib_ring_buffer_move_consumer(struct lttng_ust_ring_buffer *buf,
 	 * the writer in flight recorder mode.
 	 */
 	consumed = uatomic_read(&buf->consumed);
-	while ((long) consumed - (long) consumed_new < 0)
-		consumed = uatomic_cmpxchg(&buf->consumed, consumed,
-					   consumed_new);
+	while ((long) consumed - (long) consumed_new < 0) {
+		unsigned long old = consumed;
+
+		consumed = uatomic_cmpxchg(&buf->consumed, old, consumed_new);
+		if (consumed == old) {
+			lib_ring_buffer_wake_blocked_writers(buf);
+			break;
+		}
+	}
 }
 
 /**
@@ -1439,6 +1850,29 @@ int lib_ring_buffer_get_subbuf(struct lttng_ust_ring_buffer *buf,
 	if (!chan)
 		return -EPERM;
 	config = &chan->backend.config;
+	if (buf->snapshot_swapped
+	    && (long) (subbuf_trunc(consumed, chan) - buf->swap_consumed) >= 0
+	    && (long) (subbuf_trunc(consumed, chan) - buf->swap_produced) < 0) {
+		struct lttng_ust_ring_buffer_backend_subbuffer *ssb;
+		unsigned long id;
+
+		/*
+		 * The sub-buffer belongs to the reader since the snapshot
+		 * was swapped: exchange it with the reader sub-buffer.
+		 */
+		ssb = shmp_index(handle, buf->backend.buf_ssb,
+				 subbuf_index(consumed, chan));
+		if (!ssb)
+			return -EPERM;
+		id = ssb->id;
+		ssb->id = buf->backend.buf_rsb.id;
+		buf->backend.buf_rsb.id = id;
+		subbuffer_id_clear_noref(config, &buf->backend.buf_rsb.id);
+		buf->get_subbuf_consumed = consumed;
+		buf->get_subbuf_swapped = 1;
+		buf->get_subbuf = 1;
+		return 0;
+	}
 retry:
 	finalized = CMM_ACCESS_ONCE(buf->finalized);
 	/*
@@ -1636,6 +2070,21 @@ void lib_ring_buffer_put_subbuf(struct lttng_ust_ring_buffer *buf,
 		     && subbuffer_id_is_noref(config, bufb->buf_rsb.id));
 	subbuffer_id_set_noref(config, &bufb->buf_rsb.id);
 
+	if (buf->get_subbuf_swapped) {
+		struct lttng_ust_ring_buffer_backend_subbuffer *ssb;
+		unsigned long id;
+
+		/* Give the sub-buffer back to the swapped snapshot. */
+		buf->get_subbuf_swapped = 0;
+		ssb = shmp_index(handle, bufb->buf_ssb, subbuf_index(consumed, chan));
+		if (!ssb)
+			return;
+		id = ssb->id;
+		ssb->id = bufb->buf_rsb.id;
+		bufb->buf_rsb.id = id;
+		return;
+	}
+
 	/*
 	 * Exchange the reader subbuffer with the one we put in its place in the
 	 * writer subbuffer table. Expect the original consumed count. If
@@ -1814,10 +2263,15 @@ void lib_ring_buffer_switch_old_end(struct lttng_ust_ring_buffer *buf,
 	const struct lttng_ust_ring_buffer_config *config = &chan->backend.config;
 	unsigned long oldidx = subbuf_index(offsets->old - 1, chan);
 	unsigned long commit_count, padding_size, data_size;
+	struct lttng_ust_ring_buffer_stats *stats;
 	struct commit_counters_cold *cc_cold;
 	struct commit_counters_hot *cc_hot;
 	uint64_t *ts_end;
 
+	stats = lib_ring_buffer_stats(buf, handle);
+	if (stats)
+		stats->switches++;
+
 	data_size = subbuf_offset(offsets->old - 1, chan) + 1;
 	padding_size = chan->backend.subbuf_size - data_size;
 	subbuffer_set_data_size(config, &buf->backend, oldidx, data_size,
@@ -1913,10 +2367,15 @@ void lib_ring_buffer_switch_new_end(struct lttng_ust_ring_buffer *buf,
 				    struct lttng_ust_shm_handle *handle)
 {
 	const struct lttng_ust_ring_buffer_config *config = &chan->backend.config;
+	struct lttng_ust_ring_buffer_stats *stats;
 	struct commit_counters_cold *cc_cold;
 	unsigned long endidx, data_size;
 	uint64_t *ts_end;
 
+	stats = lib_ring_buffer_stats(buf, handle);
+	if (stats)
+		stats->switches++;
+
 	endidx = subbuf_index(offsets->end - 1, chan);
 	data_size = subbuf_offset(offsets->end - 1, chan) + 1;
 	subbuffer_set_data_size(config, &buf->backend, endidx, data_size,
@@ -2126,10 +2585,21 @@ void lib_ring_buffer_switch_slow(struct lttng_ust_ring_buffer *buf, enum switch_
 	lib_ring_buffer_switch_old_end(buf, chan, &offsets, &ctx, handle);
 }
 
+/*
+ * Wait until the consumer moves the consumed position away from
+ * @consumed, for at most RETRY_DELAY_MS or the timeout left. The
+ * consumer wakes the waiters when it moves the consumed position (see
+ * lib_ring_buffer_wake_blocked_writers()); the bounded wait still makes
+ * progress with a consumer which does not. Falls back to sleeping where
+ * process-shared futexes are not available.
+ */
 static
-bool handle_blocking_retry(int *timeout_left_ms)
+bool handle_blocking_retry(struct lttng_ust_ring_buffer *buf,
+		unsigned long consumed, int *timeout_left_ms)
 {
-	int timeout = *timeout_left_ms, delay;
+	int timeout = *timeout_left_ms, delay, ret;
+	struct timespec ts, start, end;
+	long elapsed_ms;
 
 	if (caa_likely(!timeout))
 		return false;	/* Do not retry, discard event. */
@@ -2137,9 +2607,30 @@ bool handle_blocking_retry(int *timeout_left_ms)
 		delay = RETRY_DELAY_MS;
 	else
 		delay = min_t(int, timeout, RETRY_DELAY_MS);
-	(void) poll(NULL, 0, delay);
-	if (timeout > 0)
-		*timeout_left_ms -= delay;
+	ts.tv_sec = delay / 1000;
+	ts.tv_nsec = (delay % 1000) * 1000000L;
+	(void) clock_gettime(CLOCKID, &start);
+	uatomic_inc(&buf->consumed_waiters);
+	/*
+	 * Order the waiters increment before the futex reads the consumed
+	 * position. Pairs with the memory barrier of the consumed position
+	 * update in the consumer.
+	 */
+	cmm_smp_mb();
+	ret = lttng_ust_shared_futex_wait(lib_ring_buffer_consumed_futex(buf),
+			(int32_t) consumed, &ts);
+	uatomic_dec(&buf->consumed_waiters);
+	if (ret == -ENOSYS)
+		(void) poll(NULL, 0, delay);
+	if (timeout > 0) {
+		(void) clock_gettime(CLOCKID, &end);
+		/* Round up, so a timeout expires despite early wakeups. */
+		elapsed_ms = (end.tv_sec - start.tv_sec) * 1000
+			+ (end.tv_nsec - start.tv_nsec + 999999) / 1000000;
+		if (elapsed_ms < 1)
+			elapsed_ms = 1;
+		*timeout_left_ms = elapsed_ms >= timeout ? 0 : timeout - elapsed_ms;
+	}
 	return true;	/* Retry. */
 }
 
@@ -2236,16 +2727,24 @@ retry:
 		   >> chan->backend.num_subbuf_order)
 		  - (commit_count & chan->commit_count_mask);
 		if (caa_likely(reserve_commit_diff == 0)) {
+			unsigned long consumed = uatomic_read(&buf->consumed);
+
 			/* Next subbuffer not being written to. */
 			if (caa_unlikely(config->mode != RING_BUFFER_OVERWRITE &&
 				subbuf_trunc(offsets->begin, chan)
-				 - subbuf_trunc((unsigned long)
-				     uatomic_read(&buf->consumed), chan)
+				 - subbuf_trunc(consumed, chan)
 				>= chan->backend.buf_size)) {
 				unsigned long nr_lost;
 
-				if (handle_blocking_retry(&timeout_left_ms))
+				if (handle_blocking_retry(buf, consumed,
+						&timeout_left_ms)) {
+					struct lttng_ust_ring_buffer_stats *stats;
+
+					stats = lib_ring_buffer_stats(buf, handle);
+					if (stats)
+						stats->blocking_retries++;
 					goto retry;
+				}
 
 				/*
 				 * We do not overwrite non consumed buffers
@@ -2345,6 +2844,39 @@ retry:
 	return 0;
 }
 
+/*
+ * Maximum number of cache lines of a new sub-buffer prefetched on switch.
+ */
+#define SWITCH_PREFETCH_MAX_LINES	8
+
+/*
+ * lib_ring_buffer_prefetch_new_subbuf - prefetch the start of a new sub-buffer
+ *
+ * The sub-buffer header and the record reserved right after it are the
+ * first writes to a sub-buffer which was last touched by the consumer,
+ * so they miss in the cache of the producer. Issue write prefetches for
+ * them before ending the old sub-buffer, so the misses overlap with
+ * that work instead of stalling switch_new_start.
+ */
+static
+void lib_ring_buffer_prefetch_new_subbuf(struct lttng_ust_ring_buffer *buf,
+		struct lttng_ust_ring_buffer_channel *chan,
+		const struct switch_offsets *offsets,
+		struct lttng_ust_shm_handle *handle)
+{
+	unsigned long begin = subbuf_trunc(offsets->begin, chan);
+	size_t len, off;
+	char *p;
+
+	p = lib_ring_buffer_offset_address(&buf->backend, begin, handle);
+	if (caa_unlikely(!p))
+		return;
+	len = min_t(size_t, offsets->end - begin,
+		    SWITCH_PREFETCH_MAX_LINES * CAA_CACHE_LINE_SIZE);
+	for (off = 0; off < len; off += CAA_CACHE_LINE_SIZE)
+		__builtin_prefetch(p + off, 1, 3);
+}
+
 /**
  * lib_ring_buffer_reserve_slow - Atomic slot reservation in a buffer.
  * @ctx: ring buffer context.
@@ -2360,6 +2892,7 @@ int lib_ring_buffer_reserve_slow(struct lttng_ust_ring_buffer_ctx *ctx,
 	struct lttng_ust_ring_buffer_channel *chan = ctx_private->chan;
 	struct lttng_ust_shm_handle *handle = chan->handle;
 	const struct lttng_ust_ring_buffer_config *config = &chan->backend.config;
+	struct lttng_ust_ring_buffer_stats *stats;
 	struct lttng_ust_ring_buffer *buf;
 	struct switch_offsets offsets;
 	int ret;
@@ -2372,6 +2905,10 @@ int lib_ring_buffer_reserve_slow(struct lttng_ust_ring_buffer_ctx *ctx,
 		return -EIO;
 	ctx_private->buf = buf;
 
+	stats = lib_ring_buffer_stats(buf, handle);
+	if (stats)
+		stats->reserve_slow++;
+
 	offsets.size = 0;
 
 	do {
@@ -2403,6 +2940,9 @@ int lib_ring_buffer_reserve_slow(struct lttng_ust_ring_buffer_ctx *ctx,
 				    subbuf_index(offsets.end - 1, chan),
 				    handle);
 
+	if (caa_unlikely(offsets.switch_new_start))
+		lib_ring_buffer_prefetch_new_subbuf(buf, chan, &offsets, handle);
+
 	/*
 	 * Switch old subbuffer if needed.
 	 */
@@ -2588,7 +3128,7 @@ void lib_ring_buffer_check_deliver_slow(const struct lttng_ust_ring_buffer_confi
 		if (config->wakeup == RING_BUFFER_WAKEUP_BY_WRITER
 		    && uatomic_read(&buf->active_readers)
 		    && lib_ring_buffer_poll_deliver(config, buf, chan, handle)) {
-			lib_ring_buffer_wakeup(buf, handle);
+			lib_ring_buffer_wakeup(chan, buf, handle);
 		}
 	}
 }
@@ -25,11 +25,32 @@
 #include <numaif.h>
 #endif
 
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+
 #include <lttng/ust-utils.h>
 #include <lttng/ust-fd.h>
 
 #include "common/macros.h"
 #include "common/compat/mmap.h"
+#include "common/populate.h"
+
+/*
+ * Lock a stream mapping in memory when LTTNG_UST_MAP_MLOCK is set, so
+ * the first write to each page does not take a fault in the probe and
+ * the pages cannot be reclaimed or swapped out while tracing. Failure
+ * (typically RLIMIT_MEMLOCK) is not fatal: the mapping is then used as
+ * is.
+ */
+static
+void shm_object_mlock(void *memory_map, size_t memory_map_size)
+{
+	if (!lttng_ust_map_mlock_is_enabled())
+		return;
+	if (mlock(memory_map, memory_map_size))
+		PERROR("mlock");
+}
 
 /*
  * Ensure we have the required amount of space available by writing 0
@@ -69,6 +90,57 @@ error:
 	return ret;
 }
 
+/*
+ * Create the wait/wakeup file descriptor pair of a shm object.
+ *
+ * By default, this is a pipe whose write end is non-blocking. With
+ * RING_BUFFER_WAKEUP_EVENTFD, both ends are the same non-blocking
+ * eventfd, which is closed along with the last of them.
+ */
+static
+int shm_object_create_wait_fd(struct shm_object_table *table, int waitfd[2])
+{
+	int ret;
+
+	if (table->wakeup_flags & RING_BUFFER_WAKEUP_EVENTFD) {
+#ifdef HAVE_SYS_EVENTFD_H
+		waitfd[0] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (waitfd[0] < 0) {
+			PERROR("eventfd");
+			return -1;
+		}
+		waitfd[1] = waitfd[0];
+		return 0;
+#else
+		errno = ENOSYS;
+		return -1;
+#endif
+	}
+
+	/* wait_fd: create pipe */
+	ret = pipe2(waitfd, O_CLOEXEC);
+	if (ret < 0) {
+		PERROR("pipe");
+		return -1;
+	}
+	/* The write end of the pipe needs to be non-blocking */
+	ret = fcntl(waitfd[1], F_SETFL, O_NONBLOCK);
+	if (ret < 0) {
+		PERROR("fcntl");
+		ret = close(waitfd[1]);
+		if (ret)
+			PERROR("close");
+		goto error_close;
+	}
+	return 0;
+
+error_close:
+	ret = close(waitfd[0]);
+	if (ret)
+		PERROR("close");
+	return -1;
+}
+
 struct shm_object_table *shm_object_table_create(size_t max_nb_obj, bool populate)
 {
 	struct shm_object_table *table;
@@ -98,18 +170,9 @@ struct shm_object *_shm_object_table_alloc_shm(struct shm_object_table *table,
 		return NULL;
 	obj = &table->objects[table->allocated_len];
 
-	/* wait_fd: create pipe */
-	ret = pipe2(waitfd, O_CLOEXEC);
-	if (ret < 0) {
-		PERROR("pipe");
+	ret = shm_object_create_wait_fd(table, waitfd);
+	if (ret < 0)
 		goto error_pipe;
-	}
-	/* The write end of the pipe needs to be non-blocking */
-	ret = fcntl(waitfd[1], F_SETFL, O_NONBLOCK);
-	if (ret < 0) {
-		PERROR("fcntl");
-		goto error_fcntl;
-	}
 	memcpy(obj->wait_fd, waitfd, sizeof(waitfd));
 
 	/*
@@ -156,6 +219,7 @@ struct shm_object *_shm_object_table_alloc_shm(struct shm_object_table *table,
 		PERROR("mmap");
 		goto error_mmap;
 	}
+	shm_object_mlock(memory_map, memory_map_size);
 	obj->type = SHM_OBJECT_SHM;
 	obj->memory_map = memory_map;
 	obj->memory_map_size = memory_map_size;
@@ -168,8 +232,9 @@ error_mmap:
 error_fsync:
 error_ftruncate:
 error_zero_file:
-error_fcntl:
 	for (i = 0; i < 2; i++) {
+		if (i == 1 && waitfd[1] == waitfd[0])
+			break;
 		ret = close(waitfd[i]);
 		if (ret) {
 			PERROR("close");
@@ -186,7 +251,7 @@ struct shm_object *_shm_object_table_alloc_mem(struct shm_object_table *table,
 {
 	struct shm_object *obj;
 	void *memory_map;
-	int waitfd[2], i, ret;
+	int waitfd[2], ret;
 
 	if (table->allocated_len >= table->size)
 		return NULL;
@@ -196,18 +261,9 @@ struct shm_object *_shm_object_table_alloc_mem(struct shm_object_table *table,
 	if (!memory_map)
 		goto alloc_error;
 
-	/* wait_fd: create pipe */
-	ret = pipe2(waitfd, O_CLOEXEC);
-	if (ret < 0) {
-		PERROR("pipe");
+	ret = shm_object_create_wait_fd(table, waitfd);
+	if (ret < 0)
 		goto error_pipe;
-	}
-	/* The write end of the pipe needs to be non-blocking */
-	ret = fcntl(waitfd[1], F_SETFL, O_NONBLOCK);
-	if (ret < 0) {
-		PERROR("fcntl");
-		goto error_fcntl;
-	}
 	memcpy(obj->wait_fd, waitfd, sizeof(waitfd));
 
 	/* no shm_fd */
@@ -222,14 +278,6 @@ struct shm_object *_shm_object_table_alloc_mem(struct shm_object_table *table,
 
 	return obj;
 
-error_fcntl:
-	for (i = 0; i < 2; i++) {
-		ret = close(waitfd[i]);
-		if (ret) {
-			PERROR("close");
-			assert(0);
-		}
-	}
 error_pipe:
 	free(memory_map);
 alloc_error:
@@ -345,6 +393,7 @@ struct shm_object *shm_object_table_append_shm(struct shm_object_table *table,
 		PERROR("mmap");
 		goto error_mmap;
 	}
+	shm_object_mlock(memory_map, memory_map_size);
 	obj->type = SHM_OBJECT_SHM;
 	obj->memory_map = memory_map;
 	obj->memory_map_size = memory_map_size;
@@ -358,6 +407,77 @@ error_mmap:
 	return NULL;
 }
 
+/*
+ * Map the POSIX shm object @shm_fd as a new object of @table, without
+ * wait and wakeup file descriptors. With @init, the shm object is first
+ * sized and zeroed as for shm_object_table_alloc(). Without it, the shm
+ * object was created by another process and is mapped read-only. The
+ * object takes ownership of @shm_fd.
+ */
+struct shm_object *shm_object_table_map_shm(struct shm_object_table *table,
+			int shm_fd, size_t memory_map_size, bool init,
+			bool populate)
+{
+	int flags = MAP_SHARED, prot = PROT_READ;
+	struct shm_object *obj;
+	char *memory_map;
+	int ret;
+
+	if (shm_fd < 0)
+		return NULL;
+	if (table->allocated_len >= table->size)
+		return NULL;
+	obj = &table->objects[table->allocated_len];
+
+	if (init) {
+		ret = ftruncate(shm_fd, memory_map_size);
+		if (ret) {
+			PERROR("ftruncate");
+			goto error_ftruncate;
+		}
+		ret = zero_file(shm_fd, memory_map_size);
+		if (ret) {
+			PERROR("zero_file");
+			goto error_zero_file;
+		}
+		ret = fsync(shm_fd);
+		if (ret && errno != EINVAL) {
+			PERROR("fsync");
+			goto error_fsync;
+		}
+		prot |= PROT_WRITE;
+	}
+
+	/* wait_fd: unset. */
+	obj->wait_fd[0] = -1;
+	obj->wait_fd[1] = -1;
+	obj->shm_fd = shm_fd;
+	obj->shm_fd_ownership = 1;
+
+	if (populate)
+		flags |= LTTNG_MAP_POPULATE;
+	/* memory_map: mmap */
+	memory_map = mmap(NULL, memory_map_size, prot, flags, shm_fd, 0);
+	if (memory_map == MAP_FAILED) {
+		PERROR("mmap");
+		goto error_mmap;
+	}
+	shm_object_mlock(memory_map, memory_map_size);
+	obj->type = SHM_OBJECT_SHM;
+	obj->memory_map = memory_map;
+	obj->memory_map_size = memory_map_size;
+	obj->allocated_len = init ? 0 : memory_map_size;
+	obj->index = table->allocated_len++;
+
+	return obj;
+
+error_mmap:
+error_fsync:
+error_zero_file:
+error_ftruncate:
+	return NULL;
+}
+
 /*
  * Passing ownership of mem to object.
  */
@@ -432,6 +552,9 @@ void shmp_object_destroy(struct shm_object *obj, int consumer)
 		for (i = 0; i < 2; i++) {
 			if (obj->wait_fd[i] < 0)
 				continue;
+			/* Single eventfd for both ends. */
+			if (i == 1 && obj->wait_fd[1] == obj->wait_fd[0])
+				continue;
 			if (!consumer) {
 				lttng_ust_lock_fd_tracker();
 				ret = close(obj->wait_fd[i]);
@@ -459,6 +582,9 @@ void shmp_object_destroy(struct shm_object *obj, int consumer)
 		for (i = 0; i < 2; i++) {
 			if (obj->wait_fd[i] < 0)
 				continue;
+			/* Single eventfd for both ends. */
+			if (i == 1 && obj->wait_fd[1] == obj->wait_fd[0])
+				continue;
 			if (!consumer) {
 				lttng_ust_lock_fd_tracker();
 				ret = close(obj->wait_fd[i]);
@@ -86,6 +86,12 @@ struct shm_object *shm_object_table_append_shm(struct shm_object_table *table,
 			size_t memory_map_size, bool populate)
 	__attribute__((visibility("hidden")));
 
+/* shm_fd ownership is passed to shm_object_table_map_shm(). */
+struct shm_object *shm_object_table_map_shm(struct shm_object_table *table,
+			int shm_fd, size_t memory_map_size, bool init,
+			bool populate)
+	__attribute__((visibility("hidden")));
+
 /* mem ownership is passed to shm_object_table_append_mem(). */
 struct shm_object *shm_object_table_append_mem(struct shm_object_table *table,
 			void *mem, size_t memory_map_size, int wakeup_fd)
@@ -153,6 +159,9 @@ int shm_close_wait_fd(struct lttng_ust_shm_handle *handle,
 	if (wait_fd < 0)
 		return -ENOENT;
 	obj->wait_fd[0] = -1;
+	/* A single eventfd for both ends is closed along with the last. */
+	if (wait_fd == obj->wait_fd[1])
+		return 0;
 	ret = close(wait_fd);
 	if (ret) {
 		ret = -errno;
@@ -179,6 +188,9 @@ int shm_close_wakeup_fd(struct lttng_ust_shm_handle *handle,
 	if (wakeup_fd < 0)
 		return -ENOENT;
 	obj->wait_fd[1] = -1;
+	/* A single eventfd for both ends is closed along with the last. */
+	if (wakeup_fd == obj->wait_fd[0])
+		return 0;
 	ret = close(wakeup_fd);
 	if (ret) {
 		ret = -errno;
@@ -14,6 +14,14 @@
 
 struct lttng_ust_ring_buffer_channel;
 
+/*
+ * Consumer notification flags, chosen by the consumer when it creates
+ * a channel.
+ */
+#define RING_BUFFER_WAKEUP_EVENTFD	(1U << 0)	/* Wait/wakeup fds are eventfds */
+#define RING_BUFFER_WAKEUP_FUTEX	(1U << 1)	/* Channel-wide futex word */
+#define RING_BUFFER_SNAPSHOT_SPARE	(1U << 2)	/* Spare sub-buffers for snapshots */
+
 enum shm_object_type {
 	SHM_OBJECT_SHM,
 	SHM_OBJECT_MEM,
@@ -33,6 +41,7 @@ struct shm_object {
 struct shm_object_table {
 	size_t size;
 	size_t allocated_len;
+	uint32_t wakeup_flags;	/* RING_BUFFER_WAKEUP_* of new objects */
 	struct shm_object objects[];
 };
 
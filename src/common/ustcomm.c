@@ -19,6 +19,9 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <stdbool.h>
+
+#include <urcu/hlist.h>
 
 #include <lttng/ust-ctl.h>
 #include <lttng/ust-fd.h>
@@ -29,6 +32,7 @@
 
 #include "common/events.h"
 #include "common/compat/pthread.h"
+#include "common/jhash.h"
 
 #define USTCOMM_MAX_SEND_FDS	4
 
@@ -1500,6 +1504,388 @@ error_fields:
 	return ret;
 }
 
+static
+int batch_append(char **buf, size_t *len, size_t *alloc_len,
+		const void *data, size_t data_len)
+{
+	if (*len + data_len > *alloc_len) {
+		size_t new_alloc_len = *alloc_len ? *alloc_len : 4096;
+		char *new_buf;
+
+		while (new_alloc_len < *len + data_len)
+			new_alloc_len <<= 1;
+		new_buf = realloc(*buf, new_alloc_len);
+		if (!new_buf)
+			return -ENOMEM;
+		*buf = new_buf;
+		*alloc_len = new_alloc_len;
+	}
+	memcpy(*buf + *len, data, data_len);
+	*len += data_len;
+	return 0;
+}
+
+#define USTCOMM_FIELDS_DESC_HT_BITS	8
+#define USTCOMM_FIELDS_DESC_HT_SIZE	(1U << USTCOMM_FIELDS_DESC_HT_BITS)
+
+/* Serialized fields array sent once on the notify socket. */
+struct ustcomm_fields_desc {
+	struct cds_hlist_node node;
+	uint32_t hash;
+	uint32_t id;
+	bool pending;		/* Defined by the batch being sent. */
+	size_t len;
+	char data[];
+};
+
+struct ustcomm_fields_desc_cache {
+	struct cds_hlist_head table[USTCOMM_FIELDS_DESC_HT_SIZE];
+	uint32_t next_id;
+	size_t nr_descs;
+};
+
+struct ustcomm_fields_desc_cache *ustcomm_fields_desc_cache_create(void)
+{
+	struct ustcomm_fields_desc_cache *cache;
+
+	cache = zmalloc(sizeof(*cache));
+	if (!cache)
+		return NULL;
+	cache->next_id = 1;
+	return cache;
+}
+
+void ustcomm_fields_desc_cache_destroy(struct ustcomm_fields_desc_cache *cache)
+{
+	unsigned int i;
+
+	if (!cache)
+		return;
+	for (i = 0; i < USTCOMM_FIELDS_DESC_HT_SIZE; i++) {
+		struct ustcomm_fields_desc *desc;
+		struct cds_hlist_node *pos, *tmp;
+
+		cds_hlist_for_each_entry_safe(desc, pos, tmp, &cache->table[i], node)
+			free(desc);
+	}
+	free(cache);
+}
+
+static
+struct ustcomm_fields_desc *fields_desc_lookup(struct ustcomm_fields_desc_cache *cache,
+		uint32_t hash, const void *data, size_t len)
+{
+	struct cds_hlist_head *head;
+	struct ustcomm_fields_desc *desc;
+	struct cds_hlist_node *pos;
+
+	head = &cache->table[hash & (USTCOMM_FIELDS_DESC_HT_SIZE - 1)];
+	cds_hlist_for_each_entry(desc, pos, head, node) {
+		if (desc->hash == hash && desc->len == len
+				&& !memcmp(desc->data, data, len))
+			return desc;
+	}
+	return NULL;
+}
+
+/*
+ * Add a pending descriptor. Returns NULL if the cache is full or on
+ * allocation failure, in which case the fields are sent inline.
+ */
+static
+struct ustcomm_fields_desc *fields_desc_add(struct ustcomm_fields_desc_cache *cache,
+		uint32_t hash, const void *data, size_t len)
+{
+	struct ustcomm_fields_desc *desc;
+
+	if (cache->nr_descs >= USTCOMM_NOTIFY_FIELDS_DESC_MAX || !cache->next_id)
+		return NULL;
+	desc = zmalloc(sizeof(*desc) + len);
+	if (!desc)
+		return NULL;
+	desc->hash = hash;
+	desc->id = cache->next_id++;
+	desc->pending = true;
+	desc->len = len;
+	memcpy(desc->data, data, len);
+	cds_hlist_add_head(&desc->node,
+		&cache->table[hash & (USTCOMM_FIELDS_DESC_HT_SIZE - 1)]);
+	cache->nr_descs++;
+	return desc;
+}
+
+static
+void fields_desc_remove(struct ustcomm_fields_desc_cache *cache,
+		struct ustcomm_fields_desc *desc)
+{
+	cds_hlist_del(&desc->node);
+	cache->nr_descs--;
+	free(desc);
+}
+
+/*
+ * Once a batch is sent, keep the descriptors it defined if the session
+ * daemon accepted it, else forget them.
+ */
+static
+void fields_desc_commit(struct ustcomm_fields_desc_cache *cache, bool accepted)
+{
+	unsigned int i;
+
+	for (i = 0; i < USTCOMM_FIELDS_DESC_HT_SIZE; i++) {
+		struct ustcomm_fields_desc *desc;
+		struct cds_hlist_node *pos, *tmp;
+
+		cds_hlist_for_each_entry_safe(desc, pos, tmp, &cache->table[i], node) {
+			if (!desc->pending)
+				continue;
+			if (accepted)
+				desc->pending = false;
+			else
+				fields_desc_remove(cache, desc);
+		}
+	}
+}
+
+/*
+ * Append the record of an event registration to a batch, in the same
+ * layout as a LTTNG_UST_CTL_NOTIFY_CMD_EVENT message. With a
+ * descriptor cache, fields already sent are replaced by a reference.
+ */
+static
+int batch_append_event(char **buf, size_t *len, size_t *alloc_len,
+		struct lttng_ust_session *session,
+		int session_objd, int channel_objd,
+		const struct ustcomm_event_registration *event,
+		struct ustcomm_fields_desc_cache *fields_cache)
+{
+	struct ustcomm_notify_event_msg m;
+	size_t signature_len, fields_len, model_emf_uri_len;
+	struct lttng_ust_ctl_field *fields = NULL;
+	struct ustcomm_fields_desc *new_desc = NULL;
+	size_t nr_write_fields = 0;
+	int ret;
+
+	memset(&m, 0, sizeof(m));
+	m.session_objd = session_objd;
+	m.channel_objd = channel_objd;
+	strncpy(m.event_name, event->event_name, LTTNG_UST_ABI_SYM_NAME_LEN);
+	m.event_name[LTTNG_UST_ABI_SYM_NAME_LEN - 1] = '\0';
+	m.loglevel = event->loglevel;
+	m.user_token = event->user_token;
+	signature_len = strlen(event->signature) + 1;
+	m.signature_len = signature_len;
+
+	if (event->nr_fields > 0) {
+		ret = alloc_serialize_fields(session, &nr_write_fields, &fields,
+				event->nr_fields, event->fields);
+		if (ret)
+			return ret;
+	}
+	fields_len = sizeof(*fields) * nr_write_fields;
+	if (fields_cache && fields_len) {
+		struct ustcomm_fields_desc *desc;
+		uint32_t hash;
+
+		hash = jhash(fields, fields_len, 0);
+		desc = fields_desc_lookup(fields_cache, hash, fields, fields_len);
+		if (desc) {
+			m.fields_desc_id = desc->id;
+			fields_len = 0;
+		} else {
+			new_desc = fields_desc_add(fields_cache, hash, fields,
+					fields_len);
+			if (new_desc)
+				m.fields_desc_id = new_desc->id;
+		}
+	}
+	m.fields_len = fields_len;
+	if (event->model_emf_uri) {
+		model_emf_uri_len = strlen(event->model_emf_uri) + 1;
+	} else {
+		model_emf_uri_len = 0;
+	}
+	m.model_emf_uri_len = model_emf_uri_len;
+
+	ret = batch_append(buf, len, alloc_len, &m, sizeof(m));
+	if (ret)
+		goto end;
+	ret = batch_append(buf, len, alloc_len, event->signature, signature_len);
+	if (ret)
+		goto end;
+	if (fields_len) {
+		ret = batch_append(buf, len, alloc_len, fields, fields_len);
+		if (ret)
+			goto end;
+	}
+	if (model_emf_uri_len) {
+		ret = batch_append(buf, len, alloc_len, event->model_emf_uri,
+				model_emf_uri_len);
+		if (ret)
+			goto end;
+	}
+end:
+	/* The event is left out of the batch: so is its descriptor. */
+	if (ret && new_desc)
+		fields_desc_remove(fields_cache, new_desc);
+	free(fields);
+	return ret;
+}
+
+/*
+ * Returns 0 on success, negative error value on error.
+ */
+int ustcomm_register_events(int sock,
+	struct lttng_ust_session *session,
+	int session_objd,
+	int channel_objd,
+	struct ustcomm_event_registration *events,
+	size_t nr_events,
+	struct ustcomm_fields_desc_cache *fields_cache)
+{
+	struct {
+		struct ustcomm_notify_hdr header;
+		struct ustcomm_notify_event_batch_msg m;
+	} msg;
+	struct {
+		struct ustcomm_notify_hdr header;
+		struct ustcomm_notify_event_batch_reply r;
+	} reply;
+	struct ustcomm_notify_event_batch_entry *entries = NULL;
+	size_t *batch_index = NULL, nr_batch = 0, i;
+	size_t buf_len = 0, buf_alloc_len = 0;
+	char *buf = NULL;
+	ssize_t len;
+	int ret;
+
+	if (nr_events > USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS)
+		return -EINVAL;
+	batch_index = zmalloc(nr_events * sizeof(*batch_index));
+	if (!batch_index)
+		return -ENOMEM;
+
+	/* Reserve room for the message header, filled once the size is known. */
+	ret = batch_append(&buf, &buf_len, &buf_alloc_len, &msg, sizeof(msg));
+	if (ret)
+		goto end;
+	for (i = 0; i < nr_events; i++) {
+		size_t prev_len = buf_len;
+
+		events[i].id = 0;
+		events[i].ret_code = batch_append_event(&buf, &buf_len,
+				&buf_alloc_len, session, session_objd,
+				channel_objd, &events[i], fields_cache);
+		if (events[i].ret_code) {
+			/* Leave this event out of the batch. */
+			buf_len = prev_len;
+			continue;
+		}
+		batch_index[nr_batch++] = i;
+	}
+	if (!nr_batch)
+		goto end;
+	if (buf_len - sizeof(msg) > UINT32_MAX) {
+		ret = -EINVAL;
+		goto end;
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.header.notify_cmd = LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH;
+	msg.m.nr_events = nr_batch;
+	msg.m.len = buf_len - sizeof(msg);
+	memcpy(buf, &msg, sizeof(msg));
+
+	len = ustcomm_send_unix_sock(sock, buf, buf_len);
+	if (len > 0 && len != buf_len) {
+		ret = -EIO;
+		goto end;
+	}
+	if (len < 0) {
+		ret = len;
+		goto end;
+	}
+
+	/* receive reply */
+	len = ustcomm_recv_unix_sock(sock, &reply, sizeof(reply));
+	switch (len) {
+	case 0:	/* orderly shutdown */
+		ret = -EPIPE;
+		goto end;
+	case sizeof(reply):
+		if (reply.header.notify_cmd != msg.header.notify_cmd) {
+			ERR("Unexpected result message command "
+				"expected: %u vs received: %u\n",
+				msg.header.notify_cmd, reply.header.notify_cmd);
+			ret = -EINVAL;
+			goto end;
+		}
+		if (reply.r.ret_code > 0) {
+			ret = -EINVAL;
+			goto end;
+		}
+		if (reply.r.ret_code < 0) {
+			ret = reply.r.ret_code;
+			goto end;
+		}
+		if (reply.r.nr_events != nr_batch) {
+			ERR("Unexpected number of registered events "
+				"expected: %zu vs received: %u\n",
+				nr_batch, reply.r.nr_events);
+			ret = -EINVAL;
+			goto end;
+		}
+		break;
+	default:
+		if (len < 0) {
+			/* Transport level error */
+			if (errno == EPIPE || errno == ECONNRESET)
+				len = -errno;
+			ret = len;
+		} else {
+			ERR("incorrect message size: %zd\n", len);
+			ret = len;
+		}
+		goto end;
+	}
+
+	entries = zmalloc(nr_batch * sizeof(*entries));
+	if (!entries) {
+		ret = -ENOMEM;
+		goto end;
+	}
+	len = ustcomm_recv_unix_sock(sock, entries, nr_batch * sizeof(*entries));
+	if (len > 0 && len != nr_batch * sizeof(*entries)) {
+		ret = -EIO;
+		goto end;
+	}
+	if (len == 0) {
+		ret = -EPIPE;
+		goto end;
+	}
+	if (len < 0) {
+		ret = len;
+		goto end;
+	}
+	for (i = 0; i < nr_batch; i++) {
+		struct ustcomm_event_registration *event = &events[batch_index[i]];
+
+		if (entries[i].ret_code > 0)
+			event->ret_code = -EINVAL;
+		else
+			event->ret_code = entries[i].ret_code;
+		event->id = entries[i].id;
+	}
+	DBG("Sent register event batch notification for %zu events\n", nr_batch);
+	ret = 0;
+end:
+	if (fields_cache)
+		fields_desc_commit(fields_cache, !ret);
+	free(entries);
+	free(buf);
+	free(batch_index);
+	return ret;
+}
+
 #ifdef CONFIG_LTTNG_UST_EXPERIMENTAL_COUNTER
 /*
  * Returns 0 on success, negative error value on error.
@@ -1798,6 +2184,8 @@ int ustcomm_register_channel(int sock,
 		switch (reply.r.header_type) {
 		case 1:
 		case 2:
+		case 3:
+		case 4:
 			*header_type = reply.r.header_type;
 			break;
 		default:
@@ -29,6 +29,7 @@
  * found, the application proceeds directly without any delay.
  */
 #define LTTNG_UST_DEFAULT_CONSTRUCTOR_TIMEOUT_MS	3000
+#define LTTNG_UST_DEFAULT_EARLY_BUFFER_SIZE		65536
 
 #define LTTNG_DEFAULT_RUNDIR				LTTNG_SYSTEM_RUNDIR
 #define LTTNG_DEFAULT_HOME_RUNDIR			".lttng"
@@ -78,6 +79,9 @@ struct ustcomm_ust_msg {
 		struct lttng_ust_abi_context context;
 		struct lttng_ust_abi_tracer_version version;
 		struct lttng_ust_abi_tracepoint_iter tracepoint;
+		struct lttng_ust_abi_notify_features notify_features;
+		struct lttng_ust_abi_cmd_ring cmd_ring;
+		struct lttng_ust_abi_list_batch list_batch;
 		struct {
 			uint32_t data_size;	/* following filter data */
 			uint32_t reloc_offset;
@@ -122,15 +126,63 @@ struct ustcomm_ust_reply {
 		} __attribute__((packed)) stream;
 		struct lttng_ust_abi_tracer_version version;
 		struct lttng_ust_abi_tracepoint_iter tracepoint;
+		struct {
+			uint64_t features;	/* enabled LTTNG_UST_ABI_NOTIFY_FEATURE_* */
+		} __attribute__((packed)) notify_features;
 		char padding[USTCOMM_REPLY_PADDING2];
 	} u;
 } __attribute__((packed));
 
+/*
+ * Shared-memory command ring (LTTNG_UST_ABI_CMD_RING), mapped by the
+ * session daemon and the application. The session daemon is the only
+ * producer: it writes the command in the slot at head, then increments
+ * head. The application is the only consumer: it executes the commands
+ * in order, writes the reply in the slot of the command, then
+ * increments tail. head and tail are free-running counters. Each side
+ * only issues a futex wakeup when the other side flagged that it
+ * sleeps: the application sleeps on doorbell, which the session daemon
+ * increments when it submits commands, and the session daemon sleeps on
+ * tail.
+ *
+ * Only commands without payload nor file descriptor go through the
+ * ring; the others are rejected with LTTNG_UST_ERR_INVAL and must use
+ * the command socket, which also tells the application that the
+ * session daemon is gone.
+ */
+#define USTCOMM_CMD_RING_MAGIC		0x55535452	/* "USTR" */
+#define USTCOMM_CMD_RING_MAX_SLOTS	4096
+
+struct ustcomm_cmd_ring_slot {
+	struct ustcomm_ust_msg msg;
+	struct ustcomm_ust_reply reply;
+} __attribute__((packed));
+
+#define USTCOMM_CMD_RING_PADDING	36
+struct ustcomm_cmd_ring {
+	uint32_t magic;
+	uint32_t nr_slots;		/* Power of two. */
+	int32_t head;			/* Commands submitted. */
+	int32_t tail;			/* Commands completed. Futex word. */
+	int32_t doorbell;		/* Futex word. */
+	int32_t app_waiting;		/* Application waits on doorbell. */
+	int32_t sessiond_waiting;	/* Session daemon waits on tail. */
+	char padding[USTCOMM_CMD_RING_PADDING];
+	struct ustcomm_cmd_ring_slot slots[];
+};
+
+static inline
+size_t ustcomm_cmd_ring_len(uint32_t nr_slots)
+{
+	return sizeof(struct ustcomm_cmd_ring)
+		+ (size_t) nr_slots * sizeof(struct ustcomm_cmd_ring_slot);
+}
+
 struct ustcomm_notify_hdr {
 	uint32_t notify_cmd;
 } __attribute__((packed));
 
-#define USTCOMM_NOTIFY_EVENT_MSG_PADDING	24
+#define USTCOMM_NOTIFY_EVENT_MSG_PADDING	20
 struct ustcomm_notify_event_msg {
 	uint32_t session_objd;
 	uint32_t channel_objd;
@@ -140,6 +192,13 @@ struct ustcomm_notify_event_msg {
 	uint32_t fields_len;
 	uint32_t model_emf_uri_len;
 	uint64_t user_token;
+	/*
+	 * Batch records with LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP only,
+	 * 0 otherwise. When nonzero, fields which follow define the field
+	 * descriptor of that id; if fields_len is 0, the fields are those of
+	 * the descriptor previously defined with that id.
+	 */
+	uint32_t fields_desc_id;
 	char padding[USTCOMM_NOTIFY_EVENT_MSG_PADDING];
 	/* followed by signature, fields, and model_emf_uri */
 } __attribute__((packed));
@@ -151,6 +210,39 @@ struct ustcomm_notify_event_reply {
 	char padding[USTCOMM_NOTIFY_EVENT_REPLY_PADDING];
 } __attribute__((packed));
 
+#define USTCOMM_NOTIFY_EVENT_BATCH_MSG_PADDING	32
+struct ustcomm_notify_event_batch_msg {
+	uint32_t nr_events;
+	uint32_t len;		/* Size of the event records which follow. */
+	char padding[USTCOMM_NOTIFY_EVENT_BATCH_MSG_PADDING];
+	/*
+	 * followed by @nr_events records, each made of a struct
+	 * ustcomm_notify_event_msg followed by its signature, fields,
+	 * and model_emf_uri.
+	 */
+} __attribute__((packed));
+
+#define USTCOMM_NOTIFY_EVENT_BATCH_REPLY_PADDING	32
+struct ustcomm_notify_event_batch_reply {
+	int32_t ret_code;	/* 0: ok, negative: error code for the whole batch */
+	uint32_t nr_events;
+	char padding[USTCOMM_NOTIFY_EVENT_BATCH_REPLY_PADDING];
+	/* followed by @nr_events struct ustcomm_notify_event_batch_entry */
+} __attribute__((packed));
+
+struct ustcomm_notify_event_batch_entry {
+	int32_t ret_code;	/* 0: ok, negative: error code */
+	uint32_t id;		/* 32-bit event id. */
+} __attribute__((packed));
+
+/* Upper bounds on the content of a batch sent by the application. */
+#define USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS	256
+#define USTCOMM_NOTIFY_EVENT_BATCH_MAX_LEN	(64 * 1024)
+/* Upper bound on the size of a batch accepted by the session daemon. */
+#define USTCOMM_NOTIFY_EVENT_BATCH_RECV_MAX_LEN	(64 * 1024 * 1024)
+/* Upper bound on the number of field descriptors of an application. */
+#define USTCOMM_NOTIFY_FIELDS_DESC_MAX		4096
+
 #define USTCOMM_NOTIFY_KEY_MSG_PADDING	24
 struct ustcomm_notify_key_msg {
 	uint32_t session_objd;
@@ -207,6 +299,12 @@ struct ustcomm_notify_channel_reply {
  * struct lttng_ust_field_iter field.
  */
 
+/*
+ * Largest payload following the reply of a tracepoint (field) list batch
+ * command. Larger requests are truncated to this size.
+ */
+#define USTCOMM_LIST_BATCH_MAX_LEN	65536
+
 int ustcomm_create_unix_sock(const char *pathname)
 	__attribute__((visibility("hidden")));
 
@@ -310,6 +408,57 @@ int ustcomm_register_event(int sock,
 	uint32_t *id)			/* (output) */
 	__attribute__((visibility("hidden")));
 
+/* Event registration of a batch, see ustcomm_register_events(). */
+struct ustcomm_event_registration {
+	/* Input */
+	const char *event_name;
+	int loglevel;
+	const char *signature;
+	size_t nr_fields;
+	const struct lttng_ust_event_field * const *fields;
+	const char *model_emf_uri;
+	uint64_t user_token;
+	/* Output */
+	int ret_code;			/* 0: ok, negative: error code */
+	uint32_t id;			/* event id */
+};
+
+/*
+ * Field descriptors already sent on a notify socket, for
+ * LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP.
+ */
+struct ustcomm_fields_desc_cache;
+
+struct ustcomm_fields_desc_cache *ustcomm_fields_desc_cache_create(void)
+	__attribute__((visibility("hidden")));
+
+void ustcomm_fields_desc_cache_destroy(struct ustcomm_fields_desc_cache *cache)
+	__attribute__((visibility("hidden")));
+
+/*
+ * Register up to USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS events in a
+ * single LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH round trip. Only valid
+ * once the session daemon enabled
+ * LTTNG_UST_ABI_NOTIFY_FEATURE_EVENT_BATCH. The status of each
+ * registration is set in its ret_code field.
+ *
+ * fields_cache is the descriptor cache of the notify socket if the
+ * session daemon enabled LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP,
+ * else NULL.
+ *
+ * Returns 0 on success, negative error value on error affecting the
+ * whole batch.
+ * Returns -EPIPE or -ECONNRESET if other end has hung up.
+ */
+int ustcomm_register_events(int sock,
+	struct lttng_ust_session *session,
+	int session_objd,		/* session descriptor */
+	int channel_objd,		/* channel descriptor */
+	struct ustcomm_event_registration *events,
+	size_t nr_events,
+	struct ustcomm_fields_desc_cache *fields_cache)
+	__attribute__((visibility("hidden")));
+
 #ifdef CONFIG_LTTNG_UST_EXPERIMENTAL_COUNTER
 /*
  * Returns 0 on success, negative error value on error.
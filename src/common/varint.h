@@ -0,0 +1,63 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Unsigned LEB128 encoding of the varint event header fields.
+ */
+
+#ifndef _UST_COMMON_VARINT_H
+#define _UST_COMMON_VARINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* LEB128 lengths, in bytes, of the varint header fields. */
+#define LTTNG_VARINT_EVENT_ID_MAX_LEN	5	/* 32-bit event id */
+#define LTTNG_VARINT_FULL_TIMESTAMP_LEN	10	/* 64-bit timestamp */
+#define LTTNG_VARINT_HEADER_MAX_LEN	(LTTNG_VARINT_EVENT_ID_MAX_LEN + LTTNG_VARINT_FULL_TIMESTAMP_LEN)
+
+/*
+ * Length of the LEB128 encoding of @v, in bytes.
+ */
+static inline
+size_t lttng_ust_varint_len(uint64_t v)
+{
+	size_t len = 1;
+
+	while (v >>= 7)
+		len++;
+	return len;
+}
+
+/*
+ * Encode the low-order 7 * @len bits of @v as @len bytes of LEB128 at @p.
+ * Returns the position following the encoded value.
+ */
+static inline
+uint8_t *lttng_ust_varint_encode(uint8_t *p, uint64_t v, size_t len)
+{
+	for (; len > 1; len--) {
+		*p++ = (v & 0x7F) | 0x80;
+		v >>= 7;
+	}
+	*p++ = v & 0x7F;
+	return p;
+}
+
+/*
+ * Length of the timestamp field of a varint header, for a @delta from
+ * the last timestamp saved in the buffer: the 7-bit groups covering
+ * @delta, or the full timestamp when @delta needs more than
+ * @timestamp_bits (below 64).
+ */
+static inline
+size_t lttng_ust_varint_timestamp_len(uint64_t delta,
+		unsigned int timestamp_bits)
+{
+	if (delta >> timestamp_bits)
+		return LTTNG_VARINT_FULL_TIMESTAMP_LEN;
+	return lttng_ust_varint_len(delta);
+}
+
+#endif /* _UST_COMMON_VARINT_H */
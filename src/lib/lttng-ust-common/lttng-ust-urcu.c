@@ -26,6 +26,9 @@
 #include <lttng/urcu/pointer.h>
 #include <urcu/tls-compat.h>
 
+#include "common/getcpu.h"
+#include "common/smp.h"
+
 /* Do not #define _LGPL_SOURCE to ensure we can emit the wrapper symbols */
 #undef _LGPL_SOURCE
 #include <lttng/urcu/urcu-ust.h>
@@ -67,6 +70,9 @@ void *mremap_wrapper(void *old_address __attribute__((unused)),
 #define RCU_SLEEP_DELAY_MS	10
 #define INIT_READER_COUNT	8
 
+/* Maximum number of reader registry shards, a power of two. */
+#define RCU_REGISTRY_SHARDS	64
+
 /*
  * Active attempts to check for reader Q.S. before calling sleep().
  */
@@ -107,16 +113,15 @@ int lttng_ust_urcu_has_sys_membarrier;
  * synchronize_rcu().
  */
 static pthread_mutex_t rcu_gp_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
- * rcu_registry_lock ensures mutual exclusion between threads
- * registering and unregistering themselves to/from the registry, and
- * with threads reading that registry from synchronize_rcu(). However,
- * this lock is not held all the way through the completion of awaiting
- * for the grace period. It is sporadically released between iterations
- * on the registry.
- * rcu_registry_lock may nest inside rcu_gp_lock.
+ * Grace period sequence number, written with rcu_gp_lock held. It is
+ * incremented when a grace period starts and when it ends, and is thus
+ * odd while a grace period is in progress. Callers of synchronize_rcu()
+ * waiting for rcu_gp_lock return without starting a grace period of
+ * their own if a complete grace period started after their call.
  */
-static pthread_mutex_t rcu_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long rcu_gp_seq;
 
 static pthread_mutex_t init_lock = PTHREAD_MUTEX_INITIALIZER;
 static int initialized;
@@ -131,23 +136,66 @@ struct lttng_ust_urcu_gp lttng_ust_urcu_gp = { .ctr = LTTNG_UST_URCU_GP_COUNT };
  */
 DEFINE_URCU_TLS(struct lttng_ust_urcu_reader *, lttng_ust_urcu_reader);
 
-static CDS_LIST_HEAD(registry);
-
 struct registry_chunk {
 	size_t capacity;		/* capacity of this chunk (in elements) */
-	size_t used;			/* count of elements used */
 	struct cds_list_head node;	/* chunk_list node */
 	struct lttng_ust_urcu_reader readers[];
 };
 
 struct registry_arena {
 	struct cds_list_head chunk_list;
+	struct cds_list_head free_list;	/* Free readers, linked by node */
 };
 
-static struct registry_arena registry_arena = {
-	.chunk_list = CDS_LIST_HEAD_INIT(registry_arena.chunk_list),
+/*
+ * Readers are registered in the shard of the CPU they first run on, so
+ * that threads registering on different CPUs do not contend, and so
+ * that synchronize_rcu() only blocks the registrations of the shard it
+ * is scanning.
+ */
+struct registry_shard {
+	/*
+	 * lock ensures mutual exclusion between threads registering and
+	 * unregistering themselves to/from the shard, and with threads
+	 * reading the shard from synchronize_rcu(). However, this lock
+	 * is not held all the way through the completion of awaiting for
+	 * the grace period. It is sporadically released between
+	 * iterations on the shard.
+	 * lock may nest inside rcu_gp_lock.
+	 */
+	pthread_mutex_t lock;
+	struct cds_list_head registry;
+	/* Readers sorted by the grace period in progress. */
+	struct cds_list_head cur_snap_readers;
+	struct cds_list_head qsreaders;
+	struct registry_arena arena;
+} __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
+
+static struct registry_shard registry_shards[RCU_REGISTRY_SHARDS] = {
+	[0 ... RCU_REGISTRY_SHARDS - 1] = {
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+	},
 };
 
+static pthread_once_t registry_shards_once = PTHREAD_ONCE_INIT;
+
+/* Shards in use: the number of possible CPUs, rounded up to a power of two. */
+static unsigned int registry_nr_shards = 1;
+
+/*
+ * call_rcu() callbacks are queued on call_rcu_head and invoked by a
+ * worker thread, started on the first call_rcu(), after a grace period
+ * shared by all the callbacks queued before it started. The counts of
+ * callbacks queued and invoked are used by lttng_ust_urcu_barrier().
+ */
+static pthread_mutex_t call_rcu_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t call_rcu_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t call_rcu_done_cond = PTHREAD_COND_INITIALIZER;
+static struct lttng_ust_urcu_head *call_rcu_head;
+static struct lttng_ust_urcu_head **call_rcu_tail = &call_rcu_head;
+static unsigned long call_rcu_queued, call_rcu_done;
+static bool call_rcu_thread_started;
+
 /* Saved fork signal mask, protected by rcu_gp_lock */
 static sigset_t saved_fork_signal_mask;
 
@@ -194,15 +242,62 @@ static size_t chunk_allocation_size(size_t capacity)
 		sizeof(struct registry_chunk);
 }
 
+static
+void registry_shards_init(void)
+{
+	int nr_cpus = get_possible_cpus_array_len();
+	unsigned int i;
+
+	while (registry_nr_shards < RCU_REGISTRY_SHARDS
+			&& (int) registry_nr_shards < nr_cpus)
+		registry_nr_shards <<= 1;
+	for (i = 0; i < RCU_REGISTRY_SHARDS; i++) {
+		struct registry_shard *shard = &registry_shards[i];
+
+		CDS_INIT_LIST_HEAD(&shard->registry);
+		CDS_INIT_LIST_HEAD(&shard->cur_snap_readers);
+		CDS_INIT_LIST_HEAD(&shard->qsreaders);
+		CDS_INIT_LIST_HEAD(&shard->arena.chunk_list);
+		CDS_INIT_LIST_HEAD(&shard->arena.free_list);
+	}
+}
+
+static
+void registry_shards_init_once(void)
+{
+	if (pthread_once(&registry_shards_once, registry_shards_init))
+		abort();
+}
+
+/* Called with rcu_gp_lock held. */
+static
+bool registry_has_readers(void)
+{
+	unsigned int i;
+	bool ret = false;
+
+	for (i = 0; i < registry_nr_shards && !ret; i++) {
+		struct registry_shard *shard = &registry_shards[i];
+
+		mutex_lock(&shard->lock);
+		ret = !cds_list_empty(&shard->registry);
+		mutex_unlock(&shard->lock);
+	}
+	return ret;
+}
+
 /*
- * Always called with rcu_registry lock held. Releases this lock between
+ * Always called with the shard lock held. Releases this lock between
  * iterations and grabs it again. Holds the lock when it returns.
+ * wait_loops counts the active attempts across the shards of a grace
+ * period phase.
  */
-static void wait_for_readers(struct cds_list_head *input_readers,
+static void wait_for_readers(struct registry_shard *shard,
+			struct cds_list_head *input_readers,
 			struct cds_list_head *cur_snap_readers,
-			struct cds_list_head *qsreaders)
+			struct cds_list_head *qsreaders,
+			unsigned int *wait_loops)
 {
-	unsigned int wait_loops = 0;
 	struct lttng_ust_urcu_reader *index, *tmp;
 
 	/*
@@ -211,8 +306,6 @@ static void wait_for_readers(struct cds_list_head *input_readers,
 	 * rcu_gp.ctr value.
 	 */
 	for (;;) {
-		if (wait_loops < RCU_QS_ACTIVE_ATTEMPTS)
-			wait_loops++;
 
 		cds_list_for_each_entry_safe(index, tmp, input_readers, node) {
 			switch (lttng_ust_urcu_reader_state(&index->ctr)) {
@@ -240,25 +333,38 @@ static void wait_for_readers(struct cds_list_head *input_readers,
 		if (cds_list_empty(input_readers)) {
 			break;
 		} else {
-			/* Temporarily unlock the registry lock. */
-			mutex_unlock(&rcu_registry_lock);
-			if (wait_loops >= RCU_QS_ACTIVE_ATTEMPTS)
+			/* Temporarily unlock the shard lock. */
+			mutex_unlock(&shard->lock);
+			if (*wait_loops >= RCU_QS_ACTIVE_ATTEMPTS) {
 				(void) poll(NULL, 0, RCU_SLEEP_DELAY_MS);
-			else
+			} else {
+				(*wait_loops)++;
 				caa_cpu_relax();
-			/* Re-lock the registry lock before the next loop. */
-			mutex_lock(&rcu_registry_lock);
+			}
+			/* Re-lock the shard lock before the next loop. */
+			mutex_lock(&shard->lock);
 		}
 	}
 }
 
 void lttng_ust_urcu_synchronize_rcu(void)
 {
-	CDS_LIST_HEAD(cur_snap_readers);
-	CDS_LIST_HEAD(qsreaders);
+	unsigned int i, wait_loops = 0;
+	unsigned long gp_seq_snap;
 	sigset_t newmask, oldmask;
 	int ret;
 
+	registry_shards_init_once();
+
+	/*
+	 * Order the updates of the caller before reading the grace period
+	 * sequence: a grace period starting after this point waits for
+	 * the readers which could still observe the old data.
+	 */
+	cmm_smp_mb();
+	/* End of the first grace period starting after this point. */
+	gp_seq_snap = (CMM_LOAD_SHARED(rcu_gp_seq) + 3) & ~1UL;
+
 	ret = sigfillset(&newmask);
 	assert(!ret);
 	ret = pthread_sigmask(SIG_BLOCK, &newmask, &oldmask);
@@ -266,9 +372,17 @@ void lttng_ust_urcu_synchronize_rcu(void)
 
 	mutex_lock(&rcu_gp_lock);
 
-	mutex_lock(&rcu_registry_lock);
+	/*
+	 * A grace period started and completed while we were waiting for
+	 * rcu_gp_lock: share it. rcu_gp_lock orders its end before the
+	 * caller frees the old data.
+	 */
+	if ((long) (rcu_gp_seq - gp_seq_snap) >= 0)
+		goto out_unlock;
 
-	if (cds_list_empty(&registry))
+	CMM_STORE_SHARED(rcu_gp_seq, rcu_gp_seq + 1);
+
+	if (!registry_has_readers())
 		goto out;
 
 	/* All threads should read qparity before accessing data structure
@@ -277,11 +391,19 @@ void lttng_ust_urcu_synchronize_rcu(void)
 	smp_mb_master();
 
 	/*
-	 * Wait for readers to observe original parity or be quiescent.
-	 * wait_for_readers() can release and grab again rcu_registry_lock
-	 * internally.
+	 * Wait for readers to observe original parity or be quiescent,
+	 * one shard at a time. wait_for_readers() can release and grab
+	 * again the shard lock internally.
 	 */
-	wait_for_readers(&registry, &cur_snap_readers, &qsreaders);
+	for (i = 0; i < registry_nr_shards; i++) {
+		struct registry_shard *shard = &registry_shards[i];
+
+		mutex_lock(&shard->lock);
+		wait_for_readers(shard, &shard->registry,
+			&shard->cur_snap_readers, &shard->qsreaders,
+			&wait_loops);
+		mutex_unlock(&shard->lock);
+	}
 
 	/*
 	 * Adding a cmm_smp_mb() which is _not_ formally required, but makes the
@@ -308,16 +430,20 @@ void lttng_ust_urcu_synchronize_rcu(void)
 	cmm_smp_mb();
 
 	/*
-	 * Wait for readers to observe new parity or be quiescent.
-	 * wait_for_readers() can release and grab again rcu_registry_lock
-	 * internally.
+	 * Wait for readers to observe new parity or be quiescent, and put
+	 * the quiescent reader lists back into the shard registries.
 	 */
-	wait_for_readers(&cur_snap_readers, NULL, &qsreaders);
-
-	/*
-	 * Put quiescent reader list back into registry.
-	 */
-	cds_list_splice(&qsreaders, &registry);
+	wait_loops = 0;
+	for (i = 0; i < registry_nr_shards; i++) {
+		struct registry_shard *shard = &registry_shards[i];
+
+		mutex_lock(&shard->lock);
+		wait_for_readers(shard, &shard->cur_snap_readers, NULL,
+			&shard->qsreaders, &wait_loops);
+		cds_list_splice(&shard->qsreaders, &shard->registry);
+		CDS_INIT_LIST_HEAD(&shard->qsreaders);
+		mutex_unlock(&shard->lock);
+	}
 
 	/*
 	 * Finish waiting for reader threads before letting the old ptr being
@@ -325,7 +451,8 @@ void lttng_ust_urcu_synchronize_rcu(void)
 	 */
 	smp_mb_master();
 out:
-	mutex_unlock(&rcu_registry_lock);
+	CMM_STORE_SHARED(rcu_gp_seq, rcu_gp_seq + 1);
+out_unlock:
 	mutex_unlock(&rcu_gp_lock);
 	ret = pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
 	assert(!ret);
@@ -350,12 +477,110 @@ int lttng_ust_urcu_read_ongoing(void)
 	return _lttng_ust_urcu_read_ongoing();
 }
 
+static
+void *call_rcu_thread(void *arg __attribute__((unused)))
+{
+	/* Keep the registry mapped for the callbacks. */
+	_lttng_ust_urcu_init();
+
+	mutex_lock(&call_rcu_lock);
+	for (;;) {
+		struct lttng_ust_urcu_head *head, *next;
+		unsigned long nr = 0;
+
+		while (!call_rcu_head)
+			pthread_cond_wait(&call_rcu_work_cond, &call_rcu_lock);
+		head = call_rcu_head;
+		call_rcu_head = NULL;
+		call_rcu_tail = &call_rcu_head;
+		mutex_unlock(&call_rcu_lock);
+
+		/* One grace period for the whole batch. */
+		lttng_ust_urcu_synchronize_rcu();
+		for (; head; head = next) {
+			next = head->next;
+			head->func(head);
+			nr++;
+		}
+
+		mutex_lock(&call_rcu_lock);
+		call_rcu_done += nr;
+		pthread_cond_broadcast(&call_rcu_done_cond);
+	}
+	return NULL;
+}
+
+/* Called with call_rcu_lock held. */
+static
+void call_rcu_thread_start(void)
+{
+	sigset_t newmask, oldmask;
+	pthread_t thread;
+	int ret;
+
+	/* The worker inherits a mask with all signals blocked. */
+	ret = sigfillset(&newmask);
+	if (ret)
+		abort();
+	ret = pthread_sigmask(SIG_BLOCK, &newmask, &oldmask);
+	if (ret)
+		abort();
+	ret = pthread_create(&thread, NULL, call_rcu_thread, NULL);
+	if (ret)
+		abort();
+	ret = pthread_detach(thread);
+	if (ret)
+		abort();
+	ret = pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
+	if (ret)
+		abort();
+	call_rcu_thread_started = true;
+}
+
+void lttng_ust_urcu_call_rcu(struct lttng_ust_urcu_head *head,
+		void (*func)(struct lttng_ust_urcu_head *head))
+{
+	head->next = NULL;
+	head->func = func;
+	mutex_lock(&call_rcu_lock);
+	*call_rcu_tail = head;
+	call_rcu_tail = &head->next;
+	call_rcu_queued++;
+	if (!call_rcu_thread_started)
+		call_rcu_thread_start();
+	pthread_cond_signal(&call_rcu_work_cond);
+	mutex_unlock(&call_rcu_lock);
+}
+
+void lttng_ust_urcu_barrier(void)
+{
+	unsigned long queued;
+
+	mutex_lock(&call_rcu_lock);
+	queued = call_rcu_queued;
+	while ((long) (call_rcu_done - queued) < 0)
+		pthread_cond_wait(&call_rcu_done_cond, &call_rcu_lock);
+	mutex_unlock(&call_rcu_lock);
+}
+
+/* Add the readers [from, to) of a chunk to the arena free list. */
+static
+void arena_free_readers(struct registry_arena *arena,
+		struct registry_chunk *chunk, size_t from, size_t to)
+{
+	size_t spot_idx;
+
+	for (spot_idx = from; spot_idx < to; spot_idx++)
+		cds_list_add_tail(&chunk->readers[spot_idx].node,
+			&arena->free_list);
+}
+
 /*
  * Only grow for now. If empty, allocate a ARENA_INIT_ALLOC sized chunk.
  * Else, try expanding the last chunk. If this fails, allocate a new
  * chunk twice as big as the last chunk.
  * Memory used by chunks _never_ moves. A chunk could theoretically be
- * freed when all "used" slots are released, but we don't do it at this
+ * freed when all its readers are free, but we don't do it at this
  * point.
  */
 static
@@ -377,6 +602,7 @@ void expand_arena(struct registry_arena *arena)
 		memset(new_chunk, 0, new_chunk_size_bytes);
 		new_chunk->capacity = INIT_READER_COUNT;
 		cds_list_add_tail(&new_chunk->node, &arena->chunk_list);
+		arena_free_readers(arena, new_chunk, 0, INIT_READER_COUNT);
 		return;		/* We're done. */
 	}
 
@@ -391,11 +617,15 @@ void expand_arena(struct registry_arena *arena)
 	new_chunk = mremap_wrapper(last_chunk, old_chunk_size_bytes,
 		new_chunk_size_bytes, 0);
 	if (new_chunk != MAP_FAILED) {
+		size_t old_capacity = last_chunk->capacity;
+
 		/* Should not have moved. */
 		assert(new_chunk == last_chunk);
 		memset((char *) last_chunk + old_chunk_size_bytes, 0,
 			new_chunk_size_bytes - old_chunk_size_bytes);
 		last_chunk->capacity = new_capacity;
+		arena_free_readers(arena, last_chunk, old_capacity,
+			new_capacity);
 		return;		/* We're done. */
 	}
 
@@ -410,60 +640,41 @@ void expand_arena(struct registry_arena *arena)
 	memset(new_chunk, 0, new_chunk_size_bytes);
 	new_chunk->capacity = new_capacity;
 	cds_list_add_tail(&new_chunk->node, &arena->chunk_list);
+	arena_free_readers(arena, new_chunk, 0, new_capacity);
 }
 
 static
 struct lttng_ust_urcu_reader *arena_alloc(struct registry_arena *arena)
 {
-	struct registry_chunk *chunk;
-	int expand_done = 0;	/* Only allow to expand once per alloc */
-
-retry:
-	cds_list_for_each_entry(chunk, &arena->chunk_list, node) {
-		size_t spot_idx;
-
-		/* Skip fully used chunks. */
-		if (chunk->used == chunk->capacity) {
-			continue;
-		}
-
-		/* Find a spot. */
-		for (spot_idx = 0; spot_idx < chunk->capacity; spot_idx++) {
-			if (!chunk->readers[spot_idx].alloc) {
-				chunk->readers[spot_idx].alloc = 1;
-				chunk->used++;
-				return &chunk->readers[spot_idx];
-			}
-		}
-	}
+	struct lttng_ust_urcu_reader *rcu_reader_reg;
 
-	if (!expand_done) {
+	if (cds_list_empty(&arena->free_list))
 		expand_arena(arena);
-		expand_done = 1;
-		goto retry;
-	}
-
-	return NULL;
+	rcu_reader_reg = cds_list_first_entry(&arena->free_list,
+		struct lttng_ust_urcu_reader, node);
+	cds_list_del(&rcu_reader_reg->node);
+	rcu_reader_reg->alloc = 1;
+	return rcu_reader_reg;
 }
 
-/* Called with signals off and mutex locked */
+/* Called with signals off and shard lock held */
 static
-void add_thread(void)
+void add_thread(unsigned int shard_index)
 {
+	struct registry_shard *shard = &registry_shards[shard_index];
 	struct lttng_ust_urcu_reader *rcu_reader_reg;
 	int ret;
 
-	rcu_reader_reg = arena_alloc(&registry_arena);
-	if (!rcu_reader_reg)
-		abort();
+	rcu_reader_reg = arena_alloc(&shard->arena);
 	ret = pthread_setspecific(lttng_ust_urcu_key, rcu_reader_reg);
 	if (ret)
 		abort();
 
 	/* Add to registry */
 	rcu_reader_reg->tid = pthread_self();
+	rcu_reader_reg->shard = shard_index;
 	assert(rcu_reader_reg->ctr == 0);
-	cds_list_add(&rcu_reader_reg->node, &registry);
+	cds_list_add(&rcu_reader_reg->node, &shard->registry);
 	/*
 	 * Reader threads are pointing to the reader registry. This is
 	 * why its memory should never be relocated.
@@ -471,44 +682,30 @@ void add_thread(void)
 	URCU_TLS(lttng_ust_urcu_reader) = rcu_reader_reg;
 }
 
-/* Called with mutex locked */
+/* Called with shard lock held */
 static
-void cleanup_thread(struct registry_chunk *chunk,
+void cleanup_thread(struct registry_shard *shard,
 		struct lttng_ust_urcu_reader *rcu_reader_reg)
 {
 	rcu_reader_reg->ctr = 0;
 	cds_list_del(&rcu_reader_reg->node);
 	rcu_reader_reg->tid = 0;
 	rcu_reader_reg->alloc = 0;
-	chunk->used--;
-}
-
-static
-struct registry_chunk *find_chunk(struct lttng_ust_urcu_reader *rcu_reader_reg)
-{
-	struct registry_chunk *chunk;
-
-	cds_list_for_each_entry(chunk, &registry_arena.chunk_list, node) {
-		if (rcu_reader_reg < (struct lttng_ust_urcu_reader *) &chunk->readers[0])
-			continue;
-		if (rcu_reader_reg >= (struct lttng_ust_urcu_reader *) &chunk->readers[chunk->capacity])
-			continue;
-		return chunk;
-	}
-	return NULL;
+	cds_list_add(&rcu_reader_reg->node, &shard->arena.free_list);
 }
 
-/* Called with signals off and mutex locked */
+/* Called with signals off and shard lock held */
 static
 void remove_thread(struct lttng_ust_urcu_reader *rcu_reader_reg)
 {
-	cleanup_thread(find_chunk(rcu_reader_reg), rcu_reader_reg);
+	cleanup_thread(&registry_shards[rcu_reader_reg->shard], rcu_reader_reg);
 	URCU_TLS(lttng_ust_urcu_reader) = NULL;
 }
 
-/* Disable signals, take mutex, add to registry */
+/* Disable signals, take shard mutex, add to registry */
 void lttng_ust_urcu_register(void)
 {
+	unsigned int shard_index;
 	sigset_t newmask, oldmask;
 	int ret;
 
@@ -531,9 +728,10 @@ void lttng_ust_urcu_register(void)
 	 */
 	_lttng_ust_urcu_init();
 
-	mutex_lock(&rcu_registry_lock);
-	add_thread();
-	mutex_unlock(&rcu_registry_lock);
+	shard_index = lttng_ust_get_cpu_internal() & (registry_nr_shards - 1);
+	mutex_lock(&registry_shards[shard_index].lock);
+	add_thread(shard_index);
+	mutex_unlock(&registry_shards[shard_index].lock);
 end:
 	ret = pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
 	if (ret)
@@ -546,10 +744,11 @@ void lttng_ust_urcu_register_thread(void)
 		lttng_ust_urcu_register(); /* If not yet registered. */
 }
 
-/* Disable signals, take mutex, remove from registry */
+/* Disable signals, take shard mutex, remove from registry */
 static
 void lttng_ust_urcu_unregister(struct lttng_ust_urcu_reader *rcu_reader_reg)
 {
+	struct registry_shard *shard = &registry_shards[rcu_reader_reg->shard];
 	sigset_t newmask, oldmask;
 	int ret;
 
@@ -560,9 +759,9 @@ void lttng_ust_urcu_unregister(struct lttng_ust_urcu_reader *rcu_reader_reg)
 	if (ret)
 		abort();
 
-	mutex_lock(&rcu_registry_lock);
+	mutex_lock(&shard->lock);
 	remove_thread(rcu_reader_reg);
-	mutex_unlock(&rcu_registry_lock);
+	mutex_unlock(&shard->lock);
 	ret = pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
 	if (ret)
 		abort();
@@ -616,6 +815,7 @@ void lttng_ust_urcu_sys_membarrier_init(void)
 static
 void _lttng_ust_urcu_init(void)
 {
+	registry_shards_init_once();
 	mutex_lock(&init_lock);
 	if (!lttng_ust_urcu_refcount++) {
 		int ret;
@@ -636,13 +836,19 @@ void lttng_ust_urcu_exit(void)
 	mutex_lock(&init_lock);
 	if (!--lttng_ust_urcu_refcount) {
 		struct registry_chunk *chunk, *tmp;
+		unsigned int i;
 		int ret;
 
-		cds_list_for_each_entry_safe(chunk, tmp,
-				&registry_arena.chunk_list, node) {
-			munmap((void *) chunk, chunk_allocation_size(chunk->capacity));
+		for (i = 0; i < RCU_REGISTRY_SHARDS; i++) {
+			struct registry_arena *arena = &registry_shards[i].arena;
+
+			cds_list_for_each_entry_safe(chunk, tmp,
+					&arena->chunk_list, node) {
+				munmap((void *) chunk, chunk_allocation_size(chunk->capacity));
+			}
+			CDS_INIT_LIST_HEAD(&arena->chunk_list);
+			CDS_INIT_LIST_HEAD(&arena->free_list);
 		}
-		CDS_INIT_LIST_HEAD(&registry_arena.chunk_list);
 		ret = pthread_key_delete(lttng_ust_urcu_key);
 		if (ret)
 			abort();
@@ -650,23 +856,44 @@ void lttng_ust_urcu_exit(void)
 	mutex_unlock(&init_lock);
 }
 
+static
+void registry_shards_lock(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < RCU_REGISTRY_SHARDS; i++)
+		mutex_lock(&registry_shards[i].lock);
+}
+
+static
+void registry_shards_unlock(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < RCU_REGISTRY_SHARDS; i++)
+		mutex_unlock(&registry_shards[i].lock);
+}
+
 /*
- * Holding the rcu_gp_lock and rcu_registry_lock across fork will make
- * sure we fork() don't race with a concurrent thread executing with
- * any of those locks held. This ensures that the registry and data
- * protected by rcu_gp_lock are in a coherent state in the child.
+ * Holding the rcu_gp_lock, the shard locks and call_rcu_lock across
+ * fork will make sure we fork() don't race with a concurrent thread
+ * executing with any of those locks held. This ensures that the
+ * registry, the call_rcu queue and data protected by rcu_gp_lock are
+ * in a coherent state in the child.
  */
 void lttng_ust_urcu_before_fork(void)
 {
 	sigset_t newmask, oldmask;
 	int ret;
 
+	registry_shards_init_once();
 	ret = sigfillset(&newmask);
 	assert(!ret);
 	ret = pthread_sigmask(SIG_BLOCK, &newmask, &oldmask);
 	assert(!ret);
 	mutex_lock(&rcu_gp_lock);
-	mutex_lock(&rcu_registry_lock);
+	registry_shards_lock();
+	mutex_lock(&call_rcu_lock);
 	saved_fork_signal_mask = oldmask;
 }
 
@@ -676,7 +903,8 @@ void lttng_ust_urcu_after_fork_parent(void)
 	int ret;
 
 	oldmask = saved_fork_signal_mask;
-	mutex_unlock(&rcu_registry_lock);
+	mutex_unlock(&call_rcu_lock);
+	registry_shards_unlock();
 	mutex_unlock(&rcu_gp_lock);
 	ret = pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
 	assert(!ret);
@@ -684,36 +912,58 @@ void lttng_ust_urcu_after_fork_parent(void)
 
 /*
  * Prune all entries from registry except our own thread. Fits the Linux
- * fork behavior. Called with rcu_gp_lock and rcu_registry_lock held.
+ * fork behavior. Called with rcu_gp_lock and the shard locks held.
  */
 static
 void lttng_ust_urcu_prune_registry(void)
 {
-	struct registry_chunk *chunk;
+	unsigned int i;
+
+	for (i = 0; i < RCU_REGISTRY_SHARDS; i++) {
+		struct registry_shard *shard = &registry_shards[i];
+		struct registry_chunk *chunk;
 
-	cds_list_for_each_entry(chunk, &registry_arena.chunk_list, node) {
-		size_t spot_idx;
+		cds_list_for_each_entry(chunk, &shard->arena.chunk_list, node) {
+			size_t spot_idx;
 
-		for (spot_idx = 0; spot_idx < chunk->capacity; spot_idx++) {
-			struct lttng_ust_urcu_reader *reader = &chunk->readers[spot_idx];
+			for (spot_idx = 0; spot_idx < chunk->capacity; spot_idx++) {
+				struct lttng_ust_urcu_reader *reader = &chunk->readers[spot_idx];
 
-			if (!reader->alloc)
-				continue;
-			if (reader->tid == pthread_self())
-				continue;
-			cleanup_thread(chunk, reader);
+				if (!reader->alloc)
+					continue;
+				if (reader->tid == pthread_self())
+					continue;
+				cleanup_thread(shard, reader);
+			}
 		}
 	}
 }
 
 void lttng_ust_urcu_after_fork_child(void)
 {
+	struct lttng_ust_urcu_head *head;
 	sigset_t oldmask;
 	int ret;
 
 	lttng_ust_urcu_prune_registry();
+	/*
+	 * The call_rcu worker did not survive the fork: start a new one
+	 * for the callbacks still queued. The callbacks of the batch the
+	 * parent worker was processing are not invoked in the child.
+	 */
+	if (pthread_cond_init(&call_rcu_work_cond, NULL))
+		abort();
+	if (pthread_cond_init(&call_rcu_done_cond, NULL))
+		abort();
+	call_rcu_thread_started = false;
+	call_rcu_done = call_rcu_queued;
+	for (head = call_rcu_head; head; head = head->next)
+		call_rcu_done--;
+	if (call_rcu_head)
+		call_rcu_thread_start();
 	oldmask = saved_fork_signal_mask;
-	mutex_unlock(&rcu_registry_lock);
+	mutex_unlock(&call_rcu_lock);
+	registry_shards_unlock();
 	mutex_unlock(&rcu_gp_lock);
 	ret = pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
 	assert(!ret);
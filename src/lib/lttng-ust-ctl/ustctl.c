@@ -5,6 +5,7 @@
  * Copyright (C) 2011-2013 Mathieu Desnoyers <mathieu.desnoyers@efficios.com>
  */
 
+#include <fcntl.h>
 #include <stdint.h>
 #include <string.h>
 #include <sys/mman.h>
@@ -19,6 +20,17 @@
 #include <lttng/ust-common.h>
 #include <lttng/ust-sigbus.h>
 #include <urcu/rculist.h>
+#include <urcu/hlist.h>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#include <zstd_errors.h>
+#endif
 
 #include "common/clock.h"
 #include "common/logging.h"
@@ -26,7 +38,9 @@
 #include "common/macros.h"
 #include "common/align.h"
 
+#include "common/compat/shared-futex.h"
 #include "common/ringbuffer/backend.h"
+#include "common/ringbuffer/blob_arena.h"
 #include "common/ringbuffer/frontend.h"
 #include "common/events.h"
 #include "common/wait.h"
@@ -66,6 +80,9 @@ struct lttng_ust_ctl_consumer_stream {
 	int cpu;
 	uint64_t memory_map_size;
 	void *memory_map_addr;
+#ifdef HAVE_ZSTD
+	ZSTD_CCtx *zstd_cctx;			/* Allocated on first use */
+#endif
 };
 
 /*
@@ -824,6 +841,63 @@ int lttng_ust_ctl_tracepoint_field_list_get(int sock, int tp_field_list_handle,
 	return 0;
 }
 
+/*
+ * Send a batched list get and receive the entries following the reply.
+ * Returns the number of entries received.
+ */
+static
+int tracepoint_list_get_batch(int sock, int list_handle, uint32_t cmd,
+		void *entries, size_t entry_len, unsigned int max_entries)
+{
+	struct ustcomm_ust_msg lum;
+	struct ustcomm_ust_reply lur;
+	ssize_t len;
+	int ret;
+
+	if (!entries || !max_entries)
+		return -EINVAL;
+	/* The application does not send more than this per batch. */
+	if (max_entries > USTCOMM_LIST_BATCH_MAX_LEN / entry_len)
+		max_entries = USTCOMM_LIST_BATCH_MAX_LEN / entry_len;
+
+	memset(&lum, 0, sizeof(lum));
+	lum.handle = list_handle;
+	lum.cmd = cmd;
+	lum.u.list_batch.max_entries = max_entries;
+	ret = ustcomm_send_app_cmd(sock, &lum, &lur);
+	if (ret)
+		return ret;
+	if (lur.ret_val > max_entries)
+		return -EINVAL;
+	if (!lur.ret_val)
+		return 0;
+	len = ustcomm_recv_unix_sock(sock, entries, lur.ret_val * entry_len);
+	if (len < 0)
+		return len;
+	if (len != lur.ret_val * entry_len)
+		return -EINVAL;
+	DBG("received %u tracepoint list entries", lur.ret_val);
+	return lur.ret_val;
+}
+
+int lttng_ust_ctl_tracepoint_list_get_batch(int sock, int tp_list_handle,
+		struct lttng_ust_abi_tracepoint_iter *iters,
+		unsigned int max_entries)
+{
+	return tracepoint_list_get_batch(sock, tp_list_handle,
+		LTTNG_UST_ABI_TRACEPOINT_LIST_GET_BATCH, iters,
+		sizeof(*iters), max_entries);
+}
+
+int lttng_ust_ctl_tracepoint_field_list_get_batch(int sock,
+		int tp_field_list_handle, struct lttng_ust_abi_field_iter *iters,
+		unsigned int max_entries)
+{
+	return tracepoint_list_get_batch(sock, tp_field_list_handle,
+		LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET_BATCH, iters,
+		sizeof(*iters), max_entries);
+}
+
 int lttng_ust_ctl_tracer_version(int sock, struct lttng_ust_abi_tracer_version *v)
 {
 	struct ustcomm_ust_msg lum;
@@ -860,6 +934,210 @@ int lttng_ust_ctl_wait_quiescent(int sock)
 	return 0;
 }
 
+int lttng_ust_ctl_set_notify_features(int sock, uint64_t features,
+		uint64_t *enabled)
+{
+	struct ustcomm_ust_msg lum;
+	struct ustcomm_ust_reply lur;
+	int ret;
+
+	if (!enabled)
+		return -EINVAL;
+
+	memset(&lum, 0, sizeof(lum));
+	lum.handle = LTTNG_UST_ABI_ROOT_HANDLE;
+	lum.cmd = LTTNG_UST_ABI_NOTIFY_FEATURES;
+	lum.u.notify_features.features = features;
+	ret = ustcomm_send_app_cmd(sock, &lum, &lur);
+	if (ret)
+		return ret;
+	*enabled = lur.u.notify_features.features;
+	DBG("enabled notify features %#llx", (unsigned long long) *enabled);
+	return 0;
+}
+
+struct lttng_ust_ctl_cmd_ring_pending {
+	uint32_t handle;
+	uint32_t cmd;
+};
+
+struct lttng_ust_ctl_cmd_ring {
+	struct ustcomm_cmd_ring *shm;
+	size_t len;
+	uint32_t nr_slots;
+	int32_t head;			/* Commands submitted. */
+	int32_t tail;			/* Replies consumed. */
+	struct lttng_ust_ctl_cmd_ring_pending *pending;	/* Per slot. */
+};
+
+/*
+ * Protocol for LTTNG_UST_ABI_CMD_RING command:
+ *
+ * - send:     struct ustcomm_ust_msg
+ * - receive:  struct ustcomm_ust_reply
+ * - send:     shared memory file descriptor
+ * - receive:  struct ustcomm_ust_reply (actual command return code)
+ */
+int lttng_ust_ctl_create_cmd_ring(int sock, int shm_fd, uint32_t nr_slots,
+		struct lttng_ust_ctl_cmd_ring **_ring)
+{
+	struct lttng_ust_ctl_cmd_ring *ring;
+	struct ustcomm_ust_msg lum;
+	struct ustcomm_ust_reply lur;
+	ssize_t len;
+	int ret;
+
+	if (shm_fd < 0 || !_ring || !nr_slots
+			|| nr_slots > USTCOMM_CMD_RING_MAX_SLOTS
+			|| (nr_slots & (nr_slots - 1)))
+		return -EINVAL;
+	ring = zmalloc(sizeof(*ring));
+	if (!ring)
+		return -ENOMEM;
+	ring->pending = zmalloc(nr_slots * sizeof(*ring->pending));
+	if (!ring->pending) {
+		ret = -ENOMEM;
+		goto error_pending;
+	}
+	ring->nr_slots = nr_slots;
+	ring->len = ustcomm_cmd_ring_len(nr_slots);
+	if (ftruncate(shm_fd, ring->len)) {
+		ret = -errno;
+		goto error_map;
+	}
+	ring->shm = mmap(NULL, ring->len, PROT_READ | PROT_WRITE, MAP_SHARED,
+			shm_fd, 0);
+	if (ring->shm == MAP_FAILED) {
+		ret = -errno;
+		goto error_map;
+	}
+	memset(ring->shm, 0, ring->len);
+	ring->shm->magic = USTCOMM_CMD_RING_MAGIC;
+	ring->shm->nr_slots = nr_slots;
+
+	memset(&lum, 0, sizeof(lum));
+	lum.handle = LTTNG_UST_ABI_ROOT_HANDLE;
+	lum.cmd = LTTNG_UST_ABI_CMD_RING;
+	lum.u.cmd_ring.len = ring->len;
+	lum.u.cmd_ring.nr_slots = nr_slots;
+	ret = ustcomm_send_app_cmd(sock, &lum, &lur);
+	if (ret)
+		goto error;
+
+	/* Send the shared memory. */
+	len = ustcomm_send_fds_unix_sock(sock, &shm_fd, 1);
+	if (len <= 0) {
+		ret = len ? len : -EPIPE;
+		goto error;
+	}
+
+	ret = ustcomm_recv_app_reply(sock, &lur, lum.handle, lum.cmd);
+	if (ret)
+		goto error;
+	DBG("command ring of %u slots set up", nr_slots);
+	*_ring = ring;
+	return 0;
+
+error:
+	if (munmap(ring->shm, ring->len))
+		PERROR("munmap");
+error_map:
+	free(ring->pending);
+error_pending:
+	free(ring);
+	return ret;
+}
+
+void lttng_ust_ctl_destroy_cmd_ring(struct lttng_ust_ctl_cmd_ring *ring)
+{
+	if (!ring)
+		return;
+	if (munmap(ring->shm, ring->len))
+		PERROR("munmap");
+	free(ring->pending);
+	free(ring);
+}
+
+int lttng_ust_ctl_cmd_ring_submit(struct lttng_ust_ctl_cmd_ring *ring,
+		int handle, uint32_t cmd)
+{
+	struct ustcomm_cmd_ring *shm;
+	struct ustcomm_ust_msg *lum;
+	uint32_t index;
+
+	if (!ring)
+		return -EINVAL;
+	if ((uint32_t) (ring->head - ring->tail) >= ring->nr_slots)
+		return -EAGAIN;
+	shm = ring->shm;
+	index = (uint32_t) ring->head & (ring->nr_slots - 1);
+	lum = &shm->slots[index].msg;
+	memset(lum, 0, sizeof(*lum));
+	lum->handle = handle;
+	lum->cmd = cmd;
+	ring->pending[index].handle = handle;
+	ring->pending[index].cmd = cmd;
+	/* Write the slot before head. */
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(shm->head, ++ring->head);
+	/* Order head store before app_waiting load, matches the application. */
+	cmm_smp_mb();
+	if (CMM_LOAD_SHARED(shm->app_waiting)) {
+		uatomic_inc(&shm->doorbell);
+		(void) lttng_ust_shared_futex_wake(&shm->doorbell, 1);
+	}
+	return 0;
+}
+
+int lttng_ust_ctl_cmd_ring_wait_reply(struct lttng_ust_ctl_cmd_ring *ring,
+		int timeout_ms, uint32_t *ret_val)
+{
+	struct lttng_ust_ctl_cmd_ring_pending *pending;
+	struct ustcomm_cmd_ring *shm;
+	struct ustcomm_ust_reply lur;
+	struct timespec timeout;
+	uint32_t index;
+	int ret = 0;
+
+	if (!ring)
+		return -EINVAL;
+	if (ring->tail == ring->head)
+		return -ENOENT;
+	shm = ring->shm;
+	if (timeout_ms >= 0) {
+		timeout.tv_sec = timeout_ms / 1000;
+		timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+	}
+	while (CMM_LOAD_SHARED(shm->tail) == ring->tail) {
+		CMM_STORE_SHARED(shm->sessiond_waiting, 1);
+		/* Order sessiond_waiting store before tail load. */
+		cmm_smp_mb();
+		if (CMM_LOAD_SHARED(shm->tail) == ring->tail)
+			ret = lttng_ust_shared_futex_wait(&shm->tail, ring->tail,
+					timeout_ms >= 0 ? &timeout : NULL);
+		CMM_STORE_SHARED(shm->sessiond_waiting, 0);
+		if (ret && ret != -EINTR)
+			return ret;
+	}
+	if ((uint32_t) (CMM_LOAD_SHARED(shm->tail) - ring->tail)
+			> (uint32_t) (ring->head - ring->tail))
+		return -EINVAL;
+	/* Read the reply after tail. */
+	cmm_smp_rmb();
+	index = (uint32_t) ring->tail & (ring->nr_slots - 1);
+	memcpy(&lur, &shm->slots[index].reply, sizeof(lur));
+	pending = &ring->pending[index];
+	ring->tail++;
+	if (lur.handle != pending->handle || lur.cmd != pending->cmd) {
+		ERR("Unexpected command ring reply: handle %u cmd %u, expected handle %u cmd %u",
+			lur.handle, lur.cmd, pending->handle, pending->cmd);
+		return -EINVAL;
+	}
+	if (ret_val)
+		*ret_val = lur.ret_val;
+	return lur.ret_code;
+}
+
 int lttng_ust_ctl_calibrate(int sock __attribute__((unused)),
 		struct lttng_ust_abi_calibrate *calibrate)
 {
@@ -1400,10 +1678,33 @@ int lttng_ust_ctl_get_nr_stream_per_channel(void)
 struct lttng_ust_ctl_consumer_channel *
 	lttng_ust_ctl_create_channel(struct lttng_ust_ctl_consumer_channel_attr *attr,
 		const int *stream_fds, int nr_stream_fds)
+{
+	return lttng_ust_ctl_create_channel_wakeup(attr, stream_fds,
+			nr_stream_fds, 0);
+}
+
+struct lttng_ust_ctl_consumer_channel *
+	lttng_ust_ctl_create_channel_wakeup(struct lttng_ust_ctl_consumer_channel_attr *attr,
+		const int *stream_fds, int nr_stream_fds,
+		uint32_t wakeup_flags)
 {
 	struct lttng_ust_ctl_consumer_channel *chan;
 	const char *transport_name;
 	struct lttng_transport *transport;
+	uint32_t rb_wakeup_flags = 0;
+
+	if (wakeup_flags & ~(LTTNG_UST_CTL_WAKEUP_EVENTFD | LTTNG_UST_CTL_WAKEUP_FUTEX
+			| LTTNG_UST_CTL_SNAPSHOT_SPARE))
+		return NULL;
+	if (wakeup_flags & LTTNG_UST_CTL_WAKEUP_EVENTFD)
+		rb_wakeup_flags |= RING_BUFFER_WAKEUP_EVENTFD;
+	if (wakeup_flags & LTTNG_UST_CTL_WAKEUP_FUTEX)
+		rb_wakeup_flags |= RING_BUFFER_WAKEUP_FUTEX;
+	if (wakeup_flags & LTTNG_UST_CTL_SNAPSHOT_SPARE) {
+		if (!attr->overwrite)
+			return NULL;
+		rb_wakeup_flags |= RING_BUFFER_SNAPSHOT_SPARE;
+	}
 
 	switch (attr->type) {
 	case LTTNG_UST_ABI_CHAN_PER_CPU:
@@ -1472,7 +1773,7 @@ struct lttng_ust_ctl_consumer_channel *
 			attr->read_timer_interval,
 			attr->uuid, attr->chan_id,
 			stream_fds, nr_stream_fds,
-			attr->blocking_timeout);
+			attr->blocking_timeout, rb_wakeup_flags);
 	if (!chan->chan) {
 		goto chan_error;
 	}
@@ -1703,6 +2004,9 @@ void lttng_ust_ctl_destroy_stream(struct lttng_ust_ctl_consumer_stream *stream)
 	(void) lttng_ust_ctl_stream_close_wait_fd(stream);
 	(void) lttng_ust_ctl_stream_close_wakeup_fd(stream);
 	lib_ring_buffer_release_read(buf, consumer_chan->chan->priv->rb_chan->handle);
+#ifdef HAVE_ZSTD
+	ZSTD_freeCCtx(stream->zstd_cctx);
+#endif
 	free(stream);
 }
 
@@ -1722,6 +2026,87 @@ int lttng_ust_ctl_channel_get_wakeup_fd(struct lttng_ust_ctl_consumer_channel *c
 		&chan->chan->priv->rb_chan->handle->chan._ref);
 }
 
+/*
+ * The channel-wide futex word is located in the buffer of stream 0,
+ * which the consumer maps since it created the channel.
+ */
+static
+struct lttng_ust_ring_buffer *channel_get_wakeup_buf(
+		struct lttng_ust_ctl_consumer_channel *consumer_chan,
+		struct lttng_ust_sigbus_range *range)
+{
+	struct lttng_ust_ring_buffer_channel *rb_chan;
+	struct lttng_ust_shm_handle *handle;
+	struct shm_object *obj;
+	ssize_t index;
+
+	rb_chan = consumer_chan->chan->priv->rb_chan;
+	if (!(rb_chan->u.s.wakeup_flags & RING_BUFFER_WAKEUP_FUTEX))
+		return NULL;
+	handle = rb_chan->handle;
+	index = rb_chan->backend.buf[0].shmp._ref.index;
+	if (index < 0 || (size_t) index >= handle->table->allocated_len)
+		return NULL;
+	obj = &handle->table->objects[index];
+	range->start = obj->memory_map;
+	range->end = obj->memory_map + obj->memory_map_size;
+	return shmp(handle, rb_chan->backend.buf[0].shmp);
+}
+
+int lttng_ust_ctl_channel_get_wakeup_seq(struct lttng_ust_ctl_consumer_channel *consumer_chan,
+		uint32_t *seq)
+{
+	struct lttng_ust_ring_buffer *buf;
+	struct lttng_ust_sigbus_range range;
+
+	if (!consumer_chan || !seq)
+		return -EINVAL;
+	buf = channel_get_wakeup_buf(consumer_chan, &range);
+	if (!buf)
+		return -ENOSYS;
+	if (sigbus_begin())
+		return -EIO;
+	lttng_ust_sigbus_add_range(&range, range.start, range.end - range.start);
+	*seq = (uint32_t) uatomic_read(&buf->wakeup_seq);
+	lttng_ust_sigbus_del_range(&range);
+	sigbus_end();
+	return 0;
+}
+
+int lttng_ust_ctl_channel_wait_wakeup(struct lttng_ust_ctl_consumer_channel *consumer_chan,
+		uint32_t seq, int timeout_ms)
+{
+	struct lttng_ust_ring_buffer *buf;
+	struct lttng_ust_sigbus_range range;
+	struct timespec timeout;
+	int ret;
+
+	if (!consumer_chan)
+		return -EINVAL;
+	buf = channel_get_wakeup_buf(consumer_chan, &range);
+	if (!buf)
+		return -ENOSYS;
+	if (timeout_ms >= 0) {
+		timeout.tv_sec = timeout_ms / 1000;
+		timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+	}
+	if (sigbus_begin())
+		return -EIO;
+	lttng_ust_sigbus_add_range(&range, range.start, range.end - range.start);
+	uatomic_inc(&buf->wakeup_waiters);
+	/* Order waiters increment before seq read, matches tracer wakeup. */
+	cmm_smp_mb();
+	if ((uint32_t) uatomic_read(&buf->wakeup_seq) != seq)
+		ret = 0;
+	else
+		ret = lttng_ust_shared_futex_wait(&buf->wakeup_seq, (int32_t) seq,
+				timeout_ms >= 0 ? &timeout : NULL);
+	uatomic_dec(&buf->wakeup_waiters);
+	lttng_ust_sigbus_del_range(&range);
+	sigbus_end();
+	return ret;
+}
+
 int lttng_ust_ctl_stream_get_wait_fd(struct lttng_ust_ctl_consumer_stream *stream)
 {
 	struct lttng_ust_ring_buffer *buf;
@@ -1984,6 +2369,56 @@ int lttng_ust_ctl_snapshot(struct lttng_ust_ctl_consumer_stream *stream)
 	return ret;
 }
 
+/*
+ * Swap the complete sub-buffers of the ring buffer with spare ones and
+ * save their positions.
+ */
+int lttng_ust_ctl_snapshot_swap(struct lttng_ust_ctl_consumer_stream *stream)
+{
+	struct lttng_ust_ring_buffer *buf;
+	struct lttng_ust_ctl_consumer_channel *consumer_chan;
+	struct lttng_ust_sigbus_range range;
+	int ret;
+
+	if (!stream)
+		return -EINVAL;
+	buf = stream->buf;
+	consumer_chan = stream->chan;
+	if (sigbus_begin())
+		return -EIO;
+	lttng_ust_sigbus_add_range(&range, stream->memory_map_addr,
+				stream->memory_map_size);
+	ret = lib_ring_buffer_snapshot_swap(buf, &buf->cons_snapshot,
+			&buf->prod_snapshot, consumer_chan->chan->priv->rb_chan->handle);
+	lttng_ust_sigbus_del_range(&range);
+	sigbus_end();
+	return ret;
+}
+
+/* Put the sub-buffers of a swapped snapshot back in the ring buffer */
+int lttng_ust_ctl_snapshot_release(struct lttng_ust_ctl_consumer_stream *stream)
+{
+	struct lttng_ust_ring_buffer *buf;
+	struct lttng_ust_ctl_consumer_channel *consumer_chan;
+	struct lttng_ust_sigbus_range range;
+
+	if (!stream)
+		return -EINVAL;
+	buf = stream->buf;
+	consumer_chan = stream->chan;
+	if (buf->get_subbuf)
+		return -EBUSY;
+	if (sigbus_begin())
+		return -EIO;
+	lttng_ust_sigbus_add_range(&range, stream->memory_map_addr,
+				stream->memory_map_size);
+	lib_ring_buffer_snapshot_release(buf,
+			consumer_chan->chan->priv->rb_chan->handle);
+	lttng_ust_sigbus_del_range(&range);
+	sigbus_end();
+	return 0;
+}
+
 static
 int _lttng_ust_ctl_snapshot_sample_positions(struct lttng_ust_ring_buffer *buf,
 		struct lttng_ust_ctl_consumer_channel *consumer_chan)
@@ -2518,8 +2953,8 @@ int lttng_ust_ctl_get_sequence_number(struct lttng_ust_ctl_consumer_stream *stre
 	return ret;
 }
 
-int lttng_ust_ctl_get_instance_id(struct lttng_ust_ctl_consumer_stream *stream,
-		uint64_t *id)
+int lttng_ust_ctl_get_hot_ids(struct lttng_ust_ctl_consumer_stream *stream,
+		uint32_t *version, uint32_t ids[LTTNG_UST_CTL_NR_HOT_IDS])
 {
 	struct lttng_ust_client_lib_ring_buffer_client_cb *client_cb;
 	struct lttng_ust_ring_buffer_channel *chan;
@@ -2527,54 +2962,409 @@ int lttng_ust_ctl_get_instance_id(struct lttng_ust_ctl_consumer_stream *stream,
 	struct lttng_ust_sigbus_range range;
 	int ret;
 
-	if (!stream || !id)
+	if (!stream || !version || !ids)
 		return -EINVAL;
 	buf = stream->buf;
 	chan = stream->chan->chan->priv->rb_chan;
 	client_cb = get_client_cb(buf, chan);
-	if (!client_cb)
+	if (!client_cb || !client_cb->hot_ids)
 		return -ENOSYS;
 	if (sigbus_begin())
 		return -EIO;
 	lttng_ust_sigbus_add_range(&range, stream->memory_map_addr,
 				stream->memory_map_size);
-	ret = client_cb->instance_id(buf, chan, id);
+	ret = client_cb->hot_ids(buf, chan, version, ids);
 	lttng_ust_sigbus_del_range(&range);
 	sigbus_end();
 	return ret;
 }
 
-int lttng_ust_ctl_packet_create(struct lttng_ust_ctl_consumer_packet **packet)
+int lttng_ust_ctl_validate_packet(struct lttng_ust_ctl_consumer_stream *stream)
 {
-	struct lttng_ust_ctl_consumer_packet *new_packet;
+	struct lttng_ust_client_lib_ring_buffer_client_cb *client_cb;
+	struct lttng_ust_ring_buffer_channel *chan;
+	struct lttng_ust_ring_buffer *buf;
+	struct lttng_ust_sigbus_range range;
+	int ret;
 
-	if (!packet)
+	if (!stream)
 		return -EINVAL;
-
-	new_packet = zmalloc(sizeof(struct lttng_ust_ctl_consumer_packet));
-	if (!new_packet)
-		return -ENOMEM;
-
-	*packet = new_packet;
-	return 0;
+	buf = stream->buf;
+	chan = stream->chan->chan->priv->rb_chan;
+	client_cb = get_client_cb(buf, chan);
+	if (!client_cb || !client_cb->validate_packet)
+		return -ENOSYS;
+	if (sigbus_begin())
+		return -EIO;
+	lttng_ust_sigbus_add_range(&range, stream->memory_map_addr,
+				stream->memory_map_size);
+	ret = client_cb->validate_packet(buf, chan);
+	lttng_ust_sigbus_del_range(&range);
+	sigbus_end();
+	return ret;
 }
 
-void lttng_ust_ctl_packet_destroy(struct lttng_ust_ctl_consumer_packet *packet)
+int lttng_ust_ctl_get_stream_stats(struct lttng_ust_ctl_consumer_stream *stream,
+		struct lttng_ust_ctl_stream_stats *stats)
 {
-	if (!packet)
-		return;
-
-	lttng_ust_ctl_packet_reset(packet);
-	free(packet);
-}
+	struct lttng_ust_ring_buffer_channel *rb_chan;
+	const struct lttng_ust_ring_buffer_config *config;
+	struct lttng_ust_ring_buffer_stats *buf_stats;
+	struct lttng_ust_ring_buffer *buf;
+	struct lttng_ust_sigbus_range range;
+	int ret = 0;
 
-int lttng_ust_ctl_packet_get_buffer(struct lttng_ust_ctl_consumer_packet *packet, void **buffer,
-		uint64_t *packet_length, uint64_t *packet_length_padded)
-{
-	assert(buffer);
-	assert(packet_length);
-	assert(packet_length_padded);
-	if (!packet || !packet->p)
+	if (!stream || !stats)
+		return -EINVAL;
+	buf = stream->buf;
+	rb_chan = stream->chan->chan->priv->rb_chan;
+	config = &rb_chan->backend.config;
+	if (sigbus_begin())
+		return -EIO;
+	lttng_ust_sigbus_add_range(&range, stream->memory_map_addr,
+				stream->memory_map_size);
+	buf_stats = lib_ring_buffer_stats(buf, rb_chan->handle);
+	if (!buf_stats) {
+		ret = -ENOSYS;
+		goto end;
+	}
+	memset(stats, 0, sizeof(*stats));
+	stats->records_written = CMM_LOAD_SHARED(buf_stats->records_written);
+	stats->bytes_written = CMM_LOAD_SHARED(buf_stats->bytes_written);
+	stats->reserve_slow = CMM_LOAD_SHARED(buf_stats->reserve_slow);
+	stats->switches = CMM_LOAD_SHARED(buf_stats->switches);
+	stats->blocking_retries = CMM_LOAD_SHARED(buf_stats->blocking_retries);
+	stats->max_nesting = CMM_LOAD_SHARED(buf_stats->max_nesting);
+	stats->records_lost_full = v_read(config, &buf->records_lost_full);
+	stats->records_lost_wrap = v_read(config, &buf->records_lost_wrap);
+	stats->records_lost_big = v_read(config, &buf->records_lost_big);
+end:
+	lttng_ust_sigbus_del_range(&range);
+	sigbus_end();
+	return ret;
+}
+
+/* Received bytes [begin, end) of a fragment group. */
+struct lttng_ust_ctl_fragment_range {
+	uint64_t begin;
+	uint64_t end;
+};
+
+struct lttng_ust_ctl_fragment_group {
+	struct cds_list_head node;	/* Pending groups, oldest first */
+	uint64_t id;
+	uint32_t event_id;
+	uint64_t total_len;
+	uint64_t received;		/* Bytes of the chunks added */
+	char *payload;
+	/* Disjoint, non-adjacent received ranges, sorted by offset. */
+	struct lttng_ust_ctl_fragment_range *ranges;
+	size_t nr_ranges, alloc_ranges;
+};
+
+struct lttng_ust_ctl_fragment_reassembly {
+	struct cds_list_head groups;
+	uint64_t max_pending_len;
+	uint64_t pending_len;		/* Sum of the pending total_len */
+	uint64_t dropped;
+};
+
+struct lttng_ust_ctl_fragment_reassembly *
+	lttng_ust_ctl_fragment_reassembly_create(uint64_t max_pending_len)
+{
+	struct lttng_ust_ctl_fragment_reassembly *reassembly;
+
+	reassembly = zmalloc(sizeof(*reassembly));
+	if (!reassembly)
+		return NULL;
+	CDS_INIT_LIST_HEAD(&reassembly->groups);
+	reassembly->max_pending_len = max_pending_len;
+	return reassembly;
+}
+
+static
+void fragment_group_free(struct lttng_ust_ctl_fragment_reassembly *reassembly,
+		struct lttng_ust_ctl_fragment_group *group)
+{
+	cds_list_del(&group->node);
+	reassembly->pending_len -= group->total_len;
+	free(group->ranges);
+	free(group->payload);
+	free(group);
+}
+
+/*
+ * Record the range [@offset, @offset + @len) as received. Returns 0 on
+ * success, -EEXIST if it overlaps a chunk already added, -ENOMEM.
+ */
+static
+int fragment_group_add_range(struct lttng_ust_ctl_fragment_group *group,
+		uint64_t offset, uint64_t len)
+{
+	struct lttng_ust_ctl_fragment_range *ranges = group->ranges;
+	uint64_t end = offset + len;
+	size_t i;
+
+	/* First range not entirely before the chunk. */
+	for (i = 0; i < group->nr_ranges; i++) {
+		if (ranges[i].end > offset)
+			break;
+	}
+	if (i < group->nr_ranges && ranges[i].begin < end)
+		return -EEXIST;
+	/* Merge with the adjacent ranges. */
+	if (i > 0 && ranges[i - 1].end == offset) {
+		ranges[i - 1].end = end;
+		if (i < group->nr_ranges && ranges[i].begin == end) {
+			ranges[i - 1].end = ranges[i].end;
+			memmove(&ranges[i], &ranges[i + 1],
+				(group->nr_ranges - i - 1) * sizeof(*ranges));
+			group->nr_ranges--;
+		}
+		return 0;
+	}
+	if (i < group->nr_ranges && ranges[i].begin == end) {
+		ranges[i].begin = offset;
+		return 0;
+	}
+	if (group->nr_ranges == group->alloc_ranges) {
+		size_t new_alloc = group->alloc_ranges ? 2 * group->alloc_ranges : 4;
+
+		ranges = realloc(ranges, new_alloc * sizeof(*ranges));
+		if (!ranges)
+			return -ENOMEM;
+		group->ranges = ranges;
+		group->alloc_ranges = new_alloc;
+	}
+	memmove(&ranges[i + 1], &ranges[i],
+		(group->nr_ranges - i) * sizeof(*ranges));
+	ranges[i].begin = offset;
+	ranges[i].end = end;
+	group->nr_ranges++;
+	return 0;
+}
+
+void lttng_ust_ctl_fragment_reassembly_destroy(
+		struct lttng_ust_ctl_fragment_reassembly *reassembly)
+{
+	struct lttng_ust_ctl_fragment_group *group, *tmp;
+
+	if (!reassembly)
+		return;
+	cds_list_for_each_entry_safe(group, tmp, &reassembly->groups, node)
+		fragment_group_free(reassembly, group);
+	free(reassembly);
+}
+
+static
+struct lttng_ust_ctl_fragment_group *fragment_group_create(
+		struct lttng_ust_ctl_fragment_reassembly *reassembly,
+		uint64_t id, uint32_t event_id, uint64_t total_len)
+{
+	struct lttng_ust_ctl_fragment_group *group, *tmp;
+
+	cds_list_for_each_entry_safe(group, tmp, &reassembly->groups, node) {
+		if (reassembly->pending_len + total_len <= reassembly->max_pending_len)
+			break;
+		fragment_group_free(reassembly, group);
+		reassembly->dropped++;
+	}
+	group = zmalloc(sizeof(*group));
+	if (!group)
+		return NULL;
+	group->payload = malloc(total_len);
+	if (!group->payload) {
+		free(group);
+		return NULL;
+	}
+	group->id = id;
+	group->event_id = event_id;
+	group->total_len = total_len;
+	cds_list_add_tail(&group->node, &reassembly->groups);
+	reassembly->pending_len += total_len;
+	return group;
+}
+
+int lttng_ust_ctl_fragment_add_chunk(
+		struct lttng_ust_ctl_fragment_reassembly *reassembly,
+		uint64_t id, uint32_t event_id, uint64_t offset,
+		uint64_t total_len, const void *data, size_t len,
+		struct lttng_ust_ctl_fragment_record *record)
+{
+	struct lttng_ust_ctl_fragment_group *iter, *group = NULL;
+	int ret;
+
+	if (!reassembly || !record || (len && !data))
+		return -EINVAL;
+	if (!len || offset > total_len || len > total_len - offset)
+		return -EINVAL;
+	cds_list_for_each_entry(iter, &reassembly->groups, node) {
+		if (iter->id == id) {
+			group = iter;
+			break;
+		}
+	}
+	if (!group) {
+		if (total_len > reassembly->max_pending_len
+				|| total_len > SIZE_MAX)
+			return -E2BIG;
+		group = fragment_group_create(reassembly, id, event_id,
+				total_len);
+		if (!group)
+			return -ENOMEM;
+	} else if (group->event_id != event_id
+			|| group->total_len != total_len
+			|| len > total_len - group->received) {
+		return -EINVAL;
+	}
+	ret = fragment_group_add_range(group, offset, len);
+	if (ret)
+		return ret;
+	memcpy(group->payload + offset, data, len);
+	group->received += len;
+	if (group->received < group->total_len)
+		return 0;
+	record->id = group->id;
+	record->event_id = group->event_id;
+	record->len = group->total_len;
+	record->payload = group->payload;
+	group->payload = NULL;
+	fragment_group_free(reassembly, group);
+	return 1;
+}
+
+int lttng_ust_ctl_fragment_get_dropped(
+		struct lttng_ust_ctl_fragment_reassembly *reassembly,
+		uint64_t *dropped)
+{
+	if (!reassembly || !dropped)
+		return -EINVAL;
+	*dropped = reassembly->dropped;
+	return 0;
+}
+
+struct lttng_ust_ctl_blob_arena {
+	struct lttng_ust_blob_arena *arena;
+};
+
+int lttng_ust_ctl_blob_arena_open(pid_t pid,
+		struct lttng_ust_ctl_blob_arena **_arena)
+{
+	struct lttng_ust_ctl_blob_arena *arena;
+	char name[LTTNG_UST_BLOB_ARENA_NAME_LEN];
+	int shm_fd, ret;
+
+	if (!_arena)
+		return -EINVAL;
+	ret = snprintf(name, sizeof(name), LTTNG_UST_BLOB_ARENA_NAME_FMT,
+			(int) pid);
+	if (ret < 0 || ret >= sizeof(name))
+		return -EINVAL;
+	arena = zmalloc(sizeof(*arena));
+	if (!arena)
+		return -ENOMEM;
+	shm_fd = shm_open(name, O_RDONLY, 0);
+	if (shm_fd < 0) {
+		ret = -errno;
+		goto error_open;
+	}
+	arena->arena = lttng_ust_blob_arena_map(shm_fd);
+	if (!arena->arena) {
+		ret = -EINVAL;
+		goto error_map;
+	}
+	*_arena = arena;
+	return 0;
+
+error_map:
+	if (close(shm_fd))
+		PERROR("close");
+error_open:
+	free(arena);
+	return ret;
+}
+
+void lttng_ust_ctl_blob_arena_close(struct lttng_ust_ctl_blob_arena *arena)
+{
+	if (!arena)
+		return;
+	lttng_ust_blob_arena_destroy(arena->arena, 1);
+	free(arena);
+}
+
+int lttng_ust_ctl_blob_read(struct lttng_ust_ctl_blob_arena *arena,
+		uint64_t arena_id, uint64_t offset, uint64_t length,
+		uint64_t generation, void *dst)
+{
+	struct lttng_ust_blob_ref ref = {
+		.length = length,
+		.offset = offset,
+		.generation = generation,
+		.arena_id = arena_id,
+	};
+
+	if (!arena || (!dst && length))
+		return -EINVAL;
+	return lttng_ust_blob_arena_read(arena->arena, &ref, dst);
+}
+
+int lttng_ust_ctl_get_instance_id(struct lttng_ust_ctl_consumer_stream *stream,
+		uint64_t *id)
+{
+	struct lttng_ust_client_lib_ring_buffer_client_cb *client_cb;
+	struct lttng_ust_ring_buffer_channel *chan;
+	struct lttng_ust_ring_buffer *buf;
+	struct lttng_ust_sigbus_range range;
+	int ret;
+
+	if (!stream || !id)
+		return -EINVAL;
+	buf = stream->buf;
+	chan = stream->chan->chan->priv->rb_chan;
+	client_cb = get_client_cb(buf, chan);
+	if (!client_cb)
+		return -ENOSYS;
+	if (sigbus_begin())
+		return -EIO;
+	lttng_ust_sigbus_add_range(&range, stream->memory_map_addr,
+				stream->memory_map_size);
+	ret = client_cb->instance_id(buf, chan, id);
+	lttng_ust_sigbus_del_range(&range);
+	sigbus_end();
+	return ret;
+}
+
+int lttng_ust_ctl_packet_create(struct lttng_ust_ctl_consumer_packet **packet)
+{
+	struct lttng_ust_ctl_consumer_packet *new_packet;
+
+	if (!packet)
+		return -EINVAL;
+
+	new_packet = zmalloc(sizeof(struct lttng_ust_ctl_consumer_packet));
+	if (!new_packet)
+		return -ENOMEM;
+
+	*packet = new_packet;
+	return 0;
+}
+
+void lttng_ust_ctl_packet_destroy(struct lttng_ust_ctl_consumer_packet *packet)
+{
+	if (!packet)
+		return;
+
+	lttng_ust_ctl_packet_reset(packet);
+	free(packet);
+}
+
+int lttng_ust_ctl_packet_get_buffer(struct lttng_ust_ctl_consumer_packet *packet, void **buffer,
+		uint64_t *packet_length, uint64_t *packet_length_padded)
+{
+	assert(buffer);
+	assert(packet_length);
+	assert(packet_length_padded);
+	if (!packet || !packet->p)
 		return -EINVAL;
 
 	*buffer = packet->p;
@@ -2583,6 +3373,253 @@ int lttng_ust_ctl_packet_get_buffer(struct lttng_ust_ctl_consumer_packet *packet
 	return 0;
 }
 
+int lttng_ust_ctl_compression_available(enum lttng_ust_ctl_compression compression)
+{
+	switch (compression) {
+	case LTTNG_UST_CTL_COMPRESSION_NONE:
+		return 1;
+#ifdef HAVE_LZ4
+	case LTTNG_UST_CTL_COMPRESSION_LZ4:
+		return 1;
+#endif
+#ifdef HAVE_ZSTD
+	case LTTNG_UST_CTL_COMPRESSION_ZSTD:
+		return 1;
+#endif
+	default:
+		return 0;
+	}
+}
+
+size_t lttng_ust_ctl_compress_bound(enum lttng_ust_ctl_compression compression,
+		size_t packet_size)
+{
+	const size_t header_len = sizeof(struct lttng_ust_ctl_compressed_packet_header);
+
+	switch (compression) {
+	case LTTNG_UST_CTL_COMPRESSION_NONE:
+		return header_len + packet_size;
+#ifdef HAVE_LZ4
+	case LTTNG_UST_CTL_COMPRESSION_LZ4:
+		if (packet_size > LZ4_MAX_INPUT_SIZE)
+			return 0;
+		return header_len + LZ4_compressBound(packet_size);
+#endif
+#ifdef HAVE_ZSTD
+	case LTTNG_UST_CTL_COMPRESSION_ZSTD:
+		return header_len + ZSTD_compressBound(packet_size);
+#endif
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Compress @src_len bytes of @src into @dst. Returns the compressed size,
+ * or a negative errno value. Zstd uses the context of @stream, or a
+ * temporary one without stream.
+ */
+static
+ssize_t compress_buffer(struct lttng_ust_ctl_consumer_stream *stream __attribute__((unused)),
+		enum lttng_ust_ctl_compression compression, int level,
+		const void *src, size_t src_len, void *dst, size_t dst_len)
+{
+	switch (compression) {
+	case LTTNG_UST_CTL_COMPRESSION_NONE:
+		if (src_len > dst_len)
+			return -ENOBUFS;
+		memcpy(dst, src, src_len);
+		return src_len;
+#ifdef HAVE_LZ4
+	case LTTNG_UST_CTL_COMPRESSION_LZ4:
+	{
+		int dst_cap = dst_len > INT_MAX ? INT_MAX : (int) dst_len;
+		int ret;
+
+		if (src_len > LZ4_MAX_INPUT_SIZE)
+			return -EFBIG;
+		if (level > 1)
+			ret = LZ4_compress_HC(src, dst, src_len, dst_cap, level);
+		else
+			ret = LZ4_compress_fast(src, dst, src_len, dst_cap,
+					level < 0 ? -level : 1);
+		if (!ret)
+			return -ENOBUFS;
+		return ret;
+	}
+#endif
+#ifdef HAVE_ZSTD
+	case LTTNG_UST_CTL_COMPRESSION_ZSTD:
+	{
+		size_t ret;
+
+		if (stream)
+			ret = ZSTD_compressCCtx(stream->zstd_cctx, dst, dst_len,
+					src, src_len,
+					level ? level : ZSTD_CLEVEL_DEFAULT);
+		else
+			ret = ZSTD_compress(dst, dst_len, src, src_len,
+					level ? level : ZSTD_CLEVEL_DEFAULT);
+		if (ZSTD_isError(ret)) {
+			if (ZSTD_getErrorCode(ret) == ZSTD_error_dstSize_tooSmall)
+				return -ENOBUFS;
+			return -EINVAL;
+		}
+		return ret;
+	}
+#endif
+	default:
+		return -ENOTSUP;
+	}
+}
+
+/*
+ * Compress the @content_size bytes of a packet of @packet_size bytes
+ * into @dst, prefixed by its header.
+ */
+static
+int compress_packet(struct lttng_ust_ctl_consumer_stream *stream,
+		enum lttng_ust_ctl_compression compression, int level,
+		const void *src, uint64_t content_size, uint64_t packet_size,
+		void *dst, size_t dst_len, size_t *len)
+{
+	struct lttng_ust_ctl_compressed_packet_header header;
+	ssize_t ret;
+
+	ret = compress_buffer(stream, compression, level, src, content_size,
+			(char *) dst + sizeof(header), dst_len - sizeof(header));
+	if (ret < 0)
+		return ret;
+	header.magic = LTTNG_UST_CTL_COMPRESSED_PACKET_MAGIC;
+	header.compression = compression;
+	header.content_size = content_size;
+	header.packet_size = packet_size;
+	header.compressed_size = ret;
+	memcpy(dst, &header, sizeof(header));
+	*len = sizeof(header) + ret;
+	return 0;
+}
+
+int lttng_ust_ctl_compress_buffer(enum lttng_ust_ctl_compression compression,
+		int level, const void *src, size_t content_size,
+		size_t packet_size, void *dst, size_t dst_len, size_t *len)
+{
+	if (!src || !dst || !len || content_size > packet_size)
+		return -EINVAL;
+	if (!lttng_ust_ctl_compression_available(compression))
+		return -ENOTSUP;
+	if (dst_len < sizeof(struct lttng_ust_ctl_compressed_packet_header))
+		return -ENOBUFS;
+	return compress_packet(NULL, compression, level, src, content_size,
+			packet_size, dst, dst_len, len);
+}
+
+int lttng_ust_ctl_compress_packet(struct lttng_ust_ctl_consumer_stream *stream,
+		enum lttng_ust_ctl_compression compression, int level,
+		void *dst, size_t dst_len, size_t *len)
+{
+	struct lttng_ust_ctl_compressed_packet_header header;
+	unsigned long off, content_size, packet_size;
+	struct lttng_ust_sigbus_range range;
+	char *base;
+	ssize_t ret;
+
+	if (!stream || !dst || !len)
+		return -EINVAL;
+	if (!lttng_ust_ctl_compression_available(compression))
+		return -ENOTSUP;
+	if (dst_len < sizeof(header))
+		return -ENOBUFS;
+#ifdef HAVE_ZSTD
+	if (compression == LTTNG_UST_CTL_COMPRESSION_ZSTD && !stream->zstd_cctx) {
+		stream->zstd_cctx = ZSTD_createCCtx();
+		if (!stream->zstd_cctx)
+			return -ENOMEM;
+	}
+#endif
+	base = lttng_ust_ctl_get_mmap_base(stream);
+	if (!base)
+		return -EINVAL;
+	ret = lttng_ust_ctl_get_mmap_read_offset(stream, &off);
+	if (ret)
+		return ret;
+	ret = lttng_ust_ctl_get_subbuf_size(stream, &content_size);
+	if (ret)
+		return ret;
+	ret = lttng_ust_ctl_get_padded_subbuf_size(stream, &packet_size);
+	if (ret)
+		return ret;
+
+	if (sigbus_begin())
+		return -EIO;
+	lttng_ust_sigbus_add_range(&range, stream->memory_map_addr,
+				stream->memory_map_size);
+	ret = compress_packet(stream, compression, level, base + off,
+			content_size, packet_size, dst, dst_len, len);
+	lttng_ust_sigbus_del_range(&range);
+	sigbus_end();
+	return ret;
+}
+
+int lttng_ust_ctl_decompress_packet(const void *src, size_t src_len,
+		void *dst, size_t dst_len, size_t *len)
+{
+	struct lttng_ust_ctl_compressed_packet_header header;
+	const char *data = (const char *) src + sizeof(header);
+
+	if (!src || !dst || !len || src_len < sizeof(header))
+		return -EINVAL;
+	memcpy(&header, src, sizeof(header));
+	if (header.magic != LTTNG_UST_CTL_COMPRESSED_PACKET_MAGIC)
+		return -EINVAL;
+	if (header.compressed_size > src_len - sizeof(header) ||
+			header.content_size > header.packet_size)
+		return -EINVAL;
+	if (header.packet_size > dst_len)
+		return -ENOBUFS;
+
+	switch (header.compression) {
+	case LTTNG_UST_CTL_COMPRESSION_NONE:
+		if (header.compressed_size != header.content_size)
+			return -EINVAL;
+		memcpy(dst, data, header.content_size);
+		break;
+#ifdef HAVE_LZ4
+	case LTTNG_UST_CTL_COMPRESSION_LZ4:
+	{
+		int ret;
+
+		if (header.compressed_size > INT_MAX ||
+				header.content_size > LZ4_MAX_INPUT_SIZE)
+			return -EINVAL;
+		ret = LZ4_decompress_safe(data, dst, header.compressed_size,
+				header.content_size);
+		if (ret < 0 || (uint64_t) ret != header.content_size)
+			return -EINVAL;
+		break;
+	}
+#endif
+#ifdef HAVE_ZSTD
+	case LTTNG_UST_CTL_COMPRESSION_ZSTD:
+	{
+		size_t ret;
+
+		ret = ZSTD_decompress(dst, header.content_size, data,
+				header.compressed_size);
+		if (ZSTD_isError(ret) || ret != header.content_size)
+			return -EINVAL;
+		break;
+	}
+#endif
+	default:
+		return -ENOTSUP;
+	}
+	memset((char *) dst + header.content_size, 0,
+		header.packet_size - header.content_size);
+	*len = header.packet_size;
+	return 0;
+}
+
 #ifdef HAVE_LINUX_PERF_EVENT_H
 
 int lttng_ust_ctl_has_perf_counters(void)
@@ -2790,6 +3827,9 @@ int lttng_ust_ctl_recv_notify(int sock, enum lttng_ust_ctl_notify_cmd *notify_cm
 	case 3:
 		*notify_cmd = LTTNG_UST_CTL_NOTIFY_CMD_KEY;
 		break;
+	case 4:
+		*notify_cmd = LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH;
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -2944,6 +3984,337 @@ int lttng_ust_ctl_reply_register_event(int sock,
 	return 0;
 }
 
+static
+void free_event_registrations(struct lttng_ust_ctl_event_registration *events,
+		size_t nr_events)
+{
+	size_t i;
+
+	for (i = 0; i < nr_events; i++) {
+		free(events[i].signature);
+		free(events[i].fields);
+		free(events[i].model_emf_uri);
+	}
+	free(events);
+}
+
+/*
+ * Copy a string of `len` bytes, including its terminating \0, from a
+ * batch record.
+ */
+static
+char *batch_dup_string(const char *src, size_t len)
+{
+	char *str;
+
+	str = zmalloc(len);
+	if (!str)
+		return NULL;
+	memcpy(str, src, len);
+	/* Enforce end of string */
+	str[len - 1] = '\0';
+	return str;
+}
+
+#define NOTIFY_FIELDS_CACHE_HT_BITS	8
+#define NOTIFY_FIELDS_CACHE_HT_SIZE	(1U << NOTIFY_FIELDS_CACHE_HT_BITS)
+
+struct notify_fields_desc {
+	struct cds_hlist_node node;
+	uint32_t id;
+	bool pending;		/* Defined by the batch being received. */
+	size_t nr_fields;
+	struct lttng_ust_ctl_field fields[];
+};
+
+struct lttng_ust_ctl_notify_fields_cache {
+	struct cds_hlist_head table[NOTIFY_FIELDS_CACHE_HT_SIZE];
+	size_t nr_descs;
+};
+
+struct lttng_ust_ctl_notify_fields_cache *lttng_ust_ctl_create_notify_fields_cache(void)
+{
+	return zmalloc(sizeof(struct lttng_ust_ctl_notify_fields_cache));
+}
+
+void lttng_ust_ctl_destroy_notify_fields_cache(struct lttng_ust_ctl_notify_fields_cache *cache)
+{
+	unsigned int i;
+
+	if (!cache)
+		return;
+	for (i = 0; i < NOTIFY_FIELDS_CACHE_HT_SIZE; i++) {
+		struct notify_fields_desc *desc;
+		struct cds_hlist_node *pos, *tmp;
+
+		cds_hlist_for_each_entry_safe(desc, pos, tmp, &cache->table[i], node)
+			free(desc);
+	}
+	free(cache);
+}
+
+static
+struct notify_fields_desc *notify_fields_desc_lookup(
+		struct lttng_ust_ctl_notify_fields_cache *cache, uint32_t id)
+{
+	struct notify_fields_desc *desc;
+	struct cds_hlist_node *pos;
+
+	cds_hlist_for_each_entry(desc, pos,
+			&cache->table[id & (NOTIFY_FIELDS_CACHE_HT_SIZE - 1)], node) {
+		if (desc->id == id)
+			return desc;
+	}
+	return NULL;
+}
+
+/*
+ * Keep the descriptors defined by a batch once the reply to it was
+ * sent, else forget them, as the application does when it does not
+ * receive a well-formed reply.
+ */
+static
+void notify_fields_desc_commit(struct lttng_ust_ctl_notify_fields_cache *cache,
+		bool accepted)
+{
+	unsigned int i;
+
+	for (i = 0; i < NOTIFY_FIELDS_CACHE_HT_SIZE; i++) {
+		struct notify_fields_desc *desc;
+		struct cds_hlist_node *pos, *tmp;
+
+		cds_hlist_for_each_entry_safe(desc, pos, tmp, &cache->table[i], node) {
+			if (!desc->pending)
+				continue;
+			if (accepted) {
+				desc->pending = false;
+			} else {
+				cds_hlist_del(&desc->node);
+				cache->nr_descs--;
+				free(desc);
+			}
+		}
+	}
+}
+
+/*
+ * Set the fields of a batch record, either sent inline (possibly
+ * defining a descriptor) or by reference to a known descriptor.
+ */
+static
+int batch_set_fields(struct lttng_ust_ctl_notify_fields_cache *fields_cache,
+		struct lttng_ust_ctl_event_registration *event,
+		const char *fields, size_t fields_len, uint32_t fields_desc_id)
+{
+	struct notify_fields_desc *desc = NULL;
+
+	if (fields_desc_id) {
+		if (!fields_cache)
+			return -EINVAL;
+		desc = notify_fields_desc_lookup(fields_cache, fields_desc_id);
+		if (fields_len) {
+			/* Definition: ids are never reused. */
+			if (desc || fields_cache->nr_descs >= USTCOMM_NOTIFY_FIELDS_DESC_MAX)
+				return -EINVAL;
+			desc = zmalloc(sizeof(*desc) + fields_len);
+			if (!desc)
+				return -ENOMEM;
+			desc->id = fields_desc_id;
+			desc->pending = true;
+			desc->nr_fields = fields_len / sizeof(*event->fields);
+			memcpy(desc->fields, fields, fields_len);
+			cds_hlist_add_head(&desc->node,
+				&fields_cache->table[fields_desc_id & (NOTIFY_FIELDS_CACHE_HT_SIZE - 1)]);
+			fields_cache->nr_descs++;
+		} else {
+			/* Reference. */
+			if (!desc)
+				return -EINVAL;
+			fields = (const char *) desc->fields;
+			fields_len = desc->nr_fields * sizeof(*event->fields);
+		}
+	}
+	if (fields_len) {
+		event->fields = zmalloc(fields_len);
+		if (!event->fields)
+			return -ENOMEM;
+		memcpy(event->fields, fields, fields_len);
+	}
+	event->nr_fields = fields_len / sizeof(*event->fields);
+	event->fields_desc_id = fields_desc_id;
+	return 0;
+}
+
+/*
+ * Returns 0 on success, negative UST or system error value on error.
+ */
+int lttng_ust_ctl_recv_register_event_batch(int sock,
+	struct lttng_ust_ctl_notify_fields_cache *fields_cache,
+	struct lttng_ust_ctl_event_registration **_events,
+	size_t *_nr_events)
+{
+	struct lttng_ust_ctl_event_registration *events = NULL;
+	struct ustcomm_notify_event_batch_msg msg;
+	size_t offset = 0, i;
+	char *buf = NULL;
+	ssize_t len;
+
+	/* A batch left without reply was given up by the application. */
+	if (fields_cache)
+		notify_fields_desc_commit(fields_cache, false);
+
+	len = ustcomm_recv_unix_sock(sock, &msg, sizeof(msg));
+	if (len > 0 && len != sizeof(msg))
+		return -EIO;
+	if (len == 0)
+		return -EPIPE;
+	if (len < 0)
+		return len;
+
+	if (!msg.nr_events || msg.len > USTCOMM_NOTIFY_EVENT_BATCH_RECV_MAX_LEN
+			|| msg.nr_events > msg.len / sizeof(struct ustcomm_notify_event_msg))
+		return -EINVAL;
+
+	buf = zmalloc(msg.len);
+	if (!buf)
+		return -ENOMEM;
+	len = ustcomm_recv_unix_sock(sock, buf, msg.len);
+	if (len > 0 && len != msg.len) {
+		len = -EIO;
+		goto error;
+	}
+	if (len == 0) {
+		len = -EPIPE;
+		goto error;
+	}
+	if (len < 0)
+		goto error;
+
+	events = zmalloc(msg.nr_events * sizeof(*events));
+	if (!events) {
+		len = -ENOMEM;
+		goto error;
+	}
+	for (i = 0; i < msg.nr_events; i++) {
+		struct lttng_ust_ctl_event_registration *event = &events[i];
+		struct ustcomm_notify_event_msg m;
+		size_t fields_len;
+
+		/* Validate each part of the record against the batch size. */
+		if (msg.len - offset < sizeof(m)) {
+			len = -EINVAL;
+			goto error;
+		}
+		memcpy(&m, buf + offset, sizeof(m));
+		offset += sizeof(m);
+		fields_len = m.fields_len;
+		if (!m.signature_len || fields_len % sizeof(*event->fields) != 0) {
+			len = -EINVAL;
+			goto error;
+		}
+		if (msg.len - offset < (uint64_t) m.signature_len + fields_len
+				+ m.model_emf_uri_len) {
+			len = -EINVAL;
+			goto error;
+		}
+
+		event->session_objd = m.session_objd;
+		event->channel_objd = m.channel_objd;
+		strncpy(event->event_name, m.event_name, LTTNG_UST_ABI_SYM_NAME_LEN);
+		event->event_name[LTTNG_UST_ABI_SYM_NAME_LEN - 1] = '\0';
+		event->loglevel = m.loglevel;
+		event->user_token = m.user_token;
+
+		event->signature = batch_dup_string(buf + offset, m.signature_len);
+		if (!event->signature) {
+			len = -ENOMEM;
+			goto error;
+		}
+		offset += m.signature_len;
+
+		len = batch_set_fields(fields_cache, event, buf + offset,
+				fields_len, m.fields_desc_id);
+		if (len)
+			goto error;
+		offset += fields_len;
+
+		if (m.model_emf_uri_len) {
+			event->model_emf_uri = batch_dup_string(buf + offset,
+					m.model_emf_uri_len);
+			if (!event->model_emf_uri) {
+				len = -ENOMEM;
+				goto error;
+			}
+			offset += m.model_emf_uri_len;
+		}
+	}
+	if (offset != msg.len) {
+		len = -EINVAL;
+		goto error;
+	}
+	free(buf);
+	/* Descriptors stay pending until the reply is sent. */
+	*_events = events;
+	*_nr_events = msg.nr_events;
+	return 0;
+
+error:
+	if (fields_cache)
+		notify_fields_desc_commit(fields_cache, false);
+	if (events)
+		free_event_registrations(events, msg.nr_events);
+	free(buf);
+	return len;
+}
+
+/*
+ * Returns 0 on success, negative error value on error.
+ */
+int lttng_ust_ctl_reply_register_event_batch(int sock,
+	struct lttng_ust_ctl_notify_fields_cache *fields_cache,
+	const uint32_t *ids,
+	const int *ret_codes,
+	size_t nr_events)
+{
+	struct {
+		struct ustcomm_notify_hdr header;
+		struct ustcomm_notify_event_batch_reply r;
+	} *reply;
+	struct ustcomm_notify_event_batch_entry *entries;
+	size_t reply_len, i;
+	ssize_t len;
+	int ret = 0;
+
+	if (nr_events > UINT32_MAX) {
+		ret = -EINVAL;
+		goto end;
+	}
+	reply_len = sizeof(*reply) + nr_events * sizeof(*entries);
+	reply = zmalloc(reply_len);
+	if (!reply) {
+		ret = -ENOMEM;
+		goto end;
+	}
+	reply->header.notify_cmd = LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH;
+	reply->r.ret_code = 0;
+	reply->r.nr_events = nr_events;
+	entries = (struct ustcomm_notify_event_batch_entry *) (reply + 1);
+	for (i = 0; i < nr_events; i++) {
+		entries[i].ret_code = ret_codes[i];
+		entries[i].id = ids[i];
+	}
+	len = ustcomm_send_unix_sock(sock, reply, reply_len);
+	if (len > 0 && len != reply_len)
+		ret = -EIO;
+	else if (len < 0)
+		ret = len;
+	free(reply);
+end:
+	if (fields_cache)
+		notify_fields_desc_commit(fields_cache, !ret);
+	return ret;
+}
+
 #ifdef CONFIG_LTTNG_UST_EXPERIMENTAL_COUNTER
 /*
  * Returns 0 on success, negative UST or system error value on error.
@@ -3245,6 +4616,12 @@ int lttng_ust_ctl_reply_register_channel(int sock,
 	case LTTNG_UST_CTL_CHANNEL_HEADER_LARGE:
 		reply.r.header_type = 2;
 		break;
+	case LTTNG_UST_CTL_CHANNEL_HEADER_VARINT:
+		reply.r.header_type = 3;
+		break;
+	case LTTNG_UST_CTL_CHANNEL_HEADER_COMPACT_HOT_IDS:
+		reply.r.header_type = 4;
+		break;
 	default:
 		reply.r.header_type = 0;
 		break;
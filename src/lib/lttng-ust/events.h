@@ -191,12 +191,25 @@ int lttng_probes_get_event_list(struct lttng_ust_tracepoint_list *list)
 void lttng_probes_prune_event_list(struct lttng_ust_tracepoint_list *list)
 	__attribute__((visibility("hidden")));
 
+void lttng_probes_early_buffer_register(void)
+	__attribute__((visibility("hidden")));
+
 int lttng_probes_get_field_list(struct lttng_ust_field_list *list)
 	__attribute__((visibility("hidden")));
 
 void lttng_probes_prune_field_list(struct lttng_ust_field_list *list)
 	__attribute__((visibility("hidden")));
 
+unsigned int lttng_probes_get_event_list_batch(struct lttng_ust_probe_list_cursor *cursor,
+		struct lttng_ust_abi_tracepoint_iter *entries,
+		unsigned int max_entries)
+	__attribute__((visibility("hidden")));
+
+unsigned int lttng_probes_get_field_list_batch(struct lttng_ust_probe_list_cursor *cursor,
+		struct lttng_ust_abi_field_iter *entries,
+		unsigned int max_entries)
+	__attribute__((visibility("hidden")));
+
 struct lttng_ust_abi_tracepoint_iter *
 	lttng_ust_tracepoint_list_get_iter_next(struct lttng_ust_tracepoint_list *list)
 	__attribute__((visibility("hidden")));
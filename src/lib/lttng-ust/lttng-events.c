@@ -338,6 +338,7 @@ void unregister_event(struct lttng_ust_event_common *event)
 static
 void _lttng_event_unregister(struct lttng_ust_event_common *event)
 {
+	lttng_ust_fragment_event_unpublish(event);
 	if (event->priv->registered)
 		unregister_event(event);
 }
@@ -589,6 +590,7 @@ int lttng_session_enable(struct lttng_ust_session *session)
 	int ret = 0;
 	struct lttng_ust_channel_buffer_private *chan;
 	int notify_socket;
+	bool first_enable;
 
 	if (session->active) {
 		ret = -EBUSY;
@@ -648,10 +650,16 @@ int lttng_session_enable(struct lttng_ust_session *session)
 		}
 	}
 
+	first_enable = !session->priv->been_active;
+
 	/* Set atomically the state to "active" */
 	CMM_ACCESS_ONCE(session->active) = 1;
 	CMM_ACCESS_ONCE(session->priv->been_active) = 1;
 
+	/* Record the events emitted before registration completed. */
+	if (first_enable)
+		lttng_ust_early_buffer_replay(session);
+
 	ret = lttng_session_statedump(session);
 	if (ret)
 		return ret;
@@ -1149,12 +1157,18 @@ bool lttng_event_enabler_event_desc_key_match_event(struct lttng_event_enabler_c
 	}
 }
 
+/*
+ * Allocate an event for the enabler and descriptor, which is then
+ * registered to the session daemon and published with
+ * lttng_ust_event_publish(), or freed. Fills `name` with the event
+ * name, of size LTTNG_UST_ABI_SYM_NAME_LEN.
+ */
 static
-int lttng_ust_event_create(struct lttng_event_enabler_common *event_enabler, const struct lttng_ust_event_desc *desc)
+int lttng_ust_event_prepare(struct lttng_event_enabler_common *event_enabler,
+		const struct lttng_ust_event_desc *desc, char *name,
+		struct lttng_ust_event_common **_event)
 {
 	char key_string[LTTNG_KEY_TOKEN_STRING_LEN_MAX] = { 0 };
-	char name[LTTNG_UST_ABI_SYM_NAME_LEN] = { 0 };
-	struct cds_list_head *event_list_head = lttng_get_event_list_head_from_enabler(event_enabler);
 	struct lttng_ust_event_ht *events_ht = lttng_get_event_ht_from_enabler(event_enabler);
 	struct lttng_ust_event_common_private *event_priv_iter;
 	struct lttng_ust_event_common *event;
@@ -1189,19 +1203,9 @@ int lttng_ust_event_create(struct lttng_event_enabler_common *event_enabler, con
 		ret = -ENOMEM;
 		goto alloc_error;
 	}
-
-	ret = lttng_event_register_to_sessiond(event_enabler, event, name);
-	if (ret < 0) {
-		DBG("Error (%d) registering event '%s' key '%s' to sessiond", ret, name, key_string);
-		goto sessiond_register_error;
-	}
-
-	cds_list_add(&event->priv->node, event_list_head);
-	cds_hlist_add_head(&event->priv->name_hlist_node, name_head);
+	*_event = event;
 	return 0;
 
-sessiond_register_error:
-	lttng_ust_event_free(event);
 alloc_error:
 create_enum_error:
 exist:
@@ -1211,6 +1215,159 @@ type_error:
 	return ret;
 }
 
+static
+void lttng_ust_event_publish(struct lttng_event_enabler_common *event_enabler,
+		struct lttng_ust_event_common *event, const char *name)
+{
+	struct cds_list_head *event_list_head = lttng_get_event_list_head_from_enabler(event_enabler);
+	struct lttng_ust_event_ht *events_ht = lttng_get_event_ht_from_enabler(event_enabler);
+	struct cds_hlist_head *name_head;
+
+	name_head = borrow_hash_table_bucket(events_ht->table, LTTNG_UST_EVENT_HT_SIZE, name);
+	cds_list_add(&event->priv->node, event_list_head);
+	cds_hlist_add_head(&event->priv->name_hlist_node, name_head);
+	lttng_ust_fragment_event_publish(event);
+}
+
+static
+int lttng_ust_event_create(struct lttng_event_enabler_common *event_enabler, const struct lttng_ust_event_desc *desc)
+{
+	char name[LTTNG_UST_ABI_SYM_NAME_LEN] = { 0 };
+	struct lttng_ust_event_common *event;
+	int ret;
+
+	ret = lttng_ust_event_prepare(event_enabler, desc, name, &event);
+	if (ret)
+		return ret;
+
+	ret = lttng_event_register_to_sessiond(event_enabler, event, name);
+	if (ret < 0) {
+		DBG("Error (%d) registering event '%s' to sessiond", ret, name);
+		lttng_ust_event_free(event);
+		return ret;
+	}
+
+	lttng_ust_event_publish(event_enabler, event, name);
+	return 0;
+}
+
+/*
+ * Events of a recorder enabler awaiting registration to the session
+ * daemon in a single LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH message.
+ */
+struct lttng_event_register_batch {
+	struct lttng_event_enabler_common *event_enabler;
+	size_t nr_events;
+	struct lttng_ust_event_common *events[USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS];
+	char names[USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS][LTTNG_UST_ABI_SYM_NAME_LEN];
+	struct ustcomm_event_registration regs[USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS];
+	size_t len;	/* Approximate size of the batch message. */
+};
+
+static
+bool lttng_event_register_batch_enabled(struct lttng_event_enabler_common *event_enabler)
+{
+	struct lttng_event_enabler_session_common *event_enabler_session;
+
+	if (event_enabler->enabler_type != LTTNG_EVENT_ENABLER_TYPE_RECORDER)
+		return false;
+	event_enabler_session = caa_container_of(event_enabler,
+			struct lttng_event_enabler_session_common, parent);
+	return lttng_get_notify_features(event_enabler_session->chan->session->priv->owner)
+		& LTTNG_UST_ABI_NOTIFY_FEATURE_EVENT_BATCH;
+}
+
+/*
+ * Register the events of the batch to the session daemon, then publish
+ * the ones which were registered successfully and free the others.
+ */
+static
+void lttng_event_register_batch_flush(struct lttng_event_register_batch *batch)
+{
+	struct lttng_event_enabler_session_common *event_enabler_session =
+		caa_container_of(batch->event_enabler, struct lttng_event_enabler_session_common, parent);
+	struct lttng_ust_session *session = event_enabler_session->chan->session;
+	int notify_socket, ret;
+	size_t i;
+
+	if (!batch->nr_events)
+		return;
+
+	notify_socket = lttng_get_notify_socket(session->priv->owner);
+	if (notify_socket < 0)
+		ret = notify_socket;
+	else
+		ret = ustcomm_register_events(notify_socket,
+			session,
+			session->priv->objd,
+			event_enabler_session->chan->priv->objd,
+			batch->regs,
+			batch->nr_events,
+			lttng_get_notify_fields_cache(session->priv->owner));
+	for (i = 0; i < batch->nr_events; i++) {
+		struct lttng_ust_event_common *event = batch->events[i];
+		struct lttng_ust_event_session_common_private *event_session_priv =
+			caa_container_of(event->priv, struct lttng_ust_event_session_common_private, parent);
+		int event_ret = ret ? ret : batch->regs[i].ret_code;
+
+		if (event_ret < 0) {
+			DBG("Error (%d) registering event '%s' to sessiond", event_ret, batch->names[i]);
+			lttng_ust_event_free(event);
+			continue;
+		}
+		event_session_priv->id = batch->regs[i].id;
+		lttng_ust_event_publish(batch->event_enabler, event, batch->names[i]);
+	}
+	batch->nr_events = 0;
+	batch->len = 0;
+}
+
+static
+int lttng_event_register_batch_add(struct lttng_event_register_batch *batch,
+		const struct lttng_ust_event_desc *desc)
+{
+	struct lttng_event_enabler_session_common *event_enabler_session =
+		caa_container_of(batch->event_enabler, struct lttng_event_enabler_session_common, parent);
+	struct ustcomm_event_registration *reg;
+	struct lttng_ust_event_common *event;
+	char *name;
+	int ret;
+
+	name = batch->names[batch->nr_events];
+	memset(name, 0, LTTNG_UST_ABI_SYM_NAME_LEN);
+	ret = lttng_ust_event_prepare(batch->event_enabler, desc, name, &event);
+	if (ret)
+		return ret;
+
+	reg = &batch->regs[batch->nr_events];
+	memset(reg, 0, sizeof(*reg));
+	reg->event_name = name;
+	if (desc->loglevel)
+		reg->loglevel = *(*desc->loglevel);
+	else
+		reg->loglevel = LTTNG_UST_TRACEPOINT_LOGLEVEL_DEFAULT;
+	reg->signature = desc->tp_class->signature;
+	reg->nr_fields = desc->tp_class->nr_fields;
+	reg->fields = desc->tp_class->fields;
+	if (desc->model_emf_uri)
+		reg->model_emf_uri = *(desc->model_emf_uri);
+	reg->user_token = event_enabler_session->parent.user_token;
+	batch->events[batch->nr_events++] = event;
+
+	/*
+	 * Keep batches small enough to be sent without blocking the
+	 * notification socket for long. Field descriptions dominate the
+	 * message size.
+	 */
+	batch->len += sizeof(struct ustcomm_notify_event_msg)
+		+ strlen(reg->signature) + 1
+		+ reg->nr_fields * sizeof(struct lttng_ust_ctl_field);
+	if (batch->nr_events == USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS
+			|| batch->len >= USTCOMM_NOTIFY_EVENT_BATCH_MAX_LEN)
+		lttng_event_register_batch_flush(batch);
+	return 0;
+}
+
 static
 int lttng_desc_match_star_glob_enabler(const struct lttng_ust_event_desc *desc,
 		struct lttng_event_enabler_common *enabler)
@@ -1385,9 +1542,20 @@ void lttng_create_event_if_missing(struct lttng_event_enabler_common *event_enab
 {
 	struct lttng_ust_registered_probe *reg_probe;
 	const struct lttng_ust_event_desc *desc;
+	struct lttng_event_register_batch *batch = NULL;
 	struct cds_list_head *probe_list;
 	int i;
 
+	/*
+	 * Register recorder events in batches when the session daemon
+	 * supports it, falling back on one round trip per event.
+	 */
+	if (lttng_event_register_batch_enabled(event_enabler)) {
+		batch = zmalloc(sizeof(*batch));
+		if (batch)
+			batch->event_enabler = event_enabler;
+	}
+
 	probe_list = lttng_get_probe_list_head();
 	/*
 	 * For each probe event, if we find that a probe event matches
@@ -1406,7 +1574,10 @@ void lttng_create_event_if_missing(struct lttng_event_enabler_common *event_enab
 			/*
 			 * We need to create an event for this event probe.
 			 */
-			ret = lttng_ust_event_create(event_enabler, probe_desc->event_desc[i]);
+			if (batch)
+				ret = lttng_event_register_batch_add(batch, probe_desc->event_desc[i]);
+			else
+				ret = lttng_ust_event_create(event_enabler, probe_desc->event_desc[i]);
 			/* Skip if already found. */
 			if (ret == -EEXIST)
 				continue;
@@ -1417,6 +1588,10 @@ void lttng_create_event_if_missing(struct lttng_event_enabler_common *event_enab
 			}
 		}
 	}
+	if (batch) {
+		lttng_event_register_batch_flush(batch);
+		free(batch);
+	}
 }
 
 static
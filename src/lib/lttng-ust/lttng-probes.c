@@ -262,6 +262,7 @@ struct lttng_ust_registered_probe *lttng_ust_probe_register(const struct lttng_u
 		fixup_lazy_probes();
 
 	lttng_fix_pending_event_notifiers();
+	lttng_ust_early_buffer_probe_register(desc);
 end:
 	ust_unlock();
 	return reg_probe;
@@ -282,12 +283,96 @@ void lttng_ust_probe_unregister(struct lttng_ust_registered_probe *reg_probe)
 	else
 		cds_list_del(&reg_probe->lazy_init_head);
 
+	lttng_ust_early_buffer_probe_unregister(reg_probe->desc);
 	lttng_probe_provider_unregister_events(reg_probe->desc);
 	DBG("just unregistered probes of provider %s", reg_probe->desc->provider_name);
 	ust_unlock();
 	free(reg_probe);
 }
 
+/*
+ * Connect the events of the probe providers registered so far to the
+ * early buffer. Called with the UST lock held.
+ */
+void lttng_probes_early_buffer_register(void)
+{
+	struct lttng_ust_registered_probe *reg_probe;
+
+	cds_list_for_each_entry(reg_probe, &lazy_probe_init, lazy_init_head)
+		lttng_ust_early_buffer_probe_register(reg_probe->desc);
+	cds_list_for_each_entry(reg_probe, &_probe_list, head)
+		lttng_ust_early_buffer_probe_register(reg_probe->desc);
+}
+
+static
+void fill_tracepoint_iter(const struct lttng_ust_event_desc *event_desc,
+		struct lttng_ust_abi_tracepoint_iter *tp)
+{
+	memset(tp, 0, sizeof(*tp));
+	lttng_ust_format_event_name(event_desc, tp->name);
+	if (!event_desc->loglevel) {
+		tp->loglevel = LTTNG_UST_TRACEPOINT_LOGLEVEL_DEFAULT;
+	} else {
+		tp->loglevel = *(*event_desc->loglevel);
+	}
+}
+
+/*
+ * Describe a field of an event, or the event itself when it has no
+ * fields (event_field is NULL).
+ */
+static
+void fill_field_iter(const struct lttng_ust_event_desc *event_desc,
+		const struct lttng_ust_event_field *event_field,
+		struct lttng_ust_abi_field_iter *field)
+{
+	memset(field, 0, sizeof(*field));
+	lttng_ust_format_event_name(event_desc, field->event_name);
+	if (!event_desc->loglevel) {
+		field->loglevel = LTTNG_UST_TRACEPOINT_LOGLEVEL_DEFAULT;
+	} else {
+		field->loglevel = *(*event_desc->loglevel);
+	}
+	if (!event_field) {
+		field->field_name[0] = '\0';
+		field->type = LTTNG_UST_ABI_FIELD_OTHER;
+		field->nowrite = 1;
+		return;
+	}
+	strncpy(field->field_name, event_field->name,
+		LTTNG_UST_ABI_SYM_NAME_LEN);
+	field->field_name[LTTNG_UST_ABI_SYM_NAME_LEN - 1] = '\0';
+	switch (event_field->type->type) {
+	case lttng_ust_type_integer:
+		field->type = LTTNG_UST_ABI_FIELD_INTEGER;
+		break;
+	case lttng_ust_type_string:
+		field->type = LTTNG_UST_ABI_FIELD_STRING;
+		break;
+	case lttng_ust_type_array:
+		if (lttng_ust_get_type_array(event_field->type)->encoding == lttng_ust_string_encoding_none)
+			field->type = LTTNG_UST_ABI_FIELD_OTHER;
+		else
+			field->type = LTTNG_UST_ABI_FIELD_STRING;
+		break;
+	case lttng_ust_type_sequence:
+		if (lttng_ust_get_type_sequence(event_field->type)->encoding == lttng_ust_string_encoding_none)
+			field->type = LTTNG_UST_ABI_FIELD_OTHER;
+		else
+			field->type = LTTNG_UST_ABI_FIELD_STRING;
+		break;
+	case lttng_ust_type_float:
+		field->type = LTTNG_UST_ABI_FIELD_FLOAT;
+		break;
+	case lttng_ust_type_enum:
+		field->type = LTTNG_UST_ABI_FIELD_ENUM;
+		break;
+	default:
+		field->type = LTTNG_UST_ABI_FIELD_OTHER;
+	}
+	field->nowrite = event_field->nowrite;
+}
+
 void lttng_probes_prune_event_list(struct lttng_ust_tracepoint_list *list)
 {
 	struct tp_list_entry *list_entry, *tmp;
@@ -324,12 +409,7 @@ int lttng_probes_get_event_list(struct lttng_ust_tracepoint_list *list)
 			if (!list_entry)
 				goto err_nomem;
 			cds_list_add(&list_entry->head, &list->head);
-			lttng_ust_format_event_name(event_desc, list_entry->tp.name);
-			if (!event_desc->loglevel) {
-				list_entry->tp.loglevel = LTTNG_UST_TRACEPOINT_LOGLEVEL_DEFAULT;
-			} else {
-				list_entry->tp.loglevel = *(*event_desc->loglevel);
-			}
+			fill_tracepoint_iter(event_desc, &list_entry->tp);
 		}
 	}
 	if (cds_list_empty(&list->head))
@@ -404,15 +484,7 @@ int lttng_probes_get_field_list(struct lttng_ust_field_list *list)
 				if (!list_entry)
 					goto err_nomem;
 				cds_list_add(&list_entry->head, &list->head);
-				lttng_ust_format_event_name(event_desc, list_entry->field.event_name);
-				list_entry->field.field_name[0] = '\0';
-				list_entry->field.type = LTTNG_UST_ABI_FIELD_OTHER;
-				if (!event_desc->loglevel) {
-					list_entry->field.loglevel = LTTNG_UST_TRACEPOINT_LOGLEVEL_DEFAULT;
-				} else {
-					list_entry->field.loglevel = *(*event_desc->loglevel);
-				}
-				list_entry->field.nowrite = 1;
+				fill_field_iter(event_desc, NULL, &list_entry->field);
 			}
 
 			for (j = 0; j < event_desc->tp_class->nr_fields; j++) {
@@ -427,45 +499,7 @@ int lttng_probes_get_field_list(struct lttng_ust_field_list *list)
 				if (!list_entry)
 					goto err_nomem;
 				cds_list_add(&list_entry->head, &list->head);
-				lttng_ust_format_event_name(event_desc, list_entry->field.event_name);
-				strncpy(list_entry->field.field_name,
-					event_field->name,
-					LTTNG_UST_ABI_SYM_NAME_LEN);
-				list_entry->field.field_name[LTTNG_UST_ABI_SYM_NAME_LEN - 1] = '\0';
-				switch (event_field->type->type) {
-				case lttng_ust_type_integer:
-					list_entry->field.type = LTTNG_UST_ABI_FIELD_INTEGER;
-					break;
-				case lttng_ust_type_string:
-					list_entry->field.type = LTTNG_UST_ABI_FIELD_STRING;
-					break;
-				case lttng_ust_type_array:
-					if (lttng_ust_get_type_array(event_field->type)->encoding == lttng_ust_string_encoding_none)
-						list_entry->field.type = LTTNG_UST_ABI_FIELD_OTHER;
-					else
-						list_entry->field.type = LTTNG_UST_ABI_FIELD_STRING;
-					break;
-				case lttng_ust_type_sequence:
-					if (lttng_ust_get_type_sequence(event_field->type)->encoding == lttng_ust_string_encoding_none)
-						list_entry->field.type = LTTNG_UST_ABI_FIELD_OTHER;
-					else
-						list_entry->field.type = LTTNG_UST_ABI_FIELD_STRING;
-					break;
-				case lttng_ust_type_float:
-					list_entry->field.type = LTTNG_UST_ABI_FIELD_FLOAT;
-					break;
-				case lttng_ust_type_enum:
-					list_entry->field.type = LTTNG_UST_ABI_FIELD_ENUM;
-					break;
-				default:
-					list_entry->field.type = LTTNG_UST_ABI_FIELD_OTHER;
-				}
-				if (!event_desc->loglevel) {
-					list_entry->field.loglevel = LTTNG_UST_TRACEPOINT_LOGLEVEL_DEFAULT;
-				} else {
-					list_entry->field.loglevel = *(*event_desc->loglevel);
-				}
-				list_entry->field.nowrite = event_field->nowrite;
+				fill_field_iter(event_desc, event_field, &list_entry->field);
 			}
 		}
 	}
@@ -482,6 +516,98 @@ err_nomem:
 	return -ENOMEM;
 }
 
+/*
+ * Describe the events following the cursor directly from the probe
+ * descriptors, without building a list. Returns the number of entries
+ * written, at most max_entries, 0 once all events were listed.
+ *
+ * The cursor holds positions within the registered probes: probes
+ * registered or unregistered between two batches may cause events to
+ * be skipped or listed twice.
+ *
+ * called with UST lock held.
+ */
+unsigned int lttng_probes_get_event_list_batch(struct lttng_ust_probe_list_cursor *cursor,
+		struct lttng_ust_abi_tracepoint_iter *entries,
+		unsigned int max_entries)
+{
+	struct lttng_ust_registered_probe *reg_probe;
+	struct cds_list_head *probe_list;
+	unsigned int probe = 0, nr = 0;
+
+	probe_list = lttng_get_probe_list_head();
+	cds_list_for_each_entry(reg_probe, probe_list, head) {
+		const struct lttng_ust_probe_desc *probe_desc = reg_probe->desc;
+
+		if (probe++ < cursor->probe)
+			continue;
+		for (; cursor->event < probe_desc->nr_events; cursor->event++) {
+			const struct lttng_ust_event_desc *event_desc =
+				probe_desc->event_desc[cursor->event];
+
+			if (nr == max_entries)
+				return nr;
+			/* Skip event if name is too long. */
+			if (!lttng_ust_validate_event_name(event_desc))
+				continue;
+			fill_tracepoint_iter(event_desc, &entries[nr++]);
+		}
+		cursor->probe++;
+		cursor->event = 0;
+	}
+	return nr;
+}
+
+/*
+ * Same as lttng_probes_get_event_list_batch() for the event fields.
+ *
+ * called with UST lock held.
+ */
+unsigned int lttng_probes_get_field_list_batch(struct lttng_ust_probe_list_cursor *cursor,
+		struct lttng_ust_abi_field_iter *entries,
+		unsigned int max_entries)
+{
+	struct lttng_ust_registered_probe *reg_probe;
+	struct cds_list_head *probe_list;
+	unsigned int probe = 0, nr = 0;
+
+	probe_list = lttng_get_probe_list_head();
+	cds_list_for_each_entry(reg_probe, probe_list, head) {
+		const struct lttng_ust_probe_desc *probe_desc = reg_probe->desc;
+
+		if (probe++ < cursor->probe)
+			continue;
+		for (; cursor->event < probe_desc->nr_events;
+				cursor->event++, cursor->field = 0) {
+			const struct lttng_ust_event_desc *event_desc =
+				probe_desc->event_desc[cursor->event];
+			const struct lttng_ust_tracepoint_class *tp_class =
+				event_desc->tp_class;
+
+			/* Skip event if name is too long. */
+			if (!lttng_ust_validate_event_name(event_desc))
+				continue;
+			if (tp_class->nr_fields == 0) {
+				/* Events without fields. */
+				if (nr == max_entries)
+					return nr;
+				fill_field_iter(event_desc, NULL, &entries[nr++]);
+				continue;
+			}
+			for (; cursor->field < tp_class->nr_fields; cursor->field++) {
+				if (nr == max_entries)
+					return nr;
+				fill_field_iter(event_desc,
+					tp_class->fields[cursor->field],
+					&entries[nr++]);
+			}
+		}
+		cursor->probe++;
+		cursor->event = 0;
+	}
+	return nr;
+}
+
 /*
  * Return current iteration position, advance internal iterator to next.
  * Return NULL if end of list.
@@ -25,10 +25,13 @@ struct lttng_ust_session;
 struct lttng_ust_channel_buffer;
 struct lttng_ust_ctx_field;
 struct lttng_ust_ring_buffer_ctx;
+struct ustcomm_fields_desc_cache;
 struct lttng_ust_ctx_value;
 struct lttng_ust_event_recorder;
 struct lttng_ust_event_notifier;
 struct lttng_ust_notification_ctx;
+struct lttng_ust_probe_desc;
+struct lttng_ust_event_common;
 
 int ust_lock(void) __attribute__ ((warn_unused_result))
 	__attribute__((visibility("hidden")));
@@ -69,6 +72,54 @@ const char *lttng_ust_obj_get_name(int id)
 int lttng_get_notify_socket(void *owner)
 	__attribute__((visibility("hidden")));
 
+uint64_t lttng_get_notify_features(void *owner)
+	__attribute__((visibility("hidden")));
+
+uint64_t lttng_set_notify_features(void *owner, uint64_t features)
+	__attribute__((visibility("hidden")));
+
+struct ustcomm_fields_desc_cache *lttng_get_notify_fields_cache(void *owner)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_fragment_event_publish(struct lttng_ust_event_common *event)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_fragment_event_unpublish(struct lttng_ust_event_common *event)
+	__attribute__((visibility("hidden")));
+
+int lttng_ust_early_buffer_init(size_t size)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_early_buffer_probe_register(const struct lttng_ust_probe_desc *desc)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_early_buffer_probe_unregister(const struct lttng_ust_probe_desc *desc)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_early_buffer_replay(struct lttng_ust_session *session)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_early_buffer_release(void)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_early_buffer_before_fork(void)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_early_buffer_after_fork_parent(void)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_early_buffer_after_fork_child(void)
+	__attribute__((visibility("hidden")));
+
+int lttng_ust_blob_arena_init(size_t size)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_blob_arena_exit(void)
+	__attribute__((visibility("hidden")));
+
+void lttng_ust_blob_arena_release(void)
+	__attribute__((visibility("hidden")));
+
 char* lttng_ust_sockinfo_get_procname(void *owner)
 	__attribute__((visibility("hidden")));
 
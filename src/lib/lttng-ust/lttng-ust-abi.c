@@ -24,12 +24,15 @@
 
 #define _LGPL_SOURCE
 #include <fcntl.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <unistd.h>
 
 #include <urcu/compiler.h>
 #include <urcu/list.h>
 
+#include <lttng/urcu/pointer.h>
+#include <lttng/urcu/urcu-ust.h>
 #include <lttng/tracepoint.h>
 #include <lttng/ust-abi.h>
 #include <lttng/ust-error.h>
@@ -47,6 +50,7 @@
 #include "common/tracepoint.h"
 #include "common/tracer.h"
 #include "common/strutils.h"
+#include "common/ustcomm.h"
 #include "lib/lttng-ust/events.h"
 #include "lib/lttng-ust/lttng-tracer-core.h"
 #include "context-internal.h"
@@ -62,10 +66,23 @@ static
 int lttng_abi_tracepoint_field_list(void *owner);
 
 /*
- * Object descriptor table. Should be protected from concurrent access
- * by the caller.
+ * Object descriptor table. Updates should be protected from concurrent
+ * access by the caller. Lookups are lock-free: the table is made of
+ * segments which are never moved nor freed while the table is in use,
+ * so lookups only need the UST lock or an RCU read-side critical
+ * section.
+ *
+ * Segment n holds OBJD_SEGMENT_MIN_LEN << n descriptors, starting at
+ * descriptor OBJD_SEGMENT_MIN_LEN * ((1 << n) - 1). Each segment keeps
+ * its own free list, and the segments with free descriptors are
+ * chained, so allocation and free are O(1). Each owner keeps the list
+ * of the descriptors it holds a reference on.
  */
 
+#define OBJD_SEGMENT_MIN_ORDER	8
+#define OBJD_SEGMENT_MIN_LEN	(1U << OBJD_SEGMENT_MIN_ORDER)
+#define OBJD_NR_SEGMENTS	23	/* Up to INT_MAX descriptors. */
+
 struct lttng_ust_abi_obj {
 	union {
 		struct {
@@ -75,74 +92,159 @@ struct lttng_ust_abi_obj {
 			int owner_ref;	/* has ref from owner */
 			void *owner;
 			char name[OBJ_NAME_LEN];
+			int id;
+			struct cds_list_head owner_node;	/* while owner_ref */
 		} s;
 		int freelist_next;	/* offset freelist. end is -1. */
 	} u;
 };
 
+struct lttng_ust_abi_objd_segment {
+	unsigned int index;		/* Segment number. */
+	unsigned int len;		/* Number of descriptors. */
+	int freelist_head;		/* offset in segment. end is -1 */
+	int next_free_segment;		/* segment freelist. end is -1 */
+	struct lttng_ust_abi_obj objs[];
+};
+
+struct lttng_ust_abi_objd_owner {
+	void *owner;
+	struct cds_list_head objs;	/* Objects with an owner reference. */
+	struct cds_list_head node;
+};
+
 struct lttng_ust_abi_objd_table {
-	struct lttng_ust_abi_obj *array;
-	unsigned int len, allocated_len;
-	int freelist_head;		/* offset freelist head. end is -1 */
+	struct lttng_ust_abi_objd_segment *segments[OBJD_NR_SEGMENTS];
+	unsigned int nr_segments;
+	int free_segment_head;		/* segment freelist head. end is -1 */
+	struct cds_list_head owners;
 };
 
 static struct lttng_ust_abi_objd_table objd_table = {
-	.freelist_head = -1,
+	.free_segment_head = -1,
+	.owners = CDS_LIST_HEAD_INIT(objd_table.owners),
 };
 
+static
+unsigned int objd_segment_base(unsigned int segment)
+{
+	return OBJD_SEGMENT_MIN_LEN * ((1U << segment) - 1);
+}
+
+static
+struct lttng_ust_abi_objd_owner *objd_owner_get(void *owner, bool create)
+{
+	struct lttng_ust_abi_objd_owner *objd_owner;
+
+	cds_list_for_each_entry(objd_owner, &objd_table.owners, node) {
+		if (objd_owner->owner == owner)
+			return objd_owner;
+	}
+	if (!create)
+		return NULL;
+	objd_owner = zmalloc(sizeof(*objd_owner));
+	if (!objd_owner)
+		return NULL;
+	objd_owner->owner = owner;
+	CDS_INIT_LIST_HEAD(&objd_owner->objs);
+	cds_list_add_tail(&objd_owner->node, &objd_table.owners);
+	return objd_owner;
+}
+
+static
+int objd_segment_alloc(void)
+{
+	struct lttng_ust_abi_objd_segment *segment;
+	unsigned int i, index = objd_table.nr_segments;
+
+	if (index >= OBJD_NR_SEGMENTS)
+		return -EMFILE;
+	segment = zmalloc(sizeof(*segment)
+		+ (sizeof(struct lttng_ust_abi_obj) << (OBJD_SEGMENT_MIN_ORDER + index)));
+	if (!segment)
+		return -ENOMEM;
+	segment->index = index;
+	segment->len = OBJD_SEGMENT_MIN_LEN << index;
+	/* Allocate in increasing order: the first root handle is 0. */
+	for (i = 0; i < segment->len - 1; i++)
+		segment->objs[i].u.freelist_next = i + 1;
+	segment->objs[segment->len - 1].u.freelist_next = -1;
+	segment->freelist_head = 0;
+	segment->next_free_segment = objd_table.free_segment_head;
+	objd_table.free_segment_head = index;
+	lttng_ust_rcu_assign_pointer(objd_table.segments[index], segment);
+	objd_table.nr_segments++;
+	return 0;
+}
+
 static
 int objd_alloc(void *private_data, const struct lttng_ust_abi_objd_ops *ops,
 		void *owner, const char *name)
 {
+	struct lttng_ust_abi_objd_owner *objd_owner = NULL;
+	struct lttng_ust_abi_objd_segment *segment;
 	struct lttng_ust_abi_obj *obj;
+	int offset, ret;
 
-	if (objd_table.freelist_head != -1) {
-		obj = &objd_table.array[objd_table.freelist_head];
-		objd_table.freelist_head = obj->u.freelist_next;
-		goto end;
+	if (owner) {
+		objd_owner = objd_owner_get(owner, true);
+		if (!objd_owner)
+			return -ENOMEM;
+	}
+	if (objd_table.free_segment_head == -1) {
+		ret = objd_segment_alloc();
+		if (ret)
+			return ret;
+	}
+	segment = objd_table.segments[objd_table.free_segment_head];
+	offset = segment->freelist_head;
+	obj = &segment->objs[offset];
+	segment->freelist_head = obj->u.freelist_next;
+	if (segment->freelist_head == -1) {
+		/* Segment full. */
+		objd_table.free_segment_head = segment->next_free_segment;
+		segment->next_free_segment = -1;
 	}
 
-	if (objd_table.len >= objd_table.allocated_len) {
-		unsigned int new_allocated_len, old_allocated_len;
-		struct lttng_ust_abi_obj *new_table, *old_table;
-
-		old_allocated_len = objd_table.allocated_len;
-		old_table = objd_table.array;
-		if (!old_allocated_len)
-			new_allocated_len = 1;
-		else
-			new_allocated_len = old_allocated_len << 1;
-		new_table = zmalloc(sizeof(struct lttng_ust_abi_obj) * new_allocated_len);
-		if (!new_table)
-			return -ENOMEM;
-		memcpy(new_table, old_table,
-		       sizeof(struct lttng_ust_abi_obj) * old_allocated_len);
-		free(old_table);
-		objd_table.array = new_table;
-		objd_table.allocated_len = new_allocated_len;
-	}
-	obj = &objd_table.array[objd_table.len];
-	objd_table.len++;
-end:
 	obj->u.s.private_data = private_data;
 	obj->u.s.ops = ops;
-	obj->u.s.f_count = 2;	/* count == 1 : object is allocated */
-				/* count == 2 : allocated + hold ref */
 	obj->u.s.owner_ref = 1;	/* One owner reference */
 	obj->u.s.owner = owner;
+	obj->u.s.id = objd_segment_base(segment->index) + offset;
 	strncpy(obj->u.s.name, name, OBJ_NAME_LEN);
 	obj->u.s.name[OBJ_NAME_LEN - 1] = '\0';
-	return obj - objd_table.array;
+	if (objd_owner)
+		cds_list_add_tail(&obj->u.s.owner_node, &objd_owner->objs);
+	else
+		CDS_INIT_LIST_HEAD(&obj->u.s.owner_node);
+	/* Publish the object to lock-free lookups once initialized. */
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(obj->u.s.f_count, 2);	/* count == 1 : object is allocated */
+						/* count == 2 : allocated + hold ref */
+	return obj->u.s.id;
 }
 
 static
 struct lttng_ust_abi_obj *_objd_get(int id)
 {
-	if (id >= objd_table.len)
+	struct lttng_ust_abi_objd_segment *segment;
+	struct lttng_ust_abi_obj *obj;
+	unsigned int index;
+
+	if (id < 0)
+		return NULL;
+	index = lttng_ust_fls(((unsigned int) id >> OBJD_SEGMENT_MIN_ORDER) + 1) - 1;
+	if (index >= OBJD_NR_SEGMENTS)
 		return NULL;
-	if (!objd_table.array[id].u.s.f_count)
+	segment = lttng_ust_rcu_dereference(objd_table.segments[index]);
+	if (!segment)
 		return NULL;
-	return &objd_table.array[id];
+	obj = &segment->objs[id - objd_segment_base(index)];
+	if (!CMM_LOAD_SHARED(obj->u.s.f_count))
+		return NULL;
+	/* Read the object after its reference count. */
+	cmm_smp_rmb();
+	return obj;
 }
 
 static
@@ -174,12 +276,23 @@ static
 void objd_free(int id)
 {
 	struct lttng_ust_abi_obj *obj = _objd_get(id);
+	struct lttng_ust_abi_objd_segment *segment;
+	unsigned int index;
 
 	assert(obj);
-	obj->u.freelist_next = objd_table.freelist_head;
-	objd_table.freelist_head = obj - objd_table.array;
 	assert(obj->u.s.f_count == 1);
-	obj->u.s.f_count = 0;	/* deallocated */
+	if (obj->u.s.owner_ref)
+		cds_list_del(&obj->u.s.owner_node);
+	CMM_STORE_SHARED(obj->u.s.f_count, 0);	/* deallocated */
+	index = lttng_ust_fls(((unsigned int) id >> OBJD_SEGMENT_MIN_ORDER) + 1) - 1;
+	segment = objd_table.segments[index];
+	if (segment->freelist_head == -1) {
+		/* Segment was full. */
+		segment->next_free_segment = objd_table.free_segment_head;
+		objd_table.free_segment_head = index;
+	}
+	obj->u.freelist_next = segment->freelist_head;
+	segment->freelist_head = id - objd_segment_base(index);
 }
 
 static
@@ -205,7 +318,8 @@ int lttng_ust_abi_objd_unref(int id, int is_owner)
 			ERR("Error decrementing owner reference");
 			return -EINVAL;
 		}
-		obj->u.s.owner_ref--;
+		if (!--obj->u.s.owner_ref)
+			cds_list_del(&obj->u.s.owner_node);
 	}
 	if ((--obj->u.s.f_count) == 1) {
 		const struct lttng_ust_abi_objd_ops *ops = lttng_ust_abi_objd_ops(id);
@@ -220,23 +334,38 @@ int lttng_ust_abi_objd_unref(int id, int is_owner)
 static
 void objd_table_destroy(void)
 {
-	int i;
-
-	for (i = 0; i < objd_table.allocated_len; i++) {
-		struct lttng_ust_abi_obj *obj;
-
-		obj = _objd_get(i);
-		if (!obj)
-			continue;
-		if (!obj->u.s.owner_ref)
-			continue;	/* only unref owner ref. */
-		(void) lttng_ust_abi_objd_unref(i, 1);
-	}
-	free(objd_table.array);
-	objd_table.array = NULL;
-	objd_table.len = 0;
-	objd_table.allocated_len = 0;
-	objd_table.freelist_head = -1;
+	struct lttng_ust_abi_objd_segment *segments[OBJD_NR_SEGMENTS];
+	struct lttng_ust_abi_objd_owner *objd_owner, *tmp;
+	unsigned int i;
+
+	for (i = 0; i < objd_table.nr_segments; i++) {
+		unsigned int base = objd_segment_base(i), j;
+
+		for (j = 0; j < objd_table.segments[i]->len; j++) {
+			struct lttng_ust_abi_obj *obj;
+
+			obj = _objd_get(base + j);
+			if (!obj)
+				continue;
+			if (!obj->u.s.owner_ref)
+				continue;	/* only unref owner ref. */
+			(void) lttng_ust_abi_objd_unref(base + j, 1);
+		}
+	}
+	for (i = 0; i < objd_table.nr_segments; i++) {
+		segments[i] = objd_table.segments[i];
+		lttng_ust_rcu_assign_pointer(objd_table.segments[i], NULL);
+	}
+	/* Wait for lock-free lookups before freeing the segments. */
+	lttng_ust_urcu_synchronize_rcu();
+	for (i = 0; i < objd_table.nr_segments; i++)
+		free(segments[i]);
+	cds_list_for_each_entry_safe(objd_owner, tmp, &objd_table.owners, node) {
+		cds_list_del(&objd_owner->node);
+		free(objd_owner);
+	}
+	objd_table.nr_segments = 0;
+	objd_table.free_segment_head = -1;
 }
 
 const char *lttng_ust_obj_get_name(int id)
@@ -250,20 +379,28 @@ const char *lttng_ust_obj_get_name(int id)
 
 void lttng_ust_abi_objd_table_owner_cleanup(void *owner)
 {
-	int i;
-
-	for (i = 0; i < objd_table.allocated_len; i++) {
+	struct lttng_ust_abi_objd_owner *objd_owner;
+
+	/* Root handles have NULL owners. */
+	if (!owner)
+		return;
+	objd_owner = objd_owner_get(owner, false);
+	if (!objd_owner)
+		return;
+	/*
+	 * Releasing an object can free others of the same owner: take
+	 * the first object again after each unref.
+	 */
+	while (!cds_list_empty(&objd_owner->objs)) {
 		struct lttng_ust_abi_obj *obj;
 
-		obj = _objd_get(i);
-		if (!obj)
-			continue;
-		if (!obj->u.s.owner)
-			continue;	/* skip root handles */
-		if (!obj->u.s.owner_ref)
-			continue;	/* only unref owner ref. */
-		if (obj->u.s.owner == owner)
-			(void) lttng_ust_abi_objd_unref(i, 1);
+		obj = cds_list_first_entry(&objd_owner->objs,
+				struct lttng_ust_abi_obj, u.s.owner_node);
+		if (lttng_ust_abi_objd_unref(obj->u.s.id, 1)) {
+			/* Inconsistent object: don't retry it. */
+			cds_list_del(&obj->u.s.owner_node);
+			obj->u.s.owner_ref = 0;
+		}
 	}
 }
 
@@ -409,6 +546,9 @@ long lttng_abi_add_context(int objd __attribute__((unused)),
  *		Returns a file descriptor listing available tracepoint fields
  *	LTTNG_UST_ABI_WAIT_QUIESCENT
  *		Returns after all previously running probes have completed
+ *	LTTNG_UST_ABI_NOTIFY_FEATURES
+ *		Enables notification protocol features. The subset which
+ *		is supported is returned in the 64-bit reply field
  *
  * The returned session will be deleted when its file descriptor is closed.
  */
@@ -429,6 +569,10 @@ long lttng_cmd(int objd, unsigned int cmd, unsigned long arg,
 	case LTTNG_UST_ABI_WAIT_QUIESCENT:
 		lttng_ust_urcu_synchronize_rcu();
 		return 0;
+	case LTTNG_UST_ABI_NOTIFY_FEATURES:
+		(void) lttng_set_notify_features(owner,
+			((struct lttng_ust_abi_notify_features *) arg)->features);
+		return 0;
 	case LTTNG_UST_ABI_EVENT_NOTIFIER_GROUP_CREATE:
 		return lttng_abi_event_notifier_send_fd(owner,
 			&uargs->event_notifier_handle.event_notifier_notif_fd);
@@ -1178,25 +1322,72 @@ static const struct lttng_ust_abi_objd_ops lttng_event_notifier_group_ops = {
 	.cmd = lttng_event_notifier_group_cmd,
 };
 
+/*
+ * Serialize the next batch of a tracepoint (field) list straight from the
+ * probe descriptors into uargs->list_batch, sent after the reply. Returns
+ * the number of entries.
+ */
+static
+long lttng_tracepoint_list_get_batch(struct lttng_ust_probe_list_cursor *cursor,
+		const struct lttng_ust_abi_list_batch *batch,
+		union lttng_ust_abi_args *uargs, bool fields)
+{
+	size_t entry_len = fields ? sizeof(struct lttng_ust_abi_field_iter) :
+			sizeof(struct lttng_ust_abi_tracepoint_iter);
+	unsigned int max_entries = batch->max_entries, nr;
+	void *entries;
+
+	if (!max_entries)
+		return -EINVAL;
+	if (max_entries > USTCOMM_LIST_BATCH_MAX_LEN / entry_len)
+		max_entries = USTCOMM_LIST_BATCH_MAX_LEN / entry_len;
+	entries = malloc(max_entries * entry_len);
+	if (!entries)
+		return -ENOMEM;
+	if (fields)
+		nr = lttng_probes_get_field_list_batch(cursor, entries, max_entries);
+	else
+		nr = lttng_probes_get_event_list_batch(cursor, entries, max_entries);
+	if (!nr) {
+		free(entries);
+		entries = NULL;
+	}
+	uargs->list_batch.entries = entries;
+	uargs->list_batch.len = nr * entry_len;
+	return nr;
+}
+
 static
 long lttng_tracepoint_list_cmd(int objd, unsigned int cmd, unsigned long arg,
-	union lttng_ust_abi_args *uargs __attribute__((unused)),
+	union lttng_ust_abi_args *uargs,
 	void *owner __attribute__((unused)))
 {
 	struct lttng_ust_tracepoint_list *list = objd_private(objd);
 	struct lttng_ust_abi_tracepoint_iter *tp =
 		(struct lttng_ust_abi_tracepoint_iter *) arg;
 	struct lttng_ust_abi_tracepoint_iter *iter;
+	int ret;
 
 	switch (cmd) {
 	case LTTNG_UST_ABI_TRACEPOINT_LIST_GET:
 	{
+		/* populate list by walking on all registered probes. */
+		if (!list->populated) {
+			ret = lttng_probes_get_event_list(list);
+			if (ret)
+				return ret;
+			list->populated = true;
+		}
 		iter = lttng_ust_tracepoint_list_get_iter_next(list);
 		if (!iter)
 			return -LTTNG_UST_ERR_NOENT;
 		memcpy(tp, iter, sizeof(*tp));
 		return 0;
 	}
+	case LTTNG_UST_ABI_TRACEPOINT_LIST_GET_BATCH:
+		return lttng_tracepoint_list_get_batch(&list->cursor,
+			(const struct lttng_ust_abi_list_batch *) arg,
+			uargs, false);
 	default:
 		return -EINVAL;
 	}
@@ -1218,17 +1409,14 @@ int lttng_abi_tracepoint_list(void *owner)
 		ret = -ENOMEM;
 		goto alloc_error;
 	}
+	/*
+	 * The list is only built on the first entry-by-entry get:
+	 * batched gets walk the probes directly.
+	 */
+	CDS_INIT_LIST_HEAD(&list->head);
 	objd_set_private(list_objd, list);
-
-	/* populate list by walking on all registered probes. */
-	ret = lttng_probes_get_event_list(list);
-	if (ret) {
-		goto list_error;
-	}
 	return list_objd;
 
-list_error:
-	free(list);
 alloc_error:
 	{
 		int err;
@@ -1261,22 +1449,34 @@ static const struct lttng_ust_abi_objd_ops lttng_tracepoint_list_ops = {
 
 static
 long lttng_tracepoint_field_list_cmd(int objd, unsigned int cmd,
-	unsigned long arg __attribute__((unused)), union lttng_ust_abi_args *uargs,
+	unsigned long arg, union lttng_ust_abi_args *uargs,
 	void *owner __attribute__((unused)))
 {
 	struct lttng_ust_field_list *list = objd_private(objd);
 	struct lttng_ust_abi_field_iter *tp = &uargs->field_list.entry;
 	struct lttng_ust_abi_field_iter *iter;
+	int ret;
 
 	switch (cmd) {
 	case LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET:
 	{
+		/* populate list by walking on all registered probes. */
+		if (!list->populated) {
+			ret = lttng_probes_get_field_list(list);
+			if (ret)
+				return ret;
+			list->populated = true;
+		}
 		iter = lttng_ust_field_list_get_iter_next(list);
 		if (!iter)
 			return -LTTNG_UST_ERR_NOENT;
 		memcpy(tp, iter, sizeof(*tp));
 		return 0;
 	}
+	case LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET_BATCH:
+		return lttng_tracepoint_list_get_batch(&list->cursor,
+			(const struct lttng_ust_abi_list_batch *) arg,
+			uargs, true);
 	default:
 		return -EINVAL;
 	}
@@ -1299,17 +1499,14 @@ int lttng_abi_tracepoint_field_list(void *owner)
 		ret = -ENOMEM;
 		goto alloc_error;
 	}
+	/*
+	 * The list is only built on the first entry-by-entry get:
+	 * batched gets walk the probes directly.
+	 */
+	CDS_INIT_LIST_HEAD(&list->head);
 	objd_set_private(list_objd, list);
-
-	/* populate list by walking on all registered probes. */
-	ret = lttng_probes_get_field_list(list);
-	if (ret) {
-		goto list_error;
-	}
 	return list_objd;
 
-list_error:
-	free(list);
 alloc_error:
 	{
 		int err;
@@ -0,0 +1,150 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Blob arena of the process.
+ *
+ * With LTTNG_UST_BLOB_ARENA_SIZE, the constructor creates the POSIX shm
+ * object LTTNG_UST_BLOB_ARENA_NAME_FMT, named after the PID, holding the
+ * payloads of the lttng_ust_field_blob() fields. Consumers open it by
+ * name to resolve the references found in the records. The name is
+ * unlinked at exit: the consumers which mapped it keep their mapping.
+ *
+ * A child created by fork() has no arena until it calls exec(): the
+ * exec() would skip the destructor unlinking the name of its arena,
+ * leaking a shm object for each such child.
+ */
+
+#define _LGPL_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <urcu/compiler.h>
+#include <urcu/system.h>
+
+#include <lttng/ust-events.h>
+#include <lttng/ust-fd.h>
+
+#include "common/logging.h"
+#include "common/populate.h"
+#include "common/ringbuffer/blob_arena.h"
+#include "lttng-tracer-core.h"
+
+static struct lttng_ust_blob_arena *blob_arena;
+static char blob_arena_name[LTTNG_UST_BLOB_ARENA_NAME_LEN];
+static bool blob_arena_forked;	/* In a child, before exec(). */
+
+static
+int blob_arena_open_shm(const char *name)
+{
+	int fd, ret;
+
+	lttng_ust_lock_fd_tracker();
+	fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+	if (fd < 0 && errno == EEXIST) {
+		/* Left behind by a previous process with the same PID. */
+		(void) shm_unlink(name);
+		fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR,
+				S_IRUSR | S_IWUSR);
+	}
+	if (fd < 0) {
+		PERROR("shm_open");
+		goto end;
+	}
+	ret = lttng_ust_add_fd_to_tracker(fd);
+	if (ret < 0) {
+		if (close(fd))
+			PERROR("close");
+		(void) shm_unlink(name);
+		fd = -1;
+		goto end;
+	}
+	fd = ret;
+end:
+	lttng_ust_unlock_fd_tracker();
+	return fd;
+}
+
+/*
+ * Create the blob arena, with a data area of @size bytes rounded up to
+ * a power of two. Called from the constructor.
+ */
+int lttng_ust_blob_arena_init(size_t size)
+{
+	struct lttng_ust_blob_arena *arena;
+	size_t data_size = LTTNG_UST_BLOB_ARENA_MIN_SIZE;
+	int fd, ret;
+
+	if (blob_arena || blob_arena_forked)
+		return 0;
+	if (size > LTTNG_UST_BLOB_ARENA_MAX_SIZE)
+		size = LTTNG_UST_BLOB_ARENA_MAX_SIZE;
+	while (data_size < size)
+		data_size <<= 1;
+	ret = snprintf(blob_arena_name, sizeof(blob_arena_name),
+			LTTNG_UST_BLOB_ARENA_NAME_FMT, (int) getpid());
+	if (ret < 0 || ret >= sizeof(blob_arena_name))
+		return -EINVAL;
+	fd = blob_arena_open_shm(blob_arena_name);
+	if (fd < 0)
+		return -EIO;
+	arena = lttng_ust_blob_arena_create(fd, data_size,
+			lttng_ust_map_populate_is_enabled());
+	if (!arena) {
+		lttng_ust_lock_fd_tracker();
+		if (close(fd))
+			PERROR("close");
+		else
+			lttng_ust_delete_fd_from_tracker(fd);
+		lttng_ust_unlock_fd_tracker();
+		(void) shm_unlink(blob_arena_name);
+		return -ENOMEM;
+	}
+	DBG("Blob arena %s of %zu bytes", blob_arena_name, data_size);
+	CMM_STORE_SHARED(blob_arena, arena);
+	return 0;
+}
+
+/* Unlink the name of the arena, which stays mapped until exit. */
+void lttng_ust_blob_arena_exit(void)
+{
+	if (!blob_arena)
+		return;
+	if (shm_unlink(blob_arena_name))
+		PERROR("shm_unlink");
+}
+
+/*
+ * In the child after fork: the arena belongs to the parent, which keeps
+ * its name. The child is single-threaded, so it can be unmapped. The
+ * child gets no arena of its own.
+ */
+void lttng_ust_blob_arena_release(void)
+{
+	struct lttng_ust_blob_arena *arena = blob_arena;
+
+	blob_arena_forked = true;
+	if (!arena)
+		return;
+	CMM_STORE_SHARED(blob_arena, NULL);
+	lttng_ust_blob_arena_destroy(arena, 0);
+}
+
+void lttng_ust_blob_write(const void *src, size_t len,
+		struct lttng_ust_blob_ref *ref)
+{
+	struct lttng_ust_blob_arena *arena = CMM_LOAD_SHARED(blob_arena);
+
+	if (caa_unlikely(!arena || !src)
+			|| lttng_ust_blob_arena_write(arena, src, len, ref)) {
+		ref->length = len;
+		ref->offset = 0;
+		ref->generation = 0;
+		ref->arena_id = 0;
+	}
+}
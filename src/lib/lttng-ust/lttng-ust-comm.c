@@ -48,6 +48,7 @@
 #include "common/tracepoint.h"
 #include "lttng-tracer-core.h"
 #include "common/compat/pthread.h"
+#include "common/compat/shared-futex.h"
 #include "common/procname.h"
 #include "common/ringbuffer/rb-init.h"
 #include "lttng-ust-statedump.h"
@@ -263,6 +264,17 @@ struct sock_info {
 	char sock_path[PATH_MAX];
 	int socket;
 	int notify_socket;
+	/* LTTNG_UST_ABI_NOTIFY_FEATURE_* enabled by the session daemon. */
+	uint64_t notify_features;
+	/* Field descriptors sent, with LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP. */
+	struct ustcomm_fields_desc_cache *notify_fields_cache;
+	/* Shared-memory command ring, set up by LTTNG_UST_ABI_CMD_RING. */
+	struct ustcomm_cmd_ring *cmd_ring;
+	size_t cmd_ring_len;
+	uint32_t cmd_ring_nr_slots;
+	pthread_t cmd_ring_thread;
+	int cmd_ring_thread_active;
+	int cmd_ring_stop;
 
 	/*
 	 * If wait_shm_is_file is true, use standard open to open and
@@ -353,6 +365,8 @@ static const char *cmd_name_mapping[] = {
 	[ LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST ] = "Create Tracepoint Field List",
 
 	[ LTTNG_UST_ABI_EVENT_NOTIFIER_GROUP_CREATE ] = "Create event notifier group",
+	[ LTTNG_UST_ABI_NOTIFY_FEATURES ] = "Enable notify features",
+	[ LTTNG_UST_ABI_CMD_RING ] = "Set up command ring",
 
 	/* Session FD commands */
 	[ LTTNG_UST_ABI_CHANNEL ] = "Create Channel",
@@ -374,6 +388,8 @@ static const char *cmd_name_mapping[] = {
 	/* Tracepoint list commands */
 	[ LTTNG_UST_ABI_TRACEPOINT_LIST_GET ] = "List Next Tracepoint",
 	[ LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET ] = "List Next Tracepoint Field",
+	[ LTTNG_UST_ABI_TRACEPOINT_LIST_GET_BATCH ] = "List Next Tracepoints",
+	[ LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET_BATCH ] = "List Next Tracepoint Fields",
 
 	/* Event FD commands */
 	[ LTTNG_UST_ABI_FILTER ] = "Create Filter",
@@ -532,6 +548,47 @@ int lttng_get_notify_socket(void *owner)
 	return info->notify_socket;
 }
 
+uint64_t lttng_get_notify_features(void *owner)
+{
+	struct sock_info *info = owner;
+
+	return info->notify_features;
+}
+
+static
+void reset_notify_features(struct sock_info *info)
+{
+	info->notify_features = 0;
+	ustcomm_fields_desc_cache_destroy(info->notify_fields_cache);
+	info->notify_fields_cache = NULL;
+}
+
+uint64_t lttng_set_notify_features(void *owner, uint64_t features)
+{
+	struct sock_info *info = owner;
+
+	reset_notify_features(info);
+	features &= LTTNG_UST_ABI_NOTIFY_FEATURE_EVENT_BATCH
+		| LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP;
+	/* Descriptors are only sent within batches. */
+	if (!(features & LTTNG_UST_ABI_NOTIFY_FEATURE_EVENT_BATCH))
+		features &= ~LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP;
+	if (features & LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP) {
+		info->notify_fields_cache = ustcomm_fields_desc_cache_create();
+		if (!info->notify_fields_cache)
+			features &= ~LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP;
+	}
+	info->notify_features = features;
+	return info->notify_features;
+}
+
+struct ustcomm_fields_desc_cache *lttng_get_notify_fields_cache(void *owner)
+{
+	struct sock_info *info = owner;
+
+	return info->notify_fields_cache;
+}
+
 
 char* lttng_ust_sockinfo_get_procname(void *owner)
 {
@@ -774,6 +831,105 @@ void get_allow_blocking(void)
 	}
 }
 
+/*
+ * The adaptive read timer is enabled by setting either bound. The
+ * missing bound defaults to the read timer period of each channel.
+ */
+static
+void get_read_timer_bounds(void)
+{
+	const char *str_min =
+		lttng_ust_getenv("LTTNG_UST_READ_TIMER_MIN_INTERVAL");
+	const char *str_max =
+		lttng_ust_getenv("LTTNG_UST_READ_TIMER_MAX_INTERVAL");
+	unsigned long min_interval = 0, max_interval = 0;
+
+	if (!str_min && !str_max)
+		return;
+	if (str_min)
+		min_interval = strtoul(str_min, NULL, 10);
+	if (str_max)
+		max_interval = strtoul(str_max, NULL, 10);
+	if ((str_min && !min_interval) || (str_max && !max_interval)
+			|| (str_min && str_max && min_interval > max_interval)) {
+		WARN("Invalid adaptive read timer bounds, using fixed read timer period.");
+		return;
+	}
+	DBG("Adaptive read timer bounds: [%lu, %lu] us",
+		min_interval, max_interval);
+	lttng_ust_ringbuffer_set_read_timer_bounds(min_interval, max_interval);
+}
+
+/*
+ * Parse the size in bytes held by environment variable @name.
+ * Returns 0 on success, -EINVAL if it is not a non-negative integer.
+ */
+static
+int parse_env_size(const char *name, const char *str, long *size)
+{
+	char *endptr;
+	long val;
+
+	errno = 0;
+	val = strtol(str, &endptr, 10);
+	if (errno || endptr == str || *endptr != '\0' || val < 0) {
+		WARN("Invalid %s value \"%s\", ignored.", name, str);
+		return -EINVAL;
+	}
+	*size = val;
+	return 0;
+}
+
+/*
+ * With LTTNG_UST_REGISTER_ASYNC, the constructor does not wait for the
+ * session daemons. The events emitted until the registration completes
+ * are kept in an early buffer of LTTNG_UST_EARLY_BUFFER_SIZE bytes and
+ * replayed into the sessions enabled meanwhile.
+ *
+ * Returns the constructor timeout mode to use.
+ */
+static
+int get_register_async(int timeout_mode)
+{
+	long size = LTTNG_UST_DEFAULT_EARLY_BUFFER_SIZE;
+	const char *str_size;
+
+	if (!lttng_ust_getenv("LTTNG_UST_REGISTER_ASYNC"))
+		return timeout_mode;
+	str_size = lttng_ust_getenv("LTTNG_UST_EARLY_BUFFER_SIZE");
+	if (str_size && parse_env_size("LTTNG_UST_EARLY_BUFFER_SIZE",
+			str_size, &size))
+		size = LTTNG_UST_DEFAULT_EARLY_BUFFER_SIZE;
+	DBG("Asynchronous registration, early buffer of %ld bytes", size);
+	ust_lock_nocheck();
+	if (lttng_ust_early_buffer_init(size))
+		ERR("Unable to allocate the early buffer");
+	ust_unlock();
+	/* Don't wait. */
+	return 0;
+}
+
+/*
+ * With LTTNG_UST_BLOB_ARENA_SIZE, the payloads of the
+ * lttng_ust_field_blob() fields are copied into a shared memory arena of
+ * that size, and the records only hold references to them.
+ */
+static
+void get_blob_arena(void)
+{
+	const char *str_size;
+	long size;
+
+	str_size = lttng_ust_getenv("LTTNG_UST_BLOB_ARENA_SIZE");
+	if (!str_size)
+		return;
+	if (parse_env_size("LTTNG_UST_BLOB_ARENA_SIZE", str_size, &size)
+			|| !size)
+		return;
+	if (lttng_ust_blob_arena_init(size))
+		ERR("Unable to create the blob arena");
+}
+
 static
 int register_to_sessiond(int socket, enum lttng_ust_ctl_socket_type type,
 		const char *procname)
@@ -826,6 +982,7 @@ void decrement_sem_count(unsigned int count)
 	if (ret == 0) {
 		ret = sem_post(&constructor_wait);
 		assert(!ret);
+		lttng_ust_early_buffer_release();
 	}
 }
 
@@ -1072,6 +1229,247 @@ void prepare_cmd_reply(struct ustcomm_ust_reply *lur, uint32_t handle, uint32_t
 	}
 }
 
+#ifdef LTTNG_UST_HAVE_SHARED_FUTEX
+/*
+ * Execute a command received through the command ring. Commands which
+ * carry a payload or file descriptors on the socket are refused.
+ */
+static
+void handle_ring_message(struct sock_info *sock_info,
+		struct ustcomm_ust_msg *lum, struct ustcomm_ust_reply *lur)
+{
+	const struct lttng_ust_abi_objd_ops *ops;
+	union lttng_ust_abi_args args;
+	int ret;
+
+	if (ust_lock()) {
+		ret = -LTTNG_UST_ERR_EXITING;
+		goto end;
+	}
+
+	ops = lttng_ust_abi_objd_ops(lum->handle);
+	if (!ops) {
+		ret = -ENOENT;
+		goto end;
+	}
+
+	switch (lum->cmd) {
+	case LTTNG_UST_ABI_FILTER:
+	case LTTNG_UST_ABI_EXCLUSION:
+	case LTTNG_UST_ABI_CHANNEL:
+	case LTTNG_UST_ABI_STREAM:
+	case LTTNG_UST_ABI_CONTEXT:
+	case LTTNG_UST_ABI_CAPTURE:
+	case LTTNG_UST_ABI_COUNTER:
+	case LTTNG_UST_ABI_COUNTER_CHANNEL:
+	case LTTNG_UST_ABI_COUNTER_CPU:
+#ifdef CONFIG_LTTNG_UST_EXPERIMENTAL_COUNTER
+	case LTTNG_UST_ABI_COUNTER_EVENT:
+#endif	/* CONFIG_LTTNG_UST_EXPERIMENTAL_COUNTER */
+	case LTTNG_UST_ABI_EVENT_NOTIFIER_CREATE:
+	case LTTNG_UST_ABI_EVENT_NOTIFIER_GROUP_CREATE:
+	case LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET:
+	case LTTNG_UST_ABI_TRACEPOINT_LIST_GET_BATCH:
+	case LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET_BATCH:
+	case LTTNG_UST_ABI_CMD_RING:
+		ret = -EINVAL;
+		break;
+	case LTTNG_UST_ABI_REGISTER_DONE:
+		if (lum->handle == LTTNG_UST_ABI_ROOT_HANDLE)
+			ret = handle_register_done(sock_info);
+		else
+			ret = -EINVAL;
+		break;
+	case LTTNG_UST_ABI_RELEASE:
+		if (lum->handle == LTTNG_UST_ABI_ROOT_HANDLE)
+			ret = -EPERM;
+		else
+			ret = lttng_ust_abi_objd_unref(lum->handle, 1);
+		break;
+	default:
+		if (ops->cmd)
+			ret = ops->cmd(lum->handle, lum->cmd,
+					(unsigned long) &lum->u,
+					&args, sock_info);
+		else
+			ret = -ENOSYS;
+		break;
+	}
+end:
+	prepare_cmd_reply(lur, lum->handle, lum->cmd, ret);
+	if (ret >= 0) {
+		switch (lum->cmd) {
+		case LTTNG_UST_ABI_TRACER_VERSION:
+			lur->u.version = lum->u.version;
+			break;
+		case LTTNG_UST_ABI_TRACEPOINT_LIST_GET:
+			memcpy(&lur->u.tracepoint, &lum->u.tracepoint, sizeof(lur->u.tracepoint));
+			break;
+		case LTTNG_UST_ABI_NOTIFY_FEATURES:
+			lur->u.notify_features.features = lttng_get_notify_features(sock_info);
+			break;
+		}
+	}
+	DBG("Return value: %d", lur->ret_val);
+	ust_unlock();
+
+	/* Same as handle_message(): statedump outside of the UST lock. */
+	handle_pending_statedump(sock_info);
+}
+
+/*
+ * Execute the commands of the ring in order until the ring is torn
+ * down. Sleeps on the doorbell when the ring is empty.
+ */
+static
+void *ust_cmd_ring_thread(void *arg)
+{
+	struct sock_info *sock_info = arg;
+	struct ustcomm_cmd_ring *ring = sock_info->cmd_ring;
+	uint32_t nr_slots = sock_info->cmd_ring_nr_slots;
+	int32_t tail = CMM_LOAD_SHARED(ring->tail);
+
+	lttng_ust_common_init_thread(0);
+
+	while (!CMM_LOAD_SHARED(sock_info->cmd_ring_stop)) {
+		struct ustcomm_ust_reply lur = {};
+		struct ustcomm_ust_msg lum;
+		int32_t head, doorbell;
+
+		doorbell = CMM_LOAD_SHARED(ring->doorbell);
+		head = CMM_LOAD_SHARED(ring->head);
+		if (head == tail) {
+			CMM_STORE_SHARED(ring->app_waiting, 1);
+			/* Order app_waiting store before head load. */
+			cmm_smp_mb();
+			if (CMM_LOAD_SHARED(ring->head) == tail
+					&& !CMM_LOAD_SHARED(sock_info->cmd_ring_stop))
+				(void) lttng_ust_shared_futex_wait(&ring->doorbell,
+						doorbell, NULL);
+			CMM_STORE_SHARED(ring->app_waiting, 0);
+			continue;
+		}
+		if ((uint32_t) (head - tail) > nr_slots) {
+			ERR("Invalid %s command ring head", sock_info->name);
+			break;
+		}
+		/* Read the slot after head. */
+		cmm_smp_rmb();
+		memcpy(&lum, &ring->slots[(uint32_t) tail & (nr_slots - 1)].msg,
+			sizeof(lum));
+		print_cmd(lum.cmd, lum.handle);
+		handle_ring_message(sock_info, &lum, &lur);
+		memcpy(&ring->slots[(uint32_t) tail & (nr_slots - 1)].reply, &lur,
+			sizeof(lur));
+		/* Write the reply before tail. */
+		cmm_smp_wmb();
+		CMM_STORE_SHARED(ring->tail, ++tail);
+		/* Order tail store before sessiond_waiting load. */
+		cmm_smp_mb();
+		if (CMM_LOAD_SHARED(ring->sessiond_waiting))
+			(void) lttng_ust_shared_futex_wake(&ring->tail, 1);
+	}
+	return NULL;
+}
+
+/*
+ * Map the command ring received with LTTNG_UST_ABI_CMD_RING and start
+ * its thread. Called with the UST lock held.
+ */
+static
+int cmd_ring_setup(struct sock_info *sock_info, int shm_fd,
+		const struct lttng_ust_abi_cmd_ring *cmd_ring)
+{
+	sigset_t sig_all_blocked, orig_mask;
+	struct ustcomm_cmd_ring *ring;
+	uint32_t nr_slots = cmd_ring->nr_slots;
+	size_t len;
+	int ret, sigmask_ret;
+
+	if (sock_info->cmd_ring)
+		return -EEXIST;
+	if (!nr_slots || nr_slots > USTCOMM_CMD_RING_MAX_SLOTS
+			|| (nr_slots & (nr_slots - 1)))
+		return -EINVAL;
+	len = ustcomm_cmd_ring_len(nr_slots);
+	if (cmd_ring->len != len)
+		return -EINVAL;
+	ring = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+	if (ring == MAP_FAILED)
+		return -errno;
+	if (ring->magic != USTCOMM_CMD_RING_MAGIC || ring->nr_slots != nr_slots) {
+		ret = -EINVAL;
+		goto error;
+	}
+	sock_info->cmd_ring = ring;
+	sock_info->cmd_ring_len = len;
+	sock_info->cmd_ring_nr_slots = nr_slots;
+	sock_info->cmd_ring_stop = 0;
+
+	/* Same as the listener threads: don't receive signals. */
+	sigfillset(&sig_all_blocked);
+	ret = pthread_sigmask(SIG_SETMASK, &sig_all_blocked, &orig_mask);
+	if (ret)
+		ERR("pthread_sigmask: %s", strerror(ret));
+	ret = pthread_create(&sock_info->cmd_ring_thread, NULL,
+			ust_cmd_ring_thread, sock_info);
+	sigmask_ret = pthread_sigmask(SIG_SETMASK, &orig_mask, NULL);
+	if (sigmask_ret)
+		ERR("pthread_sigmask: %s", strerror(sigmask_ret));
+	if (ret) {
+		ERR("pthread_create %s command ring: %s", sock_info->name,
+			strerror(ret));
+		sock_info->cmd_ring = NULL;
+		ret = -ret;
+		goto error;
+	}
+	sock_info->cmd_ring_thread_active = 1;
+	DBG("%s command ring of %u slots set up", sock_info->name, nr_slots);
+	return 0;
+
+error:
+	if (munmap(ring, len))
+		PERROR("munmap");
+	return ret;
+}
+#else
+/* The command ring needs futexes shared across processes. */
+static
+int cmd_ring_setup(struct sock_info *sock_info __attribute__((unused)),
+		int shm_fd __attribute__((unused)),
+		const struct lttng_ust_abi_cmd_ring *cmd_ring __attribute__((unused)))
+{
+	return -ENOSYS;
+}
+#endif
+
+/*
+ * Stop the command ring thread and unmap the ring. Called by the
+ * listener thread without the UST lock held, once the command socket
+ * is closed.
+ */
+static
+void cmd_ring_teardown(struct sock_info *sock_info)
+{
+	int ret;
+
+	if (sock_info->cmd_ring_thread_active) {
+		CMM_STORE_SHARED(sock_info->cmd_ring_stop, 1);
+		(void) uatomic_add_return(&sock_info->cmd_ring->doorbell, 1);
+		(void) lttng_ust_shared_futex_wake(&sock_info->cmd_ring->doorbell, 1);
+		ret = pthread_join(sock_info->cmd_ring_thread, NULL);
+		if (ret)
+			ERR("pthread_join %s command ring: %s", sock_info->name,
+				strerror(ret));
+		sock_info->cmd_ring_thread_active = 0;
+	}
+	if (sock_info->cmd_ring) {
+		if (munmap(sock_info->cmd_ring, sock_info->cmd_ring_len))
+			PERROR("munmap");
+		sock_info->cmd_ring = NULL;
+	}
+}
+
 static
 int handle_message(struct sock_info *sock_info,
 		int sock, struct ustcomm_ust_msg *lum)
@@ -1083,6 +1481,8 @@ int handle_message(struct sock_info *sock_info,
 	char ctxstr[LTTNG_UST_ABI_SYM_NAME_LEN];	/* App context string. */
 	ssize_t len;
 	void *var_len_cmd_data = NULL;
+	void *list_batch_entries = NULL;
+	size_t list_batch_len = 0;
 
 	if (ust_lock()) {
 		ret = -LTTNG_UST_ERR_EXITING;
@@ -1123,6 +1523,7 @@ int handle_message(struct sock_info *sock_info,
 #endif	/* CONFIG_LTTNG_UST_EXPERIMENTAL_COUNTER */
 	case LTTNG_UST_ABI_EVENT_NOTIFIER_CREATE:
 	case LTTNG_UST_ABI_EVENT_NOTIFIER_GROUP_CREATE:
+	case LTTNG_UST_ABI_CMD_RING:
 		/*
 		 * Those commands expect a reply to the struct ustcomm_ust_msg
 		 * before sending additional payload.
@@ -1457,6 +1858,30 @@ int handle_message(struct sock_info *sock_info,
 		break;
 	}
 #endif	/* CONFIG_LTTNG_UST_EXPERIMENTAL_COUNTER */
+	case LTTNG_UST_ABI_CMD_RING:
+	{
+		int shm_fd;
+
+		/* The ring is mapped right away: don't track its fd. */
+		lttng_ust_lock_fd_tracker();
+		len = ustcomm_recv_fds_unix_sock(sock, &shm_fd, 1);
+		switch (handle_error(sock_info, len, 1, "command ring", &ret)) {
+		case MSG_OK:
+			break;
+		case MSG_ERROR:		/* Fallthrough */
+		case MSG_SHUTDOWN:
+			lttng_ust_unlock_fd_tracker();
+			goto error;
+		}
+		if (lum->handle == LTTNG_UST_ABI_ROOT_HANDLE)
+			ret = cmd_ring_setup(sock_info, shm_fd, &lum->u.cmd_ring);
+		else
+			ret = -EINVAL;
+		if (close(shm_fd))
+			PERROR("close on command ring fd");
+		lttng_ust_unlock_fd_tracker();
+		break;
+	}
 	case LTTNG_UST_ABI_EVENT_NOTIFIER_CREATE:
 	{
 		len = ustcomm_recv_var_len_cmd_from_sessiond(sock,
@@ -1477,6 +1902,19 @@ int handle_message(struct sock_info *sock_info,
 			ret = -ENOSYS;
 		break;
 	}
+	case LTTNG_UST_ABI_TRACEPOINT_LIST_GET_BATCH:
+	case LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET_BATCH:
+		args.list_batch.entries = NULL;
+		args.list_batch.len = 0;
+		if (ops->cmd)
+			ret = ops->cmd(lum->handle, lum->cmd,
+					(unsigned long) &lum->u,
+					&args, sock_info);
+		else
+			ret = -ENOSYS;
+		list_batch_entries = args.list_batch.entries;
+		list_batch_len = args.list_batch.len;
+		break;
 
 	default:
 		if (ops->cmd)
@@ -1498,6 +1936,9 @@ int handle_message(struct sock_info *sock_info,
 		case LTTNG_UST_ABI_TRACEPOINT_LIST_GET:
 			memcpy(&lur.u.tracepoint, &lum->u.tracepoint, sizeof(lur.u.tracepoint));
 			break;
+		case LTTNG_UST_ABI_NOTIFY_FEATURES:
+			lur.u.notify_features.features = lttng_get_notify_features(sock_info);
+			break;
 		}
 	}
 	DBG("Return value: %d", lur.ret_val);
@@ -1523,8 +1964,8 @@ int handle_message(struct sock_info *sock_info,
 	}
 
 	/*
-	 * LTTNG_UST_TRACEPOINT_FIELD_LIST_GET needs to send the field
-	 * after the reply.
+	 * LTTNG_UST_TRACEPOINT_FIELD_LIST_GET and the batched list gets
+	 * need to send the entries after the reply.
 	 */
 	if (lur.ret_code == LTTNG_UST_OK) {
 		switch (lum->cmd) {
@@ -1540,6 +1981,23 @@ int handle_message(struct sock_info *sock_info,
 				ret = -EINVAL;
 				goto error;
 			}
+			break;
+		case LTTNG_UST_ABI_TRACEPOINT_LIST_GET_BATCH:
+		case LTTNG_UST_ABI_TRACEPOINT_FIELD_LIST_GET_BATCH:
+			/* All the entries of the batch in a single message. */
+			if (!list_batch_len)
+				break;
+			len = ustcomm_send_unix_sock(sock, list_batch_entries,
+				list_batch_len);
+			if (len < 0) {
+				ret = len;
+				goto error;
+			}
+			if (len != list_batch_len) {
+				ret = -EINVAL;
+				goto error;
+			}
+			break;
 		}
 	}
 
@@ -1547,6 +2005,7 @@ error:
 	ust_unlock();
 
 	free(var_len_cmd_data);
+	free(list_batch_entries);
 	return ret;
 }
 
@@ -1576,6 +2035,17 @@ void cleanup_sock_info(struct sock_info *sock_info, int exiting)
 
 	sock_info->registration_done = 0;
 	sock_info->initial_statedump_done = 0;
+	reset_notify_features(sock_info);
+
+	/* The command ring thread does not exist in the child after fork. */
+	sock_info->cmd_ring_thread_active = 0;
+	if (sock_info->cmd_ring) {
+		ret = munmap(sock_info->cmd_ring, sock_info->cmd_ring_len);
+		if (ret) {
+			ERR("Error unmapping command ring");
+		}
+		sock_info->cmd_ring = NULL;
+	}
 
 	if (sock_info->socket != -1) {
 		ret = ustcomm_close_unix_sock(sock_info->socket);
@@ -1967,6 +2437,7 @@ restart:
 		}
 		sock_info->notify_socket = -1;
 	}
+	reset_notify_features(sock_info);
 
 
 	/*
@@ -2199,6 +2670,8 @@ restart:
 
 	}
 end:
+	/* The command ring lives as long as the command socket. */
+	cmd_ring_teardown(sock_info);
 	if (ust_lock()) {
 		goto quit;
 	}
@@ -2352,6 +2825,12 @@ void lttng_ust_ctor(void)
 
 	get_allow_blocking();
 
+	get_read_timer_bounds();
+
+	timeout_mode = get_register_async(timeout_mode);
+
+	get_blob_arena();
+
 	ret = sem_init(&constructor_wait, 0, 0);
 	if (ret) {
 		PERROR("sem_init");
@@ -2577,6 +3056,7 @@ void lttng_ust_exit(void)
 	 * cleanup the threads if there are stalled in a syscall.
 	 */
 	lttng_ust_cleanup(1);
+	lttng_ust_blob_arena_exit();
 }
 
 static
@@ -2641,6 +3121,7 @@ void lttng_ust_before_fork(sigset_t *save_sigset)
 	pthread_mutex_lock(&ust_fork_mutex);
 
 	ust_lock_nocheck();
+	lttng_ust_early_buffer_before_fork();
 	lttng_ust_urcu_before_fork();
 	lttng_ust_lock_fd_tracker();
 	lttng_perf_lock();
@@ -2670,6 +3151,7 @@ void lttng_ust_after_fork_parent(sigset_t *restore_sigset)
 		return;
 	DBG("process %d", getpid());
 	lttng_ust_urcu_after_fork_parent();
+	lttng_ust_early_buffer_after_fork_parent();
 	/* Release mutexes and re-enable signals */
 	ust_after_fork_common(restore_sigset);
 }
@@ -2696,6 +3178,10 @@ void lttng_ust_after_fork_child(sigset_t *restore_sigset)
 	DBG("process %d", getpid());
 	/* Release urcu mutexes */
 	lttng_ust_urcu_after_fork_child();
+	/* Events of the parent are not replayed in the child. */
+	lttng_ust_early_buffer_after_fork_child();
+	/* The blob arena of the parent is not written by the child. */
+	lttng_ust_blob_arena_release();
 	lttng_ust_cleanup(0);
 	/* Release mutexes and re-enable signals */
 	ust_after_fork_common(restore_sigset);
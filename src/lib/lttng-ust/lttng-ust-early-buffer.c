@@ -0,0 +1,585 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Early-boot event buffer.
+ *
+ * When the constructor does not wait for the session daemons
+ * (LTTNG_UST_REGISTER_ASYNC), the events emitted before the sessions
+ * are enabled are recorded into a small pre-allocated buffer. Every
+ * event of every provider is connected to a placeholder channel whose
+ * operations log the writes issued by the probe, along with their
+ * alignment. When a session is enabled for the first time, the logged
+ * writes are replayed through the operations of its channels, for the
+ * events it enables, producing the same payload the probe would have
+ * written. Capture stops as soon as a session is enabled, and the
+ * buffer is released once all session daemons are done with the
+ * registration, which is when a waiting constructor would have
+ * returned.
+ */
+
+#define _LGPL_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <urcu/compiler.h>
+#include <urcu/hlist.h>
+#include <urcu/list.h>
+#include <urcu/uatomic.h>
+
+#include <lttng/tracepoint.h>
+#include <lttng/ust-events.h>
+#include <lttng/ust-ringbuffer-context.h>
+
+#include "common/align.h"
+#include "common/jhash.h"
+#include "common/logging.h"
+#include "common/macros.h"
+#include "common/tracepoint.h"
+#include "lib/lttng-ust/events.h"
+#include "lttng-tracer-core.h"
+
+#define EARLY_EVENT_HT_BITS		8
+#define EARLY_EVENT_HT_SIZE		(1U << EARLY_EVENT_HT_BITS)
+#define EARLY_BUFFER_MAX_SIZE		(16U * 1024 * 1024)
+#define EARLY_RECORD_ALIGN		8
+
+/* Placeholder event connected to a tracepoint during early boot. */
+struct early_event {
+	struct lttng_ust_event_common parent;
+	struct lttng_ust_event_recorder recorder;
+	const struct lttng_ust_event_desc *desc;	/* NULL once unregistered. */
+	bool registered;
+
+	/* Events of the session being replayed into. */
+	struct lttng_ust_event_recorder **targets;
+	size_t nr_targets, alloc_targets;
+
+	struct cds_hlist_node hlist;		/* Node in early_event_ht, by desc. */
+	struct cds_list_head node;		/* Node in early_events. */
+};
+
+/*
+ * Record of the buffer: the writes issued by one probe. Reserved with
+ * an upper bound of its size, the writes use a prefix of the record.
+ */
+struct early_record {
+	struct early_event *event;
+	uint32_t len;			/* Reserved size, including this header. */
+	uint32_t used;			/* Size of the logged writes. */
+	uint32_t data_size;		/* Payload size, from the probe. */
+	uint32_t largest_align;
+	int committed;
+	int overflow;			/* Writes did not fit: skip record. */
+	char data[];			/* struct early_write... */
+};
+
+struct early_write {
+	uint32_t len;
+	uint32_t alignment;
+	char data[];			/* Padded to EARLY_RECORD_ALIGN. */
+};
+
+static int early_capture_enabled;	/* Events are captured. */
+static bool early_retained;		/* Buffer held until released. */
+static char *early_buf;
+static size_t early_buf_size;
+static unsigned long early_buf_offset;
+static unsigned long early_lost;	/* Events not captured: buffer full. */
+
+static CDS_LIST_HEAD(early_events);
+static struct cds_hlist_head early_event_ht[EARLY_EVENT_HT_SIZE];
+
+/*
+ * Protects the early buffer state, except for the capture itself,
+ * which is lock-free. Nests inside the UST lock.
+ */
+static pthread_mutex_t early_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static
+int early_event_reserve(struct lttng_ust_ring_buffer_ctx *ctx);
+static
+void early_event_commit(struct lttng_ust_ring_buffer_ctx *ctx);
+static
+void early_event_write(struct lttng_ust_ring_buffer_ctx *ctx,
+		const void *src, size_t len, size_t alignment);
+static
+void early_event_strcpy(struct lttng_ust_ring_buffer_ctx *ctx,
+		const char *src, size_t len);
+static
+void early_event_pstrcpy_pad(struct lttng_ust_ring_buffer_ctx *ctx,
+		const char *src, size_t len);
+
+static struct lttng_ust_channel_buffer_ops early_chan_ops = {
+	.struct_size = sizeof(struct lttng_ust_channel_buffer_ops),
+	.event_reserve = early_event_reserve,
+	.event_commit = early_event_commit,
+	.event_write = early_event_write,
+	.event_strcpy = early_event_strcpy,
+	.event_pstrcpy_pad = early_event_pstrcpy_pad,
+};
+
+static struct lttng_ust_session early_session = {
+	.struct_size = sizeof(struct lttng_ust_session),
+};
+
+static struct lttng_ust_channel_buffer early_chan;
+
+static struct lttng_ust_channel_common early_chan_common = {
+	.struct_size = sizeof(struct lttng_ust_channel_common),
+	.type = LTTNG_UST_CHANNEL_TYPE_BUFFER,
+	.child = &early_chan,
+	.enabled = 1,
+	.session = &early_session,
+};
+
+static struct lttng_ust_channel_buffer early_chan = {
+	.struct_size = sizeof(struct lttng_ust_channel_buffer),
+	.parent = &early_chan_common,
+	.ops = &early_chan_ops,
+};
+
+static
+size_t early_write_size(size_t len)
+{
+	return sizeof(struct early_write) + LTTNG_UST_ALIGN(len, EARLY_RECORD_ALIGN);
+}
+
+static
+int early_event_reserve(struct lttng_ust_ring_buffer_ctx *ctx)
+{
+	struct lttng_ust_event_recorder *recorder = ctx->client_priv;
+	struct early_event *event = caa_container_of(recorder, struct early_event, recorder);
+	unsigned long offset, new_offset;
+	struct early_record *record;
+	size_t len;
+
+	if (caa_unlikely(!event->desc))
+		return -ENOENT;
+	/*
+	 * Upper bound: each field issues at most two writes (sequence
+	 * length and content), each padded.
+	 */
+	len = sizeof(struct early_record) + ctx->data_size
+		+ (2 * event->desc->tp_class->nr_fields + 1)
+			* early_write_size(EARLY_RECORD_ALIGN - 1);
+	len = LTTNG_UST_ALIGN(len, EARLY_RECORD_ALIGN);
+	do {
+		offset = uatomic_read(&early_buf_offset);
+		new_offset = offset + len;
+		if (new_offset > early_buf_size || len > UINT32_MAX) {
+			uatomic_inc(&early_lost);
+			return -ENOBUFS;
+		}
+	} while (uatomic_cmpxchg(&early_buf_offset, offset, new_offset) != offset);
+
+	record = (struct early_record *) (early_buf + offset);
+	record->event = event;
+	record->len = len;
+	record->used = 0;
+	record->data_size = ctx->data_size;
+	record->largest_align = ctx->largest_align;
+	record->overflow = 0;
+	ctx->priv = (struct lttng_ust_ring_buffer_ctx_private *) record;
+	return 0;
+}
+
+static
+void early_event_commit(struct lttng_ust_ring_buffer_ctx *ctx)
+{
+	struct early_record *record = (struct early_record *) ctx->priv;
+
+	/* Order the logged writes before the commit flag. */
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(record->committed, 1);
+}
+
+/* Append a write to the record, returning its data. */
+static
+char *early_record_append(struct lttng_ust_ring_buffer_ctx *ctx, size_t len,
+		size_t alignment)
+{
+	struct early_record *record = (struct early_record *) ctx->priv;
+	struct early_write *write;
+
+	if (caa_unlikely(record->overflow))
+		return NULL;
+	if (caa_unlikely(sizeof(*record) + record->used + early_write_size(len) > record->len)) {
+		record->overflow = 1;
+		return NULL;
+	}
+	write = (struct early_write *) (record->data + record->used);
+	write->len = len;
+	write->alignment = alignment;
+	record->used += early_write_size(len);
+	return write->data;
+}
+
+static
+void early_event_write(struct lttng_ust_ring_buffer_ctx *ctx,
+		const void *src, size_t len, size_t alignment)
+{
+	char *dst;
+
+	dst = early_record_append(ctx, len, alignment);
+	if (dst)
+		memcpy(dst, src, len);
+}
+
+/*
+ * Same result as lib_ring_buffer_strcpy() with '#' padding: the
+ * replay then writes the bytes as-is.
+ */
+static
+void early_event_strcpy(struct lttng_ust_ring_buffer_ctx *ctx,
+		const char *src, size_t len)
+{
+	size_t count;
+	char *dst;
+
+	if (caa_unlikely(!len))
+		return;
+	dst = early_record_append(ctx, len, 1);
+	if (!dst)
+		return;
+	for (count = 0; count < len - 1 && src[count] != '\0'; count++)
+		dst[count] = src[count];
+	memset(dst + count, '#', len - 1 - count);
+	dst[len - 1] = '\0';
+}
+
+/* Same result as lib_ring_buffer_pstrcpy() with '\0' padding. */
+static
+void early_event_pstrcpy_pad(struct lttng_ust_ring_buffer_ctx *ctx,
+		const char *src, size_t len)
+{
+	size_t count;
+	char *dst;
+
+	if (caa_unlikely(!len))
+		return;
+	dst = early_record_append(ctx, len, 1);
+	if (!dst)
+		return;
+	for (count = 0; count < len && src[count] != '\0'; count++)
+		dst[count] = src[count];
+	memset(dst + count, '\0', len - count);
+}
+
+static
+struct cds_hlist_head *early_event_bucket(const struct lttng_ust_event_desc *desc)
+{
+	uint32_t hash = jhash(&desc, sizeof(desc), 0);
+
+	return &early_event_ht[hash & (EARLY_EVENT_HT_SIZE - 1)];
+}
+
+static
+struct early_event *early_event_lookup(const struct lttng_ust_event_desc *desc)
+{
+	struct early_event *event;
+	struct cds_hlist_node *pos;
+
+	cds_hlist_for_each_entry(event, pos, early_event_bucket(desc), hlist) {
+		if (event->desc == desc)
+			return event;
+	}
+	return NULL;
+}
+
+/* Called with early_mutex held. */
+static
+void early_event_create(const struct lttng_ust_event_desc *desc)
+{
+	struct early_event *event;
+	int ret;
+
+	if (!lttng_ust_validate_event_name(desc) || early_event_lookup(desc))
+		return;
+	event = zmalloc(sizeof(*event));
+	if (!event)
+		return;
+	event->parent.struct_size = sizeof(struct lttng_ust_event_common);
+	event->parent.type = LTTNG_UST_EVENT_TYPE_RECORDER;
+	event->parent.child = &event->recorder;
+	event->parent.enabled = 1;
+	event->recorder.struct_size = sizeof(struct lttng_ust_event_recorder);
+	event->recorder.parent = &event->parent;
+	event->recorder.chan = &early_chan;
+	event->desc = desc;
+	cds_list_add_tail(&event->node, &early_events);
+	cds_hlist_add_head(&event->hlist, early_event_bucket(desc));
+
+	ret = lttng_ust_tp_probe_register_queue_release(desc->probe_desc->provider_name,
+			desc->event_name, desc->tp_class->probe_callback,
+			&event->parent, desc->tp_class->signature);
+	if (!ret)
+		event->registered = true;
+}
+
+/* Called with early_mutex held. */
+static
+void early_event_unregister(struct early_event *event)
+{
+	const struct lttng_ust_event_desc *desc = event->desc;
+	int ret;
+
+	if (!event->registered)
+		return;
+	ret = lttng_ust_tp_probe_unregister_queue_release(desc->probe_desc->provider_name,
+			desc->event_name, desc->tp_class->probe_callback,
+			&event->parent);
+	if (!ret)
+		event->registered = false;
+}
+
+/*
+ * Called with the UST lock held, when a probe provider is registered.
+ */
+void lttng_ust_early_buffer_probe_register(const struct lttng_ust_probe_desc *desc)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&early_mutex);
+	if (!CMM_LOAD_SHARED(early_capture_enabled))
+		goto end;
+	for (i = 0; i < desc->nr_events; i++)
+		early_event_create(desc->event_desc[i]);
+end:
+	pthread_mutex_unlock(&early_mutex);
+}
+
+/*
+ * Called with the UST lock held, when a probe provider is unregistered,
+ * before its events are. Its records are not replayed.
+ */
+void lttng_ust_early_buffer_probe_unregister(const struct lttng_ust_probe_desc *desc)
+{
+	struct early_event *event;
+	unsigned int i;
+
+	pthread_mutex_lock(&early_mutex);
+	if (!early_retained)
+		goto end;
+	for (i = 0; i < desc->nr_events; i++) {
+		event = early_event_lookup(desc->event_desc[i]);
+		if (!event)
+			continue;
+		early_event_unregister(event);
+		cds_hlist_del(&event->hlist);
+		event->desc = NULL;
+	}
+end:
+	pthread_mutex_unlock(&early_mutex);
+}
+
+/*
+ * Stop capturing. Called with early_mutex held. When this returns, no
+ * probe is writing to the early buffer anymore.
+ */
+static
+void early_capture_stop(void)
+{
+	struct early_event *event;
+
+	if (!CMM_LOAD_SHARED(early_capture_enabled))
+		return;
+	CMM_STORE_SHARED(early_capture_enabled, 0);
+	CMM_STORE_SHARED(early_session.active, 0);
+	cds_list_for_each_entry(event, &early_events, node) {
+		if (event->desc)
+			early_event_unregister(event);
+	}
+	lttng_ust_urcu_synchronize_rcu();	/* Wait for in-flight events to complete */
+	lttng_ust_tp_probe_prune_release_queue();
+	DBG("Early buffer: captured %lu bytes, lost %lu events",
+		uatomic_read(&early_buf_offset), uatomic_read(&early_lost));
+}
+
+/*
+ * Allocate the early buffer and start capturing the events of the
+ * providers registered so far, and of those registered until the
+ * buffer is released. Called from the constructor, before the listener
+ * threads are created, with the UST lock held.
+ */
+int lttng_ust_early_buffer_init(size_t size)
+{
+	if (!size)
+		return 0;
+	if (size > EARLY_BUFFER_MAX_SIZE)
+		size = EARLY_BUFFER_MAX_SIZE;
+	early_buf = zmalloc(size);
+	if (!early_buf)
+		return -ENOMEM;
+	early_buf_size = size;
+	early_retained = true;
+	early_session.active = 1;
+	CMM_STORE_SHARED(early_capture_enabled, 1);
+	lttng_probes_early_buffer_register();
+	DBG("Early buffer of %zu bytes allocated", size);
+	return 0;
+}
+
+static
+int early_event_add_target(struct early_event *event,
+		struct lttng_ust_event_recorder *target)
+{
+	if (event->nr_targets == event->alloc_targets) {
+		size_t new_alloc = event->alloc_targets ? 2 * event->alloc_targets : 1;
+		struct lttng_ust_event_recorder **new_targets;
+
+		new_targets = realloc(event->targets, new_alloc * sizeof(*new_targets));
+		if (!new_targets)
+			return -ENOMEM;
+		event->targets = new_targets;
+		event->alloc_targets = new_alloc;
+	}
+	event->targets[event->nr_targets++] = target;
+	return 0;
+}
+
+static
+void early_record_replay(struct early_record *record,
+		struct lttng_ust_event_recorder *target)
+{
+	struct lttng_ust_channel_buffer *chan = target->chan;
+	struct lttng_ust_ring_buffer_ctx ctx;
+	struct lttng_ust_probe_ctx probe_ctx;
+	size_t offset = 0;
+
+	probe_ctx.struct_size = sizeof(struct lttng_ust_probe_ctx);
+	probe_ctx.ip = NULL;
+	lttng_ust_ring_buffer_ctx_init(&ctx, target, record->data_size,
+		record->largest_align, &probe_ctx);
+	if (chan->ops->event_reserve(&ctx) < 0)
+		return;
+	while (offset < record->used) {
+		struct early_write *write = (struct early_write *) (record->data + offset);
+
+		chan->ops->event_write(&ctx, write->data, write->len, write->alignment);
+		offset += early_write_size(write->len);
+	}
+	chan->ops->event_commit(&ctx);
+}
+
+/*
+ * Replay the early buffer into a session enabled for the first time.
+ * Only the enabled events of enabled channels are replayed. Events
+ * with a filter are skipped, as the arguments of the probe needed to
+ * evaluate it are not kept. Context fields and timestamps are those of
+ * the replay.
+ *
+ * Called with the UST lock held, once the session is active.
+ */
+void lttng_ust_early_buffer_replay(struct lttng_ust_session *session)
+{
+	struct lttng_ust_event_common_private *event_priv;
+	struct early_event *event;
+	unsigned long offset = 0, end, nr_replayed = 0;
+
+	pthread_mutex_lock(&early_mutex);
+	if (!early_retained)
+		goto end;
+	early_capture_stop();
+
+	cds_list_for_each_entry(event_priv, &session->priv->events_head, node) {
+		struct lttng_ust_event_common *session_event = event_priv->pub;
+		struct lttng_ust_event_recorder *recorder;
+
+		if (session_event->type != LTTNG_UST_EVENT_TYPE_RECORDER)
+			continue;
+		if (!CMM_LOAD_SHARED(session_event->enabled)
+				|| CMM_LOAD_SHARED(session_event->eval_filter))
+			continue;
+		recorder = session_event->child;
+		if (!CMM_LOAD_SHARED(recorder->chan->parent->enabled))
+			continue;
+		event = early_event_lookup(event_priv->desc);
+		if (!event)
+			continue;
+		if (early_event_add_target(event, recorder))
+			goto reset;
+	}
+
+	end = uatomic_read(&early_buf_offset);
+	while (offset < end) {
+		struct early_record *record = (struct early_record *) (early_buf + offset);
+		size_t i;
+
+		offset += record->len;
+		if (!CMM_LOAD_SHARED(record->committed) || record->overflow
+				|| !record->event->desc)
+			continue;
+		for (i = 0; i < record->event->nr_targets; i++)
+			early_record_replay(record, record->event->targets[i]);
+		if (record->event->nr_targets)
+			nr_replayed++;
+	}
+	DBG("Early buffer: replayed %lu events", nr_replayed);
+
+reset:
+	cds_list_for_each_entry(event, &early_events, node)
+		event->nr_targets = 0;
+end:
+	pthread_mutex_unlock(&early_mutex);
+}
+
+/*
+ * Discard the early buffer, once the registration to all session
+ * daemons is done. Never takes the UST lock: may be called with or
+ * without it held.
+ */
+void lttng_ust_early_buffer_release(void)
+{
+	struct early_event *event, *tmp;
+
+	pthread_mutex_lock(&early_mutex);
+	if (!early_retained)
+		goto end;
+	early_capture_stop();
+	if (uatomic_read(&early_lost))
+		DBG("Early buffer full: %lu events lost", uatomic_read(&early_lost));
+	cds_list_for_each_entry_safe(event, tmp, &early_events, node) {
+		cds_list_del(&event->node);
+		free(event->targets);
+		free(event);
+	}
+	memset(early_event_ht, 0, sizeof(early_event_ht));
+	free(early_buf);
+	early_buf = NULL;
+	early_buf_size = 0;
+	early_buf_offset = 0;
+	early_lost = 0;
+	early_retained = false;
+end:
+	pthread_mutex_unlock(&early_mutex);
+}
+
+/*
+ * Hold early_mutex across fork, so the child does not inherit it locked
+ * by a thread releasing the buffer. Called with the UST lock held.
+ */
+void lttng_ust_early_buffer_before_fork(void)
+{
+	pthread_mutex_lock(&early_mutex);
+}
+
+void lttng_ust_early_buffer_after_fork_parent(void)
+{
+	pthread_mutex_unlock(&early_mutex);
+}
+
+/*
+ * In the child, once the urcu state is reset: the events of the parent
+ * are not replayed.
+ */
+void lttng_ust_early_buffer_after_fork_child(void)
+{
+	pthread_mutex_unlock(&early_mutex);
+	lttng_ust_early_buffer_release();
+}
@@ -0,0 +1,59 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ */
+
+#undef LTTNG_UST_TRACEPOINT_PROVIDER
+#define LTTNG_UST_TRACEPOINT_PROVIDER lttng_ust_fragment
+
+#if !defined(_TRACEPOINT_LTTNG_UST_FRAGMENT_PROVIDER_H) || defined(LTTNG_UST_TRACEPOINT_HEADER_MULTI_READ)
+#define _TRACEPOINT_LTTNG_UST_FRAGMENT_PROVIDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <lttng/tracepoint.h>
+
+/*
+ * Chunk of a record too large for a sub-buffer of its channel. The
+ * chunks sharing an @id hold, at their @offset, the @total_len bytes of
+ * the payload of one event with the channel event ID @event_id, laid
+ * out from an offset aligned on the largest alignment of its fields.
+ */
+LTTNG_UST_TRACEPOINT_EVENT(lttng_ust_fragment, chunk,
+	LTTNG_UST_TP_ARGS(
+		uint64_t, id,
+		uint32_t, event_id,
+		uint32_t, index,
+		uint64_t, offset,
+		uint64_t, total_len,
+		const uint8_t *, data,
+		uint32_t, len,
+		void *, ip
+	),
+	LTTNG_UST_TP_FIELDS(
+		lttng_ust_field_integer(uint64_t, id, id)
+		lttng_ust_field_integer(uint32_t, event_id, event_id)
+		lttng_ust_field_integer(uint32_t, index, index)
+		lttng_ust_field_integer(uint64_t, offset, offset)
+		lttng_ust_field_integer(uint64_t, total_len, total_len)
+		lttng_ust_field_sequence(uint8_t, data, data, uint32_t, len)
+		lttng_ust_field_unused(ip)
+	)
+)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRACEPOINT_LTTNG_UST_FRAGMENT_PROVIDER_H */
+
+#define LTTNG_UST_TP_IP_PARAM ip	/* IP context received as parameter */
+#undef LTTNG_UST_TRACEPOINT_INCLUDE
+#define LTTNG_UST_TRACEPOINT_INCLUDE "./lttng-ust-fragment-provider.h"
+
+/* This part must be outside ifdef protection */
+#include <lttng/tracepoint-event.h>
@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Fragmentation of records too large for a sub-buffer. A channel in
+ * which the lttng_ust_fragment:chunk event is enabled writes those
+ * records as a group of chunk events instead of discarding them.
+ */
+
+#define _LGPL_SOURCE
+#include <lttng/urcu/pointer.h>
+
+#include "common/events.h"
+#include "lttng-tracer-core.h"
+
+/* The tracepoint definition is public, but the provider definition is hidden. */
+#define LTTNG_UST_TRACEPOINT_PROVIDER_HIDDEN_DEFINITION
+
+#define LTTNG_UST_TRACEPOINT_CREATE_PROBES
+#include "lttng-ust-fragment-provider.h"
+
+/* The ring buffer clients call the probe through its descriptor. */
+lttng_ust_static_assert(__builtin_types_compatible_p(lttng_ust_fragment_probe_t,
+			__typeof__(&lttng_ust__event_probe__lttng_ust_fragment___chunk)),
+		"Fragment probe type must match the chunk event arguments",
+		Fragment_probe_type_must_match_the_chunk_event_arguments);
+
+static
+struct lttng_ust_channel_buffer_private *fragment_event_chan(
+		struct lttng_ust_event_common *event)
+{
+	struct lttng_ust_event_recorder *event_recorder;
+
+	if (event->type != LTTNG_UST_EVENT_TYPE_RECORDER)
+		return NULL;
+	if (event->priv->desc != &lttng_ust__event_desc___lttng_ust_fragment_chunk)
+		return NULL;
+	event_recorder = event->child;
+	return event_recorder->chan->priv;
+}
+
+void lttng_ust_fragment_event_publish(struct lttng_ust_event_common *event)
+{
+	struct lttng_ust_channel_buffer_private *chan_priv;
+
+	chan_priv = fragment_event_chan(event);
+	if (!chan_priv)
+		return;
+	lttng_ust_rcu_assign_pointer(chan_priv->fragment_event, event);
+}
+
+/*
+ * Called before the grace period which precedes the destruction of the
+ * event.
+ */
+void lttng_ust_fragment_event_unpublish(struct lttng_ust_event_common *event)
+{
+	struct lttng_ust_channel_buffer_private *chan_priv;
+
+	chan_priv = fragment_event_chan(event);
+	if (!chan_priv || chan_priv->fragment_event != event)
+		return;
+	lttng_ust_rcu_assign_pointer(chan_priv->fragment_event, NULL);
+}
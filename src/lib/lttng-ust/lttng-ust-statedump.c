@@ -9,15 +9,22 @@
 #define _LGPL_SOURCE
 #include <link.h>
 #include <limits.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <urcu/uatomic.h>
+
 #include "common/elf.h"
+#include "common/logging.h"
 #include "common/macros.h"
+#include "common/smp.h"
 #include "lttng-tracer-core.h"
 #include "lttng-ust-statedump.h"
 #include "common/jhash.h"
@@ -34,10 +41,46 @@
 #define LTTNG_UST_TP_SESSION_CHECK
 #include "lttng-ust-statedump-provider.h"	/* Define and create probes. */
 
+/*
+ * ELF information extracted from an object file, cached by (device,
+ * inode, modification time) so that repeated library listings do not
+ * re-parse files which are already known.
+ */
+struct elf_cache_entry {
+	struct cds_hlist_node node;
+	dev_t dev;
+	ino_t ino;
+	int64_t mtime_sec;
+	long mtime_nsec;
+	const char *parse_path;	/* Only valid while parsing. */
+	int ret;		/* Result of get_elf_info(). */
+	bool used;
+	char *dbg_file;
+	uint8_t *build_id;
+	uint64_t memsz;
+	size_t build_id_len;
+	uint32_t crc;
+	uint8_t is_pic;
+	uint8_t has_build_id;
+	uint8_t has_debug_link;
+};
+
+/* Loadable object listed by dl_iterate_phdr(). */
+struct dl_object {
+	void *base_addr_ptr;
+	char *resolved_path;
+	int vdso;
+	struct elf_cache_entry *elf;
+};
+
 struct dl_iterate_data {
 	int exec_found;
 	bool first;
 	bool cancel;
+	struct elf_parse_pool *pool;	/* Helper threads, or NULL. */
+	struct dl_object *objects;
+	size_t nr_objects;
+	size_t alloc_objects;
 };
 
 struct bin_info_data {
@@ -65,6 +108,14 @@ struct lttng_ust_dl_node {
 #define UST_DL_STATE_TABLE_SIZE	(1 << UST_DL_STATE_HASH_BITS)
 static struct cds_hlist_head dl_state_table[UST_DL_STATE_TABLE_SIZE];
 
+/* Protected by the ust lock. */
+#define UST_ELF_CACHE_HASH_BITS		8
+#define UST_ELF_CACHE_TABLE_SIZE	(1 << UST_ELF_CACHE_HASH_BITS)
+static struct cds_hlist_head elf_cache_table[UST_ELF_CACHE_TABLE_SIZE];
+
+/* Upper bound on the number of threads parsing ELF files. */
+#define UST_ELF_PARSE_MAX_THREADS	8
+
 typedef void (*tracepoint_cb)(struct lttng_ust_session *session, void *priv);
 
 static
@@ -257,46 +308,319 @@ void trace_end_cb(struct lttng_ust_session *session, void *priv __attribute__((u
 }
 
 static
-int get_elf_info(struct bin_info_data *bin_data)
+int get_elf_info(const char *path, struct elf_cache_entry *info)
 {
 	struct lttng_ust_elf *elf;
 	int ret = 0, found;
 
-	elf = lttng_ust_elf_create(bin_data->resolved_path);
+	elf = lttng_ust_elf_create(path);
 	if (!elf) {
 		ret = -1;
 		goto end;
 	}
 
-	ret = lttng_ust_elf_get_memsz(elf, &bin_data->memsz);
+	ret = lttng_ust_elf_get_memsz(elf, &info->memsz);
 	if (ret) {
 		goto end;
 	}
 
 	found = 0;
-	ret = lttng_ust_elf_get_build_id(elf, &bin_data->build_id,
-					&bin_data->build_id_len,
+	ret = lttng_ust_elf_get_build_id(elf, &info->build_id,
+					&info->build_id_len,
 					&found);
 	if (ret) {
 		goto end;
 	}
-	bin_data->has_build_id = !!found;
+	info->has_build_id = !!found;
 	found = 0;
-	ret = lttng_ust_elf_get_debug_link(elf, &bin_data->dbg_file,
-					&bin_data->crc,
+	ret = lttng_ust_elf_get_debug_link(elf, &info->dbg_file,
+					&info->crc,
 					&found);
 	if (ret) {
 		goto end;
 	}
-	bin_data->has_debug_link = !!found;
+	info->has_debug_link = !!found;
 
-	bin_data->is_pic = lttng_ust_elf_is_pic(elf);
+	info->is_pic = lttng_ust_elf_is_pic(elf);
 
 end:
 	lttng_ust_elf_destroy(elf);
 	return ret;
 }
 
+static
+void free_elf_cache_entry(struct elf_cache_entry *entry)
+{
+	free(entry->build_id);
+	free(entry->dbg_file);
+	free(entry);
+}
+
+/*
+ * Find the cache entry matching the file at path, or create an empty
+ * one which must be filled by parse_elf_cache_entries(). Returns NULL
+ * if the file cannot be stat'd or on allocation failure, in which case
+ * the caller parses the file without caching.
+ */
+static
+struct elf_cache_entry *elf_cache_lookup(const char *path, bool *created)
+{
+	struct cds_hlist_head *head;
+	struct elf_cache_entry *e;
+	struct stat sb;
+	uint64_t key[2];
+
+	*created = false;
+	if (stat(path, &sb))
+		return NULL;
+	key[0] = (uint64_t) sb.st_dev;
+	key[1] = (uint64_t) sb.st_ino;
+	head = &elf_cache_table[jhash(key, sizeof(key), 0)
+			& (UST_ELF_CACHE_TABLE_SIZE - 1)];
+	cds_hlist_for_each_entry_2(e, head, node) {
+		if (e->dev != sb.st_dev || e->ino != sb.st_ino)
+			continue;
+		/*
+		 * An entry already used by the current listing is kept
+		 * even if the file changed meanwhile.
+		 */
+		if (e->used || (e->mtime_sec == (int64_t) sb.st_mtim.tv_sec
+				&& e->mtime_nsec == sb.st_mtim.tv_nsec))
+			return e;
+		/* The file was modified: drop the stale entry. */
+		cds_hlist_del(&e->node);
+		free_elf_cache_entry(e);
+		break;
+	}
+	e = zmalloc(sizeof(*e));
+	if (!e)
+		return NULL;
+	e->dev = sb.st_dev;
+	e->ino = sb.st_ino;
+	e->mtime_sec = (int64_t) sb.st_mtim.tv_sec;
+	e->mtime_nsec = sb.st_mtim.tv_nsec;
+	e->ret = -1;
+	cds_hlist_add_head(&e->node, head);
+	*created = true;
+	return e;
+}
+
+struct elf_parse_work {
+	struct elf_cache_entry **entries;
+	unsigned long nr_entries;
+	unsigned long next;
+};
+
+static
+void parse_elf_work(struct elf_parse_work *work)
+{
+	for (;;) {
+		struct elf_cache_entry *e;
+		unsigned long i;
+
+		i = uatomic_add_return(&work->next, 1) - 1;
+		if (i >= work->nr_entries)
+			break;
+		e = work->entries[i];
+		e->ret = get_elf_info(e->parse_path, e);
+	}
+}
+
+/*
+ * Helper threads parsing ELF files, started before the ust lock is taken
+ * and the shared objects are listed. The ust lock nests within the loader
+ * lock, and the first TLS access of a thread can need the loader lock:
+ * each helper allocates its TLS before the pool is ready, so that it
+ * never needs the loader lock while the calling thread holds the ust
+ * lock waiting for it in pthread_join().
+ */
+struct elf_parse_pool {
+	pthread_t threads[UST_ELF_PARSE_MAX_THREADS - 1];
+	unsigned int nr_threads;
+	unsigned int nr_ready;
+	struct elf_parse_work *work;	/* Posted by the calling thread. */
+	bool stop;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+
+static
+void *parse_elf_thread(void *arg)
+{
+	struct elf_parse_pool *pool = (struct elf_parse_pool *) arg;
+	struct elf_parse_work *work;
+
+	lttng_ust_common_init_thread(0);
+
+	pthread_mutex_lock(&pool->lock);
+	pool->nr_ready++;
+	pthread_cond_broadcast(&pool->cond);
+	while (!pool->work && !pool->stop)
+		pthread_cond_wait(&pool->cond, &pool->lock);
+	work = pool->work;
+	pthread_mutex_unlock(&pool->lock);
+
+	if (work)
+		parse_elf_work(work);
+	return NULL;
+}
+
+/*
+ * Start up to one helper thread per possible CPU, not counting the
+ * calling thread, and wait until their TLS is allocated. Must be called
+ * without the ust lock held. The pool may end up with no thread.
+ */
+static
+void elf_parse_pool_start(struct elf_parse_pool *pool)
+{
+	sigset_t sig_all_blocked, orig_mask;
+	unsigned int max_threads, i;
+	int ret, nr_cpus;
+
+	nr_cpus = get_possible_cpus_array_len();
+	max_threads = nr_cpus > 0 ? (unsigned int) nr_cpus : 1;
+	if (max_threads > UST_ELF_PARSE_MAX_THREADS)
+		max_threads = UST_ELF_PARSE_MAX_THREADS;
+	if (max_threads <= 1)
+		return;
+
+	/* Helper threads must not receive signals. */
+	sigfillset(&sig_all_blocked);
+	ret = pthread_sigmask(SIG_SETMASK, &sig_all_blocked, &orig_mask);
+	if (ret) {
+		ERR("pthread_sigmask: %s", strerror(ret));
+	}
+	for (i = 0; i < max_threads - 1; i++) {
+		ret = pthread_create(&pool->threads[i], NULL,
+				parse_elf_thread, pool);
+		if (ret) {
+			DBG("pthread_create: %s", strerror(ret));
+			break;
+		}
+		pool->nr_threads++;
+	}
+	ret = pthread_sigmask(SIG_SETMASK, &orig_mask, NULL);
+	if (ret) {
+		ERR("pthread_sigmask: %s", strerror(ret));
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	while (pool->nr_ready < pool->nr_threads)
+		pthread_cond_wait(&pool->cond, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/* Let the helper threads finish their work, and join them. */
+static
+void elf_parse_pool_stop(struct elf_parse_pool *pool)
+{
+	unsigned int i;
+	int ret;
+
+	if (!pool->nr_threads)
+		return;
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+	for (i = 0; i < pool->nr_threads; i++) {
+		ret = pthread_join(pool->threads[i], NULL);
+		if (ret) {
+			ERR("pthread_join: %s", strerror(ret));
+		}
+	}
+	pool->nr_threads = 0;
+}
+
+/*
+ * Parse newly created cache entries, spreading the work over the helper
+ * threads of @pool, if any. The calling thread takes part in the work,
+ * and is used alone without helper threads.
+ */
+static
+void parse_elf_cache_entries(struct elf_cache_entry **entries,
+		unsigned long nr_entries, struct elf_parse_pool *pool)
+{
+	struct elf_parse_work work = {
+		.entries = entries,
+		.nr_entries = nr_entries,
+		.next = 0,
+	};
+
+	if (pool && pool->nr_threads && nr_entries > 1) {
+		pthread_mutex_lock(&pool->lock);
+		pool->work = &work;
+		pthread_cond_broadcast(&pool->cond);
+		pthread_mutex_unlock(&pool->lock);
+	}
+	parse_elf_work(&work);
+	/* The helper threads are done with @work once joined. */
+	if (pool)
+		elf_parse_pool_stop(pool);
+}
+
+/*
+ * Associate each listed object with its cache entry, parsing the files
+ * which are not cached yet.
+ */
+static
+void fill_elf_cache(struct dl_iterate_data *data)
+{
+	struct elf_cache_entry **new_entries;
+	unsigned long nr_new = 0;
+	size_t i;
+
+	new_entries = zmalloc(data->nr_objects * sizeof(*new_entries));
+	if (!new_entries)
+		return;
+	for (i = 0; i < data->nr_objects; i++) {
+		struct dl_object *obj = &data->objects[i];
+		struct elf_cache_entry *e;
+		bool created;
+
+		if (obj->vdso)
+			continue;
+		e = elf_cache_lookup(obj->resolved_path, &created);
+		if (!e)
+			continue;
+		if (created) {
+			e->parse_path = obj->resolved_path;
+			new_entries[nr_new++] = e;
+		}
+		e->used = true;
+		obj->elf = e;
+	}
+	if (nr_new)
+		parse_elf_cache_entries(new_entries, nr_new, data->pool);
+	for (i = 0; i < nr_new; i++)
+		new_entries[i]->parse_path = NULL;
+	free(new_entries);
+}
+
+/*
+ * Remove the entries of files which are not mapped anymore.
+ */
+static
+void sweep_elf_cache(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < UST_ELF_CACHE_TABLE_SIZE; i++) {
+		struct cds_hlist_head *head;
+		struct elf_cache_entry *e, *tmp;
+
+		head = &elf_cache_table[i];
+		cds_hlist_for_each_entry_safe_2(e, tmp, head, node) {
+			if (e->used) {
+				e->used = false;
+				continue;
+			}
+			cds_hlist_del(&e->node);
+			free_elf_cache_entry(e);
+		}
+	}
+}
+
 static
 void trace_baddr(struct bin_info_data *bin_data, void *owner)
 {
@@ -310,16 +634,35 @@ void trace_baddr(struct bin_info_data *bin_data, void *owner)
 }
 
 static
-int extract_baddr(struct bin_info_data *bin_data)
+int extract_baddr(struct bin_info_data *bin_data,
+		const struct elf_cache_entry *cached)
 {
+	struct elf_cache_entry uncached = { 0 };
+	const struct elf_cache_entry *info;
 	int ret = 0;
 	struct lttng_ust_dl_node *e;
 
 	if (!bin_data->vdso) {
-		ret = get_elf_info(bin_data);
+		if (cached) {
+			info = cached;
+		} else {
+			uncached.ret = get_elf_info(bin_data->resolved_path,
+					&uncached);
+			info = &uncached;
+		}
+		ret = info->ret;
 		if (ret) {
 			goto end;
 		}
+		/* Copied by alloc_dl_node(). */
+		bin_data->memsz = info->memsz;
+		bin_data->build_id = info->build_id;
+		bin_data->build_id_len = info->build_id_len;
+		bin_data->has_build_id = info->has_build_id;
+		bin_data->dbg_file = info->dbg_file;
+		bin_data->crc = info->crc;
+		bin_data->has_debug_link = info->has_debug_link;
+		bin_data->is_pic = info->is_pic;
 	} else {
 		bin_data->memsz = 0;
 		bin_data->has_build_id = 0;
@@ -333,9 +676,9 @@ int extract_baddr(struct bin_info_data *bin_data)
 	}
 	e->marked = true;
 end:
-	free(bin_data->build_id);
+	free(uncached.build_id);
+	free(uncached.dbg_file);
 	bin_data->build_id = NULL;
-	free(bin_data->dbg_file);
 	bin_data->dbg_file = NULL;
 	return ret;
 }
@@ -445,6 +788,38 @@ end:
 	ust_unlock();
 }
 
+static
+int add_dl_object(struct dl_iterate_data *data,
+		const struct bin_info_data *bin_data)
+{
+	struct dl_object *obj;
+
+	if (data->nr_objects == data->alloc_objects) {
+		size_t new_alloc = data->alloc_objects ? 2 * data->alloc_objects : 64;
+		struct dl_object *new_objects;
+
+		new_objects = realloc(data->objects,
+				new_alloc * sizeof(*new_objects));
+		if (!new_objects)
+			return -1;
+		data->objects = new_objects;
+		data->alloc_objects = new_alloc;
+	}
+	obj = &data->objects[data->nr_objects];
+	obj->resolved_path = strdup(bin_data->resolved_path);
+	if (!obj->resolved_path)
+		return -1;
+	obj->base_addr_ptr = bin_data->base_addr_ptr;
+	obj->vdso = bin_data->vdso;
+	obj->elf = NULL;
+	data->nr_objects++;
+	return 0;
+}
+
+/*
+ * List the loadable objects. Their ELF information is extracted once
+ * the iteration is over, so that files can be parsed in parallel.
+ */
 static
 int extract_bin_info_events(struct dl_phdr_info *info, size_t size __attribute__((unused)), void *_data)
 {
@@ -515,13 +890,52 @@ int extract_bin_info_events(struct dl_phdr_info *info, size_t size __attribute__
 			}
 		}
 
-		ret = extract_baddr(&bin_data);
+		ret = add_dl_object(data, &bin_data);
 		break;
 	}
 end:
 	return ret;
 }
 
+/*
+ * Mark the listed objects in the state table, extracting their ELF
+ * information from the cache.
+ */
+static
+void extract_dl_objects(struct dl_iterate_data *data)
+{
+	struct bin_info_data bin_data;
+	size_t i;
+
+	if (data->cancel)
+		return;
+	fill_elf_cache(data);
+	for (i = 0; i < data->nr_objects; i++) {
+		struct dl_object *obj = &data->objects[i];
+
+		memset(&bin_data, 0, sizeof(bin_data));
+		bin_data.base_addr_ptr = obj->base_addr_ptr;
+		strncpy(bin_data.resolved_path, obj->resolved_path,
+			PATH_MAX - 1);
+		bin_data.vdso = obj->vdso;
+		(void) extract_baddr(&bin_data, obj->elf);
+	}
+	sweep_elf_cache();
+}
+
+static
+void free_dl_objects(struct dl_iterate_data *data)
+{
+	size_t i;
+
+	for (i = 0; i < data->nr_objects; i++)
+		free(data->objects[i].resolved_path);
+	free(data->objects);
+	data->objects = NULL;
+	data->nr_objects = 0;
+	data->alloc_objects = 0;
+}
+
 static
 void ust_dl_table_statedump(void *owner)
 {
@@ -546,8 +960,17 @@ end:
 	ust_unlock();
 }
 
-void lttng_ust_dl_update(void *ip)
+static
+void dl_update(void *ip, bool parallel)
 {
+	struct elf_parse_pool pool = {
+		.nr_threads = 0,
+		.nr_ready = 0,
+		.work = NULL,
+		.stop = false,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.cond = PTHREAD_COND_INITIALIZER,
+	};
 	struct dl_iterate_data data;
 
 	if (lttng_ust_getenv("LTTNG_UST_WITHOUT_BADDR_STATEDUMP"))
@@ -559,21 +982,38 @@ void lttng_ust_dl_update(void *ip)
 	 */
 	lttng_ust_common_init_thread(0);
 
-	data.exec_found = 0;
+	memset(&data, 0, sizeof(data));
 	data.first = true;
-	data.cancel = false;
+	if (parallel) {
+		elf_parse_pool_start(&pool);
+		data.pool = &pool;
+	}
 	/*
-	 * Iterate through the list of currently loaded shared objects and
-	 * generate tables entries for loadable segments using
-	 * extract_bin_info_events.
+	 * Iterate through the list of currently loaded shared objects
+	 * using extract_bin_info_events, and generate tables entries for
+	 * their loadable segments with extract_dl_objects. ELF files are
+	 * only parsed when they are not in the cache.
 	 * Removed libraries are detected by mark-and-sweep: marking is
-	 * done in the iteration over libraries, and sweeping is
-	 * performed by iter_end().
+	 * done by extract_dl_objects(), and sweeping is performed by
+	 * iter_end().
 	 */
 	dl_iterate_phdr(extract_bin_info_events, &data);
 	if (data.first)
 		iter_begin(&data);
+	extract_dl_objects(&data);
 	iter_end(&data, ip);
+	free_dl_objects(&data);
+	elf_parse_pool_stop(&pool);
+}
+
+/*
+ * Called from the constructor and the dlopen/dlclose instrumentation,
+ * possibly with the loader lock held: no helper thread could allocate
+ * its TLS, so ELF files are parsed serially.
+ */
+void lttng_ust_dl_update(void *ip)
+{
+	dl_update(ip, false);
 }
 
 /*
@@ -586,7 +1026,8 @@ int do_baddr_statedump(void *owner)
 {
 	if (lttng_ust_getenv("LTTNG_UST_WITHOUT_BADDR_STATEDUMP"))
 		return 0;
-	lttng_ust_dl_update(LTTNG_UST_CALLER_IP());
+	/* From the listener thread, outside of the loader lock. */
+	dl_update(LTTNG_UST_CALLER_IP(), true);
 	ust_dl_table_statedump(owner);
 	return 0;
 }
@@ -651,6 +1092,15 @@ void ust_dl_state_destroy(void)
 			free_dl_node(e);
 		CDS_INIT_HLIST_HEAD(head);
 	}
+	for (i = 0; i < UST_ELF_CACHE_TABLE_SIZE; i++) {
+		struct cds_hlist_head *head;
+		struct elf_cache_entry *e, *tmp;
+
+		head = &elf_cache_table[i];
+		cds_hlist_for_each_entry_safe_2(e, tmp, head, node)
+			free_elf_cache_entry(e);
+		CDS_INIT_HLIST_HEAD(head);
+	}
 }
 
 void lttng_ust_statedump_destroy(void)
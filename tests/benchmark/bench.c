@@ -10,9 +10,12 @@
 #include <stdio.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sched.h>
 #include <time.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <urcu/compiler.h>
 
 #ifdef TRACING
@@ -28,28 +31,158 @@
 
 static int verbose_mode;
 
+/*
+ * Latency histogram of the cycles spent in each event, with 16 linear
+ * buckets per power of two: values below 16 each have their bucket,
+ * larger values are rounded down to 1/16th of their power of two.
+ */
+#define LATENCY_SUB_BUCKETS_ORDER	4
+#define LATENCY_SUB_BUCKETS		(1U << LATENCY_SUB_BUCKETS_ORDER)
+#define LATENCY_NR_BUCKETS		((64 - LATENCY_SUB_BUCKETS_ORDER + 1) * LATENCY_SUB_BUCKETS)
+
 struct thread_counter {
 	unsigned long long nr_loops;
+	uint64_t *latency;		/* LATENCY_NR_BUCKETS buckets */
+	uint64_t latency_max;
+};
+
+enum event_type {
+	EVENT_INT,
+	EVENT_STRING,
+	EVENT_SEQUENCE,
 };
 
 static int nr_threads;
 static unsigned long duration;
+static int nr_fields = 1;
+static enum event_type event_type = EVENT_INT;
+static size_t payload_len = 16;
+static int latency_mode;
+static int json_mode;
+static const char *scenario = "default";
+
+static char *payload_str;
+static uint32_t *payload_seq;
 
 static volatile int test_go, test_stop;
 
+/*
+ * Cycle counter read around each event. Falls back to CLOCK_MONOTONIC
+ * nanoseconds on architectures without a cycle counter readable from
+ * user space.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+static inline
+uint64_t read_cycles(void)
+{
+	__builtin_ia32_lfence();
+	return __builtin_ia32_rdtsc();
+}
+#elif defined(__aarch64__)
+static inline
+uint64_t read_cycles(void)
+{
+	uint64_t v;
+
+	__asm__ __volatile__ ("isb; mrs %0, cntvct_el0" : "=r" (v) :: "memory");
+	return v;
+}
+#else
+static inline
+uint64_t read_cycles(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
 static
-void do_stuff(void)
+uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static
+unsigned int latency_bucket(uint64_t v)
+{
+	unsigned int order;
+
+	if (v < LATENCY_SUB_BUCKETS)
+		return v;
+	order = 63 - __builtin_clzll(v);
+	return (order - LATENCY_SUB_BUCKETS_ORDER + 1) * LATENCY_SUB_BUCKETS +
+		((v >> (order - LATENCY_SUB_BUCKETS_ORDER)) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+/* Largest value counted in bucket @b. */
+static
+uint64_t latency_bucket_max(unsigned int b)
+{
+	unsigned int order, sub;
+
+	if (b < LATENCY_SUB_BUCKETS)
+		return b;
+	order = b / LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS_ORDER - 1;
+	sub = b % LATENCY_SUB_BUCKETS;
+	return (((uint64_t) (LATENCY_SUB_BUCKETS + sub + 1)) <<
+			(order - LATENCY_SUB_BUCKETS_ORDER)) - 1;
+}
+
+static
+void trace_event(void)
 {
-	int i;
 #ifdef TRACING
 	int v = 50;
+
+	switch (event_type) {
+	case EVENT_STRING:
+		lttng_ust_tracepoint(ust_tests_benchmark, tpbench_string, v,
+			payload_str);
+		return;
+	case EVENT_SEQUENCE:
+		lttng_ust_tracepoint(ust_tests_benchmark, tpbench_sequence, v,
+			payload_seq, payload_len);
+		return;
+	case EVENT_INT:
+		break;
+	}
+	switch (nr_fields) {
+	case 4:
+		lttng_ust_tracepoint(ust_tests_benchmark, tpbench4, v);
+		break;
+	case 16:
+		lttng_ust_tracepoint(ust_tests_benchmark, tpbench16, v);
+		break;
+	default:
+		lttng_ust_tracepoint(ust_tests_benchmark, tpbench, v);
+		break;
+	}
 #endif
+}
+
+static
+void do_stuff(struct thread_counter *thread_counter)
+{
+	uint64_t start, delta;
+	int i;
 
 	for (i = 0; i < 100; i++)
 		cmm_barrier();
-#ifdef TRACING
-	lttng_ust_tracepoint(ust_tests_benchmark, tpbench, v);
-#endif
+	if (!latency_mode) {
+		trace_event();
+		return;
+	}
+	start = read_cycles();
+	trace_event();
+	delta = read_cycles() - start;
+	if (delta > thread_counter->latency_max)
+		thread_counter->latency_max = delta;
+	thread_counter->latency[latency_bucket(delta)]++;
 }
 
 
@@ -63,7 +196,7 @@ void *function(void *arg __attribute__((unused)))
 		cmm_barrier();
 
 	for (;;) {
-		do_stuff();
+		do_stuff(thread_counter);
 		nr_loops++;
 		if (test_stop)
 			break;
@@ -72,19 +205,107 @@ void *function(void *arg __attribute__((unused)))
 	return NULL;
 }
 
+static const char *event_type_name[] = {
+	[EVENT_INT] = "int",
+	[EVENT_STRING] = "string",
+	[EVENT_SEQUENCE] = "sequence",
+};
+
+static const struct {
+	const char *name;
+	double fraction;
+} percentiles[] = {
+	{ "p50", 0.5 },
+	{ "p99", 0.99 },
+	{ "p99.9", 0.999 },
+};
+
+#define NR_PERCENTILES	(sizeof(percentiles) / sizeof(percentiles[0]))
+
+/*
+ * Print the latency percentiles of the merged histogram of all the
+ * threads, in cycles of the counter and converted to nanoseconds with
+ * @cycles_per_ns. A percentile is reported as the upper bound of its
+ * bucket.
+ */
+static
+void print_latency(struct thread_counter *thread_counter,
+		unsigned long long total_loops, double cycles_per_ns)
+{
+	uint64_t hist[LATENCY_NR_BUCKETS] = { 0 };
+	uint64_t value[NR_PERCENTILES];
+	uint64_t total = 0, max = 0, sum;
+	unsigned int i, p, b;
+
+	for (i = 0; i < (unsigned int) nr_threads; i++) {
+		for (b = 0; b < LATENCY_NR_BUCKETS; b++)
+			hist[b] += thread_counter[i].latency[b];
+		if (thread_counter[i].latency_max > max)
+			max = thread_counter[i].latency_max;
+	}
+	for (b = 0; b < LATENCY_NR_BUCKETS; b++)
+		total += hist[b];
+	if (!total)
+		return;
+	for (p = 0; p < NR_PERCENTILES; p++) {
+		uint64_t target = (uint64_t) (percentiles[p].fraction * total);
+
+		sum = 0;
+		for (b = 0; b < LATENCY_NR_BUCKETS; b++) {
+			sum += hist[b];
+			if (sum > target)
+				break;
+		}
+		value[p] = latency_bucket_max(b);
+		if (value[p] > max)
+			value[p] = max;
+	}
+
+	if (json_mode) {
+		printf("{\"scenario\": \"%s\", \"event\": \"%s\", \"fields\": %d, "
+			"\"threads\": %d, \"duration_s\": %lu, \"loops\": %llu, "
+			"\"cycles_per_ns\": %.3f",
+			scenario, event_type_name[event_type], nr_fields,
+			nr_threads, duration, total_loops, cycles_per_ns);
+		for (p = 0; p < NR_PERCENTILES; p++)
+			printf(", \"%s_cycles\": %" PRIu64, percentiles[p].name,
+				value[p]);
+		printf(", \"max_cycles\": %" PRIu64, max);
+		for (p = 0; p < NR_PERCENTILES; p++)
+			printf(", \"%s_ns\": %.0f", percentiles[p].name,
+				value[p] / cycles_per_ns);
+		printf(", \"max_ns\": %.0f}\n", max / cycles_per_ns);
+		return;
+	}
+	for (p = 0; p < NR_PERCENTILES; p++)
+		printf("Latency %s: %" PRIu64 " cycles (%.0f ns)\n",
+			percentiles[p].name, value[p], value[p] / cycles_per_ns);
+	printf("Latency max: %" PRIu64 " cycles (%.0f ns)\n",
+		max, max / cycles_per_ns);
+}
+
 static
 void usage(char **argv) {
 	printf("Usage: %s nr_threads duration(s) <OPTIONS>\n", argv[0]);
 	printf("OPTIONS:\n");
 	printf("        [-v] (verbose output)\n");
+	printf("        [-f nr_fields] (integer fields per event: 1, 4 or 16, default 1)\n");
+	printf("        [-e int|string|sequence] (event payload, default int)\n");
+	printf("        [-s len] (string length or sequence elements, default 16)\n");
+	printf("        [-l] (report the p50, p99, p99.9 and maximum latency of each event)\n");
+	printf("        [-j] (report the latency as a JSON object, implies -l)\n");
+	printf("        [-n name] (scenario name reported with -j)\n");
 	printf("\n");
 }
 
 int main(int argc, char **argv)
 {
 	unsigned long long total_loops = 0;
+	uint64_t start_cycles, start_ns;
+	double cycles_per_ns;
 	unsigned long i_thr;
 	void *retval;
+	size_t j;
 	int i;
 
 	if (argc < 3) {
@@ -102,23 +323,101 @@ int main(int argc, char **argv)
 		case 'v':
 			verbose_mode = 1;
 			break;
+		case 'l':
+			latency_mode = 1;
+			break;
+		case 'j':
+			latency_mode = 1;
+			json_mode = 1;
+			break;
+		case 'f':
+			if (i + 1 >= argc) {
+				usage(argv);
+				exit(1);
+			}
+			nr_fields = atoi(argv[++i]);
+			if (nr_fields != 1 && nr_fields != 4 && nr_fields != 16) {
+				usage(argv);
+				exit(1);
+			}
+			break;
+		case 'e':
+			if (i + 1 >= argc) {
+				usage(argv);
+				exit(1);
+			}
+			i++;
+			if (!strcmp(argv[i], "int")) {
+				event_type = EVENT_INT;
+			} else if (!strcmp(argv[i], "string")) {
+				event_type = EVENT_STRING;
+			} else if (!strcmp(argv[i], "sequence")) {
+				event_type = EVENT_SEQUENCE;
+			} else {
+				usage(argv);
+				exit(1);
+			}
+			break;
+		case 's':
+			if (i + 1 >= argc) {
+				usage(argv);
+				exit(1);
+			}
+			payload_len = strtoul(argv[++i], NULL, 0);
+			break;
+		case 'n':
+			if (i + 1 >= argc) {
+				usage(argv);
+				exit(1);
+			}
+			scenario = argv[++i];
+			break;
 		}
 	}
 
 	printf_verbose("using %d thread(s)\n", nr_threads);
 	printf_verbose("for a duration of %lds\n", duration);
+	printf_verbose("with %s event(s)\n", event_type_name[event_type]);
+	if (event_type == EVENT_INT)
+		printf_verbose("with %d integer field(s) per event\n", nr_fields);
+	else
+		printf_verbose("with a payload of %zu element(s)\n", payload_len);
+
+	payload_str = malloc(payload_len + 1);
+	payload_seq = calloc(payload_len ? payload_len : 1, sizeof(*payload_seq));
+	if (!payload_str || !payload_seq) {
+		fprintf(stderr, "payload allocation failed\n");
+		exit(1);
+	}
+	for (j = 0; j < payload_len; j++) {
+		payload_str[j] = 'a' + j % 26;
+		payload_seq[j] = j;
+	}
+	payload_str[payload_len] = '\0';
 
 	pthread_t thread[nr_threads];
 	struct thread_counter thread_counter[nr_threads];
 
 	for (i = 0; i < nr_threads; i++) {
 		thread_counter[i].nr_loops = 0;
+		thread_counter[i].latency_max = 0;
+		thread_counter[i].latency = NULL;
+		if (latency_mode) {
+			thread_counter[i].latency = calloc(LATENCY_NR_BUCKETS,
+					sizeof(uint64_t));
+			if (!thread_counter[i].latency) {
+				fprintf(stderr, "latency histogram allocation failed\n");
+				exit(1);
+			}
+		}
 		if (pthread_create(&thread[i], NULL, function, &thread_counter[i])) {
 			fprintf(stderr, "thread create %d failed\n", i);
 			exit(1);
 		}
 	}
 
+	start_ns = now_ns();
+	start_cycles = read_cycles();
 	test_go = 1;
 
 	for (i_thr = 0; i_thr < duration; i_thr++) {
@@ -131,6 +430,10 @@ int main(int argc, char **argv)
 	printf_verbose("\n");
 
 	test_stop = 1;
+	cycles_per_ns = (double) (read_cycles() - start_cycles) /
+		(double) (now_ns() - start_ns);
+	if (cycles_per_ns <= 0)
+		cycles_per_ns = 1;
 
 	for (i = 0; i < nr_threads; i++) {
 		if (pthread_join(thread[i], &retval)) {
@@ -139,6 +442,14 @@ int main(int argc, char **argv)
 		}
 		total_loops += thread_counter[i].nr_loops;
 	}
-	printf("Number of loops: %llu\n", total_loops);
+	if (!json_mode)
+		printf("Number of loops: %llu\n", total_loops);
+	if (latency_mode) {
+		print_latency(thread_counter, total_loops, cycles_per_ns);
+		for (i = 0; i < nr_threads; i++)
+			free(thread_counter[i].latency);
+	}
+	free(payload_str);
+	free(payload_seq);
 	return 0;
 }
@@ -0,0 +1,737 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright 2026 EfficiOS, Inc.
+ *
+ * LTTng Userspace Tracer (UST) - reference consumer benchmark
+ *
+ * Self-contained consumer drain benchmark: the program plays the role of
+ * the session daemon by creating a channel and its streams in-process
+ * through liblttng-ust-ctl, feeds it from a producer thread, and drains
+ * the mmap'd sub-buffers to an output file the way a consumer daemon
+ * would. Sub-buffers ready on all streams are written out as one batch
+ * through io_uring when available, falling back to pwrite(2) otherwise.
+ * Sub-buffers can optionally be compressed before being written out.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <urcu/arch.h>
+#include <urcu/compiler.h>
+#include <urcu/system.h>
+
+#include <lttng/ust-ctl.h>
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+
+#define printf_verbose(fmt, args...)		\
+	do {					\
+		if (verbose_mode)		\
+			printf(fmt, ## args);	\
+	} while (0)
+
+#define POLL_TIMEOUT_MS		100
+
+/* Number of payload-sized windows in the producer text pool. */
+#define PAYLOAD_POOL_WINDOWS	64
+
+static int verbose_mode;
+static int force_pwrite;
+
+static unsigned long duration = 5;
+static uint64_t subbuf_size = 262144;
+static uint64_t num_subbuf = 8;
+static size_t payload_size = 4096;
+static const char *output_path = "/dev/null";
+static enum lttng_ust_ctl_compression compression = LTTNG_UST_CTL_COMPRESSION_NONE;
+static int compression_level;
+static int compress_subbuf;
+static unsigned long stats_interval;
+
+static volatile int test_go, test_stop;
+
+struct producer_stats {
+	uint64_t bytes_written;
+	uint64_t nr_rejected;
+};
+
+struct drain_stats {
+	uint64_t bytes;
+	uint64_t compressed_bytes;
+	uint64_t compress_ns;
+	uint64_t nr_subbuf;
+	uint64_t nr_wakeups;
+	uint64_t latency_total_ns;
+	uint64_t latency_max_ns;
+};
+
+struct stream_state {
+	struct lttng_ust_ctl_consumer_stream *stream;
+	char *mmap_base;
+	int wait_fd;
+	int busy;		/* Holds a sub-buffer between get and put. */
+	uint64_t get_ts;
+	char *zbuf;		/* Compressed sub-buffer */
+	size_t zbuf_len;
+};
+
+/*
+ * Output backend. Writes are queued with submit() and become durable
+ * once complete() returns. Sub-buffers must not be released to the
+ * producer before their write has completed: complete() returns
+ * -EINPROGRESS if it could not wait for all of them.
+ */
+struct output {
+	int fd;
+	off_t offset;
+	int (*submit)(struct output *out, const void *buf, size_t len);
+	int (*complete)(struct output *out);
+#ifdef HAVE_LINUX_IO_URING_H
+	struct {
+		int fd;
+		unsigned int *sq_head, *sq_tail, *sq_mask, *sq_array;
+		unsigned int *cq_head, *cq_tail, *cq_mask;
+		struct io_uring_sqe *sqes;
+		struct io_uring_cqe *cqes;
+		void *sq_ring, *cq_ring;
+		size_t sq_ring_len, cq_ring_len, sqes_len;
+		unsigned int nr_entries, to_submit, inflight;
+	} uring;
+#endif
+};
+
+static
+uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static
+int pwrite_submit(struct output *out, const void *buf, size_t len)
+{
+	const char *p = buf;
+
+	while (len) {
+		ssize_t ret;
+
+		ret = pwrite(out->fd, p, len, out->offset);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+		p += ret;
+		len -= ret;
+		out->offset += ret;
+	}
+	return 0;
+}
+
+static
+int pwrite_complete(struct output *out __attribute__((unused)))
+{
+	return 0;
+}
+
+#ifdef HAVE_LINUX_IO_URING_H
+static
+int uring_submit(struct output *out, const void *buf, size_t len)
+{
+	struct io_uring_sqe *sqe;
+	unsigned int tail, index;
+
+	if (out->uring.inflight + out->uring.to_submit >= out->uring.nr_entries)
+		return -EBUSY;
+	tail = CMM_LOAD_SHARED(*out->uring.sq_tail);
+	index = tail & *out->uring.sq_mask;
+	sqe = &out->uring.sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_WRITE;
+	sqe->fd = out->fd;
+	sqe->addr = (uint64_t) (uintptr_t) buf;
+	sqe->len = len;
+	sqe->off = out->offset;
+	sqe->user_data = len;
+	out->uring.sq_array[index] = index;
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(*out->uring.sq_tail, tail + 1);
+	out->uring.to_submit++;
+	out->offset += len;
+	return 0;
+}
+
+static
+int uring_complete(struct output *out)
+{
+	int err = 0;
+
+	out->uring.inflight += out->uring.to_submit;
+	while (out->uring.inflight) {
+		unsigned int head;
+		long ret;
+
+		ret = syscall(__NR_io_uring_enter, out->uring.fd,
+			out->uring.to_submit, out->uring.inflight,
+			IORING_ENTER_GETEVENTS, NULL, 0);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("io_uring_enter");
+			return -EINPROGRESS;
+		}
+		out->uring.to_submit = 0;
+		head = *out->uring.cq_head;
+		while (head != CMM_LOAD_SHARED(*out->uring.cq_tail)) {
+			struct io_uring_cqe *cqe;
+
+			cmm_smp_rmb();
+			cqe = &out->uring.cqes[head & *out->uring.cq_mask];
+			if (cqe->res < 0)
+				err = cqe->res;
+			else if ((uint64_t) cqe->res != cqe->user_data)
+				err = -EIO;	/* Short write. */
+			head++;
+			out->uring.inflight--;
+		}
+		cmm_smp_mb();
+		CMM_STORE_SHARED(*out->uring.cq_head, head);
+	}
+	return err;
+}
+
+static
+int uring_init(struct output *out, unsigned int entries)
+{
+	struct io_uring_params p;
+	int fd;
+
+	memset(&p, 0, sizeof(p));
+	fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (fd < 0)
+		return -errno;
+	out->uring.fd = fd;
+	out->uring.nr_entries = p.sq_entries;
+	out->uring.sq_ring_len = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	out->uring.cq_ring_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	out->uring.sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	out->uring.sq_ring = mmap(NULL, out->uring.sq_ring_len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (out->uring.sq_ring == MAP_FAILED)
+		goto error_sq;
+	out->uring.cq_ring = mmap(NULL, out->uring.cq_ring_len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+	if (out->uring.cq_ring == MAP_FAILED)
+		goto error_cq;
+	out->uring.sqes = mmap(NULL, out->uring.sqes_len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (out->uring.sqes == MAP_FAILED)
+		goto error_sqes;
+	out->uring.sq_head = out->uring.sq_ring + p.sq_off.head;
+	out->uring.sq_tail = out->uring.sq_ring + p.sq_off.tail;
+	out->uring.sq_mask = out->uring.sq_ring + p.sq_off.ring_mask;
+	out->uring.sq_array = out->uring.sq_ring + p.sq_off.array;
+	out->uring.cq_head = out->uring.cq_ring + p.cq_off.head;
+	out->uring.cq_tail = out->uring.cq_ring + p.cq_off.tail;
+	out->uring.cq_mask = out->uring.cq_ring + p.cq_off.ring_mask;
+	out->uring.cqes = out->uring.cq_ring + p.cq_off.cqes;
+	out->submit = uring_submit;
+	out->complete = uring_complete;
+	return 0;
+
+error_sqes:
+	(void) munmap(out->uring.cq_ring, out->uring.cq_ring_len);
+error_cq:
+	(void) munmap(out->uring.sq_ring, out->uring.sq_ring_len);
+error_sq:
+	(void) close(fd);
+	return -ENOMEM;
+}
+
+static
+void uring_fini(struct output *out)
+{
+	if (out->submit != uring_submit)
+		return;
+	(void) munmap(out->uring.sqes, out->uring.sqes_len);
+	(void) munmap(out->uring.cq_ring, out->uring.cq_ring_len);
+	(void) munmap(out->uring.sq_ring, out->uring.sq_ring_len);
+	(void) close(out->uring.fd);
+}
+#else /* HAVE_LINUX_IO_URING_H */
+static
+int uring_init(struct output *out __attribute__((unused)),
+		unsigned int entries __attribute__((unused)))
+{
+	return -ENOSYS;
+}
+
+static
+void uring_fini(struct output *out __attribute__((unused)))
+{
+}
+#endif /* HAVE_LINUX_IO_URING_H */
+
+static
+const char *output_init(struct output *out, unsigned int nr_streams)
+{
+	memset(out, 0, sizeof(*out));
+	out->fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (out->fd < 0)
+		return NULL;
+	if (!force_pwrite && !uring_init(out, nr_streams))
+		return "io_uring";
+	out->submit = pwrite_submit;
+	out->complete = pwrite_complete;
+	return "pwrite";
+}
+
+static
+void output_fini(struct output *out)
+{
+	uring_fini(out);
+	(void) close(out->fd);
+}
+
+/*
+ * The shm file backing each stream is normally created by the session
+ * daemon. Use an unlinked temporary file instead.
+ */
+static
+int create_stream_fd(void)
+{
+	char path[] = "/tmp/lttng-ust-consumer-bench-XXXXXX";
+	int fd;
+
+	fd = mkstemp(path);
+	if (fd < 0)
+		return -1;
+	(void) unlink(path);
+	return fd;
+}
+
+static
+void *producer_thread(void *arg)
+{
+	struct lttng_ust_ctl_consumer_channel *chan = arg;
+	static const char *words[] = {
+		"lttng", "ust", "event", "cpu_id", "tid", "ret", "0x7f3a",
+		"fd", "len", "4096", "-11", "msg", "ok", "connect", "read",
+	};
+	size_t pool_len = payload_size * PAYLOAD_POOL_WINDOWS, i = 0;
+	struct producer_stats *stats;
+	uint32_t seed = 1;
+	uint64_t nr_writes = 0;
+	char *pool;
+
+	stats = calloc(1, sizeof(*stats));
+	pool = malloc(pool_len);
+	if (!stats || !pool)
+		abort();
+	/*
+	 * Fill a pool with pseudo-random words so the payload compresses
+	 * like a trace rather than like a repeated pattern. Each write
+	 * takes a different window of the pool.
+	 */
+	while (i < pool_len) {
+		const char *word;
+
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		word = words[seed % (sizeof(words) / sizeof(words[0]))];
+		while (*word && i < pool_len)
+			pool[i++] = *word++;
+		if (i < pool_len)
+			pool[i++] = seed & 0x100 ? ' ' : '=';
+	}
+
+	while (!test_go)
+		cmm_barrier();
+
+	while (!test_stop) {
+		ssize_t ret;
+
+		ret = lttng_ust_ctl_write_one_packet_to_channel(chan,
+				pool + (nr_writes++ % PAYLOAD_POOL_WINDOWS) * payload_size,
+				payload_size);
+		if (ret > 0)
+			stats->bytes_written += ret;
+		else
+			stats->nr_rejected++;
+	}
+	free(pool);
+	return stats;
+}
+
+/*
+ * Wait for the batch of writes to complete, then hand the sub-buffers
+ * it holds back to the producer. If the writes cannot be waited for,
+ * the sub-buffers stay held: the output may still be reading them.
+ */
+static
+int drain_flush(struct stream_state *streams, int nr_streams,
+		struct output *out, struct drain_stats *stats)
+{
+	int i, ret;
+
+	ret = out->complete(out);
+	if (ret == -EINPROGRESS)
+		return ret;
+	for (i = 0; i < nr_streams; i++) {
+		struct stream_state *s = &streams[i];
+		uint64_t latency;
+
+		if (!s->busy)
+			continue;
+		(void) lttng_ust_ctl_put_next_subbuf(s->stream);
+		s->busy = 0;
+		latency = now_ns() - s->get_ts;
+		stats->latency_total_ns += latency;
+		if (latency > stats->latency_max_ns)
+			stats->latency_max_ns = latency;
+		stats->nr_subbuf++;
+	}
+	return ret;
+}
+
+/*
+ * Grab the next sub-buffer of every stream which has one ready, write
+ * them all out as a single batch, then hand them back to the producer.
+ * When the output queue is full, the batch so far is written out first.
+ */
+static
+int drain_round(struct stream_state *streams, int nr_streams,
+		struct output *out, struct drain_stats *stats)
+{
+	int i, ret = 0, flush_ret, nr_written = 0;
+
+	for (i = 0; i < nr_streams; i++) {
+		struct stream_state *s = &streams[i];
+		unsigned long off, len;
+		const void *buf;
+		size_t zlen = 0, buf_len;
+
+		if (lttng_ust_ctl_get_next_subbuf(s->stream))
+			continue;
+		s->get_ts = now_ns();
+		if (lttng_ust_ctl_get_mmap_read_offset(s->stream, &off) ||
+				lttng_ust_ctl_get_padded_subbuf_size(s->stream, &len)) {
+			(void) lttng_ust_ctl_put_next_subbuf(s->stream);
+			ret = -EIO;
+			goto end;
+		}
+		if (compress_subbuf) {
+			uint64_t start = now_ns();
+
+			ret = lttng_ust_ctl_compress_packet(s->stream, compression,
+					compression_level, s->zbuf, s->zbuf_len, &zlen);
+			if (ret) {
+				(void) lttng_ust_ctl_put_next_subbuf(s->stream);
+				goto end;
+			}
+			stats->compress_ns += now_ns() - start;
+			buf = s->zbuf;
+			buf_len = zlen;
+		} else {
+			buf = s->mmap_base + off;
+			buf_len = len;
+		}
+		ret = out->submit(out, buf, buf_len);
+		if (ret == -EBUSY) {
+			ret = drain_flush(streams, nr_streams, out, stats);
+			if (!ret)
+				ret = out->submit(out, buf, buf_len);
+		}
+		if (ret) {
+			/* Not written out: the error ends the drain anyway. */
+			(void) lttng_ust_ctl_put_next_subbuf(s->stream);
+			goto end;
+		}
+		s->busy = 1;
+		nr_written++;
+		stats->bytes += len;
+		stats->compressed_bytes += zlen;
+	}
+end:
+	flush_ret = drain_flush(streams, nr_streams, out, stats);
+	if (!ret)
+		ret = flush_ret;
+	return ret < 0 ? ret : nr_written;
+}
+
+static
+int drain(struct stream_state *streams, int nr_streams,
+		struct output *out, struct drain_stats *stats)
+{
+	struct pollfd pfd[nr_streams];
+	int i, ret;
+
+	for (i = 0; i < nr_streams; i++) {
+		pfd[i].fd = streams[i].wait_fd;
+		pfd[i].events = POLLIN | POLLPRI;
+	}
+	ret = poll(pfd, nr_streams, POLL_TIMEOUT_MS);
+	if (ret < 0)
+		return errno == EINTR ? 0 : -errno;
+	for (i = 0; i < nr_streams; i++) {
+		char dummy;
+
+		if (!(pfd[i].revents & POLLIN))
+			continue;
+		stats->nr_wakeups++;
+		if (read(pfd[i].fd, &dummy, 1) < 0 && errno != EAGAIN)
+			return -errno;
+	}
+	do {
+		ret = drain_round(streams, nr_streams, out, stats);
+	} while (ret > 0);
+	return ret;
+}
+
+/* Print the live statistics of a stream on one line. */
+static
+void print_stream_stats(struct lttng_ust_ctl_consumer_stream *stream)
+{
+	struct lttng_ust_ctl_stream_stats stats;
+
+	if (lttng_ust_ctl_get_stream_stats(stream, &stats)) {
+		printf("Stream statistics: unavailable\n");
+		return;
+	}
+	printf("Stream statistics: records %" PRIu64 ", bytes %" PRIu64
+		", slow path %" PRIu64 ", switches %" PRIu64
+		", blocking retries %" PRIu64 ", lost full %" PRIu64
+		", lost wrap %" PRIu64 ", lost big %" PRIu64
+		", max nesting %" PRIu32 "\n",
+		stats.records_written, stats.bytes_written, stats.reserve_slow,
+		stats.switches, stats.blocking_retries, stats.records_lost_full,
+		stats.records_lost_wrap, stats.records_lost_big,
+		stats.max_nesting);
+}
+
+static
+int parse_compression(const char *arg)
+{
+	const char *level = strchr(arg, ':');
+	size_t len = level ? (size_t) (level - arg) : strlen(arg);
+
+	if (len == 4 && !strncmp(arg, "none", len))
+		compression = LTTNG_UST_CTL_COMPRESSION_NONE;
+	else if (len == 3 && !strncmp(arg, "lz4", len))
+		compression = LTTNG_UST_CTL_COMPRESSION_LZ4;
+	else if (len == 4 && !strncmp(arg, "zstd", len))
+		compression = LTTNG_UST_CTL_COMPRESSION_ZSTD;
+	else
+		return -1;
+	if (level)
+		compression_level = atoi(level + 1);
+	compress_subbuf = 1;
+	return 0;
+}
+
+static
+void usage(char **argv)
+{
+	printf("Usage: %s <OPTIONS>\n", argv[0]);
+	printf("OPTIONS:\n");
+	printf("        [-d duration] (seconds, default %lu)\n", duration);
+	printf("        [-s subbuf_size] (bytes, default %" PRIu64 ")\n", subbuf_size);
+	printf("        [-n num_subbuf] (power of 2, default %" PRIu64 ")\n", num_subbuf);
+	printf("        [-p payload_size] (bytes per write, default %zu)\n", payload_size);
+	printf("        [-o output] (default %s)\n", output_path);
+	printf("        [-w] (use pwrite instead of io_uring)\n");
+	printf("        [-z none|lz4|zstd[:level]] (compress sub-buffers, default none)\n");
+	printf("        [-S interval] (print the stream statistics every interval seconds)\n");
+	printf("        [-v] (verbose output)\n");
+	printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	struct lttng_ust_ctl_consumer_channel_attr attr;
+	struct lttng_ust_ctl_consumer_channel *chan;
+	struct stream_state stream_state;
+	struct producer_stats *pstats;
+	struct drain_stats dstats;
+	struct output out;
+	const char *method;
+	pthread_t producer;
+	uint64_t start, end, next_stats;
+	double elapsed;
+	int stream_fd, opt, ret = 1;
+
+	while ((opt = getopt(argc, argv, "d:s:n:p:o:wz:S:vh")) != -1) {
+		switch (opt) {
+		case 'd':
+			duration = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			subbuf_size = strtoull(optarg, NULL, 0);
+			break;
+		case 'n':
+			num_subbuf = strtoull(optarg, NULL, 0);
+			break;
+		case 'p':
+			payload_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			output_path = optarg;
+			break;
+		case 'w':
+			force_pwrite = 1;
+			break;
+		case 'z':
+			if (parse_compression(optarg)) {
+				usage(argv);
+				exit(1);
+			}
+			break;
+		case 'S':
+			stats_interval = strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			verbose_mode = 1;
+			break;
+		default:
+			usage(argv);
+			exit(opt == 'h' ? 0 : 1);
+		}
+	}
+	if (!payload_size) {
+		usage(argv);
+		exit(1);
+	}
+	if (compress_subbuf && !lttng_ust_ctl_compression_available(compression)) {
+		fprintf(stderr, "Compression not available in liblttng-ust-ctl\n");
+		exit(1);
+	}
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = LTTNG_UST_ABI_CHAN_METADATA;
+	attr.subbuf_size = subbuf_size;
+	attr.num_subbuf = num_subbuf;
+	attr.overwrite = 0;
+	attr.output = LTTNG_UST_ABI_MMAP;
+
+	stream_fd = create_stream_fd();
+	if (stream_fd < 0) {
+		perror("create_stream_fd");
+		goto end;
+	}
+	chan = lttng_ust_ctl_create_channel(&attr, &stream_fd, 1);
+	if (!chan) {
+		fprintf(stderr, "Error creating channel\n");
+		goto end;
+	}
+	memset(&stream_state, 0, sizeof(stream_state));
+	stream_state.stream = lttng_ust_ctl_create_stream(chan, 0);
+	if (!stream_state.stream) {
+		fprintf(stderr, "Error creating stream\n");
+		goto error_stream;
+	}
+	stream_state.mmap_base = lttng_ust_ctl_get_mmap_base(stream_state.stream);
+	stream_state.wait_fd = lttng_ust_ctl_stream_get_wait_fd(stream_state.stream);
+	if (!stream_state.mmap_base || stream_state.wait_fd < 0) {
+		fprintf(stderr, "Error mapping stream\n");
+		goto error_output;
+	}
+	if (compress_subbuf) {
+		stream_state.zbuf_len = lttng_ust_ctl_compress_bound(compression,
+				subbuf_size);
+		stream_state.zbuf = malloc(stream_state.zbuf_len);
+		if (!stream_state.zbuf) {
+			perror("malloc");
+			goto error_output;
+		}
+	}
+
+	method = output_init(&out, 1);
+	if (!method) {
+		perror("open output");
+		goto error_output;
+	}
+	printf_verbose("writing %s with %s, %" PRIu64 " x %" PRIu64 " bytes sub-buffers\n",
+		output_path, method, num_subbuf, subbuf_size);
+
+	if (pthread_create(&producer, NULL, producer_thread, chan)) {
+		fprintf(stderr, "producer thread create failed\n");
+		goto error_thread;
+	}
+
+	memset(&dstats, 0, sizeof(dstats));
+	start = now_ns();
+	next_stats = start + stats_interval * 1000000000ULL;
+	test_go = 1;
+	while (now_ns() - start < duration * 1000000000ULL) {
+		if (drain(&stream_state, 1, &out, &dstats) < 0) {
+			fprintf(stderr, "Error draining stream\n");
+			break;
+		}
+		if (stats_interval && now_ns() >= next_stats) {
+			print_stream_stats(stream_state.stream);
+			next_stats += stats_interval * 1000000000ULL;
+		}
+	}
+	test_stop = 1;
+	if (pthread_join(producer, (void **) &pstats)) {
+		fprintf(stderr, "thread join failed\n");
+		goto error_thread;
+	}
+
+	/* Deliver the last, partially filled, sub-buffer and drain it. */
+	(void) lttng_ust_ctl_flush_buffer(stream_state.stream, 1);
+	while (drain_round(&stream_state, 1, &out, &dstats) > 0)
+		;
+	end = now_ns();
+	elapsed = (double) (end - start) / 1e9;
+
+	printf("Output method: %s\n", method);
+	printf("Bytes produced: %" PRIu64 "\n", pstats->bytes_written);
+	printf("Bytes drained: %" PRIu64 "\n", dstats.bytes);
+	printf("Sub-buffers drained: %" PRIu64 "\n", dstats.nr_subbuf);
+	printf("Wakeups: %" PRIu64 "\n", dstats.nr_wakeups);
+	printf("Rejected writes (buffer full): %" PRIu64 "\n", pstats->nr_rejected);
+	printf("Throughput: %.2f MB/s\n", (double) dstats.bytes / elapsed / 1e6);
+	if (compress_subbuf && dstats.compressed_bytes) {
+		printf("Bytes written (compressed): %" PRIu64 "\n", dstats.compressed_bytes);
+		printf("Compression ratio: %.2f\n",
+			(double) dstats.bytes / dstats.compressed_bytes);
+		printf("Compression speed: %.2f MB/s\n",
+			(double) dstats.bytes / ((double) dstats.compress_ns / 1e9) / 1e6);
+	}
+	if (dstats.nr_subbuf)
+		printf("Drain latency: avg %" PRIu64 " ns, max %" PRIu64 " ns\n",
+			dstats.latency_total_ns / dstats.nr_subbuf,
+			dstats.latency_max_ns);
+	print_stream_stats(stream_state.stream);
+	free(pstats);
+	ret = 0;
+
+error_thread:
+	output_fini(&out);
+error_output:
+	free(stream_state.zbuf);
+	lttng_ust_ctl_destroy_stream(stream_state.stream);
+error_stream:
+	lttng_ust_ctl_destroy_channel(chan);
+end:
+	return ret;
+}
@@ -0,0 +1,203 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright 2026 EfficiOS, Inc.
+ *
+ * LTTng Userspace Tracer (UST) - constructor latency benchmark
+ *
+ * Measure the time from exec to main() of a program linked with
+ * liblttng-ust, with the constructor waiting for the session daemons
+ * and with LTTNG_UST_REGISTER_ASYNC. The benchmark re-executes itself:
+ * the parent takes a timestamp before the exec, the child takes one on
+ * entry of main(), emits a few events and reports the difference
+ * through a pipe.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LTTNG_UST_TRACEPOINT_DEFINE
+#include "ust_tests_benchmark.h"
+
+enum bench_mode {
+	BENCH_SYNC,
+	BENCH_ASYNC,
+	NR_BENCH_MODES,
+};
+
+static const char *bench_mode_names[NR_BENCH_MODES] = {
+	[BENCH_SYNC] = "sync",
+	[BENCH_ASYNC] = "async",
+};
+
+static unsigned long nr_runs = 50;
+static unsigned long nr_events = 100;
+
+static
+uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static
+int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Child: report the exec to main() latency, then emit the events. */
+static
+int child(const char *str_start, const char *str_fd, const char *str_events)
+{
+	uint64_t delta = now_ns() - strtoull(str_start, NULL, 10);
+	unsigned long i, events = strtoul(str_events, NULL, 10);
+	int fd = atoi(str_fd);
+
+	for (i = 0; i < events; i++)
+		lttng_ust_tracepoint(ust_tests_benchmark, tpbench, i);
+	if (write(fd, &delta, sizeof(delta)) != sizeof(delta))
+		return 1;
+	close(fd);
+	return 0;
+}
+
+/* Run the child once, returning its latency in *delta. */
+static
+int run_once(enum bench_mode mode, uint64_t *delta)
+{
+	char str_start[32], str_fd[16], str_events[32];
+	int pipefd[2], status, ret = -1;
+	ssize_t len;
+	pid_t pid;
+
+	if (pipe(pipefd) < 0) {
+		perror("pipe");
+		return -1;
+	}
+	snprintf(str_fd, sizeof(str_fd), "%d", pipefd[1]);
+	snprintf(str_events, sizeof(str_events), "%lu", nr_events);
+	snprintf(str_start, sizeof(str_start), "%" PRIu64, now_ns());
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		goto end;
+	}
+	if (!pid) {
+		close(pipefd[0]);
+		if (mode == BENCH_ASYNC)
+			setenv("LTTNG_UST_REGISTER_ASYNC", "1", 1);
+		else
+			unsetenv("LTTNG_UST_REGISTER_ASYNC");
+		execl("/proc/self/exe", "ctor-bench", "--child", str_start,
+			str_fd, str_events, (char *) NULL);
+		perror("execl");
+		_exit(1);
+	}
+	close(pipefd[1]);
+	pipefd[1] = -1;
+	do {
+		len = read(pipefd[0], delta, sizeof(*delta));
+	} while (len < 0 && errno == EINTR);
+	if (waitpid(pid, &status, 0) < 0) {
+		perror("waitpid");
+		goto end;
+	}
+	if (len != sizeof(*delta) || !WIFEXITED(status) || WEXITSTATUS(status)) {
+		fprintf(stderr, "Child failed\n");
+		goto end;
+	}
+	ret = 0;
+end:
+	close(pipefd[0]);
+	if (pipefd[1] >= 0)
+		close(pipefd[1]);
+	return ret;
+}
+
+static
+int run(enum bench_mode mode)
+{
+	uint64_t *deltas, sum = 0;
+	unsigned long i;
+	int ret = -1;
+
+	deltas = calloc(nr_runs, sizeof(*deltas));
+	if (!deltas) {
+		perror("calloc");
+		return -1;
+	}
+	for (i = 0; i < nr_runs; i++) {
+		if (run_once(mode, &deltas[i]))
+			goto end;
+		sum += deltas[i];
+	}
+	qsort(deltas, nr_runs, sizeof(*deltas), cmp_u64);
+	printf("%-8s %8lu %12.1f %12.1f %12.1f %12.1f\n",
+		bench_mode_names[mode], nr_runs,
+		(double) deltas[0] / 1000,
+		(double) sum / nr_runs / 1000,
+		(double) deltas[nr_runs / 2] / 1000,
+		(double) deltas[nr_runs - 1] / 1000);
+	ret = 0;
+end:
+	free(deltas);
+	return ret;
+}
+
+static
+void usage(char **argv)
+{
+	printf("Usage: %s <OPTIONS>\n", argv[0]);
+	printf("OPTIONS:\n");
+	printf("        [-n nr_runs] (executions per mode, default %lu)\n", nr_runs);
+	printf("        [-e nr_events] (events emitted by each execution, default %lu)\n", nr_events);
+	printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	enum bench_mode mode;
+	int opt;
+
+	if (argc == 5 && !strcmp(argv[1], "--child"))
+		return child(argv[2], argv[3], argv[4]);
+
+	while ((opt = getopt(argc, argv, "n:e:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			nr_runs = strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			nr_events = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv);
+			exit(opt == 'h' ? 0 : 1);
+		}
+	}
+	if (!nr_runs) {
+		usage(argv);
+		exit(1);
+	}
+
+	printf("%-8s %8s %12s %12s %12s %12s\n", "Mode", "Runs",
+		"Min (us)", "Avg (us)", "P50 (us)", "Max (us)");
+	for (mode = 0; mode < NR_BENCH_MODES; mode++) {
+		if (run(mode))
+			return 1;
+	}
+	return 0;
+}
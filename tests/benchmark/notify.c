@@ -0,0 +1,344 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright 2026 EfficiOS, Inc.
+ *
+ * LTTng Userspace Tracer (UST) - event registration benchmark
+ *
+ * Measure the cost of registering events to the session daemon over the
+ * notification socket, one round trip per event versus batched
+ * LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH messages, with and without field
+ * descriptor deduplication. A thread plays the role
+ * of the session daemon on one end of a socket pair, receiving the
+ * registrations through liblttng-ust-ctl and replying with event ids.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <lttng/ust-ctl.h>
+#include <lttng/ust-events.h>
+
+#include "common/ustcomm.h"
+
+#define SESSION_OBJD		1
+#define CHANNEL_OBJD		2
+
+enum bench_mode {
+	BENCH_PER_EVENT,
+	BENCH_BATCH,
+	BENCH_BATCH_DEDUP,
+	NR_BENCH_MODES,
+};
+
+static const char *bench_mode_names[NR_BENCH_MODES] = {
+	[BENCH_PER_EVENT] = "per-event",
+	[BENCH_BATCH] = "batch",
+	[BENCH_BATCH_DEDUP] = "dedup",
+};
+
+struct sessiond_args {
+	int sock;
+	struct lttng_ust_ctl_notify_fields_cache *fields_cache;
+};
+
+static unsigned long nr_events = 20000;
+static unsigned int nr_fields = 4;
+static int verbose_mode;
+
+struct sessiond_stats {
+	unsigned long nr_messages;
+	unsigned long nr_events;
+};
+
+static const struct lttng_ust_type_integer int_type = {
+	.parent = {
+		.type = lttng_ust_type_integer,
+	},
+	.struct_size = sizeof(struct lttng_ust_type_integer),
+	.size = 32,
+	.alignment = 8,
+	.signedness = 1,
+	.reverse_byte_order = 0,
+	.base = 10,
+};
+
+static
+uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Fake session daemon: handle event registrations until the
+ * application end of the socket is closed.
+ */
+static
+void *sessiond_thread(void *arg)
+{
+	struct sessiond_args *args = arg;
+	int sock = args->sock;
+	struct sessiond_stats *stats;
+	uint32_t next_id = 0;
+	int ret;
+
+	stats = calloc(1, sizeof(*stats));
+	if (!stats)
+		abort();
+	for (;;) {
+		enum lttng_ust_ctl_notify_cmd cmd;
+
+		ret = lttng_ust_ctl_recv_notify(sock, &cmd);
+		if (ret)
+			break;
+		stats->nr_messages++;
+		switch (cmd) {
+		case LTTNG_UST_CTL_NOTIFY_CMD_EVENT:
+		{
+			int session_objd, channel_objd, loglevel;
+			char name[LTTNG_UST_ABI_SYM_NAME_LEN];
+			char *signature, *model_emf_uri;
+			struct lttng_ust_ctl_field *fields;
+			uint64_t user_token;
+			size_t nr;
+
+			ret = lttng_ust_ctl_recv_register_event(sock,
+				&session_objd, &channel_objd, name, &loglevel,
+				&signature, &nr, &fields, &model_emf_uri,
+				&user_token);
+			if (ret)
+				goto end;
+			free(signature);
+			free(fields);
+			free(model_emf_uri);
+			ret = lttng_ust_ctl_reply_register_event(sock, next_id++, 0);
+			if (ret)
+				goto end;
+			stats->nr_events++;
+			break;
+		}
+		case LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH:
+		{
+			struct lttng_ust_ctl_event_registration *events;
+			uint32_t *ids;
+			int *ret_codes;
+			size_t nr, i;
+
+			ret = lttng_ust_ctl_recv_register_event_batch(sock,
+				args->fields_cache, &events, &nr);
+			if (ret)
+				goto end;
+			ids = calloc(nr, sizeof(*ids));
+			ret_codes = calloc(nr, sizeof(*ret_codes));
+			if (!ids || !ret_codes)
+				abort();
+			for (i = 0; i < nr; i++) {
+				ids[i] = next_id++;
+				free(events[i].signature);
+				free(events[i].fields);
+				free(events[i].model_emf_uri);
+			}
+			free(events);
+			ret = lttng_ust_ctl_reply_register_event_batch(sock,
+				args->fields_cache, ids, ret_codes, nr);
+			free(ids);
+			free(ret_codes);
+			if (ret)
+				goto end;
+			stats->nr_events += nr;
+			break;
+		}
+		default:
+			fprintf(stderr, "Unexpected notification %d\n", cmd);
+			goto end;
+		}
+	}
+end:
+	return stats;
+}
+
+static
+int register_events(int sock, enum bench_mode mode,
+		struct ustcomm_fields_desc_cache *fields_cache,
+		const struct lttng_ust_event_field * const *fields)
+{
+	struct ustcomm_event_registration regs[USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS];
+	char names[USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS][LTTNG_UST_ABI_SYM_NAME_LEN];
+	unsigned long i = 0;
+	int ret;
+
+	while (i < nr_events) {
+		size_t nr = 0, j;
+
+		if (mode == BENCH_PER_EVENT) {
+			uint32_t id;
+
+			snprintf(names[0], sizeof(names[0]), "bench:event_%lu", i);
+			ret = ustcomm_register_event(sock, NULL, SESSION_OBJD,
+				CHANNEL_OBJD, names[0], 13, "bench_signature",
+				nr_fields, fields, NULL, 0, &id);
+			if (ret)
+				return ret;
+			i++;
+			continue;
+		}
+		while (nr < USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS && i < nr_events) {
+			snprintf(names[nr], sizeof(names[nr]), "bench:event_%lu", i);
+			memset(&regs[nr], 0, sizeof(regs[nr]));
+			regs[nr].event_name = names[nr];
+			regs[nr].loglevel = 13;
+			regs[nr].signature = "bench_signature";
+			regs[nr].nr_fields = nr_fields;
+			regs[nr].fields = fields;
+			nr++;
+			i++;
+		}
+		ret = ustcomm_register_events(sock, NULL, SESSION_OBJD,
+			CHANNEL_OBJD, regs, nr, fields_cache);
+		if (ret)
+			return ret;
+		for (j = 0; j < nr; j++) {
+			if (regs[j].ret_code)
+				return regs[j].ret_code;
+		}
+	}
+	return 0;
+}
+
+static
+int run(enum bench_mode mode, const struct lttng_ust_event_field * const *fields)
+{
+	struct ustcomm_fields_desc_cache *fields_cache = NULL;
+	struct sessiond_args args = { 0 };
+	struct sessiond_stats *stats;
+	pthread_t sessiond;
+	uint64_t start, end;
+	int sv[2], ret;
+	void *tret;
+
+	if (mode == BENCH_BATCH_DEDUP) {
+		fields_cache = ustcomm_fields_desc_cache_create();
+		args.fields_cache = lttng_ust_ctl_create_notify_fields_cache();
+		if (!fields_cache || !args.fields_cache) {
+			fprintf(stderr, "Error creating field descriptor caches\n");
+			ret = -1;
+			goto end;
+		}
+	}
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+		perror("socketpair");
+		ret = -1;
+		goto end;
+	}
+	args.sock = sv[1];
+	ret = pthread_create(&sessiond, NULL, sessiond_thread, &args);
+	if (ret) {
+		errno = ret;
+		perror("pthread_create");
+		close(sv[0]);
+		close(sv[1]);
+		ret = -1;
+		goto end;
+	}
+
+	start = now_ns();
+	ret = register_events(sv[0], mode, fields_cache, fields);
+	end = now_ns();
+	if (ret)
+		fprintf(stderr, "Error registering events: %d\n", ret);
+
+	close(sv[0]);
+	pthread_join(sessiond, &tret);
+	close(sv[1]);
+	stats = tret;
+
+	printf("%-10s %10lu %10lu %12.3f %10.0f\n", bench_mode_names[mode],
+		stats->nr_events, stats->nr_messages,
+		(double) (end - start) / 1000000.0,
+		stats->nr_events ? (double) (end - start) / stats->nr_events : 0.0);
+	free(stats);
+end:
+	lttng_ust_ctl_destroy_notify_fields_cache(args.fields_cache);
+	ustcomm_fields_desc_cache_destroy(fields_cache);
+	return ret;
+}
+
+static
+void usage(char **argv)
+{
+	printf("Usage: %s <OPTIONS>\n", argv[0]);
+	printf("OPTIONS:\n");
+	printf("        [-e nr_events] (default %lu)\n", nr_events);
+	printf("        [-f nr_fields] (integer fields per event, default %u)\n", nr_fields);
+	printf("        [-v] (verbose output)\n");
+	printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	struct lttng_ust_event_field *field_storage;
+	const struct lttng_ust_event_field **fields;
+	char (*field_names)[16];
+	enum bench_mode mode;
+	unsigned int i;
+	int opt, ret = 1;
+
+	while ((opt = getopt(argc, argv, "e:f:vh")) != -1) {
+		switch (opt) {
+		case 'e':
+			nr_events = strtoul(optarg, NULL, 0);
+			break;
+		case 'f':
+			nr_fields = strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			verbose_mode = 1;
+			break;
+		default:
+			usage(argv);
+			exit(opt == 'h' ? 0 : 1);
+		}
+	}
+
+	field_storage = calloc(nr_fields, sizeof(*field_storage));
+	fields = calloc(nr_fields, sizeof(*fields));
+	field_names = calloc(nr_fields, sizeof(*field_names));
+	if (nr_fields && (!field_storage || !fields || !field_names)) {
+		perror("calloc");
+		goto end;
+	}
+	for (i = 0; i < nr_fields; i++) {
+		snprintf(field_names[i], sizeof(field_names[i]), "field_%u", i);
+		field_storage[i].struct_size = sizeof(field_storage[i]);
+		field_storage[i].name = field_names[i];
+		field_storage[i].type = &int_type.parent;
+		fields[i] = &field_storage[i];
+	}
+
+	if (verbose_mode)
+		printf("Registering %lu events with %u fields each\n",
+			nr_events, nr_fields);
+	printf("%-10s %10s %10s %12s %10s\n", "Protocol", "Events",
+		"Messages", "Total (ms)", "ns/event");
+	for (mode = 0; mode < NR_BENCH_MODES; mode++) {
+		if (run(mode, fields))
+			goto end;
+	}
+	ret = 0;
+end:
+	free(field_names);
+	free(fields);
+	free(field_storage);
+	return ret;
+}
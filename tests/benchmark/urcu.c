@@ -0,0 +1,275 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright 2026 EfficiOS, Inc.
+ *
+ * LTTng Userspace Tracer (UST) - RCU grace period stress benchmark
+ *
+ * Start many reader threads which mostly sleep between short read-side
+ * critical sections, like the threads of a thread-per-connection
+ * server, and measure the grace periods of concurrent updaters, first
+ * waiting for them with lttng_ust_urcu_synchronize_rcu(), then
+ * deferring the reclaim with lttng_ust_urcu_call_rcu().
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <urcu/compiler.h>
+#include <urcu/system.h>
+#include <urcu/uatomic.h>
+
+#include <lttng/urcu/urcu-ust.h>
+
+#define NODE_MAGIC	0x5CA1AB1E
+
+struct node {
+	uint32_t magic;
+	struct lttng_ust_urcu_head rcu_head;
+};
+
+struct updater {
+	pthread_t thread;
+	bool defer;
+	unsigned long nr_ops;
+	uint64_t total_ns;
+	uint64_t max_ns;
+};
+
+static unsigned long nr_readers = 1000;
+static unsigned long nr_updaters = 4;
+static unsigned long duration = 5;
+static unsigned long reader_sleep_us = 10000;
+
+static struct node *shared_node;
+static int test_stop, readers_stop;
+static unsigned long nr_registered, reader_errors;
+
+static
+uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static
+struct node *node_alloc(void)
+{
+	struct node *node;
+
+	node = malloc(sizeof(*node));
+	if (!node)
+		abort();
+	node->magic = NODE_MAGIC;
+	return node;
+}
+
+static
+void node_free(struct node *node)
+{
+	/* Catch readers still using the node after its grace period. */
+	node->magic = 0;
+	free(node);
+}
+
+static
+void node_free_rcu(struct lttng_ust_urcu_head *head)
+{
+	node_free(caa_container_of(head, struct node, rcu_head));
+}
+
+static
+void *reader_thread(void *arg __attribute__((unused)))
+{
+	lttng_ust_urcu_register_thread();
+	uatomic_inc(&nr_registered);
+	while (!CMM_LOAD_SHARED(readers_stop)) {
+		struct node *node;
+
+		lttng_ust_urcu_read_lock();
+		node = lttng_ust_rcu_dereference(shared_node);
+		if (node && node->magic != NODE_MAGIC)
+			uatomic_inc(&reader_errors);
+		lttng_ust_urcu_read_unlock();
+		if (reader_sleep_us)
+			usleep(reader_sleep_us);
+	}
+	return NULL;
+}
+
+static
+void *updater_thread(void *arg)
+{
+	struct updater *updater = arg;
+
+	while (!CMM_LOAD_SHARED(test_stop)) {
+		struct node *old;
+		uint64_t start, delta;
+
+		old = lttng_ust_rcu_xchg_pointer(&shared_node, node_alloc());
+		start = now_ns();
+		if (updater->defer) {
+			lttng_ust_urcu_call_rcu(&old->rcu_head, node_free_rcu);
+		} else {
+			lttng_ust_urcu_synchronize_rcu();
+			node_free(old);
+		}
+		delta = now_ns() - start;
+		updater->nr_ops++;
+		updater->total_ns += delta;
+		if (delta > updater->max_ns)
+			updater->max_ns = delta;
+	}
+	return NULL;
+}
+
+static
+int run(bool defer)
+{
+	struct updater *updaters;
+	unsigned long i, nr_ops = 0;
+	uint64_t total_ns = 0, max_ns = 0, start, end;
+	int ret = -1;
+
+	updaters = calloc(nr_updaters, sizeof(*updaters));
+	if (!updaters) {
+		perror("calloc");
+		return -1;
+	}
+	CMM_STORE_SHARED(test_stop, 0);
+	start = now_ns();
+	for (i = 0; i < nr_updaters; i++) {
+		updaters[i].defer = defer;
+		if (pthread_create(&updaters[i].thread, NULL, updater_thread,
+				&updaters[i])) {
+			perror("pthread_create");
+			abort();
+		}
+	}
+	sleep(duration);
+	CMM_STORE_SHARED(test_stop, 1);
+	for (i = 0; i < nr_updaters; i++) {
+		if (pthread_join(updaters[i].thread, NULL)) {
+			perror("pthread_join");
+			goto end;
+		}
+		nr_ops += updaters[i].nr_ops;
+		total_ns += updaters[i].total_ns;
+		if (updaters[i].max_ns > max_ns)
+			max_ns = updaters[i].max_ns;
+	}
+	if (defer)
+		lttng_ust_urcu_barrier();
+	end = now_ns();
+	printf("%-16s %12lu %14.0f %12.1f %12.1f\n",
+		defer ? "call_rcu" : "synchronize_rcu", nr_ops,
+		(double) nr_ops * 1000000000.0 / (end - start),
+		nr_ops ? (double) total_ns / nr_ops / 1000 : 0.0,
+		(double) max_ns / 1000);
+	ret = 0;
+end:
+	free(updaters);
+	return ret;
+}
+
+static
+void usage(char **argv)
+{
+	printf("Usage: %s <OPTIONS>\n", argv[0]);
+	printf("OPTIONS:\n");
+	printf("        [-r nr_readers] (reader threads, default %lu)\n", nr_readers);
+	printf("        [-u nr_updaters] (updater threads, default %lu)\n", nr_updaters);
+	printf("        [-d duration] (seconds per mode, default %lu)\n", duration);
+	printf("        [-s reader_sleep] (microseconds between read-side critical sections, default %lu)\n", reader_sleep_us);
+	printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t *readers;
+	pthread_attr_t attr;
+	uint64_t start;
+	unsigned long i;
+	int opt, ret = 1;
+
+	while ((opt = getopt(argc, argv, "r:u:d:s:h")) != -1) {
+		switch (opt) {
+		case 'r':
+			nr_readers = strtoul(optarg, NULL, 0);
+			break;
+		case 'u':
+			nr_updaters = strtoul(optarg, NULL, 0);
+			break;
+		case 'd':
+			duration = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			reader_sleep_us = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv);
+			exit(opt == 'h' ? 0 : 1);
+		}
+	}
+	if (!nr_updaters) {
+		usage(argv);
+		exit(1);
+	}
+
+	readers = calloc(nr_readers, sizeof(*readers));
+	if (!readers) {
+		perror("calloc");
+		return 1;
+	}
+	shared_node = node_alloc();
+
+	/* Keep the footprint of thousands of threads small. */
+	if (pthread_attr_init(&attr) || pthread_attr_setstacksize(&attr, 65536)) {
+		perror("pthread_attr");
+		return 1;
+	}
+	start = now_ns();
+	for (i = 0; i < nr_readers; i++) {
+		if (pthread_create(&readers[i], &attr, reader_thread, NULL)) {
+			perror("pthread_create");
+			abort();
+		}
+	}
+	while (uatomic_read(&nr_registered) < nr_readers)
+		usleep(1000);
+	printf("Registered %lu readers in %.1f ms\n\n", nr_readers,
+		(double) (now_ns() - start) / 1000000);
+
+	printf("%-16s %12s %14s %12s %12s\n", "Mode", "Updates",
+		"Updates/s", "Avg (us)", "Max (us)");
+	if (run(false) || run(true))
+		goto end;
+
+	CMM_STORE_SHARED(readers_stop, 1);
+	for (i = 0; i < nr_readers; i++) {
+		if (pthread_join(readers[i], NULL)) {
+			perror("pthread_join");
+			goto end;
+		}
+	}
+	if (uatomic_read(&reader_errors)) {
+		fprintf(stderr, "%lu reads of reclaimed nodes\n",
+			uatomic_read(&reader_errors));
+		goto end;
+	}
+	ret = 0;
+end:
+	pthread_attr_destroy(&attr);
+	free(readers);
+	return ret;
+}
@@ -19,6 +19,54 @@ LTTNG_UST_TRACEPOINT_EVENT(ust_tests_benchmark, tpbench,
 	)
 )
 
+LTTNG_UST_TRACEPOINT_EVENT(ust_tests_benchmark, tpbench4,
+	LTTNG_UST_TP_ARGS(int, value),
+	LTTNG_UST_TP_FIELDS(
+		lttng_ust_field_integer(int, field0, value)
+		lttng_ust_field_integer(int, field1, value)
+		lttng_ust_field_integer(int, field2, value)
+		lttng_ust_field_integer(int, field3, value)
+	)
+)
+
+LTTNG_UST_TRACEPOINT_EVENT(ust_tests_benchmark, tpbench16,
+	LTTNG_UST_TP_ARGS(int, value),
+	LTTNG_UST_TP_FIELDS(
+		lttng_ust_field_integer(int, field0, value)
+		lttng_ust_field_integer(int, field1, value)
+		lttng_ust_field_integer(int, field2, value)
+		lttng_ust_field_integer(int, field3, value)
+		lttng_ust_field_integer(int, field4, value)
+		lttng_ust_field_integer(int, field5, value)
+		lttng_ust_field_integer(int, field6, value)
+		lttng_ust_field_integer(int, field7, value)
+		lttng_ust_field_integer(int, field8, value)
+		lttng_ust_field_integer(int, field9, value)
+		lttng_ust_field_integer(int, field10, value)
+		lttng_ust_field_integer(int, field11, value)
+		lttng_ust_field_integer(int, field12, value)
+		lttng_ust_field_integer(int, field13, value)
+		lttng_ust_field_integer(int, field14, value)
+		lttng_ust_field_integer(int, field15, value)
+	)
+)
+
+LTTNG_UST_TRACEPOINT_EVENT(ust_tests_benchmark, tpbench_string,
+	LTTNG_UST_TP_ARGS(int, value, const char *, str),
+	LTTNG_UST_TP_FIELDS(
+		lttng_ust_field_integer(int, event, value)
+		lttng_ust_field_string(str, str)
+	)
+)
+
+LTTNG_UST_TRACEPOINT_EVENT(ust_tests_benchmark, tpbench_sequence,
+	LTTNG_UST_TP_ARGS(int, value, const uint32_t *, seq, unsigned int, len),
+	LTTNG_UST_TP_FIELDS(
+		lttng_ust_field_integer(int, event, value)
+		lttng_ust_field_sequence(uint32_t, seq, seq, unsigned int, len)
+	)
+)
+
 #endif /* _TRACEPOINT_UST_TESTS_BENCHMARK_H */
 
 #undef LTTNG_UST_TRACEPOINT_INCLUDE
@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "tap.h"
+
+#include "common/crc32c.h"
+
+#define NUM_TESTS	11
+
+#define CHECK_VALUE	0xE3069283U	/* CRC32C of "123456789". */
+#define BUF_LEN		4096
+#define MAX_SHIFT	8
+
+static uint8_t buf[BUF_LEN + MAX_SHIFT];
+
+/*
+ * The dispatched implementation, hardware when available, agrees with
+ * the table-driven one for every start alignment and for lengths
+ * exercising the head, body and tail loops.
+ */
+static
+int check_sw_hw_agree(void)
+{
+	static const size_t lengths[] = {
+		0, 1, 3, 7, 8, 9, 15, 16, 17, 31, 63, 64, 65, 255, 257,
+		1023, 1025, BUF_LEN - 1, BUF_LEN,
+	};
+	unsigned int shift, i;
+
+	for (shift = 0; shift < MAX_SHIFT; shift++) {
+		for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+			const uint8_t *p = buf + shift;
+			size_t len = lengths[i];
+
+			if (lttng_ust_crc32c(0, p, len)
+					!= lttng_ust_crc32c_sw(0, p, len)) {
+				diag("Mismatch at shift %u, length %zu",
+					shift, len);
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+int main(void)
+{
+	uint8_t packet[256];
+	uint32_t crc, partial;
+	size_t i;
+
+	plan_tests(NUM_TESTS);
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = (uint8_t) (i * 31 + (i >> 8) + 7);
+
+	ok(lttng_ust_crc32c(0, "123456789", 9) == CHECK_VALUE,
+		"Known answer");
+	ok(lttng_ust_crc32c_sw(0, "123456789", 9) == CHECK_VALUE,
+		"Known answer of the table-driven implementation");
+	ok(lttng_ust_crc32c(0, buf, 0) == 0,
+		"CRC of no data is 0");
+	ok(check_sw_hw_agree(),
+		"Implementations agree on unaligned inputs and odd lengths");
+
+	crc = lttng_ust_crc32c(0, buf + 1, 1000);
+	partial = lttng_ust_crc32c(0, buf + 1, 333);
+	ok(lttng_ust_crc32c(partial, buf + 334, 667) == crc,
+		"CRC computed in two steps");
+	partial = lttng_ust_crc32c_sw(0, buf + 1, 333);
+	ok(lttng_ust_crc32c_sw(partial, buf + 334, 667) == crc,
+		"Table-driven CRC computed in two steps");
+
+	memcpy(packet, buf + 3, sizeof(packet));
+	crc = lttng_ust_crc32c(0, packet, 200);
+	ok(lttng_ust_crc32c_check_packet(packet, 200, 32, sizeof(packet), crc) == 0,
+		"Intact packet passes");
+	packet[150] ^= 0x10;
+	ok(lttng_ust_crc32c_check_packet(packet, 200, 32, sizeof(packet), crc) == -EBADMSG,
+		"Packet with a flipped bit fails");
+	packet[150] ^= 0x10;
+	ok(lttng_ust_crc32c_check_packet(packet, 199, 32, sizeof(packet), crc) == -EBADMSG,
+		"Packet with a wrong content size fails");
+	ok(lttng_ust_crc32c_check_packet(packet, 16, 32, sizeof(packet), crc) == -EBADMSG,
+		"Content size smaller than the header fails");
+	ok(lttng_ust_crc32c_check_packet(packet, sizeof(packet) + 1, 32,
+			sizeof(packet), crc) == -EBADMSG,
+		"Content size larger than the sub-buffer fails");
+
+	return exit_status();
+}
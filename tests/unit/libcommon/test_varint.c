@@ -0,0 +1,160 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "tap.h"
+
+#include "common/varint.h"
+
+#define TIMESTAMP_BITS	27	/* Of the compact and varint headers. */
+
+struct len_test_data {
+	uint64_t v;
+	size_t len;
+};
+
+/* Each side of the 7-bit group boundaries. */
+static const struct len_test_data len_test_data[] = {
+	{ 0, 1 },
+	{ 0x7F, 1 },
+	{ 0x80, 2 },
+	{ 0x3FFF, 2 },
+	{ 0x4000, 3 },
+	{ 0x1FFFFF, 3 },
+	{ 0x200000, 4 },
+	{ 0xFFFFFFF, 4 },
+	{ 0x10000000, 5 },
+	{ UINT32_MAX, 5 },
+	{ 0x7FFFFFFFFULL, 5 },
+	{ 0x800000000ULL, 6 },
+	{ 0xFFFFFFFFFFFFFFULL, 8 },
+	{ 0x100000000000000ULL, 9 },
+	{ 0x7FFFFFFFFFFFFFFFULL, 9 },
+	{ 0x8000000000000000ULL, 10 },
+	{ UINT64_MAX, 10 },
+};
+
+/* Timestamp field length for a delta, around the timestamp_bits overflow. */
+static const struct len_test_data timestamp_test_data[] = {
+	{ 0, 1 },
+	{ 0x7F, 1 },
+	{ 0x80, 2 },
+	{ 0x1FFFFF, 3 },
+	{ 0x200000, 4 },
+	{ (1ULL << TIMESTAMP_BITS) - 1, 4 },
+	{ 1ULL << TIMESTAMP_BITS, LTTNG_VARINT_FULL_TIMESTAMP_LEN },
+	{ 0xFFFFFFFF, LTTNG_VARINT_FULL_TIMESTAMP_LEN },
+	{ UINT64_MAX, LTTNG_VARINT_FULL_TIMESTAMP_LEN },
+};
+
+struct encode_test_data {
+	uint64_t v;
+	size_t len;
+	uint8_t bytes[LTTNG_VARINT_FULL_TIMESTAMP_LEN];
+};
+
+static const struct encode_test_data encode_test_data[] = {
+	{ 0, 1, { 0x00 } },
+	{ 0x7F, 1, { 0x7F } },
+	{ 0x80, 2, { 0x80, 0x01 } },
+	{ 300, 2, { 0xAC, 0x02 } },
+	{ 0x3FFF, 2, { 0xFF, 0x7F } },
+	{ 0x4000, 3, { 0x80, 0x80, 0x01 } },
+	{ UINT32_MAX, 5, { 0xFF, 0xFF, 0xFF, 0xFF, 0x0F } },
+	{ UINT64_MAX, 10, { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+			    0xFF, 0xFF, 0xFF, 0xFF, 0x01 } },
+	{ 0x8000000000000000ULL, 10, { 0x80, 0x80, 0x80, 0x80, 0x80,
+				       0x80, 0x80, 0x80, 0x80, 0x01 } },
+	/* Only the low-order groups: the reader carries into the rest. */
+	{ 0x12345, 1, { 0x45 } },
+	{ 0x123456789ULL, 2, { 0x89, 0x4F } },
+	/* Zero low-order groups, padded to the requested length. */
+	{ 0, 3, { 0x80, 0x80, 0x00 } },
+};
+
+#define NR_LEN_TESTS		(sizeof(len_test_data) / sizeof(len_test_data[0]))
+#define NR_TIMESTAMP_TESTS	(sizeof(timestamp_test_data) / sizeof(timestamp_test_data[0]))
+#define NR_ENCODE_TESTS		(sizeof(encode_test_data) / sizeof(encode_test_data[0]))
+#define NUM_TESTS		(NR_LEN_TESTS + NR_TIMESTAMP_TESTS + NR_ENCODE_TESTS + 1)
+
+static
+uint64_t decode(const uint8_t *p, size_t *len)
+{
+	uint64_t v = 0;
+	unsigned int shift = 0;
+	size_t i = 0;
+
+	do {
+		v |= (uint64_t) (p[i] & 0x7F) << shift;
+		shift += 7;
+	} while (p[i++] & 0x80);
+	*len = i;
+	return v;
+}
+
+/*
+ * A varint header, as written by the client: event ID, then a full
+ * timestamp, decoded back field by field.
+ */
+static
+int check_header(void)
+{
+	uint8_t header[LTTNG_VARINT_HEADER_MAX_LEN];
+	const uint64_t timestamp = 0xFEDCBA9876543210ULL;
+	const uint32_t event_id = 300;
+	uint8_t *p = header;
+	size_t id_len, ts_len;
+
+	p = lttng_ust_varint_encode(p, event_id, lttng_ust_varint_len(event_id));
+	p = lttng_ust_varint_encode(p, timestamp,
+			lttng_ust_varint_timestamp_len(timestamp, TIMESTAMP_BITS));
+	return p - header == 2 + LTTNG_VARINT_FULL_TIMESTAMP_LEN
+		&& decode(header, &id_len) == event_id && id_len == 2
+		&& decode(header + id_len, &ts_len) == timestamp
+		&& ts_len == LTTNG_VARINT_FULL_TIMESTAMP_LEN;
+}
+
+int main(void)
+{
+	size_t i;
+
+	plan_tests(NUM_TESTS);
+
+	for (i = 0; i < NR_LEN_TESTS; i++) {
+		const struct len_test_data *t = &len_test_data[i];
+
+		ok(lttng_ust_varint_len(t->v) == t->len,
+			"Length of %#llx is %zu",
+			(unsigned long long) t->v, t->len);
+	}
+
+	for (i = 0; i < NR_TIMESTAMP_TESTS; i++) {
+		const struct len_test_data *t = &timestamp_test_data[i];
+
+		ok(lttng_ust_varint_timestamp_len(t->v, TIMESTAMP_BITS) == t->len,
+			"Timestamp field of delta %#llx is %zu bytes",
+			(unsigned long long) t->v, t->len);
+	}
+
+	for (i = 0; i < NR_ENCODE_TESTS; i++) {
+		const struct encode_test_data *t = &encode_test_data[i];
+		uint8_t buf[LTTNG_VARINT_FULL_TIMESTAMP_LEN + 1];
+		uint8_t *end;
+
+		memset(buf, 0xAA, sizeof(buf));
+		end = lttng_ust_varint_encode(buf, t->v, t->len);
+		ok(end == buf + t->len && !memcmp(buf, t->bytes, t->len)
+			&& buf[t->len] == 0xAA,
+			"Encoding of %#llx on %zu bytes",
+			(unsigned long long) t->v, t->len);
+	}
+
+	ok(check_header(), "Header with a full timestamp decodes back");
+
+	return exit_status();
+}
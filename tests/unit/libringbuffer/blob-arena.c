@@ -0,0 +1,128 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Write payloads into a blob arena and read them back through a second,
+ * read-only mapping: allocation, wrap-around into the next generation,
+ * and detection of overwritten payloads and foreign references.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common/ringbuffer/blob_arena.h"
+
+#include "tap.h"
+
+#define NUM_TESTS	14
+#define SHM_PATH	"/ust-blob-arena-test"
+#define SHM_PATH_OTHER	"/ust-blob-arena-test-other"
+#define DATA_SIZE	4096
+
+static char payload[DATA_SIZE + 1];
+static char buf[DATA_SIZE];
+
+static
+int read_back(struct lttng_ust_blob_arena *reader,
+		const struct lttng_ust_blob_ref *ref, const char *src)
+{
+	memset(buf, 0, sizeof(buf));
+	return lttng_ust_blob_arena_read(reader, ref, buf) == 0
+		&& !memcmp(buf, src, ref->length);
+}
+
+static
+void test_map_invalid(void)
+{
+	struct lttng_ust_blob_arena *arena = NULL;
+	int fd;
+
+	fd = shm_open(SHM_PATH_OTHER, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+	(void) shm_unlink(SHM_PATH_OTHER);
+	if (fd >= 0 && !ftruncate(fd, 2 * DATA_SIZE))
+		arena = lttng_ust_blob_arena_map(fd);
+	ok(fd >= 0 && !arena, "Map a shm object which is not an arena");
+	if (arena)
+		lttng_ust_blob_arena_destroy(arena, 1);
+	else if (fd >= 0)
+		close(fd);
+}
+
+int main(void)
+{
+	struct lttng_ust_blob_arena *writer = NULL, *reader = NULL;
+	struct lttng_ust_blob_ref first, second, wrapped, ref;
+	int fd, reader_fd;
+	size_t i;
+
+	plan_tests(NUM_TESTS);
+
+	for (i = 0; i < sizeof(payload); i++)
+		payload[i] = (char) (i * 13 + 5);
+
+	fd = shm_open(SHM_PATH, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+	reader_fd = shm_open(SHM_PATH, O_RDONLY, 0);
+	(void) shm_unlink(SHM_PATH);
+	ok(fd >= 0 && reader_fd >= 0, "Open a POSIX shm object twice");
+	if (fd < 0 || reader_fd < 0)
+		goto end;
+
+	writer = lttng_ust_blob_arena_create(fd, DATA_SIZE, false);
+	ok(writer, "Create an arena");
+	if (!writer) {
+		close(fd);
+		close(reader_fd);
+		goto end;
+	}
+	reader = lttng_ust_blob_arena_map(reader_fd);
+	ok(reader, "Map the arena read-only");
+	if (!reader) {
+		close(reader_fd);
+		goto end;
+	}
+
+	ok(lttng_ust_blob_arena_write(writer, payload, 100, &first) == 0
+		&& first.generation == 1 && first.offset == 0
+		&& first.length == 100 && first.arena_id != 0,
+		"Write a payload at the start of the first generation");
+	ok(read_back(reader, &first, payload), "Read the payload back");
+	ok(lttng_ust_blob_arena_write(writer, payload + 1, 10, &second) == 0
+		&& second.generation == 1 && second.offset == 104,
+		"Next payload starts at an aligned offset");
+	ok(lttng_ust_blob_arena_write(writer, payload, DATA_SIZE + 1, &ref) == -E2BIG,
+		"Payload larger than the data area is rejected");
+
+	ref = second;
+	ref.generation = 0;
+	ok(lttng_ust_blob_arena_read(reader, &ref, buf) == -ENOENT,
+		"Reference of generation 0 has no payload");
+	ref = second;
+	ref.offset = DATA_SIZE - 4;
+	ok(lttng_ust_blob_arena_read(reader, &ref, buf) == -EINVAL,
+		"Reference past the end of the arena is invalid");
+	ref = second;
+	ref.arena_id++;
+	ok(lttng_ust_blob_arena_read(reader, &ref, buf) == -ESTALE,
+		"Reference of another arena instance is stale");
+
+	ok(lttng_ust_blob_arena_write(writer, payload + 2, 4000, &wrapped) == 0
+		&& wrapped.generation == 2 && wrapped.offset == 0,
+		"Payload not fitting before the end wraps to the next generation");
+	ok(read_back(reader, &wrapped, payload + 2),
+		"Read the wrapped payload back");
+	ok(lttng_ust_blob_arena_read(reader, &first, buf) == -ESTALE,
+		"Overwritten payload is stale");
+
+	test_map_invalid();
+end:
+	if (reader)
+		lttng_ust_blob_arena_destroy(reader, 1);
+	if (writer)
+		lttng_ust_blob_arena_destroy(writer, 1);
+	return exit_status();
+}
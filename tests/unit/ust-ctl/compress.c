@@ -0,0 +1,178 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Compress packets with lttng_ust_ctl_compress_buffer() and restore them
+ * with lttng_ust_ctl_decompress_packet(), with each compression built
+ * into the library, and check that truncated or corrupted input is
+ * rejected.
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <lttng/ust-ctl.h>
+
+#include "tap.h"
+
+#define NUM_TESTS		21
+#define TESTS_PER_COMPRESSION	5
+#define CONTENT_SIZE		3000
+#define PACKET_SIZE		4096
+#define HEADER_LEN		sizeof(struct lttng_ust_ctl_compressed_packet_header)
+#define DST_LEN			(HEADER_LEN + 2 * PACKET_SIZE)
+
+static char packet[PACKET_SIZE];
+static char compressed[DST_LEN];
+static char decompressed[PACKET_SIZE];
+
+/* Store a header field of @buf, which may be unaligned. */
+static
+void set_header_field(char *buf, size_t offset, uint64_t value, size_t len)
+{
+	if (len == sizeof(uint32_t)) {
+		uint32_t v = (uint32_t) value;
+
+		memcpy(buf + offset, &v, sizeof(v));
+	} else {
+		memcpy(buf + offset, &value, sizeof(value));
+	}
+}
+
+static
+int is_restored(size_t len)
+{
+	size_t i;
+
+	if (len != PACKET_SIZE)
+		return 0;
+	if (memcmp(decompressed, packet, CONTENT_SIZE))
+		return 0;
+	for (i = CONTENT_SIZE; i < PACKET_SIZE; i++) {
+		if (decompressed[i])
+			return 0;
+	}
+	return 1;
+}
+
+static
+void test_round_trip(enum lttng_ust_ctl_compression compression,
+		const char *name)
+{
+	size_t len = 0, out_len = 0;
+	int ret;
+
+	skip_start(!lttng_ust_ctl_compression_available(compression),
+			TESTS_PER_COMPRESSION, "%s compression not available", name);
+
+	ret = lttng_ust_ctl_compress_buffer(compression, 0, packet,
+			CONTENT_SIZE, PACKET_SIZE, compressed, sizeof(compressed),
+			&len);
+	ok(ret == 0 && len > HEADER_LEN && len <= sizeof(compressed),
+		"%s: compress a packet", name);
+
+	memset(decompressed, 0xFF, sizeof(decompressed));
+	ret = lttng_ust_ctl_decompress_packet(compressed, len, decompressed,
+			sizeof(decompressed), &out_len);
+	ok(ret == 0 && is_restored(out_len),
+		"%s: decompress it, content and zeroed padding", name);
+
+	ret = lttng_ust_ctl_decompress_packet(compressed, len, decompressed,
+			PACKET_SIZE - 1, &out_len);
+	ok(ret == -ENOBUFS, "%s: output smaller than the packet", name);
+
+	ret = lttng_ust_ctl_decompress_packet(compressed, len - 1,
+			decompressed, sizeof(decompressed), &out_len);
+	ok(ret == -EINVAL, "%s: truncated compressed packet", name);
+
+	/* The content size no longer matches the compressed data. */
+	set_header_field(compressed,
+		offsetof(struct lttng_ust_ctl_compressed_packet_header, content_size),
+		CONTENT_SIZE + 8, sizeof(uint64_t));
+	ret = lttng_ust_ctl_decompress_packet(compressed, len, decompressed,
+			sizeof(decompressed), &out_len);
+	ok(ret == -EINVAL, "%s: corrupted content size", name);
+
+	skip_end();
+}
+
+static
+void test_invalid_header(void)
+{
+	size_t len = 0, out_len;
+	int ret;
+
+	ret = lttng_ust_ctl_compress_buffer(LTTNG_UST_CTL_COMPRESSION_NONE, 0,
+			packet, CONTENT_SIZE, PACKET_SIZE, compressed,
+			sizeof(compressed), &len);
+	if (ret) {
+		fail("Compress a packet without compression");
+		return;
+	}
+
+	ok(lttng_ust_ctl_decompress_packet(compressed, HEADER_LEN - 1,
+			decompressed, sizeof(decompressed), &out_len) == -EINVAL,
+		"Input shorter than a header");
+
+	set_header_field(compressed,
+		offsetof(struct lttng_ust_ctl_compressed_packet_header, magic),
+		LTTNG_UST_CTL_COMPRESSED_PACKET_MAGIC ^ 1, sizeof(uint32_t));
+	ok(lttng_ust_ctl_decompress_packet(compressed, len, decompressed,
+			sizeof(decompressed), &out_len) == -EINVAL,
+		"Bad magic number");
+	set_header_field(compressed,
+		offsetof(struct lttng_ust_ctl_compressed_packet_header, magic),
+		LTTNG_UST_CTL_COMPRESSED_PACKET_MAGIC, sizeof(uint32_t));
+
+	set_header_field(compressed,
+		offsetof(struct lttng_ust_ctl_compressed_packet_header, packet_size),
+		CONTENT_SIZE - 1, sizeof(uint64_t));
+	ok(lttng_ust_ctl_decompress_packet(compressed, len, decompressed,
+			sizeof(decompressed), &out_len) == -EINVAL,
+		"Content larger than the packet");
+	set_header_field(compressed,
+		offsetof(struct lttng_ust_ctl_compressed_packet_header, packet_size),
+		PACKET_SIZE, sizeof(uint64_t));
+
+	set_header_field(compressed,
+		offsetof(struct lttng_ust_ctl_compressed_packet_header, compression),
+		UINT32_MAX, sizeof(uint32_t));
+	ok(lttng_ust_ctl_decompress_packet(compressed, len, decompressed,
+			sizeof(decompressed), &out_len) == -ENOTSUP,
+		"Unknown compression");
+}
+
+int main(void)
+{
+	size_t i, len;
+
+	plan_tests(NUM_TESTS);
+
+	/* Compressible, like event records: repeated structure. */
+	for (i = 0; i < CONTENT_SIZE; i++) {
+		if (i % 64 < 16)
+			packet[i] = (char) (i / 64);
+		else
+			packet[i] = "event_record"[i % 12];
+	}
+
+	test_round_trip(LTTNG_UST_CTL_COMPRESSION_NONE, "none");
+	test_round_trip(LTTNG_UST_CTL_COMPRESSION_LZ4, "lz4");
+	test_round_trip(LTTNG_UST_CTL_COMPRESSION_ZSTD, "zstd");
+	test_invalid_header();
+
+	ok(lttng_ust_ctl_compress_buffer((enum lttng_ust_ctl_compression) 1000, 0,
+			packet, CONTENT_SIZE, PACKET_SIZE, compressed,
+			sizeof(compressed), &len) == -ENOTSUP,
+		"Compress with an unknown compression");
+	ok(lttng_ust_ctl_compress_buffer(LTTNG_UST_CTL_COMPRESSION_NONE, 0,
+			packet, CONTENT_SIZE, PACKET_SIZE, compressed,
+			HEADER_LEN + CONTENT_SIZE - 1, &len) == -ENOBUFS,
+		"Compress into a buffer too small");
+
+	return exit_status();
+}
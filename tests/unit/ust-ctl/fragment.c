@@ -0,0 +1,154 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Reassemble chunk groups with lttng_ust_ctl_fragment_add_chunk():
+ * chunks out of order, duplicate and overlapping chunks, eviction of
+ * incomplete groups and payloads above the pending limit.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lttng/ust-ctl.h>
+
+#include "tap.h"
+
+#define NUM_TESTS	20
+#define MAX_PENDING	64
+#define EVENT_ID	7
+
+static char payload[MAX_PENDING];
+
+static
+int add_chunk(struct lttng_ust_ctl_fragment_reassembly *reassembly,
+		uint64_t id, uint64_t offset, uint64_t total_len, size_t len,
+		struct lttng_ust_ctl_fragment_record *record)
+{
+	return lttng_ust_ctl_fragment_add_chunk(reassembly, id, EVENT_ID,
+			offset, total_len, payload + offset, len, record);
+}
+
+static
+int record_is_valid(const struct lttng_ust_ctl_fragment_record *record,
+		uint64_t id, uint64_t total_len)
+{
+	return record->id == id && record->event_id == EVENT_ID
+		&& record->len == total_len
+		&& !memcmp(record->payload, payload, total_len);
+}
+
+static
+void test_out_of_order(struct lttng_ust_ctl_fragment_reassembly *reassembly)
+{
+	struct lttng_ust_ctl_fragment_record record;
+	int ret;
+
+	ok(add_chunk(reassembly, 1, 32, 40, 8, &record) == 0,
+		"Last chunk first is pending");
+	ok(add_chunk(reassembly, 1, 0, 40, 16, &record) == 0,
+		"First chunk is pending");
+	ret = add_chunk(reassembly, 1, 16, 40, 16, &record);
+	ok(ret == 1 && record_is_valid(&record, 1, 40),
+		"Middle chunk completes the payload");
+	if (ret == 1)
+		free(record.payload);
+}
+
+static
+void test_duplicate(struct lttng_ust_ctl_fragment_reassembly *reassembly)
+{
+	struct lttng_ust_ctl_fragment_record record;
+	int ret;
+
+	ok(add_chunk(reassembly, 2, 0, 30, 10, &record) == 0,
+		"First chunk is pending");
+	ok(add_chunk(reassembly, 2, 0, 30, 10, &record) == -EEXIST,
+		"Duplicate chunk is rejected");
+	ok(add_chunk(reassembly, 2, 5, 30, 10, &record) == -EEXIST,
+		"Chunk overlapping the end of a range is rejected");
+	ok(add_chunk(reassembly, 2, 20, 30, 10, &record) == 0,
+		"Last chunk is pending");
+	ok(add_chunk(reassembly, 2, 15, 30, 10, &record) == -EEXIST,
+		"Chunk overlapping the start of a range is rejected");
+	ret = add_chunk(reassembly, 2, 10, 30, 10, &record);
+	ok(ret == 1 && record_is_valid(&record, 2, 30),
+		"Chunk filling the gap completes the payload");
+	if (ret == 1)
+		free(record.payload);
+	ok(add_chunk(reassembly, 3, 0, 30, 10, &record) == 0
+		&& add_chunk(reassembly, 3, 0, 20, 10, &record) == -EINVAL,
+		"Chunk with another payload length is rejected");
+	ret = add_chunk(reassembly, 3, 10, 30, 20, &record);
+	ok(ret == 1 && record_is_valid(&record, 3, 30),
+		"Group is unchanged by the rejected chunk");
+	if (ret == 1)
+		free(record.payload);
+}
+
+static
+void test_eviction(struct lttng_ust_ctl_fragment_reassembly *reassembly)
+{
+	struct lttng_ust_ctl_fragment_record record;
+	uint64_t dropped = 0;
+	int ret;
+
+	ok(add_chunk(reassembly, 4, 0, 40, 8, &record) == 0,
+		"Chunk of a first group is pending");
+	ok(add_chunk(reassembly, 5, 0, 40, 8, &record) == 0,
+		"Chunk of a second group is pending");
+	ok(!lttng_ust_ctl_fragment_get_dropped(reassembly, &dropped)
+		&& dropped == 1,
+		"Oldest group is dropped beyond the pending limit");
+	ret = add_chunk(reassembly, 5, 8, 40, 32, &record);
+	ok(ret == 1 && record_is_valid(&record, 5, 40),
+		"Second group completes");
+	if (ret == 1)
+		free(record.payload);
+	ok(add_chunk(reassembly, 4, 8, 40, 32, &record) == 0,
+		"Chunk of the dropped group starts a new group");
+}
+
+static
+void test_too_big(struct lttng_ust_ctl_fragment_reassembly *reassembly)
+{
+	struct lttng_ust_ctl_fragment_record record;
+	uint64_t dropped = 0;
+	int ret;
+
+	ok(add_chunk(reassembly, 6, 0, MAX_PENDING + 1, 8, &record) == -E2BIG,
+		"Payload above the pending limit is rejected");
+	ok(!lttng_ust_ctl_fragment_get_dropped(reassembly, &dropped)
+		&& dropped == 1,
+		"Rejected payload drops no pending group");
+	ret = add_chunk(reassembly, 6, 0, MAX_PENDING, MAX_PENDING, &record);
+	ok(ret == 1 && record_is_valid(&record, 6, MAX_PENDING),
+		"Payload at the pending limit is reassembled");
+	if (ret == 1)
+		free(record.payload);
+}
+
+int main(void)
+{
+	struct lttng_ust_ctl_fragment_reassembly *reassembly;
+	size_t i;
+
+	plan_tests(NUM_TESTS);
+
+	for (i = 0; i < sizeof(payload); i++)
+		payload[i] = (char) (i * 7 + 1);
+	reassembly = lttng_ust_ctl_fragment_reassembly_create(MAX_PENDING);
+	ok(reassembly, "Create a reassembly");
+	if (!reassembly)
+		goto end;
+	test_out_of_order(reassembly);
+	test_duplicate(reassembly);
+	test_eviction(reassembly);
+	test_too_big(reassembly);
+	lttng_ust_ctl_fragment_reassembly_destroy(reassembly);
+end:
+	return exit_status();
+}
@@ -0,0 +1,167 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Compare the mmap and read code paths of the ELF parser: time and
+ * number of read system calls needed to extract the memsz, build ID
+ * and debug link of each object.
+ */
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/elf.h"
+
+#define DEFAULT_ITERATIONS	1000
+
+static const char *default_objects[] = {
+	"data/x86/main.elf",
+	"data/x86_64/main.elf",
+	"data/armeb/main.elf",
+	"data/aarch64_be/main.elf",
+	"data/pic/hello.pic",
+};
+
+static
+uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Number of read system calls issued by this process so far, from
+ * /proc/self/io. Returns -1 if unavailable. The read of /proc/self/io
+ * itself is accounted for by the caller computing differences.
+ */
+static
+int64_t read_syscalls(void)
+{
+	char line[128];
+	int64_t syscr = -1;
+	FILE *f;
+
+	f = fopen("/proc/self/io", "r");
+	if (!f)
+		return -1;
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "syscr: %" SCNd64, &syscr) == 1)
+			break;
+	}
+	fclose(f);
+	return syscr;
+}
+
+static
+int parse_object(const char *path, unsigned int flags)
+{
+	struct lttng_ust_elf *elf;
+	uint64_t memsz;
+	uint8_t *build_id = NULL;
+	size_t build_id_len;
+	char *dbg_file = NULL;
+	uint32_t crc;
+	int found, ret = -1;
+
+	elf = lttng_ust_elf_create_flags(path, flags);
+	if (!elf)
+		return -1;
+	if (lttng_ust_elf_get_memsz(elf, &memsz))
+		goto end;
+	if (lttng_ust_elf_get_build_id(elf, &build_id, &build_id_len, &found))
+		goto end;
+	if (lttng_ust_elf_get_debug_link(elf, &dbg_file, &crc, &found))
+		goto end;
+	(void) lttng_ust_elf_is_pic(elf);
+	ret = 0;
+end:
+	free(build_id);
+	free(dbg_file);
+	lttng_ust_elf_destroy(elf);
+	return ret;
+}
+
+static
+int bench_object(const char *path, unsigned int flags, unsigned long iterations)
+{
+	int64_t syscr_begin, syscr_end, syscr_overhead;
+	uint64_t t_begin, t_end;
+	unsigned long i;
+
+	/* Warm up the page cache, and measure the accounting overhead. */
+	if (parse_object(path, flags)) {
+		fprintf(stderr, "Cannot parse %s\n", path);
+		return -1;
+	}
+	syscr_begin = read_syscalls();
+	syscr_end = read_syscalls();
+	syscr_overhead = syscr_end - syscr_begin;
+
+	syscr_begin = read_syscalls();
+	if (parse_object(path, flags))
+		return -1;
+	syscr_end = read_syscalls();
+
+	t_begin = now_ns();
+	for (i = 0; i < iterations; i++) {
+		if (parse_object(path, flags))
+			return -1;
+	}
+	t_end = now_ns();
+
+	printf("%-6s %10.0f ", (flags & LTTNG_UST_ELF_NO_MMAP) ? "read" : "mmap",
+		(double) (t_end - t_begin) / iterations);
+	if (syscr_begin < 0 || syscr_end < 0)
+		printf("%12s", "n/a");
+	else
+		printf("%12" PRId64, syscr_end - syscr_begin - syscr_overhead);
+	printf("  %s\n", path);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long iterations = DEFAULT_ITERATIONS;
+	const char **objects = default_objects;
+	int nr_objects = sizeof(default_objects) / sizeof(default_objects[0]);
+	char path[PATH_MAX];
+	const char *data_dir;
+	int i;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <test dir> [iterations [object ...]]\n",
+			argv[0]);
+		return EXIT_FAILURE;
+	}
+	data_dir = argv[1];
+	if (argc > 2)
+		iterations = strtoul(argv[2], NULL, 10);
+	if (!iterations)
+		iterations = 1;
+	if (argc > 3) {
+		objects = (const char **) &argv[3];
+		nr_objects = argc - 3;
+		data_dir = NULL;
+	}
+
+	printf("%-6s %10s %12s  %s\n", "Mode", "ns/object", "read calls", "Object");
+	for (i = 0; i < nr_objects; i++) {
+		if (data_dir)
+			snprintf(path, sizeof(path), "%s/%s", data_dir, objects[i]);
+		else
+			snprintf(path, sizeof(path), "%s", objects[i]);
+		if (bench_object(path, 0, iterations))
+			return EXIT_FAILURE;
+		if (bench_object(path, LTTNG_UST_ELF_NO_MMAP, iterations))
+			return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -15,9 +15,10 @@
 #include "tap.h"
 
 #define NUM_ARCH 4
+#define NUM_READ_MODES 2
 #define NUM_TESTS_PER_ARCH 11
 #define NUM_TESTS_PIC 3
-#define NUM_TESTS (NUM_ARCH * NUM_TESTS_PER_ARCH) + NUM_TESTS_PIC + 1
+#define NUM_TESTS (NUM_ARCH * NUM_READ_MODES * NUM_TESTS_PER_ARCH) + NUM_TESTS_PIC + 1
 
 /*
  * Expected memsz were computed using libelf, build ID and debug link
@@ -54,8 +55,9 @@ static const uint8_t aarch64_be_build_id[BUILD_ID_LEN] = {
 };
 
 static
-void test_elf(const char *test_dir, const char *arch, uint64_t exp_memsz,
-		const uint8_t *exp_build_id, uint32_t exp_crc)
+void test_elf(const char *test_dir, const char *arch, unsigned int flags,
+		uint64_t exp_memsz, const uint8_t *exp_build_id,
+		uint32_t exp_crc)
 {
 	char path[PATH_MAX];
 	struct lttng_ust_elf *elf = NULL;
@@ -68,11 +70,12 @@ void test_elf(const char *test_dir, const char *arch, uint64_t exp_memsz,
 	char *dbg_file = NULL;
 	uint32_t crc = 0;
 
-	diag("Testing %s support", arch);
+	diag("Testing %s support (%s)", arch,
+		(flags & LTTNG_UST_ELF_NO_MMAP) ? "read" : "mmap");
 
 	snprintf(path, PATH_MAX, "%s/data/%s/main.elf", test_dir, arch);
-	elf = lttng_ust_elf_create(path);
-	ok(elf != NULL, "lttng_ust_elf_create");
+	elf = lttng_ust_elf_create_flags(path, flags);
+	ok(elf != NULL, "lttng_ust_elf_create_flags");
 
 	ret = lttng_ust_elf_get_memsz(elf, &memsz);
 	ok(ret == 0, "lttng_ust_elf_get_memsz returned successfully");
@@ -138,6 +141,7 @@ void test_pic(const char *test_dir)
 int main(int argc, char **argv)
 {
 	const char *test_dir;
+	int i;
 
 	plan_tests(NUM_TESTS);
 
@@ -148,11 +152,18 @@ int main(int argc, char **argv)
 		test_dir = argv[1];
 	}
 
-	test_elf(test_dir, "x86", X86_MEMSZ, x86_build_id, X86_CRC);
-	test_elf(test_dir, "x86_64", X86_64_MEMSZ, x86_64_build_id, X86_64_CRC);
-	test_elf(test_dir, "armeb", ARMEB_MEMSZ, armeb_build_id, ARMEB_CRC);
-	test_elf(test_dir, "aarch64_be", AARCH64_BE_MEMSZ, aarch64_be_build_id,
-		AARCH64_BE_CRC);
+	for (i = 0; i < NUM_READ_MODES; i++) {
+		unsigned int flags = i ? LTTNG_UST_ELF_NO_MMAP : 0;
+
+		test_elf(test_dir, "x86", flags, X86_MEMSZ, x86_build_id,
+			X86_CRC);
+		test_elf(test_dir, "x86_64", flags, X86_64_MEMSZ,
+			x86_64_build_id, X86_64_CRC);
+		test_elf(test_dir, "armeb", flags, ARMEB_MEMSZ,
+			armeb_build_id, ARMEB_CRC);
+		test_elf(test_dir, "aarch64_be", flags, AARCH64_BE_MEMSZ,
+			aarch64_be_build_id, AARCH64_BE_CRC);
+	}
 	test_pic(test_dir);
 
 	return exit_status();
@@ -0,0 +1,245 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Set up a command ring over a socket pair, then play the application
+ * side on the shared memory: submit commands and wait for their replies
+ * while head and tail wrap around the slots, fill the ring, and wait
+ * for a reply posted by another thread.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <urcu/arch.h>
+#include <urcu/system.h>
+
+#include <lttng/ust-ctl.h>
+
+#include "common/compat/shared-futex.h"
+#include "common/ustcomm.h"
+
+#include "tap.h"
+
+#define NUM_TESTS	15
+#define SHM_PATH	"/ust-cmd-ring-test"
+#define NR_SLOTS	4
+#define NR_ROUNDS	(5 * NR_SLOTS + 1)
+
+/* Application side of the ring. */
+static struct ustcomm_cmd_ring *app_ring;
+static int32_t app_tail;
+
+static
+uint32_t reply_val(uint32_t handle, uint32_t cmd)
+{
+	return handle * 1000 + cmd;
+}
+
+/* Execute up to @nr submitted commands, as the application does. */
+static
+void app_process(unsigned int nr)
+{
+	for (; nr && CMM_LOAD_SHARED(app_ring->head) != app_tail; nr--) {
+		struct ustcomm_cmd_ring_slot *slot;
+
+		/* Read the slot after head. */
+		cmm_smp_rmb();
+		slot = &app_ring->slots[(uint32_t) app_tail & (NR_SLOTS - 1)];
+		memset(&slot->reply, 0, sizeof(slot->reply));
+		slot->reply.handle = slot->msg.handle;
+		slot->reply.cmd = slot->msg.cmd;
+		slot->reply.ret_code = LTTNG_UST_OK;
+		slot->reply.ret_val = reply_val(slot->msg.handle, slot->msg.cmd);
+		/* Write the reply before tail. */
+		cmm_smp_wmb();
+		CMM_STORE_SHARED(app_ring->tail, ++app_tail);
+		cmm_smp_mb();
+		if (CMM_LOAD_SHARED(app_ring->sessiond_waiting))
+			(void) lttng_ust_shared_futex_wake(&app_ring->tail, 1);
+	}
+}
+
+/* Reply once the session daemon sleeps on tail, to test its wakeup. */
+static
+void *app_thread(void *arg __attribute__((unused)))
+{
+	int i;
+
+	for (i = 0; i < 5000 && !CMM_LOAD_SHARED(app_ring->sessiond_waiting); i++)
+		usleep(1000);
+	app_process(1);
+	return NULL;
+}
+
+/* Wait for the reply of command @cmd on @handle. */
+static
+int wait_reply_is(struct lttng_ust_ctl_cmd_ring *ring, uint32_t handle,
+		uint32_t cmd)
+{
+	uint32_t ret_val = 0;
+
+	return lttng_ust_ctl_cmd_ring_wait_reply(ring, 0, &ret_val) == 0
+		&& ret_val == reply_val(handle, cmd);
+}
+
+/* Submit one command per slot, then submit one more. */
+static
+int fill_ring(struct lttng_ust_ctl_cmd_ring *ring, uint32_t first_handle)
+{
+	unsigned int i;
+
+	for (i = 0; i < NR_SLOTS; i++) {
+		if (lttng_ust_ctl_cmd_ring_submit(ring, first_handle + i,
+				LTTNG_UST_ABI_ENABLE))
+			return 0;
+	}
+	return lttng_ust_ctl_cmd_ring_submit(ring, first_handle + i,
+			LTTNG_UST_ABI_ENABLE) == -EAGAIN;
+}
+
+static
+int setup_ring(int sock[2], int shm_fd, struct lttng_ust_ctl_cmd_ring **ring)
+{
+	struct ustcomm_ust_reply lur;
+	int i;
+
+	/*
+	 * Queue the replies of the application to the command and to the
+	 * shared memory, so that no thread needs to answer the setup.
+	 */
+	memset(&lur, 0, sizeof(lur));
+	lur.handle = LTTNG_UST_ABI_ROOT_HANDLE;
+	lur.cmd = LTTNG_UST_ABI_CMD_RING;
+	lur.ret_code = LTTNG_UST_OK;
+	for (i = 0; i < 2; i++) {
+		if (write(sock[1], &lur, sizeof(lur)) != sizeof(lur))
+			return -1;
+	}
+	return lttng_ust_ctl_create_cmd_ring(sock[0], shm_fd, NR_SLOTS, ring);
+}
+
+int main(void)
+{
+	struct lttng_ust_ctl_cmd_ring *ring = NULL;
+	struct ustcomm_ust_msg lum;
+	pthread_t thread;
+	int sock[2], shm_fd, app_shm_fd = -1;
+	unsigned int i, round_ok;
+	uint32_t ret_val;
+	int ret;
+
+#ifndef LTTNG_UST_HAVE_SHARED_FUTEX
+	plan_skip_all("No process-shared futex on this platform");
+#endif
+	plan_tests(NUM_TESTS);
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sock)) {
+		diag("socketpair: %s", strerror(errno));
+		return exit_status();
+	}
+	shm_fd = shm_open(SHM_PATH, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+	(void) shm_unlink(SHM_PATH);
+
+	ret = shm_fd >= 0 ? setup_ring(sock, shm_fd, &ring) : -1;
+	ok(ret == 0, "Create a command ring of %d slots", NR_SLOTS);
+	if (ret)
+		goto end;
+
+	ret = ustcomm_recv_unix_sock(sock[1], &lum, sizeof(lum));
+	ok(ret == sizeof(lum) && lum.cmd == LTTNG_UST_ABI_CMD_RING
+		&& lum.u.cmd_ring.nr_slots == NR_SLOTS
+		&& lum.u.cmd_ring.len == ustcomm_cmd_ring_len(NR_SLOTS)
+		&& ustcomm_recv_fds_unix_sock(sock[1], &app_shm_fd, 1) == 1,
+		"Application receives the command and the shared memory");
+	if (app_shm_fd < 0)
+		goto end;
+	app_ring = mmap(NULL, ustcomm_cmd_ring_len(NR_SLOTS),
+			PROT_READ | PROT_WRITE, MAP_SHARED, app_shm_fd, 0);
+	ok(app_ring != MAP_FAILED && app_ring->magic == USTCOMM_CMD_RING_MAGIC
+		&& app_ring->nr_slots == NR_SLOTS,
+		"Application maps the command ring");
+	if (app_ring == MAP_FAILED)
+		goto end;
+
+	ok(lttng_ust_ctl_cmd_ring_wait_reply(ring, 0, NULL) == -ENOENT,
+		"No reply to wait for");
+	ok(fill_ring(ring, 1), "Fill the ring, then get -EAGAIN");
+	ok(lttng_ust_ctl_cmd_ring_wait_reply(ring, 10, NULL) == -ETIMEDOUT,
+		"Time out waiting for a command not executed yet");
+
+	app_process(2);
+	ok(wait_reply_is(ring, 1, LTTNG_UST_ABI_ENABLE)
+		&& wait_reply_is(ring, 2, LTTNG_UST_ABI_ENABLE),
+		"Replies of the first two commands, in order");
+	ok(lttng_ust_ctl_cmd_ring_submit(ring, 5, LTTNG_UST_ABI_DISABLE) == 0
+		&& lttng_ust_ctl_cmd_ring_submit(ring, 6, LTTNG_UST_ABI_DISABLE) == 0,
+		"Submit two commands wrapping around the end of the slots");
+	ok(lttng_ust_ctl_cmd_ring_submit(ring, 7, LTTNG_UST_ABI_DISABLE) == -EAGAIN,
+		"Ring full again after wrapping");
+	app_process(NR_SLOTS);
+	ok(wait_reply_is(ring, 3, LTTNG_UST_ABI_ENABLE)
+		&& wait_reply_is(ring, 4, LTTNG_UST_ABI_ENABLE)
+		&& wait_reply_is(ring, 5, LTTNG_UST_ABI_DISABLE)
+		&& wait_reply_is(ring, 6, LTTNG_UST_ABI_DISABLE),
+		"Replies across the wrap, in order");
+	ok(lttng_ust_ctl_cmd_ring_wait_reply(ring, 0, NULL) == -ENOENT,
+		"No reply left to wait for");
+
+	/* Vary the fill level, so head and tail wrap at every position. */
+	round_ok = 1;
+	for (i = 0; i < NR_ROUNDS && round_ok; i++) {
+		unsigned int nr = i % NR_SLOTS + 1, j;
+
+		for (j = 0; j < nr; j++) {
+			if (lttng_ust_ctl_cmd_ring_submit(ring, 100 + j,
+					LTTNG_UST_ABI_SESSION_START))
+				round_ok = 0;
+		}
+		app_process(nr);
+		for (j = 0; j < nr; j++) {
+			if (!wait_reply_is(ring, 100 + j,
+					LTTNG_UST_ABI_SESSION_START))
+				round_ok = 0;
+		}
+	}
+	ok(round_ok, "%d rounds of submit and wait_reply", NR_ROUNDS);
+	ok(CMM_LOAD_SHARED(app_ring->head) == app_tail
+		&& CMM_LOAD_SHARED(app_ring->tail) == app_tail,
+		"Head and tail match after the rounds");
+
+	ret = lttng_ust_ctl_cmd_ring_submit(ring, 42, LTTNG_UST_ABI_SESSION_STOP);
+	if (!ret)
+		ret = pthread_create(&thread, NULL, app_thread, NULL);
+	ok(ret == 0, "Submit a command executed by another thread");
+	if (!ret) {
+		ret_val = 0;
+		ret = lttng_ust_ctl_cmd_ring_wait_reply(ring, -1, &ret_val);
+		(void) pthread_join(thread, NULL);
+		ok(ret == 0 && ret_val == reply_val(42, LTTNG_UST_ABI_SESSION_STOP),
+			"Woken up by the reply of the other thread");
+	} else {
+		fail("Woken up by the reply of the other thread");
+	}
+
+end:
+	if (app_ring && app_ring != MAP_FAILED)
+		(void) munmap(app_ring, ustcomm_cmd_ring_len(NR_SLOTS));
+	if (app_shm_fd >= 0)
+		(void) close(app_shm_fd);
+	lttng_ust_ctl_destroy_cmd_ring(ring);
+	if (shm_fd >= 0)
+		(void) close(shm_fd);
+	(void) close(sock[0]);
+	(void) close(sock[1]);
+	return exit_status();
+}
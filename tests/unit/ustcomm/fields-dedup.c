@@ -0,0 +1,297 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * Copyright (C) 2026 EfficiOS, Inc.
+ *
+ * Register batches of structurally identical events over a socket pair,
+ * with and without LTTNG_UST_ABI_NOTIFY_FEATURE_FIELDS_DEDUP, and check
+ * that the session daemon side receives the same fields while fewer
+ * bytes are sent.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <lttng/ust-ctl.h>
+#include <lttng/ust-events.h>
+
+#include "common/macros.h"
+#include "common/ustcomm.h"
+
+#include "tap.h"
+
+#define NUM_TESTS	10
+#define NR_EVENTS	1000
+
+static const struct lttng_ust_type_integer int_type = {
+	.parent = {
+		.type = lttng_ust_type_integer,
+	},
+	.struct_size = sizeof(struct lttng_ust_type_integer),
+	.size = 32,
+	.alignment = 8,
+	.signedness = 1,
+	.reverse_byte_order = 0,
+	.base = 10,
+};
+
+static const struct lttng_ust_type_string string_type = {
+	.parent = {
+		.type = lttng_ust_type_string,
+	},
+	.struct_size = sizeof(struct lttng_ust_type_string),
+	.encoding = lttng_ust_string_encoding_UTF8,
+};
+
+#define INT_FIELD(_name)						\
+	static const struct lttng_ust_event_field field_##_name = {	\
+		.struct_size = sizeof(struct lttng_ust_event_field),	\
+		.name = #_name,						\
+		.type = &int_type.parent,				\
+	}
+
+INT_FIELD(cpu);
+INT_FIELD(pid);
+INT_FIELD(tid);
+INT_FIELD(len);
+
+static const struct lttng_ust_event_field *hdr_fields[] = {
+	&field_cpu, &field_pid, &field_tid,
+};
+
+static const struct lttng_ust_type_struct hdr_type = {
+	.parent = {
+		.type = lttng_ust_type_struct,
+	},
+	.struct_size = sizeof(struct lttng_ust_type_struct),
+	.nr_fields = 3,
+	.fields = hdr_fields,
+	.alignment = 0,
+};
+
+static const struct lttng_ust_event_field field_hdr = {
+	.struct_size = sizeof(struct lttng_ust_event_field),
+	.name = "hdr",
+	.type = &hdr_type.parent,
+};
+
+static const struct lttng_ust_event_field field_msg = {
+	.struct_size = sizeof(struct lttng_ust_event_field),
+	.name = "msg",
+	.type = &string_type.parent,
+};
+
+/* Two layouts shared by all events, in separate (non-shared) arrays. */
+static const struct lttng_ust_event_field *layout_a[] = {
+	&field_hdr, &field_len, &field_msg,
+};
+static const struct lttng_ust_event_field *layout_b[] = {
+	&field_pid, &field_len,
+};
+
+struct received {
+	size_t nr_events;
+	size_t bytes;			/* Event records received */
+	int errors;
+	struct lttng_ust_ctl_event_registration events[NR_EVENTS];
+};
+
+struct sessiond_args {
+	int sock;
+	struct lttng_ust_ctl_notify_fields_cache *fields_cache;
+	struct received *received;
+};
+
+static
+void *sessiond_thread(void *arg)
+{
+	struct sessiond_args *args = arg;
+	struct received *received = args->received;
+
+	for (;;) {
+		struct lttng_ust_ctl_event_registration *events;
+		struct ustcomm_notify_event_batch_msg msg;
+		enum lttng_ust_ctl_notify_cmd cmd;
+		uint32_t ids[USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS];
+		int ret_codes[USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS];
+		size_t nr, i;
+
+		if (lttng_ust_ctl_recv_notify(args->sock, &cmd))
+			break;
+		if (cmd != LTTNG_UST_CTL_NOTIFY_CMD_EVENT_BATCH)
+			goto error;
+		/* Account for the size of the records before receiving them. */
+		if (recv(args->sock, &msg, sizeof(msg), MSG_PEEK | MSG_WAITALL) != sizeof(msg))
+			goto error;
+		received->bytes += msg.len;
+		if (lttng_ust_ctl_recv_register_event_batch(args->sock,
+				args->fields_cache, &events, &nr))
+			goto error;
+		if (nr > USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS
+				|| received->nr_events + nr > NR_EVENTS)
+			goto error;
+		for (i = 0; i < nr; i++) {
+			ids[i] = received->nr_events;
+			ret_codes[i] = 0;
+			received->events[received->nr_events++] = events[i];
+		}
+		free(events);
+		if (lttng_ust_ctl_reply_register_event_batch(args->sock,
+				args->fields_cache, ids, ret_codes, nr))
+			goto error;
+	}
+	return NULL;
+
+error:
+	received->errors++;
+	return NULL;
+}
+
+/*
+ * Register NR_EVENTS events alternating between both layouts. Returns
+ * the number of events registered with the expected id.
+ */
+static
+size_t register_all(int dedup, struct received *received)
+{
+	struct ustcomm_fields_desc_cache *fields_cache = NULL;
+	struct ustcomm_event_registration regs[USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS];
+	char names[USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS][LTTNG_UST_ABI_SYM_NAME_LEN];
+	struct sessiond_args args = { 0 };
+	size_t i = 0, nr_ok = 0;
+	pthread_t sessiond;
+	int sv[2];
+
+	if (dedup) {
+		fields_cache = ustcomm_fields_desc_cache_create();
+		args.fields_cache = lttng_ust_ctl_create_notify_fields_cache();
+		if (!fields_cache || !args.fields_cache)
+			goto end;
+	}
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+		goto end;
+	args.sock = sv[1];
+	args.received = received;
+	if (pthread_create(&sessiond, NULL, sessiond_thread, &args)) {
+		close(sv[0]);
+		close(sv[1]);
+		goto end;
+	}
+
+	while (i < NR_EVENTS) {
+		size_t nr = 0, j;
+
+		while (nr < USTCOMM_NOTIFY_EVENT_BATCH_MAX_EVENTS && i < NR_EVENTS) {
+			memset(&regs[nr], 0, sizeof(regs[nr]));
+			snprintf(names[nr], sizeof(names[nr]), "test:event_%zu", i);
+			regs[nr].event_name = names[nr];
+			regs[nr].loglevel = 13;
+			regs[nr].signature = "test_signature";
+			if (i % 2) {
+				regs[nr].nr_fields = LTTNG_ARRAY_SIZE(layout_b);
+				regs[nr].fields = layout_b;
+			} else {
+				regs[nr].nr_fields = LTTNG_ARRAY_SIZE(layout_a);
+				regs[nr].fields = layout_a;
+			}
+			nr++;
+			i++;
+		}
+		if (ustcomm_register_events(sv[0], NULL, 1, 2, regs, nr,
+				fields_cache))
+			break;
+		for (j = 0; j < nr; j++) {
+			if (!regs[j].ret_code && regs[j].id == i - nr + j)
+				nr_ok++;
+		}
+	}
+
+	close(sv[0]);
+	pthread_join(sessiond, NULL);
+	close(sv[1]);
+end:
+	lttng_ust_ctl_destroy_notify_fields_cache(args.fields_cache);
+	ustcomm_fields_desc_cache_destroy(fields_cache);
+	return nr_ok;
+}
+
+static
+void free_received(struct received *received)
+{
+	size_t i;
+
+	for (i = 0; i < received->nr_events; i++) {
+		free(received->events[i].signature);
+		free(received->events[i].fields);
+		free(received->events[i].model_emf_uri);
+	}
+}
+
+int main(void)
+{
+	struct received *plain, *dedup;
+	int same_fields = 1, desc_ids_ok = 1;
+	uint32_t desc_id[2] = { 0, 0 };
+	size_t i;
+
+	plan_tests(NUM_TESTS);
+
+	plain = calloc(1, sizeof(*plain));
+	dedup = calloc(1, sizeof(*dedup));
+	if (!plain || !dedup) {
+		diag("calloc failed");
+		return EXIT_FAILURE;
+	}
+
+	ok(register_all(0, plain) == NR_EVENTS,
+		"Register %d events without deduplication", NR_EVENTS);
+	ok(!plain->errors && plain->nr_events == NR_EVENTS,
+		"Session daemon received all events without deduplication");
+	ok(register_all(1, dedup) == NR_EVENTS,
+		"Register %d events with deduplication", NR_EVENTS);
+	ok(!dedup->errors && dedup->nr_events == NR_EVENTS,
+		"Session daemon received all events with deduplication");
+
+	for (i = 0; i < dedup->nr_events && i < plain->nr_events; i++) {
+		struct lttng_ust_ctl_event_registration *a = &plain->events[i],
+			*b = &dedup->events[i];
+
+		if (strcmp(a->event_name, b->event_name) || a->nr_fields != b->nr_fields
+				|| memcmp(a->fields, b->fields, a->nr_fields * sizeof(*a->fields)))
+			same_fields = 0;
+		if (a->fields_desc_id)
+			desc_ids_ok = 0;
+		if (!desc_id[i % 2])
+			desc_id[i % 2] = b->fields_desc_id;
+		if (!b->fields_desc_id || b->fields_desc_id != desc_id[i % 2])
+			desc_ids_ok = 0;
+	}
+	ok(plain->nr_events == NR_EVENTS && plain->events[0].nr_fields == 6
+		&& plain->events[1].nr_fields == 2,
+		"Nested structure fields are flattened");
+	ok(same_fields, "Fields are identical with and without deduplication");
+	ok(desc_ids_ok, "Events of the same layout share a descriptor id");
+	ok(desc_id[0] && desc_id[1] && desc_id[0] != desc_id[1],
+		"Each layout has its own descriptor id");
+
+	diag("Event records: %zu bytes without deduplication, %zu bytes with deduplication",
+		plain->bytes, dedup->bytes);
+	ok(dedup->bytes < plain->bytes, "Deduplication reduces the bytes sent");
+	/* Fields are sent once; each event still carries its header and signature. */
+	ok(dedup->bytes <= NR_EVENTS * (sizeof(struct ustcomm_notify_event_msg)
+			+ sizeof("test_signature"))
+			+ (6 + 2) * sizeof(struct lttng_ust_ctl_field),
+		"Each field description is sent once");
+
+	free_received(plain);
+	free_received(dedup);
+	free(plain);
+	free(dedup);
+	return exit_status();
+}